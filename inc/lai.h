@@ -98,6 +98,36 @@ typedef enum _lai_log_level_t
     LAI_LOG_LEVEL_MAX           /**< Number of logging levels */
 } lai_log_level_t;
 
+/**
+ * @brief Concurrency mode selected by lai_api_initialize() flags
+ *
+ * Notifications may be called from adapter threads in every mode.
+ */
+typedef enum _lai_api_concurrency_mode_t
+{
+    /**
+     * @brief Adapter host calls LAI APIs from single thread at a time
+     */
+    LAI_API_CONCURRENCY_MODE_SINGLE_THREADED,
+
+    /**
+     * @brief Calls on different object types may run concurrently
+     *
+     * Calls on the same object type are serialized by adapter host.
+     */
+    LAI_API_CONCURRENCY_MODE_PER_OBJECT_TYPE,
+
+    /**
+     * @brief All calls may run concurrently
+     *
+     * Get, get statistics and get extended statistics in read mode run in
+     * parallel, other calls are serialized by adapter, so statistics
+     * polling can run in parallel with configuration.
+     */
+    LAI_API_CONCURRENCY_MODE_CONCURRENT_READS,
+
+} lai_api_concurrency_mode_t;
+
 typedef const char* (*lai_profile_get_value_fn)(
         _In_ lai_linecard_profile_id_t profile_id,
         _In_ const char *variable);
@@ -135,7 +165,11 @@ typedef struct _lai_service_method_table_t
  * initialize any data/control structures that may be necessary during
  * subsequent LAI operations.
  *
- * @param[in] flags Reserved for future use, must be zero
+ * Flags select concurrency mode, zero is single threaded mode. Adapter
+ * which can't provide requested mode returns #LAI_STATUS_NOT_SUPPORTED,
+ * so adapter host can retry with weaker mode.
+ *
+ * @param[in] flags Concurrency mode #lai_api_concurrency_mode_t, other bits are reserved and must be zero
  * @param[in] services Methods table with services provided by adapter host
  *
  * @return #LAI_STATUS_SUCCESS on success, failure status code on error
@@ -166,6 +200,16 @@ lai_status_t lai_api_query(
  */
 lai_status_t lai_api_uninitialize(void);
 
+/**
+ * @brief Query concurrency mode adapter was initialized with
+ *
+ * @param[out] mode Concurrency mode
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+lai_status_t lai_api_concurrency_mode_query(
+        _Out_ lai_api_concurrency_mode_t *mode);
+
 /**
  * @brief Set log level for LAI API module
  *
@@ -180,9 +224,87 @@ lai_status_t lai_log_set(
         _In_ lai_api_t api,
         _In_ lai_log_level_t log_level);
 
+/**
+ * @brief API context id
+ *
+ * Context binds adapter to single linecard slot, so one adapter host
+ * process can drive many linecards. Methods obtained from different
+ * contexts can be called concurrently from different threads.
+ */
+typedef uint32_t lai_api_context_id_t;
+
+/**
+ * @brief Adapter API context initialization call
+ *
+ * Context can be used together with lai_api_initialize(), linecard slot of
+ * context is never used by linecard created through lai_api_query() tables.
+ * Services of every context are kept by context and called with context id
+ * as profile id, so every context may use profile of its own.
+ *
+ * @param[in] context_id Context id, linecard slot
+ * @param[in] flags Concurrency mode #lai_api_concurrency_mode_t of calls within context
+ * @param[in] services Methods table with services provided by adapter host
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+lai_status_t lai_api_context_initialize(
+        _In_ lai_api_context_id_t context_id,
+        _In_ uint64_t flags,
+        _In_ const lai_service_method_table_t *services);
+
+/**
+ * @brief Retrieve a pointer to the C-style method table bound to context
+ *
+ * Linecard created through returned table is created in context linecard
+ * slot, other objects are bound to context through their linecard.
+ *
+ * @param[in] context_id Context id
+ * @param[in] api The API ID whose method table is being retrieved.
+ * @param[out] api_method_table Caller allocated method table. The table must
+ * remain valid until the lai_api_context_uninitialize() is called.
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+lai_status_t lai_api_context_query(
+        _In_ lai_api_context_id_t context_id,
+        _In_ lai_api_t api,
+        _Out_ void **api_method_table);
+
+/**
+ * @brief Uninitialize adapter API context
+ *
+ * Linecard of context and all its objects are removed.
+ *
+ * @param[in] context_id Context id
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+lai_status_t lai_api_context_uninitialize(
+        _In_ lai_api_context_id_t context_id);
+
+/**
+ * @brief Set log level for LAI API module of context
+ *
+ * Adapter with single process wide logger applies level to API module of
+ * all contexts and of lai_api_query() tables.
+ *
+ * @param[in] context_id Context id
+ * @param[in] api The API ID whose logging level is being set
+ * @param[in] log_level Log level
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+lai_status_t lai_api_context_log_set(
+        _In_ lai_api_context_id_t context_id,
+        _In_ lai_api_t api,
+        _In_ lai_log_level_t log_level);
+
 /**
  * @brief Query LAI object type.
  *
+ * Result equals LAI_OBJECT_ID_TYPE() of every valid object id, host may
+ * decode object id instead of calling adapter.
+ *
  * @param[in] object_id Object id
  *
  * @return #LAI_OBJECT_TYPE_NULL when lai_object_id is not valid.
@@ -194,6 +316,9 @@ lai_object_type_t lai_object_type_query(
 /**
  * @brief Query LAI linecard id.
  *
+ * Result equals LAI_OBJECT_ID_LINECARD() of every valid object id, host may
+ * decode object id instead of calling adapter.
+ *
  * @param[in] object_id Object id
  *
  * @return #LAI_NULL_OBJECT_ID when lai_object_id is not valid.
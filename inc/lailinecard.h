@@ -128,6 +128,28 @@ typedef void (*lai_linecard_otdr_result_notification_fn)(
         _In_ lai_object_id_t otdr_id,
         _In_ lai_otdr_result_t otdr_result);
 
+/**
+ * @brief Linecard asynchronous operation notification
+ *
+ * Called while operation started by lai_set_attribute_async() or
+ * lai_get_attribute_async() progresses and once more when it is completed.
+ * Status is meaningful only when operation is completed.
+ *
+ * @param[in] linecard_id Linecard Id
+ * @param[in] request_id Request Id returned when operation was started
+ * @param[in] object_id Object Id of operation
+ * @param[in] completed Operation is completed, no more notification follows
+ * @param[in] status Final status of operation
+ * @param[in] progress Progress of operation in percent
+ */
+typedef void (*lai_linecard_async_operation_notification_fn)(
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_request_id_t request_id,
+        _In_ lai_object_id_t object_id,
+        _In_ bool completed,
+        _In_ lai_status_t status,
+        _In_ lai_uint8_t progress);
+
 /**
  * @brief Attribute Id in lai_set_linecard_attribute() and
  *        lai_get_linecard_attribute() calls.
@@ -597,6 +619,15 @@ typedef enum _lai_linecard_attr_t
      */
     LAI_LINECARD_ATTR_LED_NAME,
 
+    /**
+     * @brief Asynchronous operation notification
+     *
+     * @type lai_pointer_t lai_linecard_async_operation_notification_fn
+     * @flags CREATE_ONLY
+     * @default NULL
+     */
+    LAI_LINECARD_ATTR_LINECARD_ASYNC_OPERATION_NOTIFY,
+
     /**
      * @brief End of attributes
      */
@@ -443,6 +443,39 @@ typedef enum _lai_oa_attr_t
      */
     LAI_OA_ATTR_APR_LINE_VALID_LLDP,
 
+    /**
+     * @brief Statistics kept in sampling ring
+     *
+     * Setting this attribute empties the ring.
+     *
+     * @type lai_s32_list_t lai_oa_stat_t
+     * @flags CREATE_AND_SET
+     * @default empty
+     */
+    LAI_OA_ATTR_SAMPLING_STATS,
+
+    /**
+     * @brief Sampling period in milliseconds, 0 disables sampling
+     *
+     * Setting this attribute empties the ring.
+     *
+     * @type lai_uint32_t
+     * @flags CREATE_AND_SET
+     * @default 0
+     */
+    LAI_OA_ATTR_SAMPLING_PERIOD,
+
+    /**
+     * @brief Number of samples kept in sampling ring
+     *
+     * Setting this attribute empties the ring.
+     *
+     * @type lai_uint32_t
+     * @flags CREATE_AND_SET
+     * @default 1024
+     */
+    LAI_OA_ATTR_SAMPLING_DEPTH,
+
     /**
      * @brief End of attributes
      */
@@ -763,6 +796,30 @@ typedef lai_status_t (*lai_clear_oa_stats_fn)(
         _In_ uint32_t number_of_counters,
         _In_ const lai_stat_id_t *counter_ids);
 
+/**
+ * @brief Drain OA sampling ring
+ *
+ * Adapter samples statistics of #LAI_OA_ATTR_SAMPLING_STATS every
+ * #LAI_OA_ATTR_SAMPLING_PERIOD into ring of #LAI_OA_ATTR_SAMPLING_DEPTH
+ * samples, when ring is full the oldest sample is overwritten. Returned
+ * samples are removed from ring, oldest first. Fewer returned samples than
+ * requested means ring is empty.
+ *
+ * @param[in] oa_id OA id
+ * @param[inout] count Number of samples fitting the arrays, number of returned samples on return
+ * @param[out] timestamps Sample times in nanoseconds since epoch
+ * @param[out] counters Sample values, for each sample one value per sampled statistic in order of #LAI_OA_ATTR_SAMPLING_STATS
+ * @param[out] dropped Number of samples overwritten since previous drain
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+typedef lai_status_t (*lai_drain_oa_samples_fn)(
+        _In_ lai_object_id_t oa_id,
+        _Inout_ uint32_t *count,
+        _Out_ uint64_t *timestamps,
+        _Out_ lai_stat_value_t *counters,
+        _Out_ uint64_t *dropped);
+
 /**
  * @brief Routing interface methods table retrieved with lai_api_query()
  */
@@ -775,6 +832,7 @@ typedef struct _lai_oa_api_t
     lai_get_oa_stats_fn             get_oa_stats;
     lai_get_oa_stats_ext_fn         get_oa_stats_ext;
     lai_clear_oa_stats_fn           clear_oa_stats;
+    lai_drain_oa_samples_fn         drain_oa_samples;
 } lai_oa_api_t;
 
 /**
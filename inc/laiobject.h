@@ -110,6 +110,194 @@ lai_status_t lai_query_attribute_enum_values_capability(
         _In_ lai_attr_id_t attr_id,
         _Inout_ lai_s32_list_t *enum_values_capability);
 
+/**
+ * @brief Set attribute asynchronously
+ *
+ * Attribute is validated before returning, so invalid attribute fails as
+ * in synchronous set. Long running operations like upgrade download, reset
+ * or scan are then reported through linecard
+ * #LAI_LINECARD_ATTR_LINECARD_ASYNC_OPERATION_NOTIFY with returned request id.
+ * Other attributes are completed with next notification. Notifications are
+ * called from adapter thread, never from the calling thread, and request id
+ * is set before first notification of the request.
+ *
+ * @param[in] object_type LAI object type
+ * @param[in] object_id Object id
+ * @param[in] attr Attribute
+ * @param[out] request_id Request id reported in notification
+ *
+ * @return #LAI_STATUS_SUCCESS if operation was started,
+ * #LAI_STATUS_UNINITIALIZED if notification is not set on linecard,
+ * failure status code on error
+ */
+lai_status_t lai_set_attribute_async(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ const lai_attribute_t *attr,
+        _Out_ lai_request_id_t *request_id);
+
+/**
+ * @brief Get attributes asynchronously
+ *
+ * Attribute list is filled before completion is notified through linecard
+ * #LAI_LINECARD_ATTR_LINECARD_ASYNC_OPERATION_NOTIFY and caller must keep
+ * it valid until then. Notification status is status of get. Notifications
+ * are ordered as those of lai_set_attribute_async().
+ *
+ * @param[in] object_type LAI object type
+ * @param[in] object_id Object id
+ * @param[in] attr_count Number of attributes
+ * @param[inout] attr_list Attributes, filled on completion
+ * @param[out] request_id Request id reported in notification
+ *
+ * @return #LAI_STATUS_SUCCESS if operation was started,
+ * #LAI_STATUS_UNINITIALIZED if notification is not set on linecard,
+ * failure status code on error
+ */
+lai_status_t lai_get_attribute_async(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list,
+        _Out_ lai_request_id_t *request_id);
+
+/**
+ * @brief Get generation of last attribute change of object
+ *
+ * Each linecard keeps generation counter, incremented by every create and by
+ * every set which changes attribute value. Object generation is generation
+ * of its creation or of its last changed attribute.
+ *
+ * @param[in] object_type LAI object type
+ * @param[in] object_id Object id
+ * @param[out] generation Object generation
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+lai_status_t lai_get_object_generation(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _Out_ lai_generation_t *generation);
+
+/**
+ * @brief Get attributes changed since generation
+ *
+ * Returns attributes of all objects on linecard which were changed after
+ * given generation, all attributes of object created after it count as
+ * changed. Set only attributes are not reported. Returned generation is
+ * passed as since to next call, zero returns all attributes. Removed objects
+ * are not reported.
+ *
+ * List values are returned with element count only, caller reads them by
+ * get with allocated list.
+ *
+ * @param[in] linecard_id Linecard id
+ * @param[in] since Generation already known to caller
+ * @param[out] generation Current linecard generation
+ * @param[inout] attr_count Number of entries, required number on #LAI_STATUS_BUFFER_OVERFLOW
+ * @param[out] object_list Object ids of changed attributes
+ * @param[inout] attr_list Changed attributes
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_BUFFER_OVERFLOW if
+ * list size insufficient, failure status code on error
+ */
+lai_status_t lai_get_changed_attributes(
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_generation_t since,
+        _Out_ lai_generation_t *generation,
+        _Inout_ uint32_t *attr_count,
+        _Out_ lai_object_id_t *object_list,
+        _Inout_ lai_attribute_t *attr_list);
+
+/**
+ * @brief Read mode of attribute get
+ */
+typedef enum _lai_read_mode_t
+{
+    /** Value kept by adapter, attribute never read is read from hardware */
+    LAI_READ_MODE_CACHED,
+
+    /** Value read from hardware */
+    LAI_READ_MODE_FORCE,
+
+    /** Value kept by adapter when not older than max age, otherwise read from hardware */
+    LAI_READ_MODE_MAX_AGE,
+
+} lai_read_mode_t;
+
+/**
+ * @brief Get attributes with read mode and value timestamps
+ *
+ * Timestamp of attribute is time when adapter last read its value from
+ * hardware or wrote it by create or set. Cached read returns last value
+ * instead of #LAI_STATUS_OBJECT_NOT_READY while hardware is busy, so
+ * pollers can accept slightly stale values cheaply and on demand reads can
+ * force hardware access.
+ *
+ * @param[in] object_type LAI object type
+ * @param[in] object_id Object id
+ * @param[in] read_mode Read mode
+ * @param[in] max_age Maximum value age in nanoseconds for #LAI_READ_MODE_MAX_AGE
+ * @param[in] attr_count Number of attributes
+ * @param[inout] attr_list Attributes
+ * @param[out] timestamp_list Value timestamps in nanoseconds since epoch
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+lai_status_t lai_get_attribute_ext(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ lai_read_mode_t read_mode,
+        _In_ uint64_t max_age,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list,
+        _Out_ uint64_t *timestamp_list);
+
+/**
+ * @brief Begin configuration transaction on linecard
+ *
+ * Create, set and remove of objects on linecard are then staged until
+ * commit or abort, adapter validates each call and returns its status.
+ * Reads before commit return committed values, object created by
+ * transaction is found only by later create, set and remove of the same
+ * transaction. Linecard with open transaction can't be removed.
+ *
+ * @param[in] linecard_id Linecard id
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_OBJECT_IN_USE if
+ * transaction is already open, failure status code on error
+ */
+lai_status_t lai_begin_transaction(
+        _In_ lai_object_id_t linecard_id);
+
+/**
+ * @brief Commit configuration transaction on linecard
+ *
+ * All staged changes are applied to linecard as single batch. When any
+ * staged call failed, no change is applied and status of the first failed
+ * call is returned. Transaction is closed in both cases.
+ *
+ * @param[in] linecard_id Linecard id
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_ITEM_NOT_FOUND if no
+ * transaction is open, failure status code on error
+ */
+lai_status_t lai_commit_transaction(
+        _In_ lai_object_id_t linecard_id);
+
+/**
+ * @brief Abort configuration transaction on linecard
+ *
+ * All staged changes are discarded and transaction is closed.
+ *
+ * @param[in] linecard_id Linecard id
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_ITEM_NOT_FOUND if no
+ * transaction is open, failure status code on error
+ */
+lai_status_t lai_abort_transaction(
+        _In_ lai_object_id_t linecard_id);
+
 /**
  * @}
  */
@@ -272,6 +272,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_transceiver_form_factor_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_FORM_FACTOR,
 
@@ -288,6 +289,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_VENDOR,
 
@@ -296,6 +298,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_VENDOR_PART,
 
@@ -304,6 +307,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_PART_NO,
 
@@ -312,6 +316,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_VENDOR_REV,
 
@@ -320,6 +325,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_DATE_CODE,
 
@@ -328,6 +334,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_MFG_NAME,
 
@@ -336,6 +343,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_MFG_DATE,
 
@@ -344,6 +352,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_HARDWARE_VERSION,
 
@@ -361,6 +370,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_transceiver_ethernet_pmd_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_ETHERNET_PMD,
 
@@ -385,6 +395,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type bool
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_REMOVABLE,
 
@@ -393,6 +404,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_transceiver_connector_type_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_CONNECTOR_TYPE,
 
@@ -401,6 +413,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_SERIAL_NO,
 
@@ -426,6 +439,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_uint32_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_NUM_OF_LANE,
 
@@ -485,6 +499,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_LOT_CODE,
 
@@ -493,6 +508,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_CLEI_CODE,
 
@@ -501,6 +517,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_transceiver_power_class_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_POWER_CLASS,
 
@@ -509,6 +526,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_NEWWORK_BIT_RATE,
 
@@ -517,6 +535,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_HOST_BIT_RATE,
 
@@ -525,6 +544,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_SM_FIBER_LEN,
 
@@ -533,6 +553,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_MM_FIBER_LEN,
 
@@ -541,6 +562,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_COPPER_CABLE_LEN,
 
@@ -549,6 +571,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_MAX_WAVELENGTH,
 
@@ -557,6 +580,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_MIN_WAVELENGTH,
 
@@ -565,6 +589,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_MAX_TX_POWER,
 
@@ -573,6 +598,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_MAX_RX_POWER,
 
@@ -581,6 +607,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_MAX_OPER_TEMP,
 
@@ -589,6 +616,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_MIN_OPER_TEMP,
 
@@ -597,6 +625,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_VCC_HIGH_ALARM_THRESHOLD,
 
@@ -605,6 +634,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_VCC_HIGH_WARN_THRESHOLD,
 
@@ -613,6 +643,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_VCC_LOW_ALARM_THRESHOLD,
 
@@ -621,6 +652,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_VCC_LOW_WARN_THRESHOLD,
 
@@ -629,6 +661,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_RX_TOTAL_POWER_HIGH_ALARM_THRESHOLD,
 
@@ -637,6 +670,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_RX_TOTAL_POWER_HIGH_WARN_THRESHOLD,
 
@@ -645,6 +679,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_RX_TOTAL_POWER_LOW_ALARM_THRESHOLD,
 
@@ -653,6 +688,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_RX_TOTAL_POWER_LOW_WARN_THRESHOLD,
 
@@ -661,6 +697,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_OA_PUMP_CURRENT_HIGH_ALARM_THRESHOLD,
 
@@ -669,6 +706,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_OA_PUMP_CURRENT_HIGH_WARN_THRESHOLD,
 
@@ -677,6 +715,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_OA_PUMP_CURRENT_LOW_ALARM_THRESHOLD,
 
@@ -685,6 +724,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_OA_PUMP_CURRENT_LOW_WARN_THRESHOLD,
 
@@ -693,6 +733,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_TX_BAIS_HIGH_ALARM_THRESHOLD,
 
@@ -701,6 +742,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_TX_BAIS_HIGH_WARN_THRESHOLD,
 
@@ -709,6 +751,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_TX_BAIS_LOW_ALARM_THRESHOLD,
 
@@ -717,6 +760,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_TX_BAIS_LOW_WARN_THRESHOLD,
 
@@ -725,6 +769,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_transceiver_extend_module_code_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_EXTEND_MODULE_CODE,
 
@@ -741,6 +786,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_transceiver_encode_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_ENCODE,
 
@@ -749,6 +795,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_BITRATE,
 
@@ -757,6 +804,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_EXTEND_BIT_RATE,
 
@@ -765,6 +813,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_WAVELENGTH,
 
@@ -773,6 +822,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_WAVELENGTH_TOLERANCE,
 
@@ -781,6 +831,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_OUI,
 
@@ -797,6 +848,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_IDENTIFIER,
 
@@ -805,6 +857,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type char
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_CMIS_REVISION,
 
@@ -813,6 +866,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_TX_POWER_HIGH_ALARM_THRESHOLD,
 
@@ -821,6 +875,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_TX_POWER_LOW_ALARM_THRESHOLD,
 
@@ -829,6 +884,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_TX_POWER_HIGH_WARN_THRESHOLD,
 
@@ -837,6 +893,7 @@ typedef enum _lai_transceiver_attr_t
      *
      * @type lai_double_t
      * @flags READ_ONLY
+     * @isstatic true
      */
     LAI_TRANSCEIVER_ATTR_TX_POWER_LOW_WARN_THRESHOLD,
 
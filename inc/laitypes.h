@@ -35,6 +35,8 @@ typedef int32_t  lai_status_t;
 typedef uint32_t lai_linecard_profile_id_t;
 typedef uint32_t lai_attr_id_t;
 typedef uint32_t lai_stat_id_t;
+typedef uint64_t lai_request_id_t;
+typedef uint64_t lai_generation_t;
 
 #define _In_
 #define _Out_
@@ -140,6 +142,65 @@ typedef enum _lai_object_type_t
     LAI_OBJECT_TYPE_MAX                      =  21,
 } lai_object_type_t;
 
+/**
+ * @def LAI_OBJECT_ID_TYPE_SHIFT
+ *
+ * Object id carries object type in bits 56-63, linecard index in bits 48-55
+ * and object index in bits 0-47. Linecard object has object index 0. Every
+ * adapter must encode object ids this way, so host resolves object type and
+ * linecard of any object id by macros below without calling
+ * lai_object_type_query() and lai_linecard_id_query().
+ */
+#define LAI_OBJECT_ID_TYPE_SHIFT            56
+
+/**
+ * @def LAI_OBJECT_ID_LINECARD_SHIFT
+ * Bit position of linecard index in object id
+ */
+#define LAI_OBJECT_ID_LINECARD_SHIFT        48
+
+/**
+ * @def LAI_OBJECT_ID_LINECARD_MASK
+ * Mask of linecard index after shift
+ */
+#define LAI_OBJECT_ID_LINECARD_MASK         0xFF
+
+/**
+ * @def LAI_OBJECT_ID_INDEX_MASK
+ * Mask of object index in object id
+ */
+#define LAI_OBJECT_ID_INDEX_MASK            ((lai_object_id_t)0xFFFFFFFFFFFFULL)
+
+/**
+ * @def LAI_OBJECT_ID_ENCODE
+ * Encodes object id from object type, linecard index and object index
+ */
+#define LAI_OBJECT_ID_ENCODE(_T_, _L_, _I_) (((lai_object_id_t)(_T_) << LAI_OBJECT_ID_TYPE_SHIFT) | (((lai_object_id_t)(_L_) & LAI_OBJECT_ID_LINECARD_MASK) << LAI_OBJECT_ID_LINECARD_SHIFT) | ((lai_object_id_t)(_I_) & LAI_OBJECT_ID_INDEX_MASK))
+
+/**
+ * @def LAI_OBJECT_ID_TYPE
+ * Object type of object id, not checked against #LAI_OBJECT_TYPE_MAX
+ */
+#define LAI_OBJECT_ID_TYPE(_O_) ((lai_object_type_t)((lai_object_id_t)(_O_) >> LAI_OBJECT_ID_TYPE_SHIFT))
+
+/**
+ * @def LAI_OBJECT_ID_LINECARD_INDEX
+ * Linecard index of object id
+ */
+#define LAI_OBJECT_ID_LINECARD_INDEX(_O_) ((uint32_t)(((lai_object_id_t)(_O_) >> LAI_OBJECT_ID_LINECARD_SHIFT) & LAI_OBJECT_ID_LINECARD_MASK))
+
+/**
+ * @def LAI_OBJECT_ID_INDEX
+ * Object index of object id
+ */
+#define LAI_OBJECT_ID_INDEX(_O_) ((lai_object_id_t)(_O_) & LAI_OBJECT_ID_INDEX_MASK)
+
+/**
+ * @def LAI_OBJECT_ID_LINECARD
+ * Linecard object id of object id, #LAI_NULL_OBJECT_ID for null object id
+ */
+#define LAI_OBJECT_ID_LINECARD(_O_) (LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_LINECARD, LAI_OBJECT_ID_LINECARD_INDEX(_O_), 0) & ((lai_object_id_t)0 - ((lai_object_id_t)(_O_) != LAI_NULL_OBJECT_ID)))
+
 typedef struct _lai_u8_list_t
 {
     uint32_t count;
@@ -0,0 +1,654 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataaccumulator.c
+ *
+ * @brief   This module implements LAI Metadata Counter Accumulator
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <lai.h>
+#include "laimetadataaccumulator.h"
+#include "laimetadata.h"
+
+/*
+ * Memory is array of 64 bit words, header is followed by sorted object
+ * ids, counter ids, per object sequence numbers and totals (object major).
+ *
+ * Sequence number of object is odd while owner updates its totals, reader
+ * retries when sequence was odd or changed during read, yielding between
+ * attempts, and gives up after bounded number of attempts, so owner which
+ * died in the middle of update can't hang readers.
+ *
+ * Owner always creates new memory. Memory left by previous owner is
+ * unlinked, not truncated, readers still attached to it keep valid mapping.
+ * Its magic is replaced by closed magic first, as owner does when it is
+ * released, so readers see old memory is not updated anymore.
+ */
+
+#define ACC_MAGIC           0x4c4149414343554dULL
+#define ACC_CLOSED          0x4c41494143434c44ULL
+#define ACC_HDR_MAGIC       0
+#define ACC_HDR_OBJECT_TYPE 1
+#define ACC_HDR_OBJECTS     2
+#define ACC_HDR_STATS       3
+#define ACC_HDR_POLLS       4
+#define ACC_HDR_ERRORS      5
+#define ACC_HDR_WORDS       8
+#define ACC_READ_ATTEMPTS   1000
+
+typedef struct _lai_metadata_accumulator_state_t
+{
+    uint64_t *words;
+    size_t size;
+    bool shared;
+    char *name;
+
+    const uint64_t *oids;
+    const uint64_t *statids;
+    uint64_t *seq;
+    uint64_t *totals;
+
+    /* owner only */
+
+    const lai_stat_metadata_t **stat_metadata;
+    lai_stat_id_t *counter_ids;
+    lai_stat_value_t *values;
+
+} lai_metadata_accumulator_state_t;
+
+static int lai_metadata_accumulator_compare_oid(
+        _In_ const void *a,
+        _In_ const void *b)
+{
+    lai_object_id_t x = *(const lai_object_id_t*)a;
+    lai_object_id_t y = *(const lai_object_id_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+static void lai_metadata_accumulator_layout(
+        _Inout_ lai_metadata_accumulator_state_t *state,
+        _In_ size_t object_count,
+        _In_ size_t stat_count)
+{
+    uint64_t *w = state->words + ACC_HDR_WORDS;
+
+    state->oids = w;
+    state->statids = w + object_count;
+    state->seq = w + object_count + stat_count;
+    state->totals = w + 2 * object_count + stat_count;
+}
+
+static size_t lai_metadata_accumulator_size(
+        _In_ size_t object_count,
+        _In_ size_t stat_count)
+{
+    return (ACC_HDR_WORDS + 2 * object_count + stat_count + object_count * stat_count) * sizeof(uint64_t);
+}
+
+void lai_metadata_accumulator_free(
+        _Inout_ lai_metadata_accumulator_t *accumulator)
+{
+    if (accumulator == NULL)
+    {
+        return;
+    }
+
+    lai_metadata_accumulator_state_t *state = (lai_metadata_accumulator_state_t*)accumulator->state;
+
+    if (state != NULL)
+    {
+        bool replaced = false;
+
+        if (state->shared && state->words != NULL)
+        {
+            /* name belongs to next owner when it closed this memory already */
+
+            if (accumulator->owner)
+            {
+                replaced = __atomic_exchange_n(&state->words[ACC_HDR_MAGIC], ACC_CLOSED, __ATOMIC_ACQ_REL) == ACC_CLOSED;
+            }
+
+            munmap(state->words, state->size);
+        }
+        else
+        {
+            free(state->words);
+        }
+
+        if (accumulator->owner && state->shared && state->name != NULL && !replaced)
+        {
+            shm_unlink(state->name);
+        }
+
+        free(state->name);
+        free((void*)state->stat_metadata);
+        free(state->counter_ids);
+        free(state->values);
+        free(state);
+    }
+
+    memset(accumulator, 0, sizeof(lai_metadata_accumulator_t));
+}
+
+static void lai_metadata_accumulator_close(
+        _In_ const char *name)
+{
+    struct stat st;
+
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if (fd < 0)
+    {
+        return;
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < ACC_HDR_WORDS * sizeof(uint64_t))
+    {
+        close(fd);
+
+        return;
+    }
+
+    void *addr = mmap(NULL, ACC_HDR_WORDS * sizeof(uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        return;
+    }
+
+    __atomic_store_n(&((uint64_t*)addr)[ACC_HDR_MAGIC], ACC_CLOSED, __ATOMIC_RELEASE);
+
+    munmap(addr, ACC_HDR_WORDS * sizeof(uint64_t));
+}
+
+static lai_status_t lai_metadata_accumulator_map(
+        _Inout_ lai_metadata_accumulator_state_t *state,
+        _In_ const char *name,
+        _In_ size_t size)
+{
+    if (name == NULL)
+    {
+        state->words = (uint64_t*)calloc(1, size);
+        state->size = size;
+
+        return state->words == NULL ? LAI_STATUS_NO_MEMORY : LAI_STATUS_SUCCESS;
+    }
+
+    state->name = (char*)malloc(strlen(name) + 1);
+
+    if (state->name == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    strcpy(state->name, name);
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+
+    if (fd < 0 && errno == EEXIST)
+    {
+        LAI_META_LOG_NOTICE("unlinking %s left by previous owner", name);
+
+        lai_metadata_accumulator_close(name);
+
+        shm_unlink(name);
+
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+
+    if (fd < 0)
+    {
+        LAI_META_LOG_ERROR("shm_open %s failed", name);
+
+        return LAI_STATUS_FAILURE;
+    }
+
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        LAI_META_LOG_ERROR("ftruncate %s to %zu bytes failed", name, size);
+
+        close(fd);
+        shm_unlink(name);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        LAI_META_LOG_ERROR("mmap %s failed", name);
+
+        shm_unlink(name);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    state->words = (uint64_t*)addr;
+    state->size = size;
+    state->shared = true;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_accumulator_create(
+        _Out_ lai_metadata_accumulator_t *accumulator,
+        _In_ const char *name,
+        _In_ lai_object_type_t object_type,
+        _In_ size_t object_count,
+        _In_ const lai_object_id_t *object_ids,
+        _In_ size_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids)
+{
+    if (accumulator == NULL || (object_count && object_ids == NULL) ||
+            counter_ids == NULL || number_of_counters == 0 || number_of_counters > UINT32_MAX)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: accumulator, object ids or counter ids");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(accumulator, 0, sizeof(lai_metadata_accumulator_t));
+
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(object_type);
+
+    if (info == NULL || info->getstatsext == NULL)
+    {
+        LAI_META_LOG_ERROR("object type %d has no statistics", object_type);
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    lai_metadata_accumulator_state_t *state = (lai_metadata_accumulator_state_t*)calloc(1, sizeof(lai_metadata_accumulator_state_t));
+
+    if (state == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    accumulator->object_type = object_type;
+    accumulator->object_count = object_count;
+    accumulator->stat_count = number_of_counters;
+    accumulator->owner = true;
+    accumulator->state = state;
+
+    state->stat_metadata = (const lai_stat_metadata_t**)calloc(number_of_counters, sizeof(lai_stat_metadata_t*));
+    state->counter_ids = (lai_stat_id_t*)calloc(number_of_counters, sizeof(lai_stat_id_t));
+    state->values = (lai_stat_value_t*)calloc(number_of_counters, sizeof(lai_stat_value_t));
+
+    if (state->stat_metadata == NULL || state->counter_ids == NULL || state->values == NULL)
+    {
+        lai_metadata_accumulator_free(accumulator);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    size_t idx = 0;
+
+    for (; idx < number_of_counters; ++idx)
+    {
+        const lai_stat_metadata_t *md = lai_metadata_get_stat_metadata(object_type, counter_ids[idx]);
+
+        if (md == NULL || !md->statvalueiscounter)
+        {
+            LAI_META_LOG_ERROR("stat id %d is not a counter of object type %d", counter_ids[idx], object_type);
+
+            lai_metadata_accumulator_free(accumulator);
+
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+
+        state->stat_metadata[idx] = md;
+        state->counter_ids[idx] = counter_ids[idx];
+    }
+
+    lai_status_t status = lai_metadata_accumulator_map(state, name, lai_metadata_accumulator_size(object_count, number_of_counters));
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        lai_metadata_accumulator_free(accumulator);
+
+        return status;
+    }
+
+    lai_metadata_accumulator_layout(state, object_count, number_of_counters);
+
+    uint64_t *oids = state->words + ACC_HDR_WORDS;
+    uint64_t *statids = oids + object_count;
+
+    memcpy(oids, object_ids, object_count * sizeof(uint64_t));
+
+    qsort(oids, object_count, sizeof(uint64_t), lai_metadata_accumulator_compare_oid);
+
+    for (idx = 1; idx < object_count; ++idx)
+    {
+        if (oids[idx] == oids[idx - 1])
+        {
+            LAI_META_LOG_ERROR("duplicated object id 0x%llx", (unsigned long long)oids[idx]);
+
+            lai_metadata_accumulator_free(accumulator);
+
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    for (idx = 0; idx < number_of_counters; ++idx)
+    {
+        statids[idx] = (uint64_t)counter_ids[idx];
+    }
+
+    state->words[ACC_HDR_OBJECT_TYPE] = (uint64_t)object_type;
+    state->words[ACC_HDR_OBJECTS] = object_count;
+    state->words[ACC_HDR_STATS] = number_of_counters;
+
+    /* magic is published last, readers attaching before see not ready */
+
+    __atomic_store_n(&state->words[ACC_HDR_MAGIC], ACC_MAGIC, __ATOMIC_RELEASE);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_accumulator_attach(
+        _Out_ lai_metadata_accumulator_t *accumulator,
+        _In_ const char *name)
+{
+    if (accumulator == NULL || name == NULL)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: accumulator or name is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(accumulator, 0, sizeof(lai_metadata_accumulator_t));
+
+    int fd = shm_open(name, O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        return LAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < ACC_HDR_WORDS * sizeof(uint64_t))
+    {
+        close(fd);
+
+        return LAI_STATUS_OBJECT_NOT_READY;
+    }
+
+    size_t size = (size_t)st.st_size;
+
+    void *addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        LAI_META_LOG_ERROR("mmap %s failed", name);
+
+        return LAI_STATUS_FAILURE;
+    }
+
+    uint64_t *words = (uint64_t*)addr;
+
+    if (__atomic_load_n(&words[ACC_HDR_MAGIC], __ATOMIC_ACQUIRE) != ACC_MAGIC ||
+            lai_metadata_accumulator_size(words[ACC_HDR_OBJECTS], words[ACC_HDR_STATS]) != size)
+    {
+        munmap(addr, size);
+
+        return LAI_STATUS_OBJECT_NOT_READY;
+    }
+
+    lai_metadata_accumulator_state_t *state = (lai_metadata_accumulator_state_t*)calloc(1, sizeof(lai_metadata_accumulator_state_t));
+
+    if (state == NULL)
+    {
+        munmap(addr, size);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    state->words = words;
+    state->size = size;
+    state->shared = true;
+
+    accumulator->object_type = (lai_object_type_t)words[ACC_HDR_OBJECT_TYPE];
+    accumulator->object_count = words[ACC_HDR_OBJECTS];
+    accumulator->stat_count = words[ACC_HDR_STATS];
+    accumulator->owner = false;
+    accumulator->state = state;
+
+    lai_metadata_accumulator_layout(state, accumulator->object_count, accumulator->stat_count);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static void lai_metadata_accumulator_add(
+        _In_ const lai_metadata_accumulator_t *accumulator,
+        _In_ size_t object_index)
+{
+    lai_metadata_accumulator_state_t *state = (lai_metadata_accumulator_state_t*)accumulator->state;
+
+    uint64_t *seq = &state->seq[object_index];
+    uint64_t *totals = &state->totals[object_index * accumulator->stat_count];
+
+    uint64_t s = *seq;
+
+    /* fence keeps odd sequence ahead of totals, pairs with acquire fence of reader */
+
+    __atomic_store_n(seq, s + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    size_t idx = 0;
+
+    for (; idx < accumulator->stat_count; ++idx)
+    {
+        const lai_stat_value_t *v = &state->values[idx];
+
+        uint64_t value;
+
+        switch (state->stat_metadata[idx]->statvaluetype)
+        {
+            case LAI_STAT_VALUE_TYPE_INT32:
+                value = (uint64_t)v->s32;
+                break;
+
+            case LAI_STAT_VALUE_TYPE_UINT32:
+                value = v->u32;
+                break;
+
+            case LAI_STAT_VALUE_TYPE_INT64:
+                value = (uint64_t)v->s64;
+                break;
+
+            case LAI_STAT_VALUE_TYPE_DOUBLE:
+                value = (uint64_t)v->d64;
+                break;
+
+            default:
+                value = v->u64;
+                break;
+        }
+
+        __atomic_store_n(&totals[idx], totals[idx] + value, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(seq, s + 2, __ATOMIC_RELEASE);
+}
+
+lai_status_t lai_metadata_accumulator_poll(
+        _Inout_ lai_metadata_accumulator_t *accumulator)
+{
+    if (accumulator == NULL || accumulator->state == NULL || !accumulator->owner)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: accumulator is not owner");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    lai_metadata_accumulator_state_t *state = (lai_metadata_accumulator_state_t*)accumulator->state;
+
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(accumulator->object_type);
+
+    lai_status_t result = LAI_STATUS_SUCCESS;
+
+    lai_object_meta_key_t mk;
+
+    memset(&mk, 0, sizeof(mk));
+
+    mk.objecttype = accumulator->object_type;
+
+    size_t idx = 0;
+
+    for (; idx < accumulator->object_count; ++idx)
+    {
+        mk.objectkey.key.object_id = state->oids[idx];
+
+        lai_status_t status = info->getstatsext(&mk, (uint32_t)accumulator->stat_count,
+                state->counter_ids, LAI_STATS_MODE_READ_AND_CLEAR, state->values);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            LAI_META_LOG_WARN("failed to read counters of 0x%llx: %d", (unsigned long long)mk.objectkey.key.object_id, status);
+
+            state->words[ACC_HDR_ERRORS]++;
+
+            result = status;
+            continue;
+        }
+
+        lai_metadata_accumulator_add(accumulator, idx);
+    }
+
+    __atomic_store_n(&state->words[ACC_HDR_POLLS], state->words[ACC_HDR_POLLS] + 1, __ATOMIC_RELEASE);
+
+    return result;
+}
+
+lai_status_t lai_metadata_accumulator_get(
+        _In_ const lai_metadata_accumulator_t *accumulator,
+        _In_ lai_object_id_t object_id,
+        _In_ size_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids,
+        _Out_ uint64_t *totals)
+{
+    if (accumulator == NULL || accumulator->state == NULL || (number_of_counters && (counter_ids == NULL || totals == NULL)))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: accumulator, counter ids or totals is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    const lai_metadata_accumulator_state_t *state = (const lai_metadata_accumulator_state_t*)accumulator->state;
+
+    /* objects are sorted by owner */
+
+    size_t lo = 0;
+    size_t hi = accumulator->object_count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (state->oids[mid] < object_id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    if (lo >= accumulator->object_count || state->oids[lo] != object_id)
+    {
+        return LAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    const uint64_t *row = &state->totals[lo * accumulator->stat_count];
+
+    uint64_t *seq = &state->seq[lo];
+
+    const uint64_t *magic = &state->words[ACC_HDR_MAGIC];
+
+    int attempt = 0;
+
+    for (; attempt < ACC_READ_ATTEMPTS; ++attempt)
+    {
+        if (attempt != 0)
+        {
+            sched_yield();
+        }
+
+        if (__atomic_load_n(magic, __ATOMIC_ACQUIRE) != ACC_MAGIC)
+        {
+            return LAI_STATUS_OBJECT_NOT_READY;
+        }
+
+        uint64_t s1 = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+
+        if (s1 & 1)
+        {
+            continue;
+        }
+
+        size_t idx = 0;
+
+        for (; idx < number_of_counters; ++idx)
+        {
+            size_t k = 0;
+
+            while (k < accumulator->stat_count && state->statids[k] != (uint64_t)counter_ids[idx])
+            {
+                k++;
+            }
+
+            if (k == accumulator->stat_count)
+            {
+                return LAI_STATUS_ITEM_NOT_FOUND;
+            }
+
+            totals[idx] = __atomic_load_n(&row[k], __ATOMIC_RELAXED);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(seq, __ATOMIC_RELAXED) == s1)
+        {
+            return LAI_STATUS_SUCCESS;
+        }
+    }
+
+    LAI_META_LOG_WARN("totals of 0x%llx are being updated for too long", (unsigned long long)object_id);
+
+    return LAI_STATUS_OBJECT_NOT_READY;
+}
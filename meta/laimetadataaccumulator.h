@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataaccumulator.h
+ *
+ * @brief   This module defines LAI Metadata Counter Accumulator
+ */
+
+#ifndef __LAIMETADATAACCUMULATOR_H_
+#define __LAIMETADATAACCUMULATOR_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATAACCUMULATOR LAI - Metadata Counter Accumulator Definitions
+ *
+ * Counters with iscounter metadata may be cleared by adapter when read with
+ * #LAI_STATS_MODE_READ_AND_CLEAR, so only single reader in the system can
+ * own them. Accumulator is this single reader. It polls counters of a set of
+ * objects and keeps monotonic 64 bit totals per object and counter.
+ *
+ * Totals are kept in shared memory, any number of readers in any process
+ * can attach to it by name and read totals without calling adapter. Each
+ * object is protected by sequence lock, so readers never block the owner.
+ * Owner replaces memory left under the same name by previous owner and
+ * marks old memory closed, as it does when released, readers attached to
+ * closed memory get #LAI_STATUS_OBJECT_NOT_READY and must attach again.
+ *
+ * Owner requires LAI APIs to be queried by lai_metadata_apis_query.
+ *
+ * @{
+ */
+
+/**
+ * @brief Counter accumulator
+ */
+typedef struct _lai_metadata_accumulator_t
+{
+    /**
+     * @brief Object type of accumulated objects.
+     */
+    lai_object_type_t object_type;
+
+    /**
+     * @brief Number of accumulated objects.
+     */
+    size_t object_count;
+
+    /**
+     * @brief Number of counters per object.
+     */
+    size_t stat_count;
+
+    /**
+     * @brief Whether this instance owns counters and polls adapter.
+     */
+    bool owner;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_accumulator_t;
+
+/**
+ * @brief Creates counter accumulator owning the counters
+ *
+ * @param[out] accumulator Accumulator to be created
+ * @param[in] name Shared memory name, or NULL for process private memory
+ * @param[in] object_type Object type of accumulated objects
+ * @param[in] object_count Number of accumulated objects
+ * @param[in] object_ids Object ids of accumulated objects
+ * @param[in] number_of_counters Number of counters per object
+ * @param[in] counter_ids Counter ids, the same for each object
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_accumulator_create(
+        _Out_ lai_metadata_accumulator_t *accumulator,
+        _In_ const char *name,
+        _In_ lai_object_type_t object_type,
+        _In_ size_t object_count,
+        _In_ const lai_object_id_t *object_ids,
+        _In_ size_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids);
+
+/**
+ * @brief Attaches to counter accumulator as reader
+ *
+ * @param[out] accumulator Accumulator to be attached
+ * @param[in] name Shared memory name used by owner
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_accumulator_attach(
+        _Out_ lai_metadata_accumulator_t *accumulator,
+        _In_ const char *name);
+
+/**
+ * @brief Releases counter accumulator
+ *
+ * Owner also marks its memory closed and removes shared memory name unless
+ * next owner replaced it already, attached readers keep their mapping
+ * until released.
+ *
+ * @param[inout] accumulator Accumulator to be released
+ */
+extern void lai_metadata_accumulator_free(
+        _Inout_ lai_metadata_accumulator_t *accumulator);
+
+/**
+ * @brief Polls adapter and accumulates counters of all objects
+ *
+ * Counters are read with #LAI_STATS_MODE_READ_AND_CLEAR. When some object
+ * fails, remaining objects are still polled and accumulated.
+ *
+ * @param[inout] accumulator Accumulator owning the counters
+ *
+ * @return #LAI_STATUS_SUCCESS on success, status of last failed object on error
+ */
+extern lai_status_t lai_metadata_accumulator_poll(
+        _Inout_ lai_metadata_accumulator_t *accumulator);
+
+/**
+ * @brief Gets accumulated totals of single object
+ *
+ * @param[in] accumulator Counter accumulator
+ * @param[in] object_id Object id
+ * @param[in] number_of_counters Number of counters
+ * @param[in] counter_ids Counter ids
+ * @param[out] totals Accumulated totals, array of number_of_counters elements
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_ITEM_NOT_FOUND if object
+ * or counter is not accumulated, #LAI_STATUS_OBJECT_NOT_READY if memory was
+ * closed or owner kept updating totals during all read attempts, failure
+ * status code on error
+ */
+extern lai_status_t lai_metadata_accumulator_get(
+        _In_ const lai_metadata_accumulator_t *accumulator,
+        _In_ lai_object_id_t object_id,
+        _In_ size_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids,
+        _Out_ uint64_t *totals);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATAACCUMULATOR_H_ */
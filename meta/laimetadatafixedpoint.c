@@ -0,0 +1,531 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatafixedpoint.c
+ *
+ * @brief   This module implements LAI Metadata Fixed Point Conversion
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <lai.h>
+#include "laimetadatafixedpoint.h"
+#include "laimetadata.h"
+
+/*
+ * Saturation bounds are the largest doubles which still convert to the
+ * integer type without overflow, lowest integer value is reserved for NaN.
+ */
+
+#define FIXED_S64_MAX ( 9223372036854774784.0)
+#define FIXED_S64_MIN (-9223372036854774784.0)
+#define FIXED_S32_MAX ( 2147483647.0)
+#define FIXED_S32_MIN (-2147483647.0)
+#define FIXED_S32_INVALID (-2147483648.0)
+
+#define FIXED_S64_SIGN  0x8000000000000000ULL
+#define FIXED_S32_SPAN  0x00000000FFFFFFFEULL
+
+static const int64_t lai_metadata_fixed_point_scales[] = {
+    1,                      /* LAI_STAT_VALUE_PRECISION_0 */
+    10,                     /* LAI_STAT_VALUE_PRECISION_1 */
+    100,                    /* LAI_STAT_VALUE_PRECISION_2 */
+    1000000000000000000,    /* LAI_STAT_VALUE_PRECISION_18 */
+};
+
+int64_t lai_metadata_get_fixed_point_scale(
+        _In_ lai_stat_value_precision_t precision)
+{
+    if ((size_t)precision >= sizeof(lai_metadata_fixed_point_scales)/sizeof(lai_metadata_fixed_point_scales[0]))
+    {
+        return 0;
+    }
+
+    return lai_metadata_fixed_point_scales[precision];
+}
+
+int64_t lai_metadata_get_stat_fixed_point_scale(
+        _In_ const lai_stat_metadata_t *metadata)
+{
+    if (metadata == NULL)
+    {
+        return 0;
+    }
+
+    if (metadata->statvaluetype != LAI_STAT_VALUE_TYPE_DOUBLE)
+    {
+        return 1;
+    }
+
+    return lai_metadata_get_fixed_point_scale(metadata->statvalueprecision);
+}
+
+/*
+ * Loops below are kept branch free (selects only) and 64-bit integer
+ * saturation is done with masks, plain x86-64 has no 64-bit compares.
+ * With gcc 12 at -O3 -fno-trapping-math, which the Makefiles use for this
+ * module, the s32 conversion and all stat value copy loops are vectorized
+ * for plain x86-64 (checked with -fopt-info-vec). Conversions between
+ * doubles and int64 need AVX-512, so the s64 conversion and its inverse
+ * are not, and neither are delta encoding and decoding, which carry the
+ * previous value.
+ */
+
+/*
+ * Rounding adds one to truncated value when remainder reaches half, which
+ * is exact. Adding 0.5 before truncation is not, it rounds 0.5 - 2^-54 up
+ * and odd values above 2^52 to the next even one.
+ */
+
+static void lai_metadata_double_to_fixed_s64(
+        _In_ double scale,
+        _In_ size_t count,
+        _In_ const lai_stat_value_t *values,
+        _Out_ int64_t *fixed)
+{
+    size_t i = 0;
+
+    for (; i < count; ++i)
+    {
+        double v = values[i].d64 * scale;
+
+        v = (v > FIXED_S64_MAX) ? FIXED_S64_MAX : v;
+        v = (v < FIXED_S64_MIN) ? FIXED_S64_MIN : v;
+
+        double x = __builtin_isnan(v) ? 0.0 : v;
+        int64_t t = (int64_t)x;
+        double f = x - (double)t;
+
+        t += (f >= 0.5) ? 1 : 0;
+        t -= (f <= -0.5) ? 1 : 0;
+
+        fixed[i] = __builtin_isnan(v) ? LAI_METADATA_FIXED_POINT_S64_INVALID : t;
+    }
+}
+
+static void lai_metadata_double_to_fixed_s32(
+        _In_ double scale,
+        _In_ size_t count,
+        _In_ const lai_stat_value_t *values,
+        _Out_ int32_t *fixed)
+{
+    size_t i = 0;
+
+    for (; i < count; ++i)
+    {
+        double v = values[i].d64 * scale;
+
+        v = (v > FIXED_S32_MAX) ? FIXED_S32_MAX : v;
+        v = (v < FIXED_S32_MIN) ? FIXED_S32_MIN : v;
+
+        /* NaN becomes the invalid value while still double, so conversion is the last step */
+
+        double t = (double)(int32_t)(__builtin_isunordered(v, v) ? 0.0 : v);
+        double f = v - t;
+
+        t += (f >= 0.5) ? 1.0 : 0.0;
+        t -= (f <= -0.5) ? 1.0 : 0.0;
+        t = __builtin_isunordered(v, v) ? FIXED_S32_INVALID : t;
+
+        fixed[i] = (int32_t)t;
+    }
+}
+
+lai_status_t lai_metadata_stat_values_to_fixed_s64(
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ size_t count,
+        _In_ const lai_stat_value_t *values,
+        _Out_ int64_t *fixed)
+{
+    if (metadata == NULL || (count && (values == NULL || fixed == NULL)))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: metadata, values or fixed is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    size_t i = 0;
+
+    switch (metadata->statvaluetype)
+    {
+        case LAI_STAT_VALUE_TYPE_INT32:
+
+            for (; i < count; ++i)
+            {
+                fixed[i] = values[i].s32;
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_UINT32:
+
+            for (; i < count; ++i)
+            {
+                fixed[i] = values[i].u32;
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_INT64:
+
+            for (; i < count; ++i)
+            {
+                uint64_t v = (uint64_t)values[i].s64;
+                uint64_t x = v ^ FIXED_S64_SIGN;
+
+                /* x | -x has sign bit clear only for zero, so INT64_MIN gets one added */
+
+                fixed[i] = (int64_t)(v + (((x | ((uint64_t)0 - x)) >> 63) ^ 1));
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_UINT64:
+
+            for (; i < count; ++i)
+            {
+                uint64_t v = values[i].u64;
+                uint64_t over = (uint64_t)0 - (v >> 63);
+
+                fixed[i] = (int64_t)((v & ~over) | ((uint64_t)INT64_MAX & over));
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_DOUBLE:
+            break;
+
+        default:
+
+            LAI_META_LOG_ERROR("%s: unsupported stat value type %d", metadata->statidname, metadata->statvaluetype);
+
+            return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    int64_t scale = lai_metadata_get_fixed_point_scale(metadata->statvalueprecision);
+
+    if (scale == 0)
+    {
+        LAI_META_LOG_ERROR("%s: unsupported stat precision %d", metadata->statidname, metadata->statvalueprecision);
+
+        return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    lai_metadata_double_to_fixed_s64((double)scale, count, values, fixed);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_stat_values_to_fixed_s32(
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ size_t count,
+        _In_ const lai_stat_value_t *values,
+        _Out_ int32_t *fixed)
+{
+    if (metadata == NULL || (count && (values == NULL || fixed == NULL)))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: metadata, values or fixed is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    size_t i = 0;
+
+    switch (metadata->statvaluetype)
+    {
+        case LAI_STAT_VALUE_TYPE_INT32:
+
+            for (; i < count; ++i)
+            {
+                int32_t v = values[i].s32;
+
+                fixed[i] = (v == INT32_MIN) ? INT32_MIN + 1 : v;
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_UINT32:
+
+            for (; i < count; ++i)
+            {
+                uint32_t v = values[i].u32;
+
+                fixed[i] = (v > INT32_MAX) ? INT32_MAX : (int32_t)v;
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_INT64:
+
+            for (; i < count; ++i)
+            {
+                uint64_t v = (uint64_t)values[i].s64;
+
+                /* values in range move to [0, FIXED_S32_SPAN], above it is borrow of span - t */
+
+                uint64_t t = v + INT32_MAX;
+                uint64_t d = FIXED_S32_SPAN - t;
+                uint64_t over = (uint64_t)0 - (((~FIXED_S32_SPAN & t) | (~(FIXED_S32_SPAN ^ t) & d)) >> 63);
+                uint64_t negative = (uint64_t)0 - (v >> 63);
+                uint64_t bound = ((uint64_t)INT32_MAX ^ negative) - negative;
+
+                fixed[i] = (int32_t)(int64_t)((v & ~over) | (bound & over));
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_UINT64:
+
+            for (; i < count; ++i)
+            {
+                uint64_t v = values[i].u64;
+                uint64_t high = v >> 31;
+                uint64_t over = (uint64_t)0 - ((high | ((uint64_t)0 - high)) >> 63);
+
+                fixed[i] = (int32_t)((v & ~over) | ((uint64_t)INT32_MAX & over));
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_DOUBLE:
+            break;
+
+        default:
+
+            LAI_META_LOG_ERROR("%s: unsupported stat value type %d", metadata->statidname, metadata->statvaluetype);
+
+            return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    int64_t scale = lai_metadata_get_fixed_point_scale(metadata->statvalueprecision);
+
+    if (scale == 0 || scale > 100)
+    {
+        LAI_META_LOG_ERROR("%s: stat precision %d not supported in 32 bits", metadata->statidname, metadata->statvalueprecision);
+
+        return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    lai_metadata_double_to_fixed_s32((double)scale, count, values, fixed);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_fixed_s64_to_stat_values(
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ size_t count,
+        _In_ const int64_t *fixed,
+        _Out_ lai_stat_value_t *values)
+{
+    if (metadata == NULL || (count && (values == NULL || fixed == NULL)))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: metadata, values or fixed is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    size_t i = 0;
+
+    switch (metadata->statvaluetype)
+    {
+        case LAI_STAT_VALUE_TYPE_INT32:
+
+            for (; i < count; ++i)
+            {
+                values[i].s32 = (int32_t)fixed[i];
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_UINT32:
+
+            for (; i < count; ++i)
+            {
+                values[i].u32 = (uint32_t)fixed[i];
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_INT64:
+
+            for (; i < count; ++i)
+            {
+                values[i].s64 = fixed[i];
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_UINT64:
+
+            for (; i < count; ++i)
+            {
+                values[i].u64 = (uint64_t)fixed[i];
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_DOUBLE:
+            break;
+
+        default:
+
+            LAI_META_LOG_ERROR("%s: unsupported stat value type %d", metadata->statidname, metadata->statvaluetype);
+
+            return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    int64_t scale = lai_metadata_get_fixed_point_scale(metadata->statvalueprecision);
+
+    if (scale == 0)
+    {
+        LAI_META_LOG_ERROR("%s: unsupported stat precision %d", metadata->statidname, metadata->statvalueprecision);
+
+        return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    double inverse = 1.0 / (double)scale;
+    double nan = __builtin_nan("");
+
+    for (; i < count; ++i)
+    {
+        int64_t v = fixed[i];
+
+        values[i].d64 = (v == LAI_METADATA_FIXED_POINT_S64_INVALID) ? nan : (double)v * inverse;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_fixed_s32_to_stat_values(
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ size_t count,
+        _In_ const int32_t *fixed,
+        _Out_ lai_stat_value_t *values)
+{
+    if (metadata == NULL || (count && (values == NULL || fixed == NULL)))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: metadata, values or fixed is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    size_t i = 0;
+
+    switch (metadata->statvaluetype)
+    {
+        case LAI_STAT_VALUE_TYPE_INT32:
+
+            for (; i < count; ++i)
+            {
+                values[i].s32 = fixed[i];
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_UINT32:
+
+            for (; i < count; ++i)
+            {
+                values[i].u32 = (uint32_t)fixed[i];
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_INT64:
+
+            for (; i < count; ++i)
+            {
+                values[i].s64 = fixed[i];
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_UINT64:
+
+            for (; i < count; ++i)
+            {
+                values[i].u64 = (uint64_t)fixed[i];
+            }
+
+            return LAI_STATUS_SUCCESS;
+
+        case LAI_STAT_VALUE_TYPE_DOUBLE:
+            break;
+
+        default:
+
+            LAI_META_LOG_ERROR("%s: unsupported stat value type %d", metadata->statidname, metadata->statvaluetype);
+
+            return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    int64_t scale = lai_metadata_get_fixed_point_scale(metadata->statvalueprecision);
+
+    if (scale == 0 || scale > 100)
+    {
+        LAI_META_LOG_ERROR("%s: stat precision %d not supported in 32 bits", metadata->statidname, metadata->statvalueprecision);
+
+        return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    double inverse = 1.0 / (double)scale;
+    double nan = __builtin_nan("");
+
+    for (; i < count; ++i)
+    {
+        int32_t v = fixed[i];
+
+        values[i].d64 = (v == LAI_METADATA_FIXED_POINT_S32_INVALID) ? nan : (double)v * inverse;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_fixed_s64_delta_encode(
+        _In_ size_t count,
+        _In_ const int64_t *fixed,
+        _Out_ int64_t *deltas)
+{
+    uint64_t prev = 0;
+
+    size_t i = 0;
+
+    for (; i < count; ++i)
+    {
+        uint64_t v = (uint64_t)fixed[i];
+
+        deltas[i] = (int64_t)(v - prev);
+
+        prev = v;
+    }
+}
+
+void lai_metadata_fixed_s64_delta_decode(
+        _In_ size_t count,
+        _In_ const int64_t *deltas,
+        _Out_ int64_t *fixed)
+{
+    uint64_t acc = 0;
+
+    size_t i = 0;
+
+    for (; i < count; ++i)
+    {
+        acc += (uint64_t)deltas[i];
+
+        fixed[i] = (int64_t)acc;
+    }
+}
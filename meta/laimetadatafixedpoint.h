@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatafixedpoint.h
+ *
+ * @brief   This module defines LAI Metadata Fixed Point Conversion
+ */
+
+#ifndef __LAIMETADATAFIXEDPOINT_H_
+#define __LAIMETADATAFIXEDPOINT_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATAFIXEDPOINT LAI - Metadata Fixed Point Definitions
+ *
+ * Statistics values of type double are converted to integers scaled by
+ * 10^precision, where precision is taken from statistics metadata. Integer
+ * statistics values are already exact and are copied without scaling.
+ *
+ * Conversion rounds half away from zero and saturates on overflow. NaN
+ * values are stored as the invalid value of the given width.
+ *
+ * @{
+ */
+
+/**
+ * @brief Invalid 64 bit fixed point value, used for NaN
+ */
+#define LAI_METADATA_FIXED_POINT_S64_INVALID INT64_MIN
+
+/**
+ * @brief Invalid 32 bit fixed point value, used for NaN
+ */
+#define LAI_METADATA_FIXED_POINT_S32_INVALID INT32_MIN
+
+/**
+ * @brief Gets fixed point scale for statistics value precision
+ *
+ * @param[in] precision Statistics value precision
+ *
+ * @return Scale factor (power of ten) or zero if precision is unknown
+ */
+extern int64_t lai_metadata_get_fixed_point_scale(
+        _In_ lai_stat_value_precision_t precision);
+
+/**
+ * @brief Gets fixed point scale for statistics
+ *
+ * Integer statistics values are never scaled and have scale one.
+ *
+ * @param[in] metadata Statistics metadata
+ *
+ * @return Scale factor (power of ten) or zero if metadata is invalid
+ */
+extern int64_t lai_metadata_get_stat_fixed_point_scale(
+        _In_ const lai_stat_metadata_t *metadata);
+
+/**
+ * @brief Converts statistics values to 64 bit fixed point
+ *
+ * All values are of the same statistics described by metadata, for example
+ * history of single gauge or single gauge across many objects.
+ *
+ * @param[in] metadata Statistics metadata
+ * @param[in] count Number of values
+ * @param[in] values Statistics values
+ * @param[out] fixed Fixed point values, array of count elements
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_stat_values_to_fixed_s64(
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ size_t count,
+        _In_ const lai_stat_value_t *values,
+        _Out_ int64_t *fixed);
+
+/**
+ * @brief Converts statistics values to 32 bit fixed point
+ *
+ * Statistics with 18 decimal precision don't fit into 32 bits and are
+ * rejected.
+ *
+ * @param[in] metadata Statistics metadata
+ * @param[in] count Number of values
+ * @param[in] values Statistics values
+ * @param[out] fixed Fixed point values, array of count elements
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_NOT_SUPPORTED if
+ * precision requires 64 bits, failure status code on error
+ */
+extern lai_status_t lai_metadata_stat_values_to_fixed_s32(
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ size_t count,
+        _In_ const lai_stat_value_t *values,
+        _Out_ int32_t *fixed);
+
+/**
+ * @brief Converts 64 bit fixed point values back to statistics values
+ *
+ * @param[in] metadata Statistics metadata
+ * @param[in] count Number of values
+ * @param[in] fixed Fixed point values
+ * @param[out] values Statistics values, array of count elements
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_fixed_s64_to_stat_values(
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ size_t count,
+        _In_ const int64_t *fixed,
+        _Out_ lai_stat_value_t *values);
+
+/**
+ * @brief Converts 32 bit fixed point values back to statistics values
+ *
+ * @param[in] metadata Statistics metadata
+ * @param[in] count Number of values
+ * @param[in] fixed Fixed point values
+ * @param[out] values Statistics values, array of count elements
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_fixed_s32_to_stat_values(
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ size_t count,
+        _In_ const int32_t *fixed,
+        _Out_ lai_stat_value_t *values);
+
+/**
+ * @brief Delta encodes 64 bit fixed point values
+ *
+ * First output value is equal to first input value, each next one is
+ * difference from previous input value in modulo 2^64 arithmetic, so
+ * decoding is always exact. Input and output can be the same array.
+ *
+ * @param[in] count Number of values
+ * @param[in] fixed Fixed point values
+ * @param[out] deltas Delta encoded values, array of count elements
+ */
+extern void lai_metadata_fixed_s64_delta_encode(
+        _In_ size_t count,
+        _In_ const int64_t *fixed,
+        _Out_ int64_t *deltas);
+
+/**
+ * @brief Decodes delta encoded 64 bit fixed point values
+ *
+ * Input and output can be the same array.
+ *
+ * @param[in] count Number of values
+ * @param[in] deltas Delta encoded values
+ * @param[out] fixed Fixed point values, array of count elements
+ */
+extern void lai_metadata_fixed_s64_delta_decode(
+        _In_ size_t count,
+        _In_ const int64_t *deltas,
+        _Out_ int64_t *fixed);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATAFIXEDPOINT_H_ */
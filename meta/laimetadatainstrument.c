@@ -0,0 +1,478 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatainstrument.c
+ *
+ * @brief   This module implements LAI Metadata API Instrumentation
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <lai.h>
+#include "laimetadata.h"
+
+/*
+ * Thread table is fixed open addressing table, only owner thread inserts
+ * and updates entries. Key is published with release after entry is
+ * initialized, counters are stored with relaxed atomics, so snapshot reads
+ * every counter whole but entry as a whole may be torn by in flight call.
+ *
+ * Table of exited thread is merged into retired entries by next snapshot.
+ */
+
+#define INSTRUMENT_SLOTS        512
+#define INSTRUMENT_KEY_USED     (1ULL << 63)
+
+typedef struct _lai_metadata_instrument_slot_t
+{
+    uint64_t key;
+
+    lai_metadata_instrument_entry_t entry;
+
+} lai_metadata_instrument_slot_t;
+
+typedef struct _lai_metadata_instrument_table_t
+{
+    struct _lai_metadata_instrument_table_t *next;
+
+    uint64_t dropped;
+    bool orphaned;
+
+    lai_metadata_instrument_slot_t slots[INSTRUMENT_SLOTS];
+
+} lai_metadata_instrument_table_t;
+
+typedef struct _lai_metadata_instrument_state_t
+{
+    pthread_mutex_t lock;
+    pthread_once_t once;
+    pthread_key_t key;
+    lai_metadata_instrument_table_t *tables;
+
+    lai_metadata_instrument_entry_t *retired;
+    size_t retired_count;
+    uint64_t retired_dropped;
+
+} lai_metadata_instrument_state_t;
+
+/* writable state is exported like lai_metadata_log_level, never declared */
+lai_metadata_instrument_state_t lai_metadata_instrument_state = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_ONCE_INIT, 0, NULL, NULL, 0, 0 };
+
+static void lai_metadata_instrument_table_release(
+        _In_ void *table)
+{
+    __atomic_store_n(&((lai_metadata_instrument_table_t*)table)->orphaned, true, __ATOMIC_RELEASE);
+}
+
+static void lai_metadata_instrument_key_create(void)
+{
+    pthread_key_create(&lai_metadata_instrument_state.key, lai_metadata_instrument_table_release);
+}
+
+static lai_metadata_instrument_table_t* lai_metadata_instrument_table(void)
+{
+    lai_metadata_instrument_table_t *table;
+
+    pthread_once(&lai_metadata_instrument_state.once, lai_metadata_instrument_key_create);
+
+    table = (lai_metadata_instrument_table_t*)pthread_getspecific(lai_metadata_instrument_state.key);
+
+    if (table != NULL)
+    {
+        return table;
+    }
+
+    table = (lai_metadata_instrument_table_t*)calloc(1, sizeof(lai_metadata_instrument_table_t));
+
+    if (table == NULL)
+    {
+        return NULL;
+    }
+
+    if (pthread_setspecific(lai_metadata_instrument_state.key, table) != 0)
+    {
+        free(table);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&lai_metadata_instrument_state.lock);
+
+    table->next = lai_metadata_instrument_state.tables;
+    lai_metadata_instrument_state.tables = table;
+
+    pthread_mutex_unlock(&lai_metadata_instrument_state.lock);
+
+    return table;
+}
+
+static uint64_t lai_metadata_instrument_key(
+        _In_ const lai_metadata_instrument_entry_t *entry)
+{
+    return INSTRUMENT_KEY_USED | ((uint64_t)entry->object_type << 40) | ((uint64_t)entry->op << 32) | entry->id;
+}
+
+static size_t lai_metadata_instrument_bucket(
+        _In_ uint64_t ns)
+{
+    size_t bucket = 0;
+
+    while (ns > 1 && bucket < LAI_METADATA_INSTRUMENT_BUCKETS - 1)
+    {
+        ns >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+uint64_t lai_metadata_instrument_begin(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void lai_metadata_instrument_end(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_metadata_instrument_op_t op,
+        _In_ lai_attr_id_t id,
+        _In_ lai_status_t status,
+        _In_ uint64_t begin)
+{
+    uint64_t ns = lai_metadata_instrument_begin() - begin;
+    lai_metadata_instrument_table_t *table = lai_metadata_instrument_table();
+    lai_metadata_instrument_entry_t *entry;
+    lai_metadata_instrument_slot_t *slot = NULL;
+    uint64_t key;
+    size_t idx;
+    size_t probe;
+
+    if (table == NULL)
+    {
+        return;
+    }
+
+    key = INSTRUMENT_KEY_USED | ((uint64_t)object_type << 40) | ((uint64_t)op << 32) | id;
+
+    for (probe = 0, idx = (size_t)(((key * 0x9e3779b97f4a7c15ULL) >> 32) % INSTRUMENT_SLOTS); probe < INSTRUMENT_SLOTS; probe++, idx = (idx + 1) % INSTRUMENT_SLOTS)
+    {
+        if (table->slots[idx].key == key)
+        {
+            slot = &table->slots[idx];
+            break;
+        }
+
+        if (table->slots[idx].key == 0)
+        {
+            slot = &table->slots[idx];
+
+            slot->entry.object_type = object_type;
+            slot->entry.op = op;
+            slot->entry.id = id;
+
+            __atomic_store_n(&slot->key, key, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+
+    if (slot == NULL)
+    {
+        __atomic_store_n(&table->dropped, table->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    entry = &slot->entry;
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        __atomic_store_n(&entry->errors, entry->errors + 1, __ATOMIC_RELAXED);
+
+        for (idx = 0; idx < LAI_METADATA_INSTRUMENT_STATUS_SLOTS; idx++)
+        {
+            if (entry->status_count[idx] == 0)
+            {
+                entry->status[idx] = status;
+            }
+
+            if (entry->status[idx] == status)
+            {
+                __atomic_store_n(&entry->status_count[idx], entry->status_count[idx] + 1, __ATOMIC_RELEASE);
+                break;
+            }
+        }
+    }
+
+    __atomic_store_n(&entry->total_ns, entry->total_ns + ns, __ATOMIC_RELAXED);
+
+    if (ns > entry->max_ns)
+    {
+        __atomic_store_n(&entry->max_ns, ns, __ATOMIC_RELAXED);
+    }
+
+    idx = lai_metadata_instrument_bucket(ns);
+
+    __atomic_store_n(&entry->histogram[idx], entry->histogram[idx] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->calls, entry->calls + 1, __ATOMIC_RELAXED);
+}
+
+static void lai_metadata_instrument_read(
+        _In_ const lai_metadata_instrument_entry_t *entry,
+        _Out_ lai_metadata_instrument_entry_t *copy)
+{
+    size_t idx;
+
+    copy->object_type = entry->object_type;
+    copy->op = entry->op;
+    copy->id = entry->id;
+    copy->calls = __atomic_load_n(&entry->calls, __ATOMIC_RELAXED);
+    copy->errors = __atomic_load_n(&entry->errors, __ATOMIC_RELAXED);
+    copy->total_ns = __atomic_load_n(&entry->total_ns, __ATOMIC_RELAXED);
+    copy->max_ns = __atomic_load_n(&entry->max_ns, __ATOMIC_RELAXED);
+
+    for (idx = 0; idx < LAI_METADATA_INSTRUMENT_STATUS_SLOTS; idx++)
+    {
+        copy->status_count[idx] = __atomic_load_n(&entry->status_count[idx], __ATOMIC_ACQUIRE);
+        copy->status[idx] = copy->status_count[idx] ? entry->status[idx] : LAI_STATUS_SUCCESS;
+    }
+
+    for (idx = 0; idx < LAI_METADATA_INSTRUMENT_BUCKETS; idx++)
+    {
+        copy->histogram[idx] = __atomic_load_n(&entry->histogram[idx], __ATOMIC_RELAXED);
+    }
+}
+
+static int lai_metadata_instrument_compare(
+        _In_ const void *a,
+        _In_ const void *b)
+{
+    uint64_t x = lai_metadata_instrument_key((const lai_metadata_instrument_entry_t*)a);
+    uint64_t y = lai_metadata_instrument_key((const lai_metadata_instrument_entry_t*)b);
+
+    return (x > y) - (x < y);
+}
+
+static void lai_metadata_instrument_add(
+        _Inout_ lai_metadata_instrument_entry_t *dst,
+        _In_ const lai_metadata_instrument_entry_t *src)
+{
+    size_t idx;
+    size_t pos;
+
+    dst->calls += src->calls;
+    dst->errors += src->errors;
+    dst->total_ns += src->total_ns;
+    dst->max_ns = (src->max_ns > dst->max_ns) ? src->max_ns : dst->max_ns;
+
+    for (idx = 0; idx < LAI_METADATA_INSTRUMENT_BUCKETS; idx++)
+    {
+        dst->histogram[idx] += src->histogram[idx];
+    }
+
+    for (idx = 0; idx < LAI_METADATA_INSTRUMENT_STATUS_SLOTS && src->status_count[idx] != 0; idx++)
+    {
+        for (pos = 0; pos < LAI_METADATA_INSTRUMENT_STATUS_SLOTS; pos++)
+        {
+            if (dst->status_count[pos] == 0)
+            {
+                dst->status[pos] = src->status[idx];
+            }
+
+            if (dst->status[pos] == src->status[idx])
+            {
+                dst->status_count[pos] += src->status_count[idx];
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Sorts entries and merges entries of the same key, returns new count.
+ */
+static size_t lai_metadata_instrument_merge(
+        _Inout_ lai_metadata_instrument_entry_t *entries,
+        _In_ size_t count)
+{
+    size_t idx;
+    size_t kept = 0;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    qsort(entries, count, sizeof(lai_metadata_instrument_entry_t), lai_metadata_instrument_compare);
+
+    for (idx = 1; idx < count; idx++)
+    {
+        if (lai_metadata_instrument_compare(&entries[kept], &entries[idx]) == 0)
+        {
+            lai_metadata_instrument_add(&entries[kept], &entries[idx]);
+        }
+        else
+        {
+            entries[++kept] = entries[idx];
+        }
+    }
+
+    return kept + 1;
+}
+
+static size_t lai_metadata_instrument_collect(
+        _In_ const lai_metadata_instrument_table_t *table,
+        _Out_ lai_metadata_instrument_entry_t *entries)
+{
+    size_t count = 0;
+    size_t idx;
+
+    for (idx = 0; idx < INSTRUMENT_SLOTS; idx++)
+    {
+        if (__atomic_load_n(&table->slots[idx].key, __ATOMIC_ACQUIRE) != 0)
+        {
+            lai_metadata_instrument_read(&table->slots[idx].entry, &entries[count++]);
+        }
+    }
+
+    return count;
+}
+
+lai_status_t lai_metadata_instrument_snapshot(
+        _Out_ lai_metadata_instrument_snapshot_t *snapshot)
+{
+    lai_metadata_instrument_state_t *state = &lai_metadata_instrument_state;
+    lai_metadata_instrument_table_t **link;
+    lai_metadata_instrument_table_t *table;
+    lai_metadata_instrument_entry_t *entries;
+    size_t tables = 0;
+    size_t count;
+
+    if (snapshot == NULL)
+    {
+        LAI_META_LOG_ERROR("snapshot parameter is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    pthread_mutex_lock(&state->lock);
+
+    for (table = state->tables; table != NULL; table = table->next)
+    {
+        tables++;
+    }
+
+    entries = (lai_metadata_instrument_entry_t*)malloc((state->retired_count + tables * INSTRUMENT_SLOTS + 1) * sizeof(lai_metadata_instrument_entry_t));
+
+    if (entries == NULL)
+    {
+        pthread_mutex_unlock(&state->lock);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    /* tables of exited threads are final, retire them first */
+
+    count = 0;
+
+    if (state->retired_count != 0)
+    {
+        memcpy(entries, state->retired, state->retired_count * sizeof(lai_metadata_instrument_entry_t));
+
+        count = state->retired_count;
+    }
+
+    link = &state->tables;
+
+    while ((table = *link) != NULL)
+    {
+        if (!__atomic_load_n(&table->orphaned, __ATOMIC_ACQUIRE))
+        {
+            link = &table->next;
+            continue;
+        }
+
+        count += lai_metadata_instrument_collect(table, &entries[count]);
+
+        state->retired_dropped += table->dropped;
+
+        *link = table->next;
+
+        free(table);
+    }
+
+    count = lai_metadata_instrument_merge(entries, count);
+
+    if (count != state->retired_count)
+    {
+        free(state->retired);
+
+        state->retired = (lai_metadata_instrument_entry_t*)malloc((count + 1) * sizeof(lai_metadata_instrument_entry_t));
+        state->retired_count = 0;
+
+        if (state->retired == NULL)
+        {
+            free(entries);
+
+            pthread_mutex_unlock(&state->lock);
+
+            return LAI_STATUS_NO_MEMORY;
+        }
+    }
+
+    if (count != 0)
+    {
+        memcpy(state->retired, entries, count * sizeof(lai_metadata_instrument_entry_t));
+    }
+
+    state->retired_count = count;
+
+    snapshot->dropped = state->retired_dropped;
+
+    for (table = state->tables; table != NULL; table = table->next)
+    {
+        count += lai_metadata_instrument_collect(table, &entries[count]);
+
+        snapshot->dropped += __atomic_load_n(&table->dropped, __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_unlock(&state->lock);
+
+    snapshot->count = lai_metadata_instrument_merge(entries, count);
+    snapshot->entries = entries;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_instrument_snapshot_free(
+        _Inout_ lai_metadata_instrument_snapshot_t *snapshot)
+{
+    if (snapshot == NULL)
+    {
+        return;
+    }
+
+    free(snapshot->entries);
+
+    memset(snapshot, 0, sizeof(*snapshot));
+}
@@ -0,0 +1,208 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatainstrument.h
+ *
+ * @brief   This module defines LAI Metadata API Instrumentation
+ */
+
+#ifndef __LAIMETADATAINSTRUMENT_H_
+#define __LAIMETADATAINSTRUMENT_H_
+
+#include <lai.h>
+
+/**
+ * @defgroup LAIMETADATAINSTRUMENT LAI - Metadata API Instrumentation Definitions
+ *
+ * Generated lai_metadata_instrument_apis() replaces method tables returned
+ * by lai_metadata_apis_query() with tables of generated wrappers. Every
+ * wrapper measures adapter call and records it per object type, operation
+ * and attribute or statistic id.
+ *
+ * Every instrumented #lai_apis_t, like tables of each API context, keeps
+ * its adapter tables in own slot of #lai_metadata_api_slots_t, so calls
+ * reach adapter tables which created linecard of object. Instrumenting
+ * more than #LAI_METADATA_API_SLOTS structs fails with
+ * #LAI_STATUS_INSUFFICIENT_RESOURCES.
+ *
+ * Every thread records into its own table without locks or atomic read
+ * modify write, snapshot merges tables of all threads.
+ *
+ * @{
+ */
+
+/**
+ * @brief Number of latency histogram buckets
+ */
+#define LAI_METADATA_INSTRUMENT_BUCKETS         32
+
+/**
+ * @brief Number of distinct failure statuses counted per entry
+ */
+#define LAI_METADATA_INSTRUMENT_STATUS_SLOTS    4
+
+/**
+ * @brief Id of entry for create, remove, and for calls with more than one
+ * attribute or statistic
+ */
+#define LAI_METADATA_INSTRUMENT_ID_ANY          0xffffffff
+
+/**
+ * @brief Instrumented operation
+ */
+typedef enum _lai_metadata_instrument_op_t
+{
+    LAI_METADATA_INSTRUMENT_OP_CREATE,
+
+    LAI_METADATA_INSTRUMENT_OP_REMOVE,
+
+    LAI_METADATA_INSTRUMENT_OP_SET,
+
+    LAI_METADATA_INSTRUMENT_OP_GET,
+
+    LAI_METADATA_INSTRUMENT_OP_GET_STATS,
+
+    LAI_METADATA_INSTRUMENT_OP_GET_STATS_EXT,
+
+    LAI_METADATA_INSTRUMENT_OP_CLEAR_STATS,
+
+} lai_metadata_instrument_op_t;
+
+/**
+ * @brief Counters of one object type, operation and id
+ */
+typedef struct _lai_metadata_instrument_entry_t
+{
+    /**
+     * @brief Object type.
+     */
+    lai_object_type_t object_type;
+
+    /**
+     * @brief Operation.
+     */
+    lai_metadata_instrument_op_t op;
+
+    /**
+     * @brief Attribute or statistic id, or #LAI_METADATA_INSTRUMENT_ID_ANY.
+     */
+    lai_attr_id_t id;
+
+    /**
+     * @brief Number of calls.
+     */
+    uint64_t calls;
+
+    /**
+     * @brief Number of calls which did not return success.
+     */
+    uint64_t errors;
+
+    /**
+     * @brief Failure statuses, first ones seen.
+     */
+    lai_status_t status[LAI_METADATA_INSTRUMENT_STATUS_SLOTS];
+
+    /**
+     * @brief Number of calls which returned status of the same index.
+     */
+    uint64_t status_count[LAI_METADATA_INSTRUMENT_STATUS_SLOTS];
+
+    /**
+     * @brief Sum of latencies in nanoseconds.
+     */
+    uint64_t total_ns;
+
+    /**
+     * @brief Maximal latency in nanoseconds.
+     */
+    uint64_t max_ns;
+
+    /**
+     * @brief Bucket N counts latencies from 2^N to 2^(N+1)-1 nanoseconds,
+     * last bucket counts all longer latencies.
+     */
+    uint64_t histogram[LAI_METADATA_INSTRUMENT_BUCKETS];
+
+} lai_metadata_instrument_entry_t;
+
+/**
+ * @brief Merged counters of all threads
+ */
+typedef struct _lai_metadata_instrument_snapshot_t
+{
+    /**
+     * @brief Number of entries.
+     */
+    size_t count;
+
+    /**
+     * @brief Entries sorted by object type, operation and id.
+     */
+    lai_metadata_instrument_entry_t *entries;
+
+    /**
+     * @brief Calls not recorded because thread table was full.
+     */
+    uint64_t dropped;
+
+} lai_metadata_instrument_snapshot_t;
+
+/**
+ * @brief Gets start time of instrumented call
+ *
+ * @return Monotonic time in nanoseconds
+ */
+extern uint64_t lai_metadata_instrument_begin(void);
+
+/**
+ * @brief Records instrumented call
+ *
+ * @param[in] object_type Object type
+ * @param[in] op Operation
+ * @param[in] id Attribute or statistic id
+ * @param[in] status Status returned by adapter
+ * @param[in] begin Value returned by lai_metadata_instrument_begin()
+ */
+extern void lai_metadata_instrument_end(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_metadata_instrument_op_t op,
+        _In_ lai_attr_id_t id,
+        _In_ lai_status_t status,
+        _In_ uint64_t begin);
+
+/**
+ * @brief Takes snapshot of counters of all threads
+ *
+ * @param[out] snapshot Snapshot, must be released by
+ * lai_metadata_instrument_snapshot_free()
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_instrument_snapshot(
+        _Out_ lai_metadata_instrument_snapshot_t *snapshot);
+
+/**
+ * @brief Releases snapshot
+ *
+ * @param[inout] snapshot Snapshot
+ */
+extern void lai_metadata_instrument_snapshot_free(
+        _Inout_ lai_metadata_instrument_snapshot_t *snapshot);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATAINSTRUMENT_H_ */
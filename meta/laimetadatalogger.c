@@ -0,0 +1,726 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatalogger.c
+ *
+ * @brief   This module implements LAI Metadata Logger
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <lai.h>
+#include "laimetadata.h"
+
+/*
+ * Deferred mode installs recorder as lai_metadata_log, so LAI_META_LOG macro
+ * is unchanged. Recorder walks format and copies every argument by its
+ * conversion into fixed size record, strings are copied into record text.
+ * Drainer walks format again and formats argument by argument.
+ *
+ * Every thread has its own single producer single consumer ring, producer
+ * publishes head and consumer publishes tail. Consumer side is serialized
+ * by ring list mutex, which producer takes only when it creates its ring.
+ */
+
+/* conversion specifications are built at runtime from recorded format */
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+
+#define LOG_RING_RECORDS    256
+#define LOG_MAX_ARGS        16
+#define LOG_TEXT_SIZE       256
+#define LOG_MESSAGE_SIZE    1024
+#define LOG_SPEC_SIZE       32
+#define LOG_DRAIN_NS        10000000L
+
+typedef enum _lai_metadata_log_arg_type_t
+{
+    LAI_METADATA_LOG_ARG_TYPE_INT,
+    LAI_METADATA_LOG_ARG_TYPE_UINT,
+    LAI_METADATA_LOG_ARG_TYPE_DOUBLE,
+    LAI_METADATA_LOG_ARG_TYPE_POINTER,
+    LAI_METADATA_LOG_ARG_TYPE_STRING,
+
+} lai_metadata_log_arg_type_t;
+
+typedef union _lai_metadata_log_arg_t
+{
+    long long s64;
+    unsigned long long u64;
+    double d64;
+    const void *ptr;
+    size_t offset;
+
+} lai_metadata_log_arg_t;
+
+typedef struct _lai_metadata_log_record_t
+{
+    lai_log_level_t log_level;
+    int line;
+    const char *file;
+    const char *function;
+    const char *format;
+
+    size_t argc;
+    lai_metadata_log_arg_t args[LOG_MAX_ARGS];
+
+    size_t textlen;
+    char text[LOG_TEXT_SIZE];
+
+} lai_metadata_log_record_t;
+
+typedef struct _lai_metadata_log_ring_t
+{
+    struct _lai_metadata_log_ring_t *next;
+
+    uint64_t head;
+    uint64_t tail;
+    uint64_t recorded;
+    uint64_t dropped;
+    uint64_t truncated;
+    bool orphaned;
+
+    lai_metadata_log_record_t records[LOG_RING_RECORDS];
+
+} lai_metadata_log_ring_t;
+
+/* specification of one conversion, star width and precision included */
+typedef struct _lai_metadata_log_spec_t
+{
+    const char *start;
+    const char *end;
+    int stars;
+    bool longdouble;
+    char conversion;
+    lai_metadata_log_arg_type_t type;
+
+} lai_metadata_log_spec_t;
+
+typedef struct _lai_metadata_log_state_t
+{
+    pthread_mutex_t lock;
+    pthread_once_t once;
+    pthread_key_t key;
+    lai_metadata_log_ring_t *rings;
+    lai_metadata_log_stats_t released;
+
+    pthread_mutex_t mode_lock;
+    lai_metadata_log_mode_t mode;
+    volatile lai_metadata_log_fn sink;
+    pthread_t drainer;
+    bool running;
+
+} lai_metadata_log_state_t;
+
+/* writable state is exported like lai_metadata_log_level, never declared */
+lai_metadata_log_state_t lai_metadata_log_state = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_ONCE_INIT, 0, NULL, { 0, 0, 0 },
+    PTHREAD_MUTEX_INITIALIZER, LAI_METADATA_LOG_MODE_SYNC, NULL, 0, false };
+
+static void lai_metadata_log_ring_release(
+        _In_ void *ring)
+{
+    __atomic_store_n(&((lai_metadata_log_ring_t*)ring)->orphaned, true, __ATOMIC_RELEASE);
+}
+
+static void lai_metadata_log_key_create(void)
+{
+    pthread_key_create(&lai_metadata_log_state.key, lai_metadata_log_ring_release);
+}
+
+static lai_metadata_log_ring_t* lai_metadata_log_ring(void)
+{
+    lai_metadata_log_ring_t *ring;
+
+    pthread_once(&lai_metadata_log_state.once, lai_metadata_log_key_create);
+
+    ring = (lai_metadata_log_ring_t*)pthread_getspecific(lai_metadata_log_state.key);
+
+    if (ring != NULL)
+    {
+        return ring;
+    }
+
+    ring = (lai_metadata_log_ring_t*)calloc(1, sizeof(lai_metadata_log_ring_t));
+
+    if (ring == NULL)
+    {
+        return NULL;
+    }
+
+    if (pthread_setspecific(lai_metadata_log_state.key, ring) != 0)
+    {
+        free(ring);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&lai_metadata_log_state.lock);
+
+    ring->next = lai_metadata_log_state.rings;
+    lai_metadata_log_state.rings = ring;
+
+    pthread_mutex_unlock(&lai_metadata_log_state.lock);
+
+    return ring;
+}
+
+/*
+ * Parses conversion specification starting after '%', returns false for
+ * conversions which are not recorded.
+ */
+static bool lai_metadata_log_parse_spec(
+        _In_ const char *ptr,
+        _Out_ lai_metadata_log_spec_t *spec)
+{
+    int longs = 0;
+    int shorts = 0;
+    char size = 0;
+
+    memset(spec, 0, sizeof(*spec));
+
+    spec->start = ptr - 1;
+
+    while (*ptr && strchr("-+ #0'", *ptr))
+    {
+        ptr++;
+    }
+
+    if (*ptr == '*')
+    {
+        spec->stars++;
+        ptr++;
+    }
+
+    while (*ptr >= '0' && *ptr <= '9')
+    {
+        ptr++;
+    }
+
+    if (*ptr == '.')
+    {
+        ptr++;
+
+        if (*ptr == '*')
+        {
+            spec->stars++;
+            ptr++;
+        }
+
+        while (*ptr >= '0' && *ptr <= '9')
+        {
+            ptr++;
+        }
+    }
+
+    while (*ptr && strchr("hlLzjtq", *ptr))
+    {
+        longs += (*ptr == 'l' || *ptr == 'q') ? 1 : 0;
+        shorts += (*ptr == 'h') ? 1 : 0;
+        size = (*ptr == 'h') ? size : *ptr;
+        spec->longdouble = spec->longdouble || (*ptr == 'L');
+        ptr++;
+    }
+
+    spec->conversion = *ptr;
+    spec->end = (*ptr) ? ptr + 1 : ptr;
+
+    switch (*ptr)
+    {
+        case 'd':
+        case 'i':
+        case 'c':
+            spec->type = LAI_METADATA_LOG_ARG_TYPE_INT;
+            break;
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            spec->type = LAI_METADATA_LOG_ARG_TYPE_UINT;
+            break;
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec->type = LAI_METADATA_LOG_ARG_TYPE_DOUBLE;
+            break;
+
+        case 'p':
+            spec->type = LAI_METADATA_LOG_ARG_TYPE_POINTER;
+            break;
+
+        case 's':
+            spec->type = LAI_METADATA_LOG_ARG_TYPE_STRING;
+            break;
+
+        default:
+            return false;
+    }
+
+    /* size is encoded into conversion for integer types */
+
+    if (spec->type == LAI_METADATA_LOG_ARG_TYPE_INT || spec->type == LAI_METADATA_LOG_ARG_TYPE_UINT)
+    {
+        spec->conversion = (char)(longs >= 2 ? 'q' : longs == 1 ? 'l' : size ? size : shorts >= 2 ? 'H' : shorts ? 'h' : 'i');
+    }
+
+    return true;
+}
+
+static void lai_metadata_log_record(
+        _In_ lai_log_level_t log_level,
+        _In_ const char *file,
+        _In_ int line,
+        _In_ const char *function,
+        _In_ const char *format,
+        _In_ ...)
+{
+    lai_metadata_log_ring_t *ring = lai_metadata_log_ring();
+    lai_metadata_log_record_t *record;
+    lai_metadata_log_spec_t spec;
+    const char *ptr;
+    const char *str;
+    uint64_t head;
+    size_t len;
+    int star;
+    va_list ap;
+
+    if (ring == NULL)
+    {
+        return;
+    }
+
+    head = ring->head;
+
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= LOG_RING_RECORDS)
+    {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    record = &ring->records[head % LOG_RING_RECORDS];
+
+    record->log_level = log_level;
+    record->file = file;
+    record->line = line;
+    record->function = function;
+    record->format = format;
+    record->argc = 0;
+    record->textlen = 0;
+
+    va_start(ap, format);
+
+    for (ptr = strchr(format, '%'); ptr != NULL; ptr = strchr(ptr, '%'))
+    {
+        if (ptr[1] == '%')
+        {
+            ptr += 2;
+            continue;
+        }
+
+        if (!lai_metadata_log_parse_spec(ptr + 1, &spec) || record->argc + (size_t)spec.stars >= LOG_MAX_ARGS)
+        {
+            /* rest of format is written as is */
+            break;
+        }
+
+        for (star = 0; star < spec.stars; star++)
+        {
+            record->args[record->argc++].s64 = va_arg(ap, int);
+        }
+
+        switch (spec.type)
+        {
+            case LAI_METADATA_LOG_ARG_TYPE_INT:
+
+                switch (spec.conversion)
+                {
+                    case 'q': record->args[record->argc].s64 = va_arg(ap, long long); break;
+                    case 'l': record->args[record->argc].s64 = va_arg(ap, long); break;
+                    case 'z': record->args[record->argc].s64 = (long long)va_arg(ap, size_t); break;
+                    case 'j': record->args[record->argc].s64 = (long long)va_arg(ap, intmax_t); break;
+                    case 't': record->args[record->argc].s64 = va_arg(ap, ptrdiff_t); break;
+                    case 'h': record->args[record->argc].s64 = (short)va_arg(ap, int); break;
+                    case 'H': record->args[record->argc].s64 = (signed char)va_arg(ap, int); break;
+                    default:  record->args[record->argc].s64 = va_arg(ap, int); break;
+                }
+                break;
+
+            case LAI_METADATA_LOG_ARG_TYPE_UINT:
+
+                switch (spec.conversion)
+                {
+                    case 'q': record->args[record->argc].u64 = va_arg(ap, unsigned long long); break;
+                    case 'l': record->args[record->argc].u64 = va_arg(ap, unsigned long); break;
+                    case 'z': record->args[record->argc].u64 = va_arg(ap, size_t); break;
+                    case 'j': record->args[record->argc].u64 = va_arg(ap, uintmax_t); break;
+                    case 't': record->args[record->argc].u64 = (unsigned long long)va_arg(ap, ptrdiff_t); break;
+                    case 'h': record->args[record->argc].u64 = (unsigned short)va_arg(ap, unsigned int); break;
+                    case 'H': record->args[record->argc].u64 = (unsigned char)va_arg(ap, unsigned int); break;
+                    default:  record->args[record->argc].u64 = va_arg(ap, unsigned int); break;
+                }
+                break;
+
+            case LAI_METADATA_LOG_ARG_TYPE_DOUBLE:
+
+                record->args[record->argc].d64 = spec.longdouble ? (double)va_arg(ap, long double) : va_arg(ap, double);
+                break;
+
+            case LAI_METADATA_LOG_ARG_TYPE_POINTER:
+
+                record->args[record->argc].ptr = va_arg(ap, const void*);
+                break;
+
+            case LAI_METADATA_LOG_ARG_TYPE_STRING:
+            default:
+
+                str = va_arg(ap, const char*);
+                str = (str == NULL) ? "(null)" : str;
+                len = strlen(str);
+
+                if (record->textlen + len + 1 > LOG_TEXT_SIZE)
+                {
+                    len = LOG_TEXT_SIZE - record->textlen - 1;
+
+                    __atomic_store_n(&ring->truncated, ring->truncated + 1, __ATOMIC_RELAXED);
+                }
+
+                memcpy(record->text + record->textlen, str, len);
+
+                record->args[record->argc].offset = record->textlen;
+                record->textlen += len;
+                record->text[record->textlen++] = 0;
+                break;
+        }
+
+        record->argc++;
+        ptr = spec.end;
+    }
+
+    va_end(ap);
+
+    __atomic_store_n(&ring->recorded, ring->recorded + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void lai_metadata_log_format(
+        _In_ const lai_metadata_log_record_t *record,
+        _Out_ char *message,
+        _In_ size_t size)
+{
+    lai_metadata_log_spec_t spec;
+    char buffer[LOG_SPEC_SIZE];
+    const char *ptr = record->format;
+    const char *next;
+    size_t pos = 0;
+    size_t argc = 0;
+    size_t len;
+    int star[2];
+    int written;
+    bool escaped;
+    char *out;
+
+    message[0] = 0;
+
+    while (*ptr && pos + 1 < size)
+    {
+        next = strchr(ptr, '%');
+        escaped = (next != NULL && next[1] == '%');
+
+        if (escaped)
+        {
+            /* escaped percent, copied with text before it */
+            next++;
+        }
+        else if (next != NULL && (!lai_metadata_log_parse_spec(next + 1, &spec) || argc + (size_t)spec.stars >= record->argc))
+        {
+            /* recorder stopped here, rest of format is written as is */
+            next = NULL;
+        }
+
+        len = (next == NULL) ? strlen(ptr) : (size_t)(next - ptr);
+        len = (len < size - pos - 1) ? len : size - pos - 1;
+
+        memcpy(message + pos, ptr, len);
+        pos += len;
+        message[pos] = 0;
+
+        if (next == NULL)
+        {
+            break;
+        }
+
+        if (escaped)
+        {
+            ptr = next + 1;
+            continue;
+        }
+
+        /* specification without length modifiers, star values inlined */
+
+        out = buffer;
+        len = 0;
+        star[0] = (spec.stars > 0) ? (int)record->args[argc].s64 : 0;
+        star[1] = (spec.stars > 1) ? (int)record->args[argc + 1].s64 : 0;
+        argc += (size_t)spec.stars;
+
+        for (next = spec.start; next < spec.end - 1 && len + 12 < LOG_SPEC_SIZE; next++)
+        {
+            if (*next == '*')
+            {
+                len += (size_t)snprintf(out + len, LOG_SPEC_SIZE - len, "%d", star[out[len - 1] == '.' ? spec.stars - 1 : 0]);
+            }
+            else if (!strchr("hlLzjtq", *next))
+            {
+                out[len++] = *next;
+            }
+        }
+
+        if ((spec.type == LAI_METADATA_LOG_ARG_TYPE_INT || spec.type == LAI_METADATA_LOG_ARG_TYPE_UINT) && spec.end[-1] != 'c')
+        {
+            out[len++] = 'l';
+            out[len++] = 'l';
+        }
+
+        out[len++] = spec.end[-1];
+        out[len] = 0;
+
+        switch (spec.type)
+        {
+            case LAI_METADATA_LOG_ARG_TYPE_INT:
+                written = (spec.end[-1] == 'c') ?
+                    snprintf(message + pos, size - pos, buffer, (int)record->args[argc].s64) :
+                    snprintf(message + pos, size - pos, buffer, record->args[argc].s64);
+                break;
+
+            case LAI_METADATA_LOG_ARG_TYPE_UINT:
+                written = snprintf(message + pos, size - pos, buffer, record->args[argc].u64);
+                break;
+
+            case LAI_METADATA_LOG_ARG_TYPE_DOUBLE:
+                written = snprintf(message + pos, size - pos, buffer, record->args[argc].d64);
+                break;
+
+            case LAI_METADATA_LOG_ARG_TYPE_POINTER:
+                written = snprintf(message + pos, size - pos, buffer, record->args[argc].ptr);
+                break;
+
+            case LAI_METADATA_LOG_ARG_TYPE_STRING:
+            default:
+                written = snprintf(message + pos, size - pos, buffer, record->text + record->args[argc].offset);
+                break;
+        }
+
+        if (written > 0)
+        {
+            pos += ((size_t)written < size - pos) ? (size_t)written : size - pos - 1;
+        }
+
+        argc++;
+        ptr = spec.end;
+    }
+}
+
+static void lai_metadata_log_write(
+        _In_ const lai_metadata_log_record_t *record)
+{
+    char message[LOG_MESSAGE_SIZE];
+    lai_metadata_log_fn sink = lai_metadata_log_state.sink;
+
+    lai_metadata_log_format(record, message, sizeof(message));
+
+    if (sink == NULL)
+    {
+        fprintf(stderr, "%s:%d %s: %s\n", record->file, record->line, record->function, message);
+    }
+    else
+    {
+        sink(record->log_level, record->file, record->line, record->function, "%s", message);
+    }
+}
+
+static void lai_metadata_log_drain(void)
+{
+    lai_metadata_log_ring_t **link;
+    lai_metadata_log_ring_t *ring;
+    uint64_t head;
+    bool orphaned;
+
+    pthread_mutex_lock(&lai_metadata_log_state.lock);
+
+    link = &lai_metadata_log_state.rings;
+
+    while ((ring = *link) != NULL)
+    {
+        /* read orphaned first, thread does not record after it is set */
+
+        orphaned = __atomic_load_n(&ring->orphaned, __ATOMIC_ACQUIRE);
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+        for (; ring->tail != head; )
+        {
+            lai_metadata_log_write(&ring->records[ring->tail % LOG_RING_RECORDS]);
+
+            __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+        }
+
+        if (orphaned)
+        {
+            lai_metadata_log_state.released.recorded += ring->recorded;
+            lai_metadata_log_state.released.dropped += ring->dropped;
+            lai_metadata_log_state.released.truncated += ring->truncated;
+
+            *link = ring->next;
+
+            free(ring);
+            continue;
+        }
+
+        link = &ring->next;
+    }
+
+    pthread_mutex_unlock(&lai_metadata_log_state.lock);
+}
+
+static void* lai_metadata_log_drainer_run(
+        _In_ void *arg)
+{
+    struct timespec ts;
+
+    ts.tv_sec = 0;
+    ts.tv_nsec = LOG_DRAIN_NS;
+
+    while (__atomic_load_n(&lai_metadata_log_state.running, __ATOMIC_ACQUIRE))
+    {
+        lai_metadata_log_drain();
+
+        nanosleep(&ts, NULL);
+    }
+
+    lai_metadata_log_drain();
+
+    return NULL;
+}
+
+void lai_metadata_log_set_level(
+        _In_ lai_log_level_t log_level)
+{
+    lai_metadata_log_level = log_level;
+}
+
+void lai_metadata_log_set_sink(
+        _In_ lai_metadata_log_fn sink)
+{
+    pthread_mutex_lock(&lai_metadata_log_state.mode_lock);
+
+    lai_metadata_log_state.sink = sink;
+
+    if (lai_metadata_log_state.mode == LAI_METADATA_LOG_MODE_SYNC)
+    {
+        lai_metadata_log = sink;
+    }
+
+    pthread_mutex_unlock(&lai_metadata_log_state.mode_lock);
+}
+
+lai_status_t lai_metadata_log_set_mode(
+        _In_ lai_metadata_log_mode_t mode)
+{
+    lai_status_t status = LAI_STATUS_SUCCESS;
+
+    pthread_mutex_lock(&lai_metadata_log_state.mode_lock);
+
+    if (mode == lai_metadata_log_state.mode)
+    {
+        pthread_mutex_unlock(&lai_metadata_log_state.mode_lock);
+        return LAI_STATUS_SUCCESS;
+    }
+
+    switch (mode)
+    {
+        case LAI_METADATA_LOG_MODE_DEFERRED:
+
+            lai_metadata_log_state.running = true;
+
+            if (pthread_create(&lai_metadata_log_state.drainer, NULL, lai_metadata_log_drainer_run, NULL) != 0)
+            {
+                lai_metadata_log_state.running = false;
+                status = LAI_STATUS_FAILURE;
+                break;
+            }
+
+            lai_metadata_log = lai_metadata_log_record;
+            lai_metadata_log_state.mode = mode;
+            break;
+
+        case LAI_METADATA_LOG_MODE_SYNC:
+
+            /* threads which already read recorder still finish recording */
+
+            lai_metadata_log = lai_metadata_log_state.sink;
+            __atomic_store_n(&lai_metadata_log_state.running, false, __ATOMIC_RELEASE);
+
+            pthread_join(lai_metadata_log_state.drainer, NULL);
+
+            lai_metadata_log_state.mode = mode;
+            break;
+
+        default:
+
+            LAI_META_LOG_ERROR("invalid log mode %d", mode);
+
+            status = LAI_STATUS_INVALID_PARAMETER;
+            break;
+    }
+
+    pthread_mutex_unlock(&lai_metadata_log_state.mode_lock);
+
+    return status;
+}
+
+void lai_metadata_log_flush(void)
+{
+    lai_metadata_log_drain();
+}
+
+void lai_metadata_log_get_stats(
+        _Out_ lai_metadata_log_stats_t *stats)
+{
+    const lai_metadata_log_ring_t *ring;
+
+    pthread_mutex_lock(&lai_metadata_log_state.lock);
+
+    *stats = lai_metadata_log_state.released;
+
+    for (ring = lai_metadata_log_state.rings; ring != NULL; ring = ring->next)
+    {
+        stats->recorded += __atomic_load_n(&ring->recorded, __ATOMIC_RELAXED);
+        stats->dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+        stats->truncated += __atomic_load_n(&ring->truncated, __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_unlock(&lai_metadata_log_state.lock);
+}
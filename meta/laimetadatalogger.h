@@ -51,16 +51,16 @@ typedef void (*lai_metadata_log_fn)(
 /**
  * @brief User specified log function.
  *
- * TODO: add a set function to update this?
+ * Prefer lai_metadata_log_set_sink(), in deferred mode this points to
+ * recorder of log ring.
  */
 extern volatile lai_metadata_log_fn lai_metadata_log;
 
 /**
  * @brief Log level for LAI metadata macros.
  *
- * Log level can be changed by user at any time.
- *
- * TODO: add a set function to update this?
+ * Log level can be changed by user at any time, see
+ * lai_metadata_log_set_level().
  */
 extern volatile lai_log_level_t lai_metadata_log_level;
 
@@ -79,6 +79,95 @@ extern volatile lai_log_level_t lai_metadata_log_level;
         lai_metadata_log(loglevel, __FILE__, __LINE__, __func__, format, ##__VA_ARGS__);\
 }
 
+/**
+ * @brief Log delivery mode
+ */
+typedef enum _lai_metadata_log_mode_t
+{
+    /**
+     * @brief Message is formatted and written by calling thread
+     */
+    LAI_METADATA_LOG_MODE_SYNC,
+
+    /**
+     * @brief Message is recorded into ring of calling thread
+     *
+     * Calling thread only copies format pointer and raw arguments, string
+     * arguments are copied and may be truncated. Background thread formats
+     * messages and passes them to sink. Message is dropped when ring of
+     * calling thread is full.
+     */
+    LAI_METADATA_LOG_MODE_DEFERRED,
+
+} lai_metadata_log_mode_t;
+
+/**
+ * @brief Log statistics
+ */
+typedef struct _lai_metadata_log_stats_t
+{
+    /**
+     * @brief Messages recorded into rings.
+     */
+    uint64_t recorded;
+
+    /**
+     * @brief Messages dropped because ring was full.
+     */
+    uint64_t dropped;
+
+    /**
+     * @brief Messages with truncated string arguments.
+     */
+    uint64_t truncated;
+
+} lai_metadata_log_stats_t;
+
+/**
+ * @brief Sets log level for LAI metadata macros
+ *
+ * @param[in] log_level Log level
+ */
+extern void lai_metadata_log_set_level(
+        _In_ lai_log_level_t log_level);
+
+/**
+ * @brief Sets log sink
+ *
+ * Sink receives formatted messages in both modes, NULL sink writes
+ * messages to stderr.
+ *
+ * @param[in] sink Log function
+ */
+extern void lai_metadata_log_set_sink(
+        _In_ lai_metadata_log_fn sink);
+
+/**
+ * @brief Sets log delivery mode
+ *
+ * Switching to synchronous mode stops background thread after it drains
+ * all rings.
+ *
+ * @param[in] mode Log mode
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_log_set_mode(
+        _In_ lai_metadata_log_mode_t mode);
+
+/**
+ * @brief Formats and writes all recorded messages in calling thread
+ */
+extern void lai_metadata_log_flush(void);
+
+/**
+ * @brief Gets log statistics
+ *
+ * @param[out] stats Log statistics
+ */
+extern void lai_metadata_log_get_stats(
+        _Out_ lai_metadata_log_stats_t *stats);
+
 /*
  * Helper macros.
  */
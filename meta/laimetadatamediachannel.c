@@ -0,0 +1,865 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatamediachannel.c
+ *
+ * @brief   This module implements LAI Metadata Media Channel Planner
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <lai.h>
+#include "laimetadatamediachannel.h"
+#include "laimetadata.h"
+
+/*
+ * Interval tree is implicit over channels sorted by lower frequency, node
+ * of slice [lo, hi) is its middle entry and keeps highest upper frequency
+ * of slice. Query skips subtree ending below range and stops at entry
+ * starting above range, so it visits O(log n) nodes plus found overlaps.
+ */
+
+#define LAI_METADATA_MEDIACHANNEL_PORT_SIZE sizeof(((lai_attribute_value_t*)NULL)->chardata)
+
+typedef struct _lai_metadata_mediachannel_entry_t
+{
+    lai_uint64_t lower;
+
+    lai_uint64_t upper;
+
+    size_t index;
+
+} lai_metadata_mediachannel_entry_t;
+
+typedef struct _lai_metadata_mediachannel_id_t
+{
+    uint32_t id;
+
+    size_t index;
+
+} lai_metadata_mediachannel_id_t;
+
+typedef struct _lai_metadata_mediachannel_info_t
+{
+    lai_uint64_t lower;
+
+    lai_uint64_t upper;
+
+    const char *source;
+
+    const char *dest;
+
+    uint32_t id;
+
+    uint32_t parent;
+
+    bool has_id;
+
+    bool has_lower;
+
+    bool has_upper;
+
+    bool has_parent;
+
+    bool super_channel;
+
+} lai_metadata_mediachannel_info_t;
+
+typedef struct _lai_metadata_mediachannel_state_t
+{
+    lai_metadata_mediachannel_info_t *infos;
+
+    /* channels with valid frequency range sorted by lower frequency */
+
+    lai_metadata_mediachannel_entry_t *entries;
+
+    size_t entry_count;
+
+    /* highest upper frequency of tree slice, indexed as entries */
+
+    lai_uint64_t *max_upper;
+
+    /* channel indexes in create order */
+
+    size_t *order;
+
+} lai_metadata_mediachannel_state_t;
+
+typedef struct _lai_metadata_mediachannel_collector_t
+{
+    size_t *positions;
+
+    size_t capacity;
+
+    size_t count;
+
+    bool grow;
+
+} lai_metadata_mediachannel_collector_t;
+
+static int lai_metadata_mediachannel_entry_cmp(
+        _In_ const void *lhs,
+        _In_ const void *rhs)
+{
+    const lai_metadata_mediachannel_entry_t *l = (const lai_metadata_mediachannel_entry_t*)lhs;
+    const lai_metadata_mediachannel_entry_t *r = (const lai_metadata_mediachannel_entry_t*)rhs;
+
+    if (l->lower != r->lower)
+    {
+        return (l->lower > r->lower) - (l->lower < r->lower);
+    }
+
+    if (l->upper != r->upper)
+    {
+        return (l->upper > r->upper) - (l->upper < r->upper);
+    }
+
+    return (l->index > r->index) - (l->index < r->index);
+}
+
+static int lai_metadata_mediachannel_id_cmp(
+        _In_ const void *lhs,
+        _In_ const void *rhs)
+{
+    const lai_metadata_mediachannel_id_t *l = (const lai_metadata_mediachannel_id_t*)lhs;
+    const lai_metadata_mediachannel_id_t *r = (const lai_metadata_mediachannel_id_t*)rhs;
+
+    if (l->id != r->id)
+    {
+        return (l->id > r->id) - (l->id < r->id);
+    }
+
+    return (l->index > r->index) - (l->index < r->index);
+}
+
+static int lai_metadata_mediachannel_conflict_cmp(
+        _In_ const void *lhs,
+        _In_ const void *rhs)
+{
+    const lai_metadata_mediachannel_conflict_t *l = (const lai_metadata_mediachannel_conflict_t*)lhs;
+    const lai_metadata_mediachannel_conflict_t *r = (const lai_metadata_mediachannel_conflict_t*)rhs;
+
+    if (l->index != r->index)
+    {
+        return (l->index > r->index) - (l->index < r->index);
+    }
+
+    if (l->other != r->other)
+    {
+        return (l->other > r->other) - (l->other < r->other);
+    }
+
+    return (l->kind > r->kind) - (l->kind < r->kind);
+}
+
+static lai_status_t lai_metadata_mediachannel_extract(
+        _In_ const lai_metadata_mediachannel_t *channel,
+        _Out_ lai_metadata_mediachannel_info_t *info)
+{
+    const lai_attr_metadata_t *md;
+    uint32_t idx;
+
+    memset(info, 0, sizeof(*info));
+
+    if (channel->attr_count != 0 && channel->attr_list == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < channel->attr_count; idx++)
+    {
+        const lai_attribute_t *attr = &channel->attr_list[idx];
+
+        md = lai_metadata_get_attr_metadata(LAI_OBJECT_TYPE_MEDIACHANNEL, attr->id);
+
+        if (md == NULL)
+        {
+            LAI_META_LOG_ERROR("unknown media channel attribute 0x%x", attr->id);
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+
+        switch (attr->id)
+        {
+            case LAI_MEDIACHANNEL_ATTR_ID:
+                info->id = attr->value.u32;
+                info->has_id = true;
+                break;
+
+            case LAI_MEDIACHANNEL_ATTR_LOWER_FREQUENCY:
+                info->lower = attr->value.u64;
+                info->has_lower = true;
+                break;
+
+            case LAI_MEDIACHANNEL_ATTR_UPPER_FREQUENCY:
+                info->upper = attr->value.u64;
+                info->has_upper = true;
+                break;
+
+            case LAI_MEDIACHANNEL_ATTR_SUPER_CHANNEL:
+                info->super_channel = attr->value.booldata;
+                break;
+
+            case LAI_MEDIACHANNEL_ATTR_SUPER_CHANNEL_PARENT:
+                info->parent = attr->value.u32;
+                info->has_parent = true;
+                break;
+
+            case LAI_MEDIACHANNEL_ATTR_SOURCE_PORT_NAME:
+                info->source = attr->value.chardata;
+                break;
+
+            case LAI_MEDIACHANNEL_ATTR_DEST_PORT_NAME:
+                info->dest = attr->value.chardata;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static bool lai_metadata_mediachannel_valid_frequency(
+        _In_ const lai_metadata_mediachannel_info_t *info)
+{
+    return info->has_lower && info->has_upper && info->lower < info->upper;
+}
+
+static bool lai_metadata_mediachannel_valid_port(
+        _In_ const char *port)
+{
+    return port != NULL && port[0] != '\0';
+}
+
+static bool lai_metadata_mediachannel_same_port(
+        _In_ const char *lhs,
+        _In_ const char *rhs)
+{
+    return lai_metadata_mediachannel_valid_port(lhs) && lai_metadata_mediachannel_valid_port(rhs) &&
+        strncmp(lhs, rhs, LAI_METADATA_MEDIACHANNEL_PORT_SIZE) == 0;
+}
+
+static size_t lai_metadata_mediachannel_root(
+        _In_ size_t lo,
+        _In_ size_t hi)
+{
+    return lo + (hi - lo) / 2;
+}
+
+static lai_uint64_t lai_metadata_mediachannel_tree_build(
+        _Inout_ lai_metadata_mediachannel_state_t *state,
+        _In_ size_t lo,
+        _In_ size_t hi)
+{
+    size_t mid = lai_metadata_mediachannel_root(lo, hi);
+    lai_uint64_t max = state->entries[mid].upper;
+    lai_uint64_t sub;
+
+    if (lo < mid)
+    {
+        sub = lai_metadata_mediachannel_tree_build(state, lo, mid);
+        max = sub > max ? sub : max;
+    }
+
+    if (mid + 1 < hi)
+    {
+        sub = lai_metadata_mediachannel_tree_build(state, mid + 1, hi);
+        max = sub > max ? sub : max;
+    }
+
+    state->max_upper[mid] = max;
+
+    return max;
+}
+
+static lai_status_t lai_metadata_mediachannel_collect(
+        _Inout_ lai_metadata_mediachannel_collector_t *collector,
+        _In_ size_t position)
+{
+    if (collector->count == collector->capacity && collector->grow)
+    {
+        size_t capacity = collector->capacity == 0 ? 16 : collector->capacity * 2;
+        size_t *positions = (size_t*)realloc(collector->positions, capacity * sizeof(size_t));
+
+        if (positions == NULL)
+        {
+            return LAI_STATUS_NO_MEMORY;
+        }
+
+        collector->positions = positions;
+        collector->capacity = capacity;
+    }
+
+    if (collector->count < collector->capacity)
+    {
+        collector->positions[collector->count] = position;
+    }
+
+    collector->count++;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+/*
+ * Collects entries at position from and above overlapping range, in order
+ * of lower frequency.
+ */
+
+static lai_status_t lai_metadata_mediachannel_tree_query(
+        _In_ const lai_metadata_mediachannel_state_t *state,
+        _In_ size_t lo,
+        _In_ size_t hi,
+        _In_ size_t from,
+        _In_ lai_uint64_t lower,
+        _In_ lai_uint64_t upper,
+        _Inout_ lai_metadata_mediachannel_collector_t *collector)
+{
+    size_t mid;
+    lai_status_t status;
+
+    if (lo >= hi || hi <= from)
+    {
+        return LAI_STATUS_SUCCESS;
+    }
+
+    mid = lai_metadata_mediachannel_root(lo, hi);
+
+    if (state->max_upper[mid] <= lower)
+    {
+        return LAI_STATUS_SUCCESS;
+    }
+
+    status = lai_metadata_mediachannel_tree_query(state, lo, mid, from, lower, upper, collector);
+
+    if (status != LAI_STATUS_SUCCESS || state->entries[mid].lower >= upper)
+    {
+        return status;
+    }
+
+    if (mid >= from && state->entries[mid].upper > lower)
+    {
+        status = lai_metadata_mediachannel_collect(collector, mid);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return lai_metadata_mediachannel_tree_query(state, mid + 1, hi, from, lower, upper, collector);
+}
+
+static lai_status_t lai_metadata_mediachannel_conflict(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _Inout_ size_t *capacity,
+        _In_ lai_metadata_mediachannel_conflict_kind_t kind,
+        _In_ size_t index,
+        _In_ size_t other)
+{
+    lai_metadata_mediachannel_conflict_t *conflict;
+
+    if (plan->conflict_count == *capacity)
+    {
+        size_t size = *capacity == 0 ? 16 : *capacity * 2;
+        lai_metadata_mediachannel_conflict_t *conflicts;
+
+        conflicts = (lai_metadata_mediachannel_conflict_t*)realloc(plan->conflicts,
+                size * sizeof(lai_metadata_mediachannel_conflict_t));
+
+        if (conflicts == NULL)
+        {
+            return LAI_STATUS_NO_MEMORY;
+        }
+
+        plan->conflicts = conflicts;
+        *capacity = size;
+    }
+
+    conflict = &plan->conflicts[plan->conflict_count++];
+
+    /* pair of equal channels is reported once, parent conflict is reported on channel */
+
+    conflict->kind = kind;
+    conflict->index = (kind == LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_PARENT || index < other) ? index : other;
+    conflict->other = conflict->index == index ? other : index;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+/*
+ * Parent is looked up by binary search in ID sorted channels, duplicate ID
+ * is already conflict, so the first channel with ID is taken.
+ */
+
+static size_t lai_metadata_mediachannel_find_id(
+        _In_ const lai_metadata_mediachannel_id_t *ids,
+        _In_ size_t count,
+        _In_ uint32_t id)
+{
+    size_t lo = 0;
+    size_t hi = count;
+
+    while (lo < hi)
+    {
+        size_t mid = lai_metadata_mediachannel_root(lo, hi);
+
+        if (ids[mid].id < id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static lai_status_t lai_metadata_mediachannel_check_ids(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _Inout_ size_t *capacity,
+        _In_ const lai_metadata_mediachannel_state_t *state,
+        _Out_ size_t *parents)
+{
+    lai_metadata_mediachannel_id_t *ids;
+    const lai_metadata_mediachannel_info_t *info;
+    lai_status_t status = LAI_STATUS_SUCCESS;
+    size_t id_count = 0;
+    size_t idx;
+    size_t pos;
+
+    ids = (lai_metadata_mediachannel_id_t*)malloc((plan->count + 1) * sizeof(lai_metadata_mediachannel_id_t));
+
+    if (ids == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < plan->count && status == LAI_STATUS_SUCCESS; idx++)
+    {
+        if (state->infos[idx].has_id)
+        {
+            ids[id_count].id = state->infos[idx].id;
+            ids[id_count].index = idx;
+            id_count++;
+        }
+        else
+        {
+            status = lai_metadata_mediachannel_conflict(plan, capacity, LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_ID, idx, idx);
+        }
+    }
+
+    qsort(ids, id_count, sizeof(lai_metadata_mediachannel_id_t), lai_metadata_mediachannel_id_cmp);
+
+    for (pos = 1; pos < id_count && status == LAI_STATUS_SUCCESS; pos++)
+    {
+        if (ids[pos].id == ids[pos - 1].id)
+        {
+            status = lai_metadata_mediachannel_conflict(plan, capacity, LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_ID,
+                    ids[pos].index, ids[pos - 1].index);
+        }
+    }
+
+    for (idx = 0; idx < plan->count && status == LAI_STATUS_SUCCESS; idx++)
+    {
+        info = &state->infos[idx];
+
+        parents[idx] = plan->count;
+
+        if (!info->has_parent)
+        {
+            continue;
+        }
+
+        pos = lai_metadata_mediachannel_find_id(ids, id_count, info->parent);
+
+        if (pos < id_count && ids[pos].id == info->parent && ids[pos].index != idx)
+        {
+            const lai_metadata_mediachannel_info_t *parent = &state->infos[ids[pos].index];
+
+            parents[idx] = ids[pos].index;
+
+            if (parent->super_channel &&
+                    (!lai_metadata_mediachannel_valid_frequency(info) || !lai_metadata_mediachannel_valid_frequency(parent) ||
+                     (parent->lower <= info->lower && info->upper <= parent->upper)))
+            {
+                continue;
+            }
+
+            status = lai_metadata_mediachannel_conflict(plan, capacity, LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_PARENT,
+                    idx, ids[pos].index);
+        }
+        else
+        {
+            status = lai_metadata_mediachannel_conflict(plan, capacity, LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_PARENT, idx, idx);
+        }
+    }
+
+    free(ids);
+
+    return status;
+}
+
+static lai_status_t lai_metadata_mediachannel_check_overlaps(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _Inout_ size_t *capacity,
+        _In_ const lai_metadata_mediachannel_state_t *state,
+        _In_ const size_t *parents)
+{
+    lai_metadata_mediachannel_collector_t collector;
+    lai_status_t status = LAI_STATUS_SUCCESS;
+    size_t pos;
+    size_t idx;
+
+    memset(&collector, 0, sizeof(collector));
+
+    collector.grow = true;
+
+    for (pos = 0; pos < state->entry_count && status == LAI_STATUS_SUCCESS; pos++)
+    {
+        const lai_metadata_mediachannel_entry_t *entry = &state->entries[pos];
+        const lai_metadata_mediachannel_info_t *info = &state->infos[entry->index];
+
+        collector.count = 0;
+
+        status = lai_metadata_mediachannel_tree_query(state, 0, state->entry_count, pos + 1,
+                entry->lower, entry->upper, &collector);
+
+        for (idx = 0; idx < collector.count && status == LAI_STATUS_SUCCESS; idx++)
+        {
+            size_t other = state->entries[collector.positions[idx]].index;
+            const lai_metadata_mediachannel_info_t *overlap = &state->infos[other];
+
+            if (parents[entry->index] == other || parents[other] == entry->index)
+            {
+                continue;
+            }
+
+            if (lai_metadata_mediachannel_same_port(info->source, overlap->source) ||
+                    lai_metadata_mediachannel_same_port(info->dest, overlap->dest))
+            {
+                status = lai_metadata_mediachannel_conflict(plan, capacity, LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_OVERLAP,
+                        entry->index, other);
+            }
+        }
+    }
+
+    free(collector.positions);
+
+    return status;
+}
+
+static lai_status_t lai_metadata_mediachannel_validate(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _Inout_ lai_metadata_mediachannel_state_t *state)
+{
+    size_t capacity = 0;
+    size_t *parents;
+    size_t idx;
+    size_t created = 0;
+    lai_status_t status = LAI_STATUS_SUCCESS;
+
+    for (idx = 0; idx < plan->count && status == LAI_STATUS_SUCCESS; idx++)
+    {
+        const lai_metadata_mediachannel_info_t *info = &state->infos[idx];
+
+        if (lai_metadata_mediachannel_valid_frequency(info))
+        {
+            state->entries[state->entry_count].lower = info->lower;
+            state->entries[state->entry_count].upper = info->upper;
+            state->entries[state->entry_count].index = idx;
+            state->entry_count++;
+        }
+        else
+        {
+            status = lai_metadata_mediachannel_conflict(plan, &capacity, LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_FREQUENCY, idx, idx);
+        }
+
+        if (status == LAI_STATUS_SUCCESS &&
+                (!lai_metadata_mediachannel_valid_port(info->source) || !lai_metadata_mediachannel_valid_port(info->dest) ||
+                 lai_metadata_mediachannel_same_port(info->source, info->dest)))
+        {
+            status = lai_metadata_mediachannel_conflict(plan, &capacity, LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_PORT, idx, idx);
+        }
+    }
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    qsort(state->entries, state->entry_count, sizeof(lai_metadata_mediachannel_entry_t), lai_metadata_mediachannel_entry_cmp);
+
+    if (state->entry_count != 0)
+    {
+        lai_metadata_mediachannel_tree_build(state, 0, state->entry_count);
+    }
+
+    parents = (size_t*)malloc((plan->count + 1) * sizeof(size_t));
+
+    if (parents == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    status = lai_metadata_mediachannel_check_ids(plan, &capacity, state, parents);
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        status = lai_metadata_mediachannel_check_overlaps(plan, &capacity, state, parents);
+    }
+
+    /* super channel parents are created before their channels */
+
+    for (idx = 0; idx < plan->count; idx++)
+    {
+        if (parents[idx] == plan->count)
+        {
+            state->order[created++] = idx;
+        }
+    }
+
+    for (idx = 0; idx < plan->count; idx++)
+    {
+        if (parents[idx] != plan->count)
+        {
+            state->order[created++] = idx;
+        }
+    }
+
+    free(parents);
+
+    if (status == LAI_STATUS_SUCCESS && plan->conflict_count != 0)
+    {
+        qsort(plan->conflicts, plan->conflict_count, sizeof(lai_metadata_mediachannel_conflict_t),
+                lai_metadata_mediachannel_conflict_cmp);
+    }
+
+    return status;
+}
+
+lai_status_t lai_metadata_mediachannel_plan(
+        _In_ size_t count,
+        _In_ const lai_metadata_mediachannel_t *channels,
+        _Out_ lai_metadata_mediachannel_plan_t *plan)
+{
+    lai_metadata_mediachannel_state_t *state;
+    lai_status_t status;
+    size_t idx;
+
+    if (plan == NULL || (count != 0 && channels == NULL))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: channels or plan");
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(plan, 0, sizeof(*plan));
+
+    plan->count = count;
+    plan->channels = channels;
+
+    state = (lai_metadata_mediachannel_state_t*)calloc(1, sizeof(lai_metadata_mediachannel_state_t));
+
+    if (state == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    plan->state = state;
+
+    state->infos = (lai_metadata_mediachannel_info_t*)malloc((count + 1) * sizeof(lai_metadata_mediachannel_info_t));
+    state->entries = (lai_metadata_mediachannel_entry_t*)malloc((count + 1) * sizeof(lai_metadata_mediachannel_entry_t));
+    state->max_upper = (lai_uint64_t*)malloc((count + 1) * sizeof(lai_uint64_t));
+    state->order = (size_t*)malloc((count + 1) * sizeof(size_t));
+    plan->object_ids = (lai_object_id_t*)calloc(count + 1, sizeof(lai_object_id_t));
+
+    if (state->infos == NULL || state->entries == NULL || state->max_upper == NULL ||
+            state->order == NULL || plan->object_ids == NULL)
+    {
+        lai_metadata_mediachannel_plan_free(plan);
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < count; idx++)
+    {
+        status = lai_metadata_mediachannel_extract(&channels[idx], &state->infos[idx]);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            LAI_META_LOG_ERROR("invalid media channel %zu", idx);
+
+            lai_metadata_mediachannel_plan_free(plan);
+            return status;
+        }
+    }
+
+    status = lai_metadata_mediachannel_validate(plan, state);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        lai_metadata_mediachannel_plan_free(plan);
+    }
+
+    return status;
+}
+
+lai_status_t lai_metadata_mediachannel_plan_query(
+        _In_ const lai_metadata_mediachannel_plan_t *plan,
+        _In_ lai_uint64_t lower_frequency,
+        _In_ lai_uint64_t upper_frequency,
+        _Inout_ size_t *count,
+        _Out_ size_t *indexes)
+{
+    const lai_metadata_mediachannel_state_t *state;
+    lai_metadata_mediachannel_collector_t collector;
+    lai_status_t status = LAI_STATUS_SUCCESS;
+    size_t idx;
+
+    if (plan == NULL || plan->state == NULL || count == NULL || (*count != 0 && indexes == NULL))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: plan, count or indexes");
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    state = (const lai_metadata_mediachannel_state_t*)plan->state;
+
+    memset(&collector, 0, sizeof(collector));
+
+    collector.positions = indexes;
+    collector.capacity = *count;
+
+    if (lower_frequency < upper_frequency && state->entry_count != 0)
+    {
+        status = lai_metadata_mediachannel_tree_query(state, 0, state->entry_count, 0,
+                lower_frequency, upper_frequency, &collector);
+    }
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    /* positions are replaced by channel indexes in place */
+
+    for (idx = 0; idx < collector.count && idx < collector.capacity; idx++)
+    {
+        indexes[idx] = state->entries[indexes[idx]].index;
+    }
+
+    status = collector.count > *count ? LAI_STATUS_BUFFER_OVERFLOW : LAI_STATUS_SUCCESS;
+
+    *count = collector.count;
+
+    return status;
+}
+
+lai_status_t lai_metadata_mediachannel_plan_apply(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _In_ lai_object_id_t linecard_id,
+        _Out_ size_t *failed)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(LAI_OBJECT_TYPE_MEDIACHANNEL);
+    const lai_metadata_mediachannel_state_t *state;
+    lai_object_meta_key_t meta_key;
+    lai_status_t status;
+    size_t idx;
+    size_t pos;
+
+    if (plan == NULL || plan->state == NULL || failed == NULL || info == NULL)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: plan or failed");
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (plan->conflict_count != 0)
+    {
+        LAI_META_LOG_ERROR("media channel plan has %zu conflicts", plan->conflict_count);
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    state = (const lai_metadata_mediachannel_state_t*)plan->state;
+
+    for (pos = 0; pos < plan->count; pos++)
+    {
+        idx = state->order[pos];
+
+        memset(&meta_key, 0, sizeof(meta_key));
+
+        meta_key.objecttype = LAI_OBJECT_TYPE_MEDIACHANNEL;
+
+        status = info->create(&meta_key, linecard_id, plan->channels[idx].attr_count, plan->channels[idx].attr_list);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            LAI_META_LOG_ERROR("create of media channel %zu failed: %d", idx, status);
+
+            *failed = idx;
+
+            /* channels created so far are removed in reverse order */
+
+            while (pos-- > 0)
+            {
+                idx = state->order[pos];
+
+                meta_key.objectkey.key.object_id = plan->object_ids[idx];
+
+                if (info->remove(&meta_key) != LAI_STATUS_SUCCESS)
+                {
+                    LAI_META_LOG_ERROR("remove of media channel 0x%llx failed", (unsigned long long)plan->object_ids[idx]);
+                }
+
+                plan->object_ids[idx] = LAI_NULL_OBJECT_ID;
+            }
+
+            return status;
+        }
+
+        plan->object_ids[idx] = meta_key.objectkey.key.object_id;
+    }
+
+    *failed = plan->count;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_mediachannel_plan_free(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan)
+{
+    lai_metadata_mediachannel_state_t *state;
+
+    if (plan == NULL)
+    {
+        return;
+    }
+
+    state = (lai_metadata_mediachannel_state_t*)plan->state;
+
+    if (state != NULL)
+    {
+        free(state->infos);
+        free(state->entries);
+        free(state->max_upper);
+        free(state->order);
+        free(state);
+    }
+
+    free(plan->conflicts);
+    free(plan->object_ids);
+
+    memset(plan, 0, sizeof(*plan));
+}
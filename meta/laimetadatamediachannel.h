@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatamediachannel.h
+ *
+ * @brief   This module defines LAI Metadata Media Channel Planner
+ */
+
+#ifndef __LAIMETADATAMEDIACHANNEL_H_
+#define __LAIMETADATAMEDIACHANNEL_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATAMEDIACHANNEL LAI - Metadata Media Channel Planner Definitions
+ *
+ * Planner validates whole media channel plan of WSS before any channel is
+ * created. Channels are sorted by lower frequency into static interval tree
+ * keeping highest upper frequency of every subtree, so overlaps of all
+ * channels are found in O(n log n) plus number of overlaps instead of
+ * comparing every pair.
+ *
+ * Frequency ranges are half open, channels sharing only boundary frequency
+ * don't overlap. Overlapping channels conflict when they share source or
+ * destination port, channel overlapping its super channel parent doesn't
+ * conflict with it.
+ *
+ * Plan without conflicts is created through tables queried by
+ * lai_metadata_apis_query(), super channel parents first. Apply between
+ * lai_begin_transaction() and lai_commit_transaction() makes the adapter
+ * take the plan as single batch.
+ *
+ * @{
+ */
+
+/**
+ * @brief Kind of plan conflict
+ */
+typedef enum _lai_metadata_mediachannel_conflict_kind_t
+{
+    /** Channel has no ID or the same ID as other channel */
+    LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_ID,
+
+    /** Channel has no frequency range or lower frequency is not below upper */
+    LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_FREQUENCY,
+
+    /** Channel has no source or destination port, or both are the same */
+    LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_PORT,
+
+    /** Channel overlaps other channel on the same port */
+    LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_OVERLAP,
+
+    /** Super channel parent is not in plan, is not super channel or doesn't contain channel */
+    LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_PARENT,
+
+} lai_metadata_mediachannel_conflict_kind_t;
+
+/**
+ * @brief Media channel of plan
+ */
+typedef struct _lai_metadata_mediachannel_t
+{
+    /**
+     * @brief Number of attributes.
+     */
+    uint32_t attr_count;
+
+    /**
+     * @brief Create attributes of #LAI_OBJECT_TYPE_MEDIACHANNEL.
+     */
+    const lai_attribute_t *attr_list;
+
+} lai_metadata_mediachannel_t;
+
+/**
+ * @brief Single plan conflict
+ */
+typedef struct _lai_metadata_mediachannel_conflict_t
+{
+    /**
+     * @brief Kind of conflict.
+     */
+    lai_metadata_mediachannel_conflict_kind_t kind;
+
+    /**
+     * @brief Index of channel.
+     */
+    size_t index;
+
+    /**
+     * @brief Index of other channel or of super channel parent, equal to index when conflict has single channel.
+     */
+    size_t other;
+
+} lai_metadata_mediachannel_conflict_t;
+
+/**
+ * @brief Media channel plan
+ */
+typedef struct _lai_metadata_mediachannel_plan_t
+{
+    /**
+     * @brief Number of channels.
+     */
+    size_t count;
+
+    /**
+     * @brief Channels, points to planned channels.
+     */
+    const lai_metadata_mediachannel_t *channels;
+
+    /**
+     * @brief Number of conflicts.
+     */
+    size_t conflict_count;
+
+    /**
+     * @brief Conflicts ordered by channel index.
+     */
+    lai_metadata_mediachannel_conflict_t *conflicts;
+
+    /**
+     * @brief Object ids of created channels, indexed as channels.
+     */
+    lai_object_id_t *object_ids;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_mediachannel_plan_t;
+
+/**
+ * @brief Validates media channel plan
+ *
+ * Plan points to channels, they must stay valid until plan is released.
+ * Conflicts don't fail validation, they are reported in plan.
+ *
+ * @param[in] count Number of channels
+ * @param[in] channels Channels
+ * @param[out] plan Plan, must be released by lai_metadata_mediachannel_plan_free()
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_INVALID_PARAMETER on
+ * unknown attribute, failure status code on error
+ */
+extern lai_status_t lai_metadata_mediachannel_plan(
+        _In_ size_t count,
+        _In_ const lai_metadata_mediachannel_t *channels,
+        _Out_ lai_metadata_mediachannel_plan_t *plan);
+
+/**
+ * @brief Gets channels overlapping frequency range
+ *
+ * Channels without valid frequency range are never returned.
+ *
+ * @param[in] plan Plan
+ * @param[in] lower_frequency Lower frequency of range in MHz
+ * @param[in] upper_frequency Upper frequency of range in MHz
+ * @param[inout] count Number of indexes fitting the list, number of overlapping channels on return
+ * @param[out] indexes Channel indexes ordered by lower frequency
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_BUFFER_OVERFLOW if
+ * list size insufficient, failure status code on error
+ */
+extern lai_status_t lai_metadata_mediachannel_plan_query(
+        _In_ const lai_metadata_mediachannel_plan_t *plan,
+        _In_ lai_uint64_t lower_frequency,
+        _In_ lai_uint64_t upper_frequency,
+        _Inout_ size_t *count,
+        _Out_ size_t *indexes);
+
+/**
+ * @brief Creates channels of plan without conflicts
+ *
+ * On failure channels already created by apply are removed again.
+ *
+ * @param[inout] plan Plan, object ids are filled in
+ * @param[in] linecard_id Linecard id
+ * @param[out] failed Index of failed channel, plan count on success
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_INVALID_PARAMETER if
+ * plan has conflicts, status of failed create on error
+ */
+extern lai_status_t lai_metadata_mediachannel_plan_apply(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _In_ lai_object_id_t linecard_id,
+        _Out_ size_t *failed);
+
+/**
+ * @brief Releases plan
+ *
+ * @param[inout] plan Plan
+ */
+extern void lai_metadata_mediachannel_plan_free(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATAMEDIACHANNEL_H_ */
@@ -0,0 +1,869 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataotdr.c
+ *
+ * @brief   This module implements LAI Metadata OTDR Analysis
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <lai.h>
+#include "laimetadataotdr.h"
+#include "laimetadata.h"
+
+/*
+ * Alignment is greedy merge of two distance sorted lists. Pair within
+ * tolerance is matched unless next event of either list is closer, which
+ * keeps two close events from stealing each other's match.
+ *
+ * Trace with the same sample grid as baseline is compared in integer
+ * loops without branches in body. Decoded trace is kept as two plain arrays
+ * instead of array of points, so decode loops per sample encoding and bucket
+ * averages of downsampling run over contiguous doubles.
+ *
+ * With gcc 12 at -O3 the per-sample difference of compare for every sample
+ * encoding, the bucket average of downsampling and the decode loops are
+ * vectorized, the search of largest change, compare of resampled trace and
+ * the event loops are not.
+ * No loop is vectorized at -O2.
+ */
+
+typedef struct _lai_metadata_otdr_point_t
+{
+    double length;
+    int32_t index;
+
+} lai_metadata_otdr_point_t;
+
+static double lai_metadata_otdr_abs(
+        _In_ double x)
+{
+    return x < 0 ? -x : x;
+}
+
+static int lai_metadata_otdr_point_compare(
+        _In_ const void *lhs,
+        _In_ const void *rhs)
+{
+    const lai_metadata_otdr_point_t *l = (const lai_metadata_otdr_point_t*)lhs;
+    const lai_metadata_otdr_point_t *r = (const lai_metadata_otdr_point_t*)rhs;
+
+    if (l->length < r->length)
+    {
+        return -1;
+    }
+
+    if (l->length > r->length)
+    {
+        return 1;
+    }
+
+    return l->index < r->index ? -1 : (l->index > r->index);
+}
+
+static bool lai_metadata_otdr_events_valid(
+        _In_ const lai_otdr_events_t *events)
+{
+    if (events->events.count != 0 && events->events.list == NULL)
+    {
+        return false;
+    }
+
+    return events->events.count <= INT32_MAX;
+}
+
+static size_t lai_metadata_otdr_points(
+        _In_ const lai_otdr_event_list_t *events,
+        _Out_ lai_metadata_otdr_point_t *points)
+{
+    size_t n = 0;
+    uint32_t i;
+
+    for (i = 0; i < events->count; i++)
+    {
+        if (events->list[i].type == LAI_OTDR_EVENT_TYPE_FIBER_SECTION)
+        {
+            continue;
+        }
+
+        points[n].length = events->list[i].length;
+        points[n].index = (int32_t)i;
+
+        n++;
+    }
+
+    qsort(points, n, sizeof(lai_metadata_otdr_point_t), lai_metadata_otdr_point_compare);
+
+    return n;
+}
+
+static void lai_metadata_otdr_unmatched(
+        _Inout_ lai_metadata_otdr_comparison_t *comparison,
+        _In_ const lai_metadata_otdr_point_t *point,
+        _In_ bool removed)
+{
+    lai_metadata_otdr_event_diff_t *diff = &comparison->events[comparison->count++];
+
+    diff->change = removed ? LAI_METADATA_OTDR_EVENT_CHANGE_REMOVED : LAI_METADATA_OTDR_EVENT_CHANGE_NEW;
+    diff->baseline_index = removed ? point->index : -1;
+    diff->result_index = removed ? -1 : point->index;
+    diff->length = point->length;
+    diff->length_delta = __builtin_nan("");
+    diff->loss_delta = __builtin_nan("");
+    diff->reflection_delta = __builtin_nan("");
+
+    if (removed)
+    {
+        comparison->removed_events++;
+    }
+    else
+    {
+        comparison->new_events++;
+    }
+}
+
+static void lai_metadata_otdr_matched(
+        _Inout_ lai_metadata_otdr_comparison_t *comparison,
+        _In_ const lai_metadata_otdr_thresholds_t *thresholds,
+        _In_ const lai_otdr_event_t *baseline,
+        _In_ int32_t baseline_index,
+        _In_ const lai_otdr_event_t *result,
+        _In_ int32_t result_index)
+{
+    lai_metadata_otdr_event_diff_t *diff = &comparison->events[comparison->count++];
+
+    diff->baseline_index = baseline_index;
+    diff->result_index = result_index;
+    diff->length = result->length;
+    diff->length_delta = result->length - baseline->length;
+    diff->loss_delta = result->loss - baseline->loss;
+    diff->reflection_delta = result->reflection - baseline->reflection;
+
+    if (result->type != baseline->type ||
+            lai_metadata_otdr_abs(diff->loss_delta) > thresholds->loss ||
+            (baseline->type == LAI_OTDR_EVENT_TYPE_REFLECTION &&
+             lai_metadata_otdr_abs(diff->reflection_delta) > thresholds->reflection))
+    {
+        diff->change = LAI_METADATA_OTDR_EVENT_CHANGE_CHANGED;
+
+        comparison->changed_events++;
+    }
+    else
+    {
+        diff->change = LAI_METADATA_OTDR_EVENT_CHANGE_NONE;
+    }
+}
+
+static lai_status_t lai_metadata_otdr_compare_events(
+        _In_ const lai_otdr_result_t *baseline,
+        _In_ const lai_otdr_result_t *result,
+        _In_ const lai_metadata_otdr_thresholds_t *thresholds,
+        _Inout_ lai_metadata_otdr_comparison_t *comparison)
+{
+    const lai_otdr_event_list_t *bl = &baseline->events.events;
+    const lai_otdr_event_list_t *rl = &result->events.events;
+    lai_metadata_otdr_point_t *points;
+    lai_metadata_otdr_point_t *b;
+    lai_metadata_otdr_point_t *r;
+    size_t total = (size_t)bl->count + (size_t)rl->count;
+    size_t nb;
+    size_t nr;
+    size_t i = 0;
+    size_t j = 0;
+    double tol = thresholds->distance_tolerance;
+    double d;
+
+    points = (lai_metadata_otdr_point_t*)calloc(total + 1, sizeof(lai_metadata_otdr_point_t));
+
+    comparison->events = (lai_metadata_otdr_event_diff_t*)calloc(total + 1, sizeof(lai_metadata_otdr_event_diff_t));
+
+    if (points == NULL || comparison->events == NULL)
+    {
+        free(points);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    b = points;
+    nb = lai_metadata_otdr_points(bl, b);
+
+    r = points + nb;
+    nr = lai_metadata_otdr_points(rl, r);
+
+    while (i < nb && j < nr)
+    {
+        d = r[j].length - b[i].length;
+
+        if (d < -tol)
+        {
+            lai_metadata_otdr_unmatched(comparison, &r[j++], false);
+        }
+        else if (d > tol)
+        {
+            lai_metadata_otdr_unmatched(comparison, &b[i++], true);
+        }
+        else if (j + 1 < nr && lai_metadata_otdr_abs(r[j + 1].length - b[i].length) < lai_metadata_otdr_abs(d))
+        {
+            lai_metadata_otdr_unmatched(comparison, &r[j++], false);
+        }
+        else if (i + 1 < nb && lai_metadata_otdr_abs(r[j].length - b[i + 1].length) < lai_metadata_otdr_abs(d))
+        {
+            lai_metadata_otdr_unmatched(comparison, &b[i++], true);
+        }
+        else
+        {
+            lai_metadata_otdr_matched(comparison, thresholds,
+                    &bl->list[b[i].index], b[i].index,
+                    &rl->list[r[j].index], r[j].index);
+
+            i++;
+            j++;
+        }
+    }
+
+    while (i < nb)
+    {
+        lai_metadata_otdr_unmatched(comparison, &b[i++], true);
+    }
+
+    while (j < nr)
+    {
+        lai_metadata_otdr_unmatched(comparison, &r[j++], false);
+    }
+
+    free(points);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static size_t lai_metadata_otdr_sample_width(
+        _In_ lai_metadata_otdr_sample_t sample)
+{
+    switch (sample)
+    {
+        case LAI_METADATA_OTDR_SAMPLE_UINT8:
+            return 1;
+
+        case LAI_METADATA_OTDR_SAMPLE_UINT16_BE:
+        case LAI_METADATA_OTDR_SAMPLE_UINT16_LE:
+            return 2;
+
+        default:
+            return 0;
+    }
+}
+
+static int32_t lai_metadata_otdr_level(
+        _In_ const uint8_t *data,
+        _In_ lai_metadata_otdr_sample_t sample,
+        _In_ size_t k)
+{
+    switch (sample)
+    {
+        case LAI_METADATA_OTDR_SAMPLE_UINT8:
+            return data[k];
+
+        case LAI_METADATA_OTDR_SAMPLE_UINT16_BE:
+            return (int32_t)((uint32_t)data[2 * k] << 8 | data[2 * k + 1]);
+
+        default:
+            return (int32_t)((uint32_t)data[2 * k + 1] << 8 | data[2 * k]);
+    }
+}
+
+static void lai_metadata_otdr_diff(
+        _In_ const uint8_t *bd,
+        _In_ const uint8_t *rd,
+        _In_ lai_metadata_otdr_sample_t sample,
+        _In_ size_t n,
+        _Out_ int32_t *max,
+        _Out_ uint64_t *sum)
+{
+    int32_t m = 0;
+    uint64_t s = 0;
+    int32_t delta;
+    size_t k;
+
+    for (k = 0; k < n; k++)
+    {
+        delta = lai_metadata_otdr_level(rd, sample, k) - lai_metadata_otdr_level(bd, sample, k);
+        delta = delta < 0 ? -delta : delta;
+
+        m = delta > m ? delta : m;
+        s += (uint64_t)((uint32_t)delta * (uint32_t)delta);
+    }
+
+    *max = m;
+    *sum = s;
+}
+
+static void lai_metadata_otdr_compare_trace(
+        _In_ const lai_otdr_result_t *baseline,
+        _In_ const lai_otdr_result_t *result,
+        _In_ const lai_metadata_otdr_trace_format_t *format,
+        _In_ const lai_metadata_otdr_thresholds_t *thresholds,
+        _Inout_ lai_metadata_otdr_comparison_t *comparison)
+{
+    const uint8_t *bd = baseline->trace.data.list;
+    const uint8_t *rd = result->trace.data.list;
+    lai_metadata_otdr_sample_t sample = format->sample;
+    size_t width = lai_metadata_otdr_sample_width(sample);
+    size_t nb = bd == NULL ? 0 : baseline->trace.data.count / width;
+    size_t nr = rd == NULL ? 0 : result->trace.data.count / width;
+    uint32_t range_b = baseline->scanning_profile.distance_range;
+    uint32_t range_r = result->scanning_profile.distance_range;
+    bool same_grid = (nb == nr);
+    double scale = lai_metadata_otdr_abs(format->scale);
+    double ratio = 1.0;
+    uint64_t sum = 0;
+    int32_t max = 0;
+    int32_t delta;
+    size_t n = nb < nr ? nb : nr;
+    size_t k;
+    size_t at = 0;
+    size_t idx;
+
+    comparison->trace_max_delta = __builtin_nan("");
+    comparison->trace_max_distance = __builtin_nan("");
+    comparison->trace_rms_delta = __builtin_nan("");
+
+    if (nb == 0 || nr == 0)
+    {
+        return;
+    }
+
+    if (range_b != range_r && range_b != 0 && range_r != 0)
+    {
+        ratio = ((double)range_b * (double)nr) / ((double)nb * (double)range_r);
+
+        same_grid = false;
+    }
+    else if (!same_grid)
+    {
+        ratio = (double)nr / (double)nb;
+    }
+
+    if (same_grid)
+    {
+        /* encoding is constant in each call, so every loop reads samples directly */
+
+        switch (sample)
+        {
+            case LAI_METADATA_OTDR_SAMPLE_UINT8:
+                lai_metadata_otdr_diff(bd, rd, LAI_METADATA_OTDR_SAMPLE_UINT8, n, &max, &sum);
+                break;
+
+            case LAI_METADATA_OTDR_SAMPLE_UINT16_BE:
+                lai_metadata_otdr_diff(bd, rd, LAI_METADATA_OTDR_SAMPLE_UINT16_BE, n, &max, &sum);
+                break;
+
+            default:
+                lai_metadata_otdr_diff(bd, rd, LAI_METADATA_OTDR_SAMPLE_UINT16_LE, n, &max, &sum);
+                break;
+        }
+
+        for (k = 0; k < n; k++)
+        {
+            delta = lai_metadata_otdr_level(rd, sample, k) - lai_metadata_otdr_level(bd, sample, k);
+
+            if (delta == max || delta == -max)
+            {
+                at = k;
+                break;
+            }
+        }
+    }
+    else
+    {
+        /* baseline sample positions mapped to result grid */
+
+        for (k = 0; k < nb; k++)
+        {
+            idx = (size_t)((double)k * ratio);
+
+            if (idx >= nr)
+            {
+                break;
+            }
+
+            delta = lai_metadata_otdr_level(rd, sample, idx) - lai_metadata_otdr_level(bd, sample, k);
+            delta = delta < 0 ? -delta : delta;
+
+            if (delta > max)
+            {
+                max = delta;
+                at = k;
+            }
+
+            sum += (uint64_t)((uint32_t)delta * (uint32_t)delta);
+        }
+
+        n = k;
+    }
+
+    comparison->trace_samples = n;
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    comparison->trace_max_delta = (double)max * scale;
+    comparison->trace_rms_delta = sqrt((double)sum / (double)n) * scale;
+    comparison->trace_changed = comparison->trace_max_delta > thresholds->trace;
+
+    if (range_b != 0)
+    {
+        comparison->trace_max_distance = (double)at * (double)range_b / (double)nb;
+    }
+}
+
+static lai_status_t lai_metadata_otdr_trace_alloc(
+        _Out_ lai_metadata_otdr_trace_t *trace,
+        _In_ size_t count)
+{
+    memset(trace, 0, sizeof(lai_metadata_otdr_trace_t));
+
+    if (count > ((size_t)-1) / sizeof(lai_double_t) - 1)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    trace->distance = (lai_double_t*)malloc((count + 1) * sizeof(lai_double_t));
+    trace->power = (lai_double_t*)malloc((count + 1) * sizeof(lai_double_t));
+
+    if (trace->distance == NULL || trace->power == NULL)
+    {
+        lai_metadata_otdr_trace_free(trace);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    trace->count = count;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static size_t lai_metadata_otdr_lttb(
+        _In_ const lai_double_t *x,
+        _In_ const lai_double_t *y,
+        _In_ size_t n,
+        _In_ size_t count,
+        _Out_ lai_double_t *ox,
+        _Out_ lai_double_t *oy)
+{
+    double every;
+    double ax;
+    double ay;
+    double cx;
+    double cy;
+    double area;
+    double best;
+    size_t a = 0;
+    size_t pick;
+    size_t start;
+    size_t end;
+    size_t next;
+    size_t i;
+    size_t j;
+
+    if (n <= count || count < 3)
+    {
+        memcpy(ox, x, n * sizeof(lai_double_t));
+        memcpy(oy, y, n * sizeof(lai_double_t));
+
+        return n;
+    }
+
+    /* inner points are split into count - 2 buckets */
+
+    every = (double)(n - 2) / (double)(count - 2);
+
+    ox[0] = x[0];
+    oy[0] = y[0];
+
+    for (i = 0; i < count - 2; i++)
+    {
+        start = (size_t)((double)i * every) + 1;
+        end = (size_t)((double)(i + 1) * every) + 1;
+        next = (size_t)((double)(i + 2) * every) + 1;
+
+        end = end > n - 1 ? n - 1 : end;
+        next = next > n ? n : next;
+        next = next <= end ? end + 1 : next;
+
+        /* average of next bucket, the last point for the last bucket */
+
+        cx = 0;
+        cy = 0;
+
+        for (j = end; j < next; j++)
+        {
+            cx += x[j];
+            cy += y[j];
+        }
+
+        cx /= (double)(next - end);
+        cy /= (double)(next - end);
+
+        ax = x[a];
+        ay = y[a];
+
+        best = -1;
+        pick = start;
+
+        for (j = start; j < end; j++)
+        {
+            area = (ax - cx) * (y[j] - ay) - (ax - x[j]) * (cy - ay);
+            area = area < 0 ? -area : area;
+
+            if (area > best)
+            {
+                best = area;
+                pick = j;
+            }
+        }
+
+        ox[i + 1] = x[pick];
+        oy[i + 1] = y[pick];
+
+        a = pick;
+    }
+
+    ox[count - 1] = x[n - 1];
+    oy[count - 1] = y[n - 1];
+
+    return count;
+}
+
+static size_t lai_metadata_otdr_lower_bound(
+        _In_ const lai_metadata_otdr_trace_t *trace,
+        _In_ double distance,
+        _In_ bool inclusive)
+{
+    size_t lo = 0;
+    size_t hi = trace->count;
+    size_t mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+
+        if (trace->distance[mid] < distance || (inclusive && !(trace->distance[mid] > distance)))
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+void lai_metadata_otdr_thresholds_init(
+        _Out_ lai_metadata_otdr_thresholds_t *thresholds)
+{
+    if (thresholds == NULL)
+    {
+        return;
+    }
+
+    thresholds->distance_tolerance = 0.1;
+    thresholds->loss = 0.5;
+    thresholds->reflection = 3.0;
+    thresholds->span_distance = 0.1;
+    thresholds->span_loss = 1.0;
+    thresholds->trace = 1.0;
+}
+
+void lai_metadata_otdr_comparison_free(
+        _Inout_ lai_metadata_otdr_comparison_t *comparison)
+{
+    if (comparison == NULL)
+    {
+        return;
+    }
+
+    free(comparison->events);
+
+    memset(comparison, 0, sizeof(lai_metadata_otdr_comparison_t));
+}
+
+lai_status_t lai_metadata_otdr_compare(
+        _In_ const lai_otdr_result_t *baseline,
+        _In_ const lai_otdr_result_t *result,
+        _In_ const lai_metadata_otdr_trace_format_t *format,
+        _In_ const lai_metadata_otdr_thresholds_t *thresholds,
+        _Out_ lai_metadata_otdr_comparison_t *comparison)
+{
+    lai_status_t status;
+
+    if (baseline == NULL || result == NULL || format == NULL || thresholds == NULL || comparison == NULL)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: baseline, result, format, thresholds or comparison");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(comparison, 0, sizeof(lai_metadata_otdr_comparison_t));
+
+    if (!(thresholds->distance_tolerance >= 0) || !(thresholds->loss >= 0) ||
+            !(thresholds->reflection >= 0) || !(thresholds->span_distance >= 0) ||
+            !(thresholds->span_loss >= 0) || !(thresholds->trace >= 0))
+    {
+        LAI_META_LOG_ERROR("invalid thresholds, must not be negative");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (lai_metadata_otdr_sample_width(format->sample) == 0 || !__builtin_isfinite(format->scale))
+    {
+        LAI_META_LOG_ERROR("invalid trace format, sample encoding %d", format->sample);
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!lai_metadata_otdr_events_valid(&baseline->events) ||
+            !lai_metadata_otdr_events_valid(&result->events))
+    {
+        LAI_META_LOG_ERROR("invalid event list");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    status = lai_metadata_otdr_compare_events(baseline, result, thresholds, comparison);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        lai_metadata_otdr_comparison_free(comparison);
+
+        return status;
+    }
+
+    comparison->span_distance_delta = result->events.span_distance - baseline->events.span_distance;
+    comparison->span_loss_delta = result->events.span_loss - baseline->events.span_loss;
+
+    comparison->span_distance_changed = lai_metadata_otdr_abs(comparison->span_distance_delta) > thresholds->span_distance;
+    comparison->span_loss_changed = lai_metadata_otdr_abs(comparison->span_loss_delta) > thresholds->span_loss;
+
+    lai_metadata_otdr_compare_trace(baseline, result, format, thresholds, comparison);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_otdr_trace_free(
+        _Inout_ lai_metadata_otdr_trace_t *trace)
+{
+    if (trace == NULL)
+    {
+        return;
+    }
+
+    free(trace->distance);
+    free(trace->power);
+
+    memset(trace, 0, sizeof(lai_metadata_otdr_trace_t));
+}
+
+lai_status_t lai_metadata_otdr_trace_decode(
+        _In_ const lai_otdr_result_trace_t *trace,
+        _In_ const lai_metadata_otdr_trace_format_t *format,
+        _Out_ lai_metadata_otdr_trace_t *decoded)
+{
+    const uint8_t *data;
+    lai_status_t status;
+    double step;
+    double limit;
+    double scale;
+    double offset;
+    size_t width;
+    size_t n;
+    size_t k;
+
+    if (trace == NULL || format == NULL || decoded == NULL ||
+            (trace->data.count != 0 && trace->data.list == NULL))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: trace, format or decoded");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(decoded, 0, sizeof(lai_metadata_otdr_trace_t));
+
+    width = lai_metadata_otdr_sample_width(format->sample);
+
+    if (width == 0)
+    {
+        LAI_META_LOG_ERROR("invalid sample encoding %d", format->sample);
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!__builtin_isfinite(format->scale) || !__builtin_isfinite(format->offset))
+    {
+        LAI_META_LOG_ERROR("invalid trace scale or offset");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    n = trace->data.count / width;
+
+    if (format->sampling_resolution > 0 && __builtin_isfinite(format->sampling_resolution))
+    {
+        step = format->sampling_resolution / 1000.0;
+
+        if (format->distance_range != 0)
+        {
+            limit = (double)format->distance_range / step;
+
+            if (limit < (double)n)
+            {
+                n = (size_t)limit + 1;
+            }
+        }
+    }
+    else if (format->distance_range != 0)
+    {
+        step = n == 0 ? 0 : (double)format->distance_range / (double)n;
+    }
+    else
+    {
+        LAI_META_LOG_ERROR("sample spacing unknown, sampling resolution and distance range are not set");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    status = lai_metadata_otdr_trace_alloc(decoded, n);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    data = trace->data.list;
+    scale = format->scale;
+    offset = format->offset;
+
+    for (k = 0; k < n; k++)
+    {
+        decoded->distance[k] = (double)k * step;
+    }
+
+    switch (format->sample)
+    {
+        case LAI_METADATA_OTDR_SAMPLE_UINT8:
+
+            for (k = 0; k < n; k++)
+            {
+                decoded->power[k] = offset + scale * (double)data[k];
+            }
+
+            break;
+
+        case LAI_METADATA_OTDR_SAMPLE_UINT16_BE:
+
+            for (k = 0; k < n; k++)
+            {
+                decoded->power[k] = offset + scale * (double)((uint32_t)data[2 * k] << 8 | data[2 * k + 1]);
+            }
+
+            break;
+
+        default:
+
+            for (k = 0; k < n; k++)
+            {
+                decoded->power[k] = offset + scale * (double)((uint32_t)data[2 * k + 1] << 8 | data[2 * k]);
+            }
+
+            break;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_otdr_trace_downsample(
+        _In_ const lai_metadata_otdr_trace_t *trace,
+        _In_ size_t count,
+        _Out_ lai_metadata_otdr_trace_t *downsampled)
+{
+    lai_status_t status;
+
+    if (trace == NULL || downsampled == NULL || count < 3)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: trace or downsampled, or count below 3");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    status = lai_metadata_otdr_trace_alloc(downsampled, trace->count < count ? trace->count : count);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    downsampled->count = lai_metadata_otdr_lttb(trace->distance, trace->power, trace->count, count,
+            downsampled->distance, downsampled->power);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_otdr_trace_zoom(
+        _In_ const lai_metadata_otdr_trace_t *trace,
+        _In_ lai_double_t from_distance,
+        _In_ lai_double_t to_distance,
+        _In_ size_t count,
+        _Out_ lai_metadata_otdr_trace_t *zoomed)
+{
+    lai_status_t status;
+    size_t lo;
+    size_t hi;
+    size_t n;
+
+    if (trace == NULL || zoomed == NULL || (count != 0 && count < 3) || !(from_distance <= to_distance))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: trace, zoomed, count or distance window");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    lo = lai_metadata_otdr_lower_bound(trace, from_distance, false);
+    hi = lai_metadata_otdr_lower_bound(trace, to_distance, true);
+
+    n = hi > lo ? hi - lo : 0;
+
+    if (count == 0 || count > n)
+    {
+        count = n;
+    }
+
+    status = lai_metadata_otdr_trace_alloc(zoomed, count);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    zoomed->count = lai_metadata_otdr_lttb(trace->distance + lo, trace->power + lo, n, count,
+            zoomed->distance, zoomed->power);
+
+    return LAI_STATUS_SUCCESS;
+}
@@ -0,0 +1,409 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataotdr.h
+ *
+ * @brief   This module defines LAI Metadata OTDR Analysis
+ */
+
+#ifndef __LAIMETADATAOTDR_H_
+#define __LAIMETADATAOTDR_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATAOTDR LAI - Metadata OTDR Analysis Definitions
+ *
+ * Comparison of OTDR result with baseline result of the same fiber. Events
+ * of both results are sorted by distance and aligned in single merge pass,
+ * events closer than distance tolerance are the same event. Fiber section
+ * events carry section length instead of distance and are not aligned,
+ * their loss is covered by total fiber loss.
+ *
+ * Trace comparison decodes sample levels of both traces by trace data
+ * format, samples are spread evenly over scanning profile distance range.
+ * Level change is turned to dB by format scale, format offset cancels out.
+ * Traces with different sample count or distance range are compared at
+ * baseline sample positions.
+ *
+ * Fiber distance and fiber loss changes map to
+ * #LAI_ALARM_TYPE_OTDR_SPAN_DISTANCE_CHANGE_BASELINE and
+ * #LAI_ALARM_TYPE_OTDR_SPAN_LOSS_CHANGE_BASELINE.
+ *
+ * Comparison is linear in number of samples, needs sort of events and
+ * allocates only event lists, so many fibers can be compared on every scan
+ * period.
+ *
+ * Trace decoder turns trace data into distance and power arrays for display
+ * and storage. Sample spacing is given by #LAI_OTDR_ATTR_SAMPLING_RESOLUTION
+ * in meters, or by #LAI_OTDR_ATTR_DISTANCE_RANGE divided by number of
+ * samples when resolution is unknown. Decoded trace can be reduced to few
+ * hundreds of points by largest triangle three buckets downsampling, which
+ * keeps reflection peaks and steps that plain decimation drops, and zoom
+ * extracts distance window before reducing it.
+ *
+ * @{
+ */
+
+/**
+ * @brief Change of single event against baseline
+ */
+typedef enum _lai_metadata_otdr_event_change_t
+{
+    /** Event is in both results within thresholds */
+    LAI_METADATA_OTDR_EVENT_CHANGE_NONE,
+
+    /** Event is only in new result */
+    LAI_METADATA_OTDR_EVENT_CHANGE_NEW,
+
+    /** Event is only in baseline */
+    LAI_METADATA_OTDR_EVENT_CHANGE_REMOVED,
+
+    /** Event is in both results with changed type, loss or reflection */
+    LAI_METADATA_OTDR_EVENT_CHANGE_CHANGED,
+
+} lai_metadata_otdr_event_change_t;
+
+/**
+ * @brief Comparison thresholds
+ */
+typedef struct _lai_metadata_otdr_thresholds_t
+{
+    /**
+     * @brief Events closer than tolerance in km are the same event.
+     */
+    lai_double_t distance_tolerance;
+
+    /**
+     * @brief Event loss change in dB.
+     */
+    lai_double_t loss;
+
+    /**
+     * @brief Event reflection change in dB.
+     */
+    lai_double_t reflection;
+
+    /**
+     * @brief Fiber distance change in km.
+     */
+    lai_double_t span_distance;
+
+    /**
+     * @brief Fiber loss change in dB.
+     */
+    lai_double_t span_loss;
+
+    /**
+     * @brief Trace sample change in dB.
+     */
+    lai_double_t trace;
+
+} lai_metadata_otdr_thresholds_t;
+
+/**
+ * @brief Aligned event pair
+ */
+typedef struct _lai_metadata_otdr_event_diff_t
+{
+    /**
+     * @brief Change against baseline.
+     */
+    lai_metadata_otdr_event_change_t change;
+
+    /**
+     * @brief Index in baseline event list, -1 for new event.
+     */
+    int32_t baseline_index;
+
+    /**
+     * @brief Index in result event list, -1 for removed event.
+     */
+    int32_t result_index;
+
+    /**
+     * @brief Event distance in km, baseline distance for removed event.
+     */
+    lai_double_t length;
+
+    /**
+     * @brief Distance change in km.
+     */
+    lai_double_t length_delta;
+
+    /**
+     * @brief Loss change in dB.
+     */
+    lai_double_t loss_delta;
+
+    /**
+     * @brief Reflection change in dB.
+     */
+    lai_double_t reflection_delta;
+
+} lai_metadata_otdr_event_diff_t;
+
+/**
+ * @brief Comparison of result with baseline
+ */
+typedef struct _lai_metadata_otdr_comparison_t
+{
+    /**
+     * @brief Number of aligned events.
+     */
+    size_t count;
+
+    /**
+     * @brief Aligned events ordered by distance.
+     */
+    lai_metadata_otdr_event_diff_t *events;
+
+    /**
+     * @brief Number of new events.
+     */
+    size_t new_events;
+
+    /**
+     * @brief Number of removed events.
+     */
+    size_t removed_events;
+
+    /**
+     * @brief Number of changed events.
+     */
+    size_t changed_events;
+
+    /**
+     * @brief Fiber distance change in km.
+     */
+    lai_double_t span_distance_delta;
+
+    /**
+     * @brief Fiber loss change in dB.
+     */
+    lai_double_t span_loss_delta;
+
+    /**
+     * @brief Fiber distance change exceeds threshold.
+     */
+    bool span_distance_changed;
+
+    /**
+     * @brief Fiber loss change exceeds threshold.
+     */
+    bool span_loss_changed;
+
+    /**
+     * @brief Number of compared trace samples.
+     */
+    size_t trace_samples;
+
+    /**
+     * @brief Largest absolute trace change in dB.
+     */
+    lai_double_t trace_max_delta;
+
+    /**
+     * @brief Distance of largest trace change in km.
+     */
+    lai_double_t trace_max_distance;
+
+    /**
+     * @brief Root mean square of trace change in dB.
+     */
+    lai_double_t trace_rms_delta;
+
+    /**
+     * @brief Largest trace change exceeds threshold.
+     */
+    bool trace_changed;
+
+} lai_metadata_otdr_comparison_t;
+
+/**
+ * @brief Trace sample encoding
+ */
+typedef enum _lai_metadata_otdr_sample_t
+{
+    /** One byte per sample */
+    LAI_METADATA_OTDR_SAMPLE_UINT8,
+
+    /** Two bytes per sample, most significant byte first */
+    LAI_METADATA_OTDR_SAMPLE_UINT16_BE,
+
+    /** Two bytes per sample, least significant byte first */
+    LAI_METADATA_OTDR_SAMPLE_UINT16_LE,
+
+} lai_metadata_otdr_sample_t;
+
+/**
+ * @brief Trace data format
+ *
+ * Sample power in dB is offset + level * scale.
+ */
+typedef struct _lai_metadata_otdr_trace_format_t
+{
+    /**
+     * @brief Sample encoding.
+     */
+    lai_metadata_otdr_sample_t sample;
+
+    /**
+     * @brief Level step in dB.
+     */
+    lai_double_t scale;
+
+    /**
+     * @brief Power of level 0 in dB.
+     */
+    lai_double_t offset;
+
+    /**
+     * @brief Sampling resolution in m, 0 when unknown.
+     */
+    lai_double_t sampling_resolution;
+
+    /**
+     * @brief Distance range in km, 0 when unknown.
+     */
+    uint32_t distance_range;
+
+} lai_metadata_otdr_trace_format_t;
+
+/**
+ * @brief Decoded trace
+ */
+typedef struct _lai_metadata_otdr_trace_t
+{
+    /**
+     * @brief Number of points.
+     */
+    size_t count;
+
+    /**
+     * @brief Point distances in km, ascending.
+     */
+    lai_double_t *distance;
+
+    /**
+     * @brief Point powers in dB.
+     */
+    lai_double_t *power;
+
+} lai_metadata_otdr_trace_t;
+
+/**
+ * @brief Initializes thresholds to defaults
+ *
+ * Defaults are 0.1 km tolerance, 0.5 dB loss, 3 dB reflection, 0.1 km fiber
+ * distance, 1 dB fiber loss and 1 dB trace change.
+ *
+ * @param[out] thresholds Thresholds
+ */
+extern void lai_metadata_otdr_thresholds_init(
+        _Out_ lai_metadata_otdr_thresholds_t *thresholds);
+
+/**
+ * @brief Compares OTDR result with baseline
+ *
+ * @param[in] baseline Baseline result
+ * @param[in] result New result
+ * @param[in] format Trace data format of both results
+ * @param[in] thresholds Thresholds
+ * @param[out] comparison Comparison, must be released by lai_metadata_otdr_comparison_free()
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_otdr_compare(
+        _In_ const lai_otdr_result_t *baseline,
+        _In_ const lai_otdr_result_t *result,
+        _In_ const lai_metadata_otdr_trace_format_t *format,
+        _In_ const lai_metadata_otdr_thresholds_t *thresholds,
+        _Out_ lai_metadata_otdr_comparison_t *comparison);
+
+/**
+ * @brief Releases comparison
+ *
+ * @param[inout] comparison Comparison
+ */
+extern void lai_metadata_otdr_comparison_free(
+        _Inout_ lai_metadata_otdr_comparison_t *comparison);
+
+/**
+ * @brief Decodes trace data
+ *
+ * Samples beyond distance range are dropped, odd trailing byte of two byte
+ * encoding is ignored.
+ *
+ * @param[in] trace Trace of OTDR result
+ * @param[in] format Trace data format
+ * @param[out] decoded Decoded trace, must be released by lai_metadata_otdr_trace_free()
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_INVALID_PARAMETER when
+ * sample spacing is unknown, failure status code on error
+ */
+extern lai_status_t lai_metadata_otdr_trace_decode(
+        _In_ const lai_otdr_result_trace_t *trace,
+        _In_ const lai_metadata_otdr_trace_format_t *format,
+        _Out_ lai_metadata_otdr_trace_t *decoded);
+
+/**
+ * @brief Downsamples trace by largest triangle three buckets
+ *
+ * The first and the last point are always kept, every other bucket keeps
+ * point forming the largest triangle with previous kept point and average
+ * of next bucket. Trace with no more than count points is copied.
+ *
+ * @param[in] trace Decoded trace
+ * @param[in] count Number of points, at least 3
+ * @param[out] downsampled Downsampled trace, must be released by lai_metadata_otdr_trace_free()
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_otdr_trace_downsample(
+        _In_ const lai_metadata_otdr_trace_t *trace,
+        _In_ size_t count,
+        _Out_ lai_metadata_otdr_trace_t *downsampled);
+
+/**
+ * @brief Extracts distance window of trace
+ *
+ * @param[in] trace Decoded trace
+ * @param[in] from_distance Start of window in km, inclusive
+ * @param[in] to_distance End of window in km, inclusive
+ * @param[in] count Number of points, 0 keeps all points of window
+ * @param[out] zoomed Points of window downsampled to count, must be released by lai_metadata_otdr_trace_free()
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_otdr_trace_zoom(
+        _In_ const lai_metadata_otdr_trace_t *trace,
+        _In_ lai_double_t from_distance,
+        _In_ lai_double_t to_distance,
+        _In_ size_t count,
+        _Out_ lai_metadata_otdr_trace_t *zoomed);
+
+/**
+ * @brief Releases decoded trace
+ *
+ * @param[inout] trace Decoded trace
+ */
+extern void lai_metadata_otdr_trace_free(
+        _Inout_ lai_metadata_otdr_trace_t *trace);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATAOTDR_H_ */
@@ -0,0 +1,562 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatapm.c
+ *
+ * @brief   This module implements LAI Metadata Performance Monitoring Bins
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <lai.h>
+#include "laimetadatapm.h"
+#include "laimetadata.h"
+
+/*
+ * Bins are kept in structure of arrays form, column after column, where
+ * each column holds one statistics of all objects. This way update of one
+ * statistics is a tight loop over contiguous values of all objects.
+ *
+ * Gauge columns keep 4 fields (min, max, sum, last) interleaved per object,
+ * counter columns keep one array of totals. Slots form a ring of history
+ * + 1 bins.
+ *
+ * Update loops have no branches and no 64-bit compares, plain x86-64 has
+ * neither unsigned nor signed ones. Counter reset is the borrow of v - p,
+ * missing gauge sample is NaN found from exponent bits by subtraction,
+ * and gauge selects are ?: on doubles. Interleaved gauge fields leave
+ * only raw values and samples as separate streams, four field arrays
+ * needed more alias checks than gcc versions a loop for. With gcc 12 at
+ * -O3 -fno-trapping-math, which the Makefile uses for this module, slot
+ * reset and both update loops are vectorized for plain x86-64 (checked
+ * with -fopt-info-vec). Of extract loops, which read strided union
+ * members, only 32-bit integer gauges are vectorized, conversions between
+ * 64-bit integers and doubles need AVX-512.
+ */
+
+#define PM_GAUGE_MIN    0
+#define PM_GAUGE_MAX    1
+#define PM_GAUGE_SUM    2
+#define PM_GAUGE_LAST   3
+#define PM_GAUGE_FIELDS 4
+
+#define PM_DOUBLE_ABS_MASK  0x7FFFFFFFFFFFFFFFULL
+#define PM_DOUBLE_INF_BITS  0x7FF0000000000000ULL
+
+typedef struct _lai_metadata_pm_state_t
+{
+    size_t slots;
+    size_t head;
+    size_t recorded;
+
+    size_t counter_columns;
+    size_t gauge_columns;
+
+    /* per statistics index into counter or gauge columns */
+
+    size_t *column;
+
+    /* per slot */
+
+    uint64_t *start;
+    uint64_t *totals;
+    double *gauges;
+    uint64_t *samples;
+
+    /* previous raw counter values for LAI_STATS_MODE_READ */
+
+    uint64_t *previous;
+    uint64_t *hasprevious;
+
+    /* scratch column for values of single statistics */
+
+    uint64_t *rawcounters;
+    double *rawgauges;
+
+} lai_metadata_pm_state_t;
+
+static void *lai_metadata_pm_alloc(
+        _In_ size_t count,
+        _In_ size_t size)
+{
+    if (count == 0)
+    {
+        count = 1;
+    }
+
+    if (count > ((size_t)-1) / size)
+    {
+        return NULL;
+    }
+
+    return calloc(count, size);
+}
+
+static void lai_metadata_pm_reset_slot(
+        _Inout_ lai_metadata_pm_bins_t *bins,
+        _In_ size_t slot,
+        _In_ uint64_t start)
+{
+    lai_metadata_pm_state_t *state = (lai_metadata_pm_state_t*)bins->state;
+
+    size_t n = bins->object_count;
+
+    state->start[slot] = start;
+
+    memset(&state->totals[slot * state->counter_columns * n], 0, state->counter_columns * n * sizeof(uint64_t));
+    memset(&state->samples[slot * bins->stat_count * n], 0, bins->stat_count * n * sizeof(uint64_t));
+
+    double *g = &state->gauges[slot * state->gauge_columns * PM_GAUGE_FIELDS * n];
+
+    size_t col = 0;
+
+    for (; col < state->gauge_columns; ++col, g += PM_GAUGE_FIELDS * n)
+    {
+        size_t i = 0;
+
+        for (; i < n; ++i)
+        {
+            g[i * PM_GAUGE_FIELDS + PM_GAUGE_MIN] = __builtin_inf();
+            g[i * PM_GAUGE_FIELDS + PM_GAUGE_MAX] = -__builtin_inf();
+            g[i * PM_GAUGE_FIELDS + PM_GAUGE_SUM] = 0.0;
+            g[i * PM_GAUGE_FIELDS + PM_GAUGE_LAST] = __builtin_nan("");
+        }
+    }
+}
+
+void lai_metadata_pm_bins_free(
+        _Inout_ lai_metadata_pm_bins_t *bins)
+{
+    if (bins == NULL)
+    {
+        return;
+    }
+
+    lai_metadata_pm_state_t *state = (lai_metadata_pm_state_t*)bins->state;
+
+    if (state != NULL)
+    {
+        free(state->column);
+        free(state->start);
+        free(state->totals);
+        free(state->gauges);
+        free(state->samples);
+        free(state->previous);
+        free(state->hasprevious);
+        free(state->rawcounters);
+        free(state->rawgauges);
+        free(state);
+    }
+
+    free((void*)bins->stat_metadata);
+
+    memset(bins, 0, sizeof(lai_metadata_pm_bins_t));
+}
+
+lai_status_t lai_metadata_pm_bins_init(
+        _Out_ lai_metadata_pm_bins_t *bins,
+        _In_ lai_object_type_t object_type,
+        _In_ size_t object_count,
+        _In_ size_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids,
+        _In_ uint64_t interval,
+        _In_ size_t history,
+        _In_ lai_stats_mode_t mode)
+{
+    if (bins == NULL || counter_ids == NULL || number_of_counters == 0 || interval == 0)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: bins, counter ids or interval");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (mode != LAI_STATS_MODE_READ && mode != LAI_STATS_MODE_READ_AND_CLEAR)
+    {
+        LAI_META_LOG_ERROR("invalid stats mode %d", mode);
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(bins, 0, sizeof(lai_metadata_pm_bins_t));
+
+    bins->object_type = object_type;
+    bins->object_count = object_count;
+    bins->stat_count = number_of_counters;
+    bins->interval = interval;
+    bins->history = history;
+    bins->mode = mode;
+
+    bins->stat_metadata = (const lai_stat_metadata_t**)lai_metadata_pm_alloc(number_of_counters, sizeof(lai_stat_metadata_t*));
+
+    lai_metadata_pm_state_t *state = (lai_metadata_pm_state_t*)calloc(1, sizeof(lai_metadata_pm_state_t));
+
+    bins->state = state;
+
+    if (bins->stat_metadata == NULL || state == NULL)
+    {
+        lai_metadata_pm_bins_free(bins);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    state->slots = history + 1;
+
+    state->column = (size_t*)lai_metadata_pm_alloc(number_of_counters, sizeof(size_t));
+
+    if (state->column == NULL)
+    {
+        lai_metadata_pm_bins_free(bins);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    size_t idx = 0;
+
+    for (; idx < number_of_counters; ++idx)
+    {
+        const lai_stat_metadata_t *md = lai_metadata_get_stat_metadata(object_type, counter_ids[idx]);
+
+        if (md == NULL)
+        {
+            LAI_META_LOG_ERROR("invalid stat id %d for object type %d", counter_ids[idx], object_type);
+
+            lai_metadata_pm_bins_free(bins);
+
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+
+        bins->stat_metadata[idx] = md;
+
+        state->column[idx] = md->statvalueiscounter ? state->counter_columns++ : state->gauge_columns++;
+    }
+
+    size_t n = object_count;
+
+    state->start = (uint64_t*)lai_metadata_pm_alloc(state->slots, sizeof(uint64_t));
+    state->totals = (uint64_t*)lai_metadata_pm_alloc(state->slots * state->counter_columns * n, sizeof(uint64_t));
+    state->gauges = (double*)lai_metadata_pm_alloc(state->slots * state->gauge_columns * PM_GAUGE_FIELDS * n, sizeof(double));
+    state->samples = (uint64_t*)lai_metadata_pm_alloc(state->slots * number_of_counters * n, sizeof(uint64_t));
+    state->previous = (uint64_t*)lai_metadata_pm_alloc(state->counter_columns * n, sizeof(uint64_t));
+    state->hasprevious = (uint64_t*)lai_metadata_pm_alloc(state->counter_columns * n, sizeof(uint64_t));
+    state->rawcounters = (uint64_t*)lai_metadata_pm_alloc(n, sizeof(uint64_t));
+    state->rawgauges = (double*)lai_metadata_pm_alloc(n, sizeof(double));
+
+    if (state->start == NULL || state->totals == NULL || state->gauges == NULL ||
+            state->samples == NULL || state->previous == NULL || state->hasprevious == NULL ||
+            state->rawcounters == NULL || state->rawgauges == NULL)
+    {
+        LAI_META_LOG_ERROR("failed to allocate bins for %zu objects and %zu stats", object_count, number_of_counters);
+
+        lai_metadata_pm_bins_free(bins);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    size_t slot = 0;
+
+    for (; slot < state->slots; ++slot)
+    {
+        lai_metadata_pm_reset_slot(bins, slot, 0);
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+/*
+ * Extracts single statistics column from object major snapshot, type
+ * switch is done once per column instead of once per value.
+ */
+
+static void lai_metadata_pm_extract_counters(
+        _In_ const lai_stat_metadata_t *md,
+        _In_ size_t n,
+        _In_ size_t stride,
+        _In_ const lai_stat_value_t *values,
+        _Out_ uint64_t *raw)
+{
+    size_t i = 0;
+
+    switch (md->statvaluetype)
+    {
+        case LAI_STAT_VALUE_TYPE_INT32:
+            for (; i < n; ++i) raw[i] = (uint64_t)values[i * stride].s32;
+            break;
+
+        case LAI_STAT_VALUE_TYPE_UINT32:
+            for (; i < n; ++i) raw[i] = values[i * stride].u32;
+            break;
+
+        case LAI_STAT_VALUE_TYPE_INT64:
+            for (; i < n; ++i) raw[i] = (uint64_t)values[i * stride].s64;
+            break;
+
+        case LAI_STAT_VALUE_TYPE_DOUBLE:
+            for (; i < n; ++i) raw[i] = (uint64_t)values[i * stride].d64;
+            break;
+
+        default:
+            for (; i < n; ++i) raw[i] = values[i * stride].u64;
+            break;
+    }
+}
+
+static void lai_metadata_pm_extract_gauges(
+        _In_ const lai_stat_metadata_t *md,
+        _In_ size_t n,
+        _In_ size_t stride,
+        _In_ const lai_stat_value_t *values,
+        _Out_ double *raw)
+{
+    size_t i = 0;
+
+    switch (md->statvaluetype)
+    {
+        case LAI_STAT_VALUE_TYPE_INT32:
+            for (; i < n; ++i) raw[i] = values[i * stride].s32;
+            break;
+
+        case LAI_STAT_VALUE_TYPE_UINT32:
+            for (; i < n; ++i) raw[i] = values[i * stride].u32;
+            break;
+
+        case LAI_STAT_VALUE_TYPE_INT64:
+            for (; i < n; ++i) raw[i] = (double)values[i * stride].s64;
+            break;
+
+        case LAI_STAT_VALUE_TYPE_UINT64:
+            for (; i < n; ++i) raw[i] = (double)values[i * stride].u64;
+            break;
+
+        default:
+            for (; i < n; ++i) raw[i] = values[i * stride].d64;
+            break;
+    }
+}
+
+static void lai_metadata_pm_update_counters(
+        _In_ size_t n,
+        _In_ lai_stats_mode_t mode,
+        _In_ const uint64_t *raw,
+        _Inout_ uint64_t *previous,
+        _Inout_ uint64_t *hasprevious,
+        _Inout_ uint64_t *totals,
+        _Inout_ uint64_t *samples)
+{
+    size_t i = 0;
+
+    if (mode == LAI_STATS_MODE_READ_AND_CLEAR)
+    {
+        for (; i < n; ++i)
+        {
+            totals[i] += raw[i];
+            samples[i] += 1;
+        }
+
+        return;
+    }
+
+    for (; i < n; ++i)
+    {
+        uint64_t v = raw[i];
+        uint64_t p = previous[i];
+        uint64_t d = v - p;
+
+        /* borrow of v - p means counter went back, it was reset, count from zero */
+
+        uint64_t reset = (uint64_t)0 - (((~v & p) | (~(v ^ p) & d)) >> 63);
+        uint64_t delta = (d & ~reset) | (v & reset);
+
+        totals[i] += delta & ((uint64_t)0 - hasprevious[i]);
+        samples[i] += 1;
+
+        previous[i] = v;
+        hasprevious[i] = 1;
+    }
+}
+
+static void lai_metadata_pm_update_gauges(
+        _In_ size_t n,
+        _In_ const double *raw,
+        _Inout_ double *gauges,
+        _Inout_ uint64_t *samples)
+{
+    size_t i = 0;
+
+    for (; i < n; ++i, gauges += PM_GAUGE_FIELDS)
+    {
+        double v = raw[i];
+        uint64_t bits;
+
+        /* NaN compares false, so it keeps min and max */
+
+        gauges[PM_GAUGE_MIN] = (v < gauges[PM_GAUGE_MIN]) ? v : gauges[PM_GAUGE_MIN];
+        gauges[PM_GAUGE_MAX] = (v > gauges[PM_GAUGE_MAX]) ? v : gauges[PM_GAUGE_MAX];
+        gauges[PM_GAUGE_SUM] += __builtin_isunordered(v, v) ? 0.0 : v;
+        gauges[PM_GAUGE_LAST] = __builtin_isunordered(v, v) ? gauges[PM_GAUGE_LAST] : v;
+
+        /* absolute value bits above infinity borrow from it for NaN */
+
+        memcpy(&bits, &v, sizeof(bits));
+
+        samples[i] += 1 - ((PM_DOUBLE_INF_BITS - (bits & PM_DOUBLE_ABS_MASK)) >> 63);
+    }
+}
+
+lai_status_t lai_metadata_pm_bins_update(
+        _Inout_ lai_metadata_pm_bins_t *bins,
+        _In_ uint64_t timestamp,
+        _In_ const lai_stat_value_t *counters)
+{
+    if (bins == NULL || bins->state == NULL || counters == NULL)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: bins or counters is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    lai_metadata_pm_state_t *state = (lai_metadata_pm_state_t*)bins->state;
+
+    uint64_t start = timestamp - timestamp % bins->interval;
+
+    if (state->recorded == 0)
+    {
+        lai_metadata_pm_reset_slot(bins, state->head, start);
+
+        state->recorded = 1;
+    }
+    else if (start < state->start[state->head])
+    {
+        LAI_META_LOG_WARN("sample time %llu is before current bin %llu, ignoring",
+                (unsigned long long)timestamp, (unsigned long long)state->start[state->head]);
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+    else if (start > state->start[state->head])
+    {
+        uint64_t steps = (start - state->start[state->head]) / bins->interval;
+
+        /* skipped intervals are recorded as empty bins */
+
+        steps = (steps > state->slots) ? state->slots : steps;
+
+        for (; steps > 0; --steps)
+        {
+            state->head = (state->head + 1) % state->slots;
+
+            lai_metadata_pm_reset_slot(bins, state->head, start - (steps - 1) * bins->interval);
+
+            state->recorded += (state->recorded < state->slots) ? 1 : 0;
+        }
+    }
+
+    size_t n = bins->object_count;
+    size_t slot = state->head;
+
+    size_t idx = 0;
+
+    for (; idx < bins->stat_count; ++idx)
+    {
+        const lai_stat_metadata_t *md = bins->stat_metadata[idx];
+
+        size_t col = state->column[idx];
+
+        uint64_t *samples = &state->samples[(slot * bins->stat_count + idx) * n];
+
+        if (md->statvalueiscounter)
+        {
+            lai_metadata_pm_extract_counters(md, n, bins->stat_count, &counters[idx], state->rawcounters);
+
+            lai_metadata_pm_update_counters(n, bins->mode, state->rawcounters,
+                    &state->previous[col * n],
+                    &state->hasprevious[col * n],
+                    &state->totals[(slot * state->counter_columns + col) * n],
+                    samples);
+        }
+        else
+        {
+            lai_metadata_pm_extract_gauges(md, n, bins->stat_count, &counters[idx], state->rawgauges);
+
+            lai_metadata_pm_update_gauges(n, state->rawgauges,
+                    &state->gauges[(slot * state->gauge_columns + col) * PM_GAUGE_FIELDS * n],
+                    samples);
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_pm_bins_get(
+        _In_ const lai_metadata_pm_bins_t *bins,
+        _In_ size_t bin,
+        _In_ size_t object_index,
+        _In_ size_t stat_index,
+        _Out_ lai_metadata_pm_value_t *value)
+{
+    if (bins == NULL || bins->state == NULL || value == NULL)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: bins or value is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (object_index >= bins->object_count || stat_index >= bins->stat_count)
+    {
+        LAI_META_LOG_ERROR("object index %zu or stat index %zu out of range", object_index, stat_index);
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    const lai_metadata_pm_state_t *state = (const lai_metadata_pm_state_t*)bins->state;
+
+    if (bin >= state->recorded)
+    {
+        return LAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    size_t n = bins->object_count;
+    size_t slot = (state->head + state->slots - bin) % state->slots;
+    size_t col = state->column[stat_index];
+
+    memset(value, 0, sizeof(lai_metadata_pm_value_t));
+
+    value->start_time = state->start[slot];
+    value->samples = state->samples[(slot * bins->stat_count + stat_index) * n + object_index];
+
+    if (bins->stat_metadata[stat_index]->statvalueiscounter)
+    {
+        value->total = state->totals[(slot * state->counter_columns + col) * n + object_index];
+
+        return LAI_STATUS_SUCCESS;
+    }
+
+    const double *g = &state->gauges[(slot * state->gauge_columns + col) * PM_GAUGE_FIELDS * n];
+
+    if (value->samples == 0)
+    {
+        value->min = value->max = value->avg = value->last = __builtin_nan("");
+
+        return LAI_STATUS_SUCCESS;
+    }
+
+    g += object_index * PM_GAUGE_FIELDS;
+
+    value->min = g[PM_GAUGE_MIN];
+    value->max = g[PM_GAUGE_MAX];
+    value->avg = g[PM_GAUGE_SUM] / (double)value->samples;
+    value->last = g[PM_GAUGE_LAST];
+
+    return LAI_STATUS_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatapm.h
+ *
+ * @brief   This module defines LAI Metadata Performance Monitoring Bins
+ */
+
+#ifndef __LAIMETADATAPM_H_
+#define __LAIMETADATAPM_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATAPM LAI - Metadata Performance Monitoring Bins Definitions
+ *
+ * Bins keep performance monitoring data for a set of objects of the same
+ * object type and the same list of statistics, for example all OCH objects
+ * with their power and OSNR gauges. Typical use is one bins instance with
+ * 900 seconds interval and one with 86400 seconds interval.
+ *
+ * Statistics with iscounter metadata are accumulated over the interval,
+ * other statistics are gauges and keep min, max, average and last value.
+ *
+ * @{
+ */
+
+/**
+ * @brief Performance monitoring value of single statistics in single bin
+ */
+typedef struct _lai_metadata_pm_value_t
+{
+    /**
+     * @brief Bin start time in seconds.
+     */
+    uint64_t start_time;
+
+    /**
+     * @brief Number of valid samples in the bin.
+     */
+    uint64_t samples;
+
+    /**
+     * @brief Counter increase over the bin, valid for counters.
+     */
+    uint64_t total;
+
+    /**
+     * @brief Minimal value, valid for gauges.
+     */
+    lai_double_t min;
+
+    /**
+     * @brief Maximal value, valid for gauges.
+     */
+    lai_double_t max;
+
+    /**
+     * @brief Average value, valid for gauges.
+     */
+    lai_double_t avg;
+
+    /**
+     * @brief Last value, valid for gauges.
+     */
+    lai_double_t last;
+
+} lai_metadata_pm_value_t;
+
+/**
+ * @brief Performance monitoring bins
+ */
+typedef struct _lai_metadata_pm_bins_t
+{
+    /**
+     * @brief Object type of binned objects.
+     */
+    lai_object_type_t object_type;
+
+    /**
+     * @brief Number of binned objects.
+     */
+    size_t object_count;
+
+    /**
+     * @brief Number of statistics per object.
+     */
+    size_t stat_count;
+
+    /**
+     * @brief Statistics metadata, array of stat_count elements.
+     */
+    const lai_stat_metadata_t **stat_metadata;
+
+    /**
+     * @brief Bin interval in seconds.
+     */
+    uint64_t interval;
+
+    /**
+     * @brief Number of completed bins kept in history.
+     */
+    size_t history;
+
+    /**
+     * @brief Statistics mode used to read counters.
+     *
+     * For #LAI_STATS_MODE_READ counters are cumulative and bins accumulate
+     * difference from previous sample, for #LAI_STATS_MODE_READ_AND_CLEAR
+     * each sample is already an increase.
+     */
+    lai_stats_mode_t mode;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_pm_bins_t;
+
+/**
+ * @brief Initializes performance monitoring bins
+ *
+ * @param[out] bins Bins to be initialized
+ * @param[in] object_type Object type of binned objects
+ * @param[in] object_count Number of binned objects
+ * @param[in] number_of_counters Number of statistics per object
+ * @param[in] counter_ids Statistics ids, the same for each object
+ * @param[in] interval Bin interval in seconds
+ * @param[in] history Number of completed bins kept in history
+ * @param[in] mode Statistics mode used to read counters
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_pm_bins_init(
+        _Out_ lai_metadata_pm_bins_t *bins,
+        _In_ lai_object_type_t object_type,
+        _In_ size_t object_count,
+        _In_ size_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids,
+        _In_ uint64_t interval,
+        _In_ size_t history,
+        _In_ lai_stats_mode_t mode);
+
+/**
+ * @brief Releases performance monitoring bins
+ *
+ * @param[inout] bins Bins to be released
+ */
+extern void lai_metadata_pm_bins_free(
+        _Inout_ lai_metadata_pm_bins_t *bins);
+
+/**
+ * @brief Updates bins with statistics snapshot of all objects
+ *
+ * Values are stored object after object, each object has statistics in
+ * the same order as passed at initialization, which is the layout of consecutive
+ * get_stats_ext calls. Gauge value NaN marks missing sample.
+ *
+ * When timestamp enters new interval, current bin is moved to history.
+ *
+ * @param[inout] bins Performance monitoring bins
+ * @param[in] timestamp Sample time in seconds
+ * @param[in] counters Statistics values, array of object_count * stat_count elements
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_pm_bins_update(
+        _Inout_ lai_metadata_pm_bins_t *bins,
+        _In_ uint64_t timestamp,
+        _In_ const lai_stat_value_t *counters);
+
+/**
+ * @brief Gets value of single statistics from bin
+ *
+ * @param[in] bins Performance monitoring bins
+ * @param[in] bin Bin index, 0 is current bin, 1 is most recent completed bin
+ * @param[in] object_index Object index
+ * @param[in] stat_index Statistics index
+ * @param[out] value Bin value
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_ITEM_NOT_FOUND if bin
+ * was not yet recorded, failure status code on error
+ */
+extern lai_status_t lai_metadata_pm_bins_get(
+        _In_ const lai_metadata_pm_bins_t *bins,
+        _In_ size_t bin,
+        _In_ size_t object_index,
+        _In_ size_t stat_index,
+        _Out_ lai_metadata_pm_value_t *value);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATAPM_H_ */
@@ -0,0 +1,678 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataprofile.c
+ *
+ * @brief   This module implements LAI Metadata Profile Cache
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <lai.h>
+#include "laimetadataprofile.h"
+#include "laimetadata.h"
+
+/*
+ * Open addressing table of entry pointers with linear probing, capacity is
+ * power of two and kept at most half full. Entries do not move when table
+ * grows, so returned values stay valid until reload. Entry owns copies of
+ * name and value, strings returned by host are not referenced after load.
+ *
+ * When host does not enumerate profile, lookups fill table lazily and
+ * variables which do not exist are cached too, so host is asked only once
+ * for each name. Lazy lookups find and store under lock of cache, lookups
+ * of loaded profile only read table and take no lock.
+ */
+
+#define PROFILE_MIN_CAPACITY    16
+#define PROFILE_FNV_OFFSET      0xcbf29ce484222325ULL
+#define PROFILE_FNV_PRIME       0x100000001b3ULL
+
+typedef struct _lai_metadata_profile_entry_t
+{
+    uint64_t hash;
+    char *name;
+    char *text;
+    bool present;
+    lai_metadata_profile_value_t value;
+
+} lai_metadata_profile_entry_t;
+
+typedef struct _lai_metadata_profile_state_t
+{
+    lai_service_method_table_t services;
+    bool lazy;
+
+    /* serializes lazy lookups */
+
+    pthread_mutex_t lock;
+
+    lai_metadata_profile_change_handler_fn handler;
+
+    lai_metadata_profile_entry_t **entries;
+    size_t capacity;
+    size_t used;
+
+} lai_metadata_profile_state_t;
+
+static uint64_t lai_metadata_profile_hash(
+        _In_ const char *name)
+{
+    uint64_t hash = PROFILE_FNV_OFFSET;
+
+    while (*name)
+    {
+        hash ^= (unsigned char)*name++;
+        hash *= PROFILE_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static char* lai_metadata_profile_strdup(
+        _In_ const char *str)
+{
+    size_t len = strlen(str) + 1;
+    char *copy = (char*)malloc(len);
+
+    if (copy != NULL)
+    {
+        memcpy(copy, str, len);
+    }
+
+    return copy;
+}
+
+static void lai_metadata_profile_parse(
+        _Inout_ lai_metadata_profile_value_t *value,
+        _In_ const char *text)
+{
+    const char *digits = text;
+    char *end;
+    long long s64;
+    double d64;
+
+    memset(value, 0, sizeof(*value));
+
+    value->type = LAI_METADATA_PROFILE_VALUE_TYPE_STRING;
+    value->chardata = text;
+
+    if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0)
+    {
+        value->type = LAI_METADATA_PROFILE_VALUE_TYPE_BOOL;
+        value->booldata = (text[0] == 't');
+        return;
+    }
+
+    if (*text == 0)
+    {
+        return;
+    }
+
+    if (*digits == '-' || *digits == '+')
+    {
+        digits++;
+    }
+
+    /* decimal or hex, leading zero is not taken as octal */
+
+    errno = 0;
+
+    if (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+    {
+        s64 = strtoll(text, &end, 16);
+    }
+    else
+    {
+        s64 = strtoll(text, &end, 10);
+    }
+
+    if (*end == 0 && errno == 0)
+    {
+        value->type = LAI_METADATA_PROFILE_VALUE_TYPE_INT;
+        value->s64 = (int64_t)s64;
+        value->d64 = (lai_double_t)s64;
+        return;
+    }
+
+    errno = 0;
+
+    d64 = strtod(text, &end);
+
+    if (*end == 0 && errno == 0)
+    {
+        value->type = LAI_METADATA_PROFILE_VALUE_TYPE_DOUBLE;
+        value->d64 = d64;
+    }
+}
+
+static lai_metadata_profile_entry_t* lai_metadata_profile_find(
+        _In_ const lai_metadata_profile_state_t *state,
+        _In_ const char *name,
+        _In_ uint64_t hash)
+{
+    size_t mask = state->capacity - 1;
+    size_t idx;
+
+    if (state->capacity == 0)
+    {
+        return NULL;
+    }
+
+    for (idx = (size_t)hash & mask; state->entries[idx] != NULL; idx = (idx + 1) & mask)
+    {
+        if (state->entries[idx]->hash == hash && strcmp(state->entries[idx]->name, name) == 0)
+        {
+            return state->entries[idx];
+        }
+    }
+
+    return NULL;
+}
+
+static void lai_metadata_profile_entries_free(
+        _Inout_ lai_metadata_profile_entry_t **entries,
+        _In_ size_t capacity)
+{
+    size_t idx;
+
+    if (entries == NULL)
+    {
+        return;
+    }
+
+    for (idx = 0; idx < capacity; idx++)
+    {
+        if (entries[idx] != NULL)
+        {
+            free(entries[idx]->name);
+            free(entries[idx]->text);
+            free(entries[idx]);
+        }
+    }
+
+    free(entries);
+}
+
+static lai_status_t lai_metadata_profile_grow(
+        _Inout_ lai_metadata_profile_state_t *state)
+{
+    lai_metadata_profile_entry_t **entries;
+    size_t capacity;
+    size_t mask;
+    size_t idx;
+    size_t pos;
+
+    if (2 * (state->used + 1) <= state->capacity)
+    {
+        return LAI_STATUS_SUCCESS;
+    }
+
+    capacity = state->capacity == 0 ? PROFILE_MIN_CAPACITY : 2 * state->capacity;
+    mask = capacity - 1;
+
+    entries = (lai_metadata_profile_entry_t**)calloc(capacity, sizeof(lai_metadata_profile_entry_t*));
+
+    if (entries == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < state->capacity; idx++)
+    {
+        if (state->entries[idx] == NULL)
+        {
+            continue;
+        }
+
+        for (pos = (size_t)state->entries[idx]->hash & mask; entries[pos] != NULL; pos = (pos + 1) & mask)
+        {
+        }
+
+        entries[pos] = state->entries[idx];
+    }
+
+    free(state->entries);
+
+    state->entries = entries;
+    state->capacity = capacity;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+/*
+ * Inserts or replaces variable, value NULL caches missing variable. Returns
+ * entry through changed when stored value differs from previous one.
+ */
+static lai_status_t lai_metadata_profile_store(
+        _Inout_ lai_metadata_profile_state_t *state,
+        _In_ const char *name,
+        _In_ const char *text,
+        _Out_ lai_metadata_profile_entry_t **changed)
+{
+    lai_metadata_profile_entry_t *entry;
+    uint64_t hash = lai_metadata_profile_hash(name);
+    size_t mask;
+    size_t pos;
+    char *copy = NULL;
+
+    *changed = NULL;
+
+    entry = lai_metadata_profile_find(state, name, hash);
+
+    if (entry != NULL)
+    {
+        if (!entry->present && text == NULL)
+        {
+            return LAI_STATUS_SUCCESS;
+        }
+
+        if (entry->present && text != NULL && strcmp(entry->text, text) == 0)
+        {
+            return LAI_STATUS_SUCCESS;
+        }
+    }
+
+    if (text != NULL && (copy = lai_metadata_profile_strdup(text)) == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    if (entry == NULL)
+    {
+        if (lai_metadata_profile_grow(state) != LAI_STATUS_SUCCESS)
+        {
+            free(copy);
+            return LAI_STATUS_NO_MEMORY;
+        }
+
+        entry = (lai_metadata_profile_entry_t*)calloc(1, sizeof(lai_metadata_profile_entry_t));
+
+        if (entry == NULL || (entry->name = lai_metadata_profile_strdup(name)) == NULL)
+        {
+            free(entry);
+            free(copy);
+            return LAI_STATUS_NO_MEMORY;
+        }
+
+        entry->hash = hash;
+
+        mask = state->capacity - 1;
+
+        for (pos = (size_t)hash & mask; state->entries[pos] != NULL; pos = (pos + 1) & mask)
+        {
+        }
+
+        state->entries[pos] = entry;
+        state->used++;
+    }
+
+    free(entry->text);
+
+    entry->text = copy;
+    entry->present = (copy != NULL);
+
+    if (copy != NULL)
+    {
+        lai_metadata_profile_parse(&entry->value, copy);
+    }
+    else
+    {
+        memset(&entry->value, 0, sizeof(entry->value));
+    }
+
+    *changed = entry;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static size_t lai_metadata_profile_count(
+        _In_ const lai_metadata_profile_state_t *state)
+{
+    size_t count = 0;
+    size_t idx;
+
+    for (idx = 0; idx < state->capacity; idx++)
+    {
+        count += (state->entries[idx] != NULL && state->entries[idx]->present);
+    }
+
+    return count;
+}
+
+static lai_status_t lai_metadata_profile_enumerate(
+        _Inout_ lai_metadata_profile_state_t *state,
+        _In_ lai_linecard_profile_id_t profile_id)
+{
+    const char *variable = NULL;
+    const char *value = NULL;
+    lai_metadata_profile_entry_t *changed;
+    lai_status_t status;
+
+    /* restart enumeration */
+
+    state->services.profile_get_next_value(profile_id, NULL, NULL);
+
+    while (state->services.profile_get_next_value(profile_id, &variable, &value) == 0)
+    {
+        if (variable == NULL || value == NULL)
+        {
+            continue;
+        }
+
+        status = lai_metadata_profile_store(state, variable, value, &changed);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_profile_key_init(
+        _Out_ lai_metadata_profile_key_t *key,
+        _In_ const char *name)
+{
+    key->name = name;
+    key->hash = lai_metadata_profile_hash(name);
+}
+
+lai_status_t lai_metadata_profile_load(
+        _Out_ lai_metadata_profile_t *profile,
+        _In_ lai_linecard_profile_id_t profile_id,
+        _In_ const lai_service_method_table_t *services)
+{
+    lai_metadata_profile_state_t *state;
+    lai_status_t status;
+
+    if (profile == NULL || services == NULL)
+    {
+        LAI_META_LOG_ERROR("profile or services parameter is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(profile, 0, sizeof(*profile));
+
+    if (services->profile_get_value == NULL && services->profile_get_next_value == NULL)
+    {
+        LAI_META_LOG_ERROR("services provide no profile access");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    state = (lai_metadata_profile_state_t*)calloc(1, sizeof(lai_metadata_profile_state_t));
+
+    if (state == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    state->services = *services;
+    state->lazy = (services->profile_get_next_value == NULL);
+
+    pthread_mutex_init(&state->lock, NULL);
+
+    if (!state->lazy)
+    {
+        status = lai_metadata_profile_enumerate(state, profile_id);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            lai_metadata_profile_entries_free(state->entries, state->capacity);
+            pthread_mutex_destroy(&state->lock);
+            free(state);
+
+            return status;
+        }
+    }
+
+    profile->profile_id = profile_id;
+    profile->count = lai_metadata_profile_count(state);
+    profile->state = state;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_profile_set_change_handler(
+        _Inout_ lai_metadata_profile_t *profile,
+        _In_ lai_metadata_profile_change_handler_fn handler)
+{
+    if (profile != NULL && profile->state != NULL)
+    {
+        ((lai_metadata_profile_state_t*)profile->state)->handler = handler;
+    }
+}
+
+lai_status_t lai_metadata_profile_reload(
+        _Inout_ lai_metadata_profile_t *profile)
+{
+    lai_metadata_profile_state_t *state;
+    lai_metadata_profile_state_t fresh;
+    lai_metadata_profile_entry_t *changed;
+    lai_metadata_profile_entry_t *entry;
+    lai_status_t status;
+    uint64_t changes = 0;
+    size_t idx;
+
+    if (profile == NULL || profile->state == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    state = (lai_metadata_profile_state_t*)profile->state;
+
+    memset(&fresh, 0, sizeof(fresh));
+
+    fresh.services = state->services;
+    fresh.lazy = state->lazy;
+    fresh.handler = state->handler;
+
+    if (state->lazy)
+    {
+        /* only variables asked for so far are known */
+
+        for (idx = 0; idx < state->capacity; idx++)
+        {
+            if ((entry = state->entries[idx]) == NULL)
+            {
+                continue;
+            }
+
+            status = lai_metadata_profile_store(&fresh, entry->name,
+                    state->services.profile_get_value(profile->profile_id, entry->name), &changed);
+
+            if (status != LAI_STATUS_SUCCESS)
+            {
+                lai_metadata_profile_entries_free(fresh.entries, fresh.capacity);
+                return status;
+            }
+        }
+    }
+    else
+    {
+        status = lai_metadata_profile_enumerate(&fresh, profile->profile_id);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            lai_metadata_profile_entries_free(fresh.entries, fresh.capacity);
+            return status;
+        }
+    }
+
+    for (idx = 0; idx < fresh.capacity; idx++)
+    {
+        if ((changed = fresh.entries[idx]) == NULL)
+        {
+            continue;
+        }
+
+        entry = lai_metadata_profile_find(state, changed->name, changed->hash);
+
+        if (entry == NULL ? !changed->present :
+                (entry->present == changed->present && (!entry->present || strcmp(entry->text, changed->text) == 0)))
+        {
+            continue;
+        }
+
+        changes++;
+
+        if (state->handler != NULL)
+        {
+            state->handler(profile->profile_id, changed->name, changed->present ? &changed->value : NULL);
+        }
+    }
+
+    for (idx = 0; idx < state->capacity; idx++)
+    {
+        entry = state->entries[idx];
+
+        if (entry == NULL || !entry->present ||
+                lai_metadata_profile_find(&fresh, entry->name, entry->hash) != NULL)
+        {
+            continue;
+        }
+
+        changes++;
+
+        if (state->handler != NULL)
+        {
+            state->handler(profile->profile_id, entry->name, NULL);
+        }
+    }
+
+    lai_metadata_profile_entries_free(state->entries, state->capacity);
+
+    state->entries = fresh.entries;
+    state->capacity = fresh.capacity;
+    state->used = fresh.used;
+
+    profile->count = lai_metadata_profile_count(state);
+    profile->version += (changes != 0);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_profile_free(
+        _Inout_ lai_metadata_profile_t *profile)
+{
+    lai_metadata_profile_state_t *state;
+
+    if (profile == NULL || profile->state == NULL)
+    {
+        return;
+    }
+
+    state = (lai_metadata_profile_state_t*)profile->state;
+
+    lai_metadata_profile_entries_free(state->entries, state->capacity);
+
+    pthread_mutex_destroy(&state->lock);
+
+    free(state);
+
+    profile->state = NULL;
+    profile->count = 0;
+}
+
+const lai_metadata_profile_value_t* lai_metadata_profile_get(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key)
+{
+    lai_metadata_profile_state_t *state;
+    lai_metadata_profile_entry_t *entry;
+
+    if (profile == NULL || profile->state == NULL || key == NULL || key->name == NULL)
+    {
+        return NULL;
+    }
+
+    state = (lai_metadata_profile_state_t*)profile->state;
+
+    if (!state->lazy)
+    {
+        entry = lai_metadata_profile_find(state, key->name, key->hash);
+
+        return (entry != NULL && entry->present) ? &entry->value : NULL;
+    }
+
+    pthread_mutex_lock(&state->lock);
+
+    entry = lai_metadata_profile_find(state, key->name, key->hash);
+
+    if (entry == NULL &&
+            lai_metadata_profile_store(state, key->name,
+                state->services.profile_get_value(profile->profile_id, key->name), &entry) != LAI_STATUS_SUCCESS)
+    {
+        entry = NULL;
+    }
+
+    pthread_mutex_unlock(&state->lock);
+
+    return (entry != NULL && entry->present) ? &entry->value : NULL;
+}
+
+int64_t lai_metadata_profile_get_int(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key,
+        _In_ int64_t defvalue)
+{
+    const lai_metadata_profile_value_t *value = lai_metadata_profile_get(profile, key);
+
+    return (value != NULL && value->type == LAI_METADATA_PROFILE_VALUE_TYPE_INT) ? value->s64 : defvalue;
+}
+
+lai_double_t lai_metadata_profile_get_double(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key,
+        _In_ lai_double_t defvalue)
+{
+    const lai_metadata_profile_value_t *value = lai_metadata_profile_get(profile, key);
+
+    if (value != NULL &&
+            (value->type == LAI_METADATA_PROFILE_VALUE_TYPE_INT || value->type == LAI_METADATA_PROFILE_VALUE_TYPE_DOUBLE))
+    {
+        return value->d64;
+    }
+
+    return defvalue;
+}
+
+bool lai_metadata_profile_get_bool(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key,
+        _In_ bool defvalue)
+{
+    const lai_metadata_profile_value_t *value = lai_metadata_profile_get(profile, key);
+
+    return (value != NULL && value->type == LAI_METADATA_PROFILE_VALUE_TYPE_BOOL) ? value->booldata : defvalue;
+}
+
+const char* lai_metadata_profile_get_string(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key,
+        _In_ const char *defvalue)
+{
+    const lai_metadata_profile_value_t *value = lai_metadata_profile_get(profile, key);
+
+    return value != NULL ? value->chardata : defvalue;
+}
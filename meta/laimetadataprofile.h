@@ -0,0 +1,277 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataprofile.h
+ *
+ * @brief   This module defines LAI Metadata Profile Cache
+ */
+
+#ifndef __LAIMETADATAPROFILE_H_
+#define __LAIMETADATAPROFILE_H_
+
+#include <lai.h>
+
+/**
+ * @defgroup LAIMETADATAPROFILE LAI - Metadata Profile Cache Definitions
+ *
+ * Profile services of adapter host are string keyed and return strings, so
+ * every lookup walks host profile and every number is parsed again. Profile
+ * cache loads whole profile once into hash table, every value is parsed
+ * once into its type.
+ *
+ * Lookup takes key with precomputed hash, so hot paths only compare hash
+ * and name of single entry. Reload compares new profile with cached one and
+ * calls change handler for every added, changed or removed variable.
+ *
+ * Lookups may run concurrently, lazy lookups which fill the table take lock
+ * of cache. Reload must be serialized with lookups by caller.
+ *
+ * @{
+ */
+
+/**
+ * @brief Type of profile value
+ */
+typedef enum _lai_metadata_profile_value_type_t
+{
+    LAI_METADATA_PROFILE_VALUE_TYPE_STRING,
+
+    LAI_METADATA_PROFILE_VALUE_TYPE_INT,
+
+    LAI_METADATA_PROFILE_VALUE_TYPE_DOUBLE,
+
+    LAI_METADATA_PROFILE_VALUE_TYPE_BOOL,
+
+} lai_metadata_profile_value_type_t;
+
+/**
+ * @brief Parsed profile value
+ */
+typedef struct _lai_metadata_profile_value_t
+{
+    /**
+     * @brief Type detected when value was parsed.
+     */
+    lai_metadata_profile_value_type_t type;
+
+    /**
+     * @brief Value as integer, valid for integer type.
+     */
+    int64_t s64;
+
+    /**
+     * @brief Value as double, valid for integer and double type.
+     */
+    lai_double_t d64;
+
+    /**
+     * @brief Value as bool, valid for bool type.
+     */
+    bool booldata;
+
+    /**
+     * @brief Value as returned by adapter host, valid for all types.
+     */
+    const char *chardata;
+
+} lai_metadata_profile_value_t;
+
+/**
+ * @brief Profile variable key with precomputed hash
+ */
+typedef struct _lai_metadata_profile_key_t
+{
+    /**
+     * @brief Variable name.
+     */
+    const char *name;
+
+    /**
+     * @brief Hash of variable name.
+     */
+    uint64_t hash;
+
+} lai_metadata_profile_key_t;
+
+/**
+ * @brief Profile variable change handler
+ *
+ * @param[in] profile_id Profile id
+ * @param[in] variable Variable name
+ * @param[in] value New value, NULL when variable was removed
+ */
+typedef void (*lai_metadata_profile_change_handler_fn)(
+        _In_ lai_linecard_profile_id_t profile_id,
+        _In_ const char *variable,
+        _In_ const lai_metadata_profile_value_t *value);
+
+/**
+ * @brief Profile cache
+ */
+typedef struct _lai_metadata_profile_t
+{
+    /**
+     * @brief Profile id passed to services.
+     */
+    lai_linecard_profile_id_t profile_id;
+
+    /**
+     * @brief Number of cached variables, not updated by lazy lookups.
+     */
+    size_t count;
+
+    /**
+     * @brief Incremented by every reload which changed some variable.
+     */
+    uint64_t version;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_profile_t;
+
+/**
+ * @brief Initializes key of profile variable
+ *
+ * @param[out] key Key to be initialized
+ * @param[in] name Variable name, must remain valid while key is used
+ */
+extern void lai_metadata_profile_key_init(
+        _Out_ lai_metadata_profile_key_t *key,
+        _In_ const char *name);
+
+/**
+ * @brief Loads profile into cache
+ *
+ * Whole profile is loaded when host provides profile_get_next_value.
+ * Otherwise variables are cached on first lookup through profile_get_value.
+ *
+ * @param[out] profile Profile cache to be loaded
+ * @param[in] profile_id Profile id
+ * @param[in] services Services provided by adapter host
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_profile_load(
+        _Out_ lai_metadata_profile_t *profile,
+        _In_ lai_linecard_profile_id_t profile_id,
+        _In_ const lai_service_method_table_t *services);
+
+/**
+ * @brief Sets handler called by reload for every changed variable
+ *
+ * @param[inout] profile Profile cache
+ * @param[in] handler Change handler, NULL disables notifications
+ */
+extern void lai_metadata_profile_set_change_handler(
+        _Inout_ lai_metadata_profile_t *profile,
+        _In_ lai_metadata_profile_change_handler_fn handler);
+
+/**
+ * @brief Reloads profile and notifies changed variables
+ *
+ * Values returned by previous lookups are invalid after reload.
+ *
+ * @param[inout] profile Profile cache
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_profile_reload(
+        _Inout_ lai_metadata_profile_t *profile);
+
+/**
+ * @brief Releases profile cache
+ *
+ * @param[inout] profile Profile cache
+ */
+extern void lai_metadata_profile_free(
+        _Inout_ lai_metadata_profile_t *profile);
+
+/**
+ * @brief Gets profile value
+ *
+ * Returned value stays valid until reload or free of cache.
+ *
+ * @param[in] profile Profile cache
+ * @param[in] key Variable key
+ *
+ * @return Value or NULL if variable does not exist
+ */
+extern const lai_metadata_profile_value_t* lai_metadata_profile_get(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key);
+
+/**
+ * @brief Gets profile value as integer
+ *
+ * @param[in] profile Profile cache
+ * @param[in] key Variable key
+ * @param[in] defvalue Value returned when variable does not exist or is not integer
+ *
+ * @return Variable value or default value
+ */
+extern int64_t lai_metadata_profile_get_int(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key,
+        _In_ int64_t defvalue);
+
+/**
+ * @brief Gets profile value as double
+ *
+ * @param[in] profile Profile cache
+ * @param[in] key Variable key
+ * @param[in] defvalue Value returned when variable does not exist or is not number
+ *
+ * @return Variable value or default value
+ */
+extern lai_double_t lai_metadata_profile_get_double(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key,
+        _In_ lai_double_t defvalue);
+
+/**
+ * @brief Gets profile value as bool
+ *
+ * @param[in] profile Profile cache
+ * @param[in] key Variable key
+ * @param[in] defvalue Value returned when variable does not exist or is not bool
+ *
+ * @return Variable value or default value
+ */
+extern bool lai_metadata_profile_get_bool(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key,
+        _In_ bool defvalue);
+
+/**
+ * @brief Gets profile value as string
+ *
+ * @param[in] profile Profile cache
+ * @param[in] key Variable key
+ * @param[in] defvalue Value returned when variable does not exist
+ *
+ * @return Variable value or default value
+ */
+extern const char* lai_metadata_profile_get_string(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key,
+        _In_ const char *defvalue);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATAPROFILE_H_ */
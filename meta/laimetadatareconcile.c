@@ -0,0 +1,991 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatareconcile.c
+ *
+ * @brief   This module implements LAI Metadata Warm Restart Reconciliation
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <lai.h>
+#include "laimetadatautils.h"
+#include "laimetadatalogger.h"
+#include "laimetadata.h"
+
+typedef struct _lai_metadata_reconcile_state_t
+{
+    /* create attributes of all create operations */
+
+    lai_attribute_t *attrs;
+
+    /* create operations sorted by stored object id */
+
+    lai_metadata_reconcile_op_t **creates;
+
+    size_t create_count;
+
+} lai_metadata_reconcile_state_t;
+
+typedef struct _lai_metadata_reconcile_builder_t
+{
+    /* NULL in counting pass */
+
+    lai_metadata_reconcile_op_t *ops;
+
+    lai_attribute_t *attrs;
+
+    size_t op_count;
+
+    size_t attr_count;
+
+    size_t unchanged;
+
+    uint32_t order[LAI_OBJECT_TYPE_MAX];
+
+    /* live objects removed or recreated by plan, by position in sorted live set */
+
+    bool *removed;
+
+} lai_metadata_reconcile_builder_t;
+
+static bool lai_metadata_reconcile_is_settable(
+        _In_ const lai_attr_metadata_t *md)
+{
+    return LAI_HAS_FLAG_CREATE_AND_SET(md->flags) || LAI_HAS_FLAG_SET_ONLY(md->flags);
+}
+
+static void lai_metadata_reconcile_order(
+        _Out_ uint32_t *order)
+{
+    const lai_object_type_info_t *info;
+    const lai_attr_metadata_t *md;
+    bool changed = true;
+    uint32_t pass;
+    size_t ot;
+    size_t idx;
+    size_t jdx;
+
+    for (ot = 0; ot < LAI_OBJECT_TYPE_MAX; ot++)
+    {
+        order[ot] = (ot == LAI_OBJECT_TYPE_LINECARD) ? 0 : 1;
+    }
+
+    /* longest path, passes are bounded so cycle can't loop forever */
+
+    for (pass = 0; changed && pass < LAI_OBJECT_TYPE_MAX; pass++)
+    {
+        changed = false;
+
+        for (ot = 0; ot < LAI_OBJECT_TYPE_MAX; ot++)
+        {
+            info = lai_metadata_get_object_type_info((lai_object_type_t)ot);
+
+            if (info == NULL)
+            {
+                continue;
+            }
+
+            for (idx = 0; idx < info->attrmetadatalength; idx++)
+            {
+                md = info->attrmetadata[idx];
+
+                if (!md->isoidattribute || LAI_HAS_FLAG_READ_ONLY(md->flags))
+                {
+                    continue;
+                }
+
+                for (jdx = 0; jdx < md->allowedobjecttypeslength; jdx++)
+                {
+                    lai_object_type_t dep = md->allowedobjecttypes[jdx];
+
+                    if ((size_t)dep != ot && order[ot] <= order[dep] && order[dep] < LAI_OBJECT_TYPE_MAX)
+                    {
+                        order[ot] = order[dep] + 1;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void lai_metadata_reconcile_emit(
+        _Inout_ lai_metadata_reconcile_builder_t *builder,
+        _In_ lai_metadata_reconcile_op_kind_t kind,
+        _In_ const lai_metadata_reconcile_object_t *object,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    lai_metadata_reconcile_op_t *op;
+
+    if (builder->ops != NULL)
+    {
+        op = &builder->ops[builder->op_count];
+
+        op->kind = kind;
+        op->object_type = object->object_type;
+        op->order = builder->order[object->object_type];
+        op->object_id = object->object_id;
+        op->attr_count = attr_count;
+        op->attr_list = attr_list;
+        op->created_id = LAI_NULL_OBJECT_ID;
+    }
+
+    builder->op_count++;
+}
+
+static lai_status_t lai_metadata_reconcile_create(
+        _Inout_ lai_metadata_reconcile_builder_t *builder,
+        _In_ const lai_metadata_reconcile_object_t *object)
+{
+    const lai_attr_metadata_t *md;
+    lai_attribute_t *attrs = NULL;
+    uint32_t count = 0;
+    uint32_t idx;
+
+    if (builder->attrs != NULL)
+    {
+        attrs = &builder->attrs[builder->attr_count];
+    }
+
+    for (idx = 0; idx < object->attr_count; idx++)
+    {
+        md = lai_metadata_get_attr_metadata(object->object_type, object->attr_list[idx].id);
+
+        if (!md->isrecoverable || LAI_HAS_FLAG_READ_ONLY(md->flags) || LAI_HAS_FLAG_SET_ONLY(md->flags))
+        {
+            continue;
+        }
+
+        if (attrs != NULL)
+        {
+            attrs[count] = object->attr_list[idx];
+        }
+
+        count++;
+    }
+
+    builder->attr_count += count;
+
+    lai_metadata_reconcile_emit(builder, LAI_METADATA_RECONCILE_OP_KIND_CREATE, object, count, attrs);
+
+    /* set only attributes can be applied only after create */
+
+    for (idx = 0; idx < object->attr_count; idx++)
+    {
+        md = lai_metadata_get_attr_metadata(object->object_type, object->attr_list[idx].id);
+
+        if (md->isrecoverable && LAI_HAS_FLAG_SET_ONLY(md->flags))
+        {
+            lai_metadata_reconcile_emit(builder, LAI_METADATA_RECONCILE_OP_KIND_SET, object, 1, &object->attr_list[idx]);
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_metadata_reconcile_compare(
+        _In_ const lai_metadata_reconcile_object_t *stored,
+        _In_ const lai_metadata_reconcile_object_t *live,
+        _In_ uint32_t index,
+        _Out_ bool *equal)
+{
+    const lai_attr_metadata_t *md = lai_metadata_get_attr_metadata(stored->object_type, stored->attr_list[index].id);
+    const lai_attribute_t *attr;
+
+    *equal = true;
+
+    /* set only attribute can't be read back, so it is applied only on create */
+
+    if (!md->isrecoverable || LAI_HAS_FLAG_READ_ONLY(md->flags) || LAI_HAS_FLAG_SET_ONLY(md->flags))
+    {
+        return LAI_STATUS_SUCCESS;
+    }
+
+    attr = lai_metadata_get_attr_by_id(stored->attr_list[index].id, live->attr_count, live->attr_list);
+
+    *equal = false;
+
+    if (attr == NULL)
+    {
+        return LAI_STATUS_SUCCESS;
+    }
+
+    return lai_metadata_deepequal_attr_value(md, &stored->attr_list[index], attr, equal);
+}
+
+static lai_status_t lai_metadata_reconcile_needs_recreate(
+        _In_ const lai_metadata_reconcile_object_t *stored,
+        _In_ const lai_metadata_reconcile_object_t *live,
+        _Out_ bool *recreate)
+{
+    lai_status_t status;
+    bool equal;
+    uint32_t idx;
+
+    *recreate = false;
+
+    for (idx = 0; idx < stored->attr_count; idx++)
+    {
+        status = lai_metadata_reconcile_compare(stored, live, idx, &equal);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+
+        if (!equal && !lai_metadata_reconcile_is_settable(lai_metadata_get_attr_metadata(stored->object_type, stored->attr_list[idx].id)))
+        {
+            *recreate = true;
+            break;
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_metadata_reconcile_update(
+        _Inout_ lai_metadata_reconcile_builder_t *builder,
+        _In_ const lai_metadata_reconcile_object_t *stored,
+        _In_ const lai_metadata_reconcile_object_t *live,
+        _In_ bool recreate)
+{
+    size_t first = builder->op_count;
+    lai_status_t status;
+    bool equal;
+    uint32_t idx;
+
+    if (recreate)
+    {
+        /* create carries all stored values */
+
+        lai_metadata_reconcile_emit(builder, LAI_METADATA_RECONCILE_OP_KIND_REMOVE, live, 0, NULL);
+
+        return lai_metadata_reconcile_create(builder, stored);
+    }
+
+    for (idx = 0; idx < stored->attr_count; idx++)
+    {
+        status = lai_metadata_reconcile_compare(stored, live, idx, &equal);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+
+        if (!equal)
+        {
+            lai_metadata_reconcile_emit(builder, LAI_METADATA_RECONCILE_OP_KIND_SET, stored, 1, &stored->attr_list[idx]);
+        }
+    }
+
+    if (builder->op_count == first)
+    {
+        builder->unchanged++;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static int lai_metadata_reconcile_object_cmp(
+        _In_ const void *lhs,
+        _In_ const void *rhs)
+{
+    lai_object_id_t l = (*(const lai_metadata_reconcile_object_t* const*)lhs)->object_id;
+    lai_object_id_t r = (*(const lai_metadata_reconcile_object_t* const*)rhs)->object_id;
+
+    return (l > r) - (l < r);
+}
+
+static int lai_metadata_reconcile_op_cmp(
+        _In_ const void *lhs,
+        _In_ const void *rhs)
+{
+    const lai_metadata_reconcile_op_t *l = (const lai_metadata_reconcile_op_t*)lhs;
+    const lai_metadata_reconcile_op_t *r = (const lai_metadata_reconcile_op_t*)rhs;
+
+    if (l->kind != r->kind)
+    {
+        return (l->kind > r->kind) - (l->kind < r->kind);
+    }
+
+    if (l->order != r->order)
+    {
+        /* dependent objects are removed before objects they depend on */
+
+        if (l->kind == LAI_METADATA_RECONCILE_OP_KIND_REMOVE)
+        {
+            return (l->order < r->order) - (l->order > r->order);
+        }
+
+        return (l->order > r->order) - (l->order < r->order);
+    }
+
+    if (l->object_type != r->object_type)
+    {
+        return (l->object_type > r->object_type) - (l->object_type < r->object_type);
+    }
+
+    if (l->object_id != r->object_id)
+    {
+        return (l->object_id > r->object_id) - (l->object_id < r->object_id);
+    }
+
+    if (l->attr_count != 0 && r->attr_count != 0)
+    {
+        return (l->attr_list->id > r->attr_list->id) - (l->attr_list->id < r->attr_list->id);
+    }
+
+    return 0;
+}
+
+static lai_status_t lai_metadata_reconcile_sort(
+        _Inout_ const lai_metadata_reconcile_object_t **objects,
+        _In_ size_t count,
+        _In_ const lai_metadata_reconcile_object_t *list)
+{
+    size_t idx;
+    uint32_t adx;
+
+    for (idx = 0; idx < count; idx++)
+    {
+        if (!lai_metadata_is_object_type_valid(list[idx].object_type) ||
+                list[idx].object_id == LAI_NULL_OBJECT_ID ||
+                (list[idx].attr_count != 0 && list[idx].attr_list == NULL))
+        {
+            LAI_META_LOG_ERROR("invalid object at index %zu", idx);
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+
+        for (adx = 0; adx < list[idx].attr_count; adx++)
+        {
+            if (lai_metadata_get_attr_metadata(list[idx].object_type, list[idx].attr_list[adx].id) == NULL)
+            {
+                LAI_META_LOG_ERROR("unknown attribute %u on object 0x%llx", list[idx].attr_list[adx].id,
+                        (unsigned long long)list[idx].object_id);
+                return LAI_STATUS_INVALID_PARAMETER;
+            }
+        }
+
+        objects[idx] = &list[idx];
+    }
+
+    qsort(objects, count, sizeof(objects[0]), lai_metadata_reconcile_object_cmp);
+
+    for (idx = 1; idx < count; idx++)
+    {
+        if (objects[idx - 1]->object_id == objects[idx]->object_id)
+        {
+            LAI_META_LOG_ERROR("duplicate object 0x%llx", (unsigned long long)objects[idx]->object_id);
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static size_t lai_metadata_reconcile_find(
+        _In_ size_t count,
+        _In_ const lai_metadata_reconcile_object_t **objects,
+        _In_ lai_object_id_t object_id)
+{
+    size_t lo = 0;
+    size_t hi = count;
+    size_t mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+
+        if (objects[mid]->object_id < object_id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return (lo < count && objects[lo]->object_id == object_id) ? lo : count;
+}
+
+static bool lai_metadata_reconcile_is_removed(
+        _In_ size_t live_count,
+        _In_ const lai_metadata_reconcile_object_t **live,
+        _In_ const bool *removed,
+        _In_ lai_object_id_t object_id)
+{
+    size_t idx = lai_metadata_reconcile_find(live_count, live, object_id);
+
+    return idx < live_count && removed[idx];
+}
+
+/*
+ * Live object depends on removed object when it is placed on removed
+ * linecard or refers to removed object by writable object id attribute.
+ */
+
+static bool lai_metadata_reconcile_depends(
+        _In_ const lai_metadata_reconcile_object_t *object,
+        _In_ size_t live_count,
+        _In_ const lai_metadata_reconcile_object_t **live,
+        _In_ const bool *removed)
+{
+    const lai_attr_metadata_t *md;
+    const lai_attribute_value_t *value;
+    uint32_t idx;
+    uint32_t jdx;
+
+    if (object->object_type != LAI_OBJECT_TYPE_LINECARD &&
+            lai_metadata_reconcile_is_removed(live_count, live, removed, LAI_OBJECT_ID_LINECARD(object->object_id)))
+    {
+        return true;
+    }
+
+    for (idx = 0; idx < object->attr_count; idx++)
+    {
+        md = lai_metadata_get_attr_metadata(object->object_type, object->attr_list[idx].id);
+        value = &object->attr_list[idx].value;
+
+        if (!md->isoidattribute || LAI_HAS_FLAG_READ_ONLY(md->flags))
+        {
+            continue;
+        }
+
+        if (md->attrvaluetype == LAI_ATTR_VALUE_TYPE_OBJECT_ID &&
+                lai_metadata_reconcile_is_removed(live_count, live, removed, value->oid))
+        {
+            return true;
+        }
+
+        if (md->attrvaluetype == LAI_ATTR_VALUE_TYPE_OBJECT_LIST && value->objlist.list != NULL)
+        {
+            for (jdx = 0; jdx < value->objlist.count; jdx++)
+            {
+                if (lai_metadata_reconcile_is_removed(live_count, live, removed, value->objlist.list[jdx]))
+                {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Marks live objects which go away, objects only in live set and objects
+ * with changed create only attribute, then their dependents, which must be
+ * removed before them and created after them.
+ */
+
+static lai_status_t lai_metadata_reconcile_cascade(
+        _In_ size_t stored_count,
+        _In_ const lai_metadata_reconcile_object_t **stored,
+        _In_ size_t live_count,
+        _In_ const lai_metadata_reconcile_object_t **live,
+        _Out_ bool *removed)
+{
+    lai_status_t status;
+    bool changed = true;
+    size_t sdx = 0;
+    size_t ldx;
+
+    for (ldx = 0; ldx < live_count; ldx++)
+    {
+        while (sdx < stored_count && stored[sdx]->object_id < live[ldx]->object_id)
+        {
+            sdx++;
+        }
+
+        removed[ldx] = true;
+
+        if (sdx < stored_count && stored[sdx]->object_id == live[ldx]->object_id &&
+                stored[sdx]->object_type == live[ldx]->object_type)
+        {
+            status = lai_metadata_reconcile_needs_recreate(stored[sdx], live[ldx], &removed[ldx]);
+
+            if (status != LAI_STATUS_SUCCESS)
+            {
+                return status;
+            }
+        }
+    }
+
+    /* every pass marks at least one object, so passes are bounded by live count */
+
+    while (changed)
+    {
+        changed = false;
+
+        for (ldx = 0; ldx < live_count; ldx++)
+        {
+            if (!removed[ldx] && lai_metadata_reconcile_depends(live[ldx], live_count, live, removed))
+            {
+                removed[ldx] = true;
+                changed = true;
+            }
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_metadata_reconcile_walk(
+        _Inout_ lai_metadata_reconcile_builder_t *builder,
+        _In_ size_t stored_count,
+        _In_ const lai_metadata_reconcile_object_t **stored,
+        _In_ size_t live_count,
+        _In_ const lai_metadata_reconcile_object_t **live)
+{
+    lai_status_t status = LAI_STATUS_SUCCESS;
+    size_t sdx = 0;
+    size_t ldx = 0;
+
+    builder->op_count = 0;
+    builder->attr_count = 0;
+    builder->unchanged = 0;
+
+    while (status == LAI_STATUS_SUCCESS && (sdx < stored_count || ldx < live_count))
+    {
+        if (ldx == live_count || (sdx < stored_count && stored[sdx]->object_id < live[ldx]->object_id))
+        {
+            status = lai_metadata_reconcile_create(builder, stored[sdx++]);
+        }
+        else if (sdx == stored_count || live[ldx]->object_id < stored[sdx]->object_id)
+        {
+            lai_metadata_reconcile_emit(builder, LAI_METADATA_RECONCILE_OP_KIND_REMOVE, live[ldx++], 0, NULL);
+        }
+        else if (stored[sdx]->object_type != live[ldx]->object_type)
+        {
+            LAI_META_LOG_ERROR("object 0x%llx has different type in stored and live set",
+                    (unsigned long long)live[ldx]->object_id);
+
+            status = LAI_STATUS_INVALID_PARAMETER;
+        }
+        else
+        {
+            status = lai_metadata_reconcile_update(builder, stored[sdx++], live[ldx], builder->removed[ldx]);
+            ldx++;
+        }
+    }
+
+    return status;
+}
+
+static int lai_metadata_reconcile_create_cmp(
+        _In_ const void *lhs,
+        _In_ const void *rhs)
+{
+    lai_object_id_t l = (*(lai_metadata_reconcile_op_t* const*)lhs)->object_id;
+    lai_object_id_t r = (*(lai_metadata_reconcile_op_t* const*)rhs)->object_id;
+
+    return (l > r) - (l < r);
+}
+
+static lai_status_t lai_metadata_reconcile_finish(
+        _Inout_ lai_metadata_reconcile_plan_t *plan,
+        _Inout_ lai_metadata_reconcile_state_t *state)
+{
+    size_t idx;
+
+    qsort(plan->ops, plan->count, sizeof(plan->ops[0]), lai_metadata_reconcile_op_cmp);
+
+    plan->batches = (lai_metadata_reconcile_batch_t*)calloc(plan->count + 1, sizeof(lai_metadata_reconcile_batch_t));
+    state->creates = (lai_metadata_reconcile_op_t**)calloc(plan->count + 1, sizeof(lai_metadata_reconcile_op_t*));
+
+    if (plan->batches == NULL || state->creates == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < plan->count; idx++)
+    {
+        lai_metadata_reconcile_batch_t *batch = &plan->batches[plan->batch_count - (plan->batch_count != 0)];
+
+        if (plan->batch_count == 0 || batch->kind != plan->ops[idx].kind ||
+                batch->object_type != plan->ops[idx].object_type)
+        {
+            batch = &plan->batches[plan->batch_count++];
+
+            batch->kind = plan->ops[idx].kind;
+            batch->object_type = plan->ops[idx].object_type;
+            batch->first = idx;
+        }
+
+        batch->count++;
+
+        if (plan->ops[idx].kind == LAI_METADATA_RECONCILE_OP_KIND_CREATE)
+        {
+            state->creates[state->create_count++] = &plan->ops[idx];
+        }
+    }
+
+    qsort(state->creates, state->create_count, sizeof(state->creates[0]), lai_metadata_reconcile_create_cmp);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_reconcile(
+        _In_ size_t stored_count,
+        _In_ const lai_metadata_reconcile_object_t *stored,
+        _In_ size_t live_count,
+        _In_ const lai_metadata_reconcile_object_t *live,
+        _Out_ lai_metadata_reconcile_plan_t *plan)
+{
+    const lai_metadata_reconcile_object_t **sorted_stored = NULL;
+    const lai_metadata_reconcile_object_t **sorted_live = NULL;
+    lai_metadata_reconcile_builder_t builder;
+    lai_metadata_reconcile_state_t *state;
+    lai_status_t status;
+
+    if (plan == NULL || (stored_count != 0 && stored == NULL) || (live_count != 0 && live == NULL))
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(plan, 0, sizeof(*plan));
+    memset(&builder, 0, sizeof(builder));
+
+    state = (lai_metadata_reconcile_state_t*)calloc(1, sizeof(lai_metadata_reconcile_state_t));
+    sorted_stored = (const lai_metadata_reconcile_object_t**)calloc(stored_count + 1, sizeof(sorted_stored[0]));
+    sorted_live = (const lai_metadata_reconcile_object_t**)calloc(live_count + 1, sizeof(sorted_live[0]));
+    builder.removed = (bool*)calloc(live_count + 1, sizeof(bool));
+
+    plan->state = state;
+
+    status = (state == NULL || sorted_stored == NULL || sorted_live == NULL || builder.removed == NULL) ?
+        LAI_STATUS_NO_MEMORY : LAI_STATUS_SUCCESS;
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        status = lai_metadata_reconcile_sort(sorted_stored, stored_count, stored);
+    }
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        status = lai_metadata_reconcile_sort(sorted_live, live_count, live);
+    }
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        status = lai_metadata_reconcile_cascade(stored_count, sorted_stored, live_count, sorted_live, builder.removed);
+    }
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        lai_metadata_reconcile_order(builder.order);
+
+        /* first pass only counts operations and create attributes */
+
+        status = lai_metadata_reconcile_walk(&builder, stored_count, sorted_stored, live_count, sorted_live);
+    }
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        builder.ops = (lai_metadata_reconcile_op_t*)calloc(builder.op_count + 1, sizeof(lai_metadata_reconcile_op_t));
+        builder.attrs = (lai_attribute_t*)calloc(builder.attr_count + 1, sizeof(lai_attribute_t));
+
+        plan->ops = builder.ops;
+        state->attrs = builder.attrs;
+
+        status = (builder.ops == NULL || builder.attrs == NULL) ? LAI_STATUS_NO_MEMORY : LAI_STATUS_SUCCESS;
+    }
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        status = lai_metadata_reconcile_walk(&builder, stored_count, sorted_stored, live_count, sorted_live);
+
+        plan->count = builder.op_count;
+        plan->unchanged = builder.unchanged;
+    }
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        status = lai_metadata_reconcile_finish(plan, state);
+    }
+
+    free((void*)sorted_stored);
+    free((void*)sorted_live);
+    free(builder.removed);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        lai_metadata_reconcile_plan_free(plan);
+    }
+
+    return status;
+}
+
+static lai_object_id_t lai_metadata_reconcile_translate(
+        _In_ const lai_metadata_reconcile_state_t *state,
+        _In_ lai_object_id_t object_id)
+{
+    size_t lo = 0;
+    size_t hi = state->create_count;
+    size_t mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+
+        if (state->creates[mid]->object_id < object_id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    if (lo < state->create_count && state->creates[lo]->object_id == object_id &&
+            state->creates[lo]->created_id != LAI_NULL_OBJECT_ID)
+    {
+        return state->creates[lo]->created_id;
+    }
+
+    return object_id;
+}
+
+static void lai_metadata_reconcile_free_attrs(
+        _In_ lai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list)
+{
+    const lai_attr_metadata_t *md;
+    uint32_t idx;
+
+    if (attr_list == NULL)
+    {
+        return;
+    }
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        md = lai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+
+        if (md->attrvaluetype == LAI_ATTR_VALUE_TYPE_OBJECT_LIST)
+        {
+            free(attr_list[idx].value.objlist.list);
+        }
+    }
+
+    free(attr_list);
+}
+
+static lai_status_t lai_metadata_reconcile_translate_attrs(
+        _In_ const lai_metadata_reconcile_state_t *state,
+        _In_ const lai_metadata_reconcile_op_t *op,
+        _Out_ lai_attribute_t **attr_list)
+{
+    const lai_attr_metadata_t *md;
+    lai_attribute_t *attrs;
+    lai_object_list_t *list;
+    uint32_t idx;
+    uint32_t jdx;
+
+    *attr_list = NULL;
+
+    for (idx = 0; idx < op->attr_count; idx++)
+    {
+        md = lai_metadata_get_attr_metadata(op->object_type, op->attr_list[idx].id);
+
+        if (md->isoidattribute)
+        {
+            break;
+        }
+    }
+
+    if (idx == op->attr_count || state->create_count == 0)
+    {
+        return LAI_STATUS_SUCCESS;
+    }
+
+    attrs = (lai_attribute_t*)calloc(op->attr_count, sizeof(lai_attribute_t));
+
+    if (attrs == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    memcpy(attrs, op->attr_list, op->attr_count * sizeof(lai_attribute_t));
+
+    for (idx = 0; idx < op->attr_count; idx++)
+    {
+        md = lai_metadata_get_attr_metadata(op->object_type, attrs[idx].id);
+
+        if (md->attrvaluetype == LAI_ATTR_VALUE_TYPE_OBJECT_ID)
+        {
+            attrs[idx].value.oid = lai_metadata_reconcile_translate(state, attrs[idx].value.oid);
+        }
+        else if (md->attrvaluetype == LAI_ATTR_VALUE_TYPE_OBJECT_LIST)
+        {
+            list = &attrs[idx].value.objlist;
+
+            if (list->count == 0 || list->list == NULL)
+            {
+                list->list = NULL;
+                continue;
+            }
+
+            list->list = (lai_object_id_t*)malloc(list->count * sizeof(lai_object_id_t));
+
+            if (list->list == NULL)
+            {
+                lai_metadata_reconcile_free_attrs(op->object_type, op->attr_count, attrs);
+                return LAI_STATUS_NO_MEMORY;
+            }
+
+            for (jdx = 0; jdx < list->count; jdx++)
+            {
+                list->list[jdx] = lai_metadata_reconcile_translate(state, op->attr_list[idx].value.objlist.list[jdx]);
+            }
+        }
+    }
+
+    *attr_list = attrs;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_metadata_reconcile_apply_op(
+        _In_ const lai_metadata_reconcile_state_t *state,
+        _Inout_ lai_metadata_reconcile_op_t *op)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(op->object_type);
+    const lai_attribute_t *attrs = op->attr_list;
+    lai_object_meta_key_t meta_key;
+    lai_attribute_t *translated;
+    lai_object_id_t linecard_id = LAI_NULL_OBJECT_ID;
+    lai_status_t status;
+
+    status = lai_metadata_reconcile_translate_attrs(state, op, &translated);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    if (translated != NULL)
+    {
+        attrs = translated;
+    }
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = op->object_type;
+
+    switch (op->kind)
+    {
+        case LAI_METADATA_RECONCILE_OP_KIND_CREATE:
+
+            if (op->object_type != LAI_OBJECT_TYPE_LINECARD)
+            {
+                linecard_id = lai_metadata_reconcile_translate(state, LAI_OBJECT_ID_LINECARD(op->object_id));
+            }
+
+            status = info->create(&meta_key, linecard_id, op->attr_count, attrs);
+
+            if (status == LAI_STATUS_SUCCESS)
+            {
+                op->created_id = meta_key.objectkey.key.object_id;
+            }
+
+            break;
+
+        case LAI_METADATA_RECONCILE_OP_KIND_REMOVE:
+
+            meta_key.objectkey.key.object_id = op->object_id;
+
+            status = info->remove(&meta_key);
+            break;
+
+        case LAI_METADATA_RECONCILE_OP_KIND_SET:
+
+            meta_key.objectkey.key.object_id = lai_metadata_reconcile_translate(state, op->object_id);
+
+            status = info->set(&meta_key, attrs);
+            break;
+
+        default:
+            status = LAI_STATUS_INVALID_PARAMETER;
+            break;
+    }
+
+    lai_metadata_reconcile_free_attrs(op->object_type, op->attr_count, translated);
+
+    return status;
+}
+
+lai_status_t lai_metadata_reconcile_apply(
+        _Inout_ lai_metadata_reconcile_plan_t *plan,
+        _Out_ size_t *failed)
+{
+    lai_status_t status;
+    size_t idx;
+
+    if (plan == NULL || plan->state == NULL || failed == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < plan->count; idx++)
+    {
+        status = lai_metadata_reconcile_apply_op((const lai_metadata_reconcile_state_t*)plan->state, &plan->ops[idx]);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            LAI_META_LOG_ERROR("reconciliation operation %zu on object 0x%llx failed: %d", idx,
+                    (unsigned long long)plan->ops[idx].object_id, status);
+
+            *failed = idx;
+
+            return status;
+        }
+    }
+
+    *failed = plan->count;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_reconcile_plan_free(
+        _Inout_ lai_metadata_reconcile_plan_t *plan)
+{
+    lai_metadata_reconcile_state_t *state;
+
+    if (plan == NULL)
+    {
+        return;
+    }
+
+    state = (lai_metadata_reconcile_state_t*)plan->state;
+
+    if (state != NULL)
+    {
+        free(state->attrs);
+        free(state->creates);
+        free(state);
+    }
+
+    free(plan->ops);
+    free(plan->batches);
+
+    memset(plan, 0, sizeof(*plan));
+}
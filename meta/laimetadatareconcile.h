@@ -0,0 +1,256 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatareconcile.h
+ *
+ * @brief   This module defines LAI Metadata Warm Restart Reconciliation
+ */
+
+#ifndef __LAIMETADATARECONCILE_H_
+#define __LAIMETADATARECONCILE_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATARECONCILE LAI - Metadata Warm Restart Reconciliation Definitions
+ *
+ * After warm restart host compares configuration stored in its database
+ * with attributes read back from linecard. Reconciliation takes both sets,
+ * compares attributes with isrecoverable metadata by
+ * lai_metadata_deepequal_attr_value() and plans minimal set of operations
+ * bringing linecard to stored configuration:
+ *
+ * - object only in stored set is created with its create attributes,
+ * - object only in live set is removed,
+ * - changed create only attribute recreates object,
+ * - changed settable attribute is set,
+ * - object on removed or recreated linecard is recreated too, as well as
+ * object referring to removed or recreated object by writable object id
+ * attribute in live set, transitively.
+ *
+ * Operations are grouped into batches of single kind and object type.
+ * Removes go first, from dependent object types to linecard, then creates
+ * from linecard to dependent object types, then sets in the same order.
+ * Object type depends on linecard and on object types of its writable
+ * object id attributes.
+ *
+ * Stored object ids of created objects are placeholders, apply translates
+ * them in all following operations to ids returned by adapter.
+ *
+ * @{
+ */
+
+/**
+ * @brief Kind of reconciliation operation
+ */
+typedef enum _lai_metadata_reconcile_op_kind_t
+{
+    LAI_METADATA_RECONCILE_OP_KIND_REMOVE,
+
+    LAI_METADATA_RECONCILE_OP_KIND_CREATE,
+
+    LAI_METADATA_RECONCILE_OP_KIND_SET,
+
+} lai_metadata_reconcile_op_kind_t;
+
+/**
+ * @brief Attributes of single object
+ */
+typedef struct _lai_metadata_reconcile_object_t
+{
+    /**
+     * @brief Object type.
+     */
+    lai_object_type_t object_type;
+
+    /**
+     * @brief Object id.
+     */
+    lai_object_id_t object_id;
+
+    /**
+     * @brief Number of attributes.
+     */
+    uint32_t attr_count;
+
+    /**
+     * @brief Attributes, live set must be read for the same ids as stored.
+     */
+    const lai_attribute_t *attr_list;
+
+} lai_metadata_reconcile_object_t;
+
+/**
+ * @brief Single reconciliation operation
+ */
+typedef struct _lai_metadata_reconcile_op_t
+{
+    /**
+     * @brief Kind of operation.
+     */
+    lai_metadata_reconcile_op_kind_t kind;
+
+    /**
+     * @brief Object type.
+     */
+    lai_object_type_t object_type;
+
+    /**
+     * @brief Position of object type in dependency order, linecard is 0.
+     */
+    uint32_t order;
+
+    /**
+     * @brief Object id, stored id for create and for set on created object.
+     */
+    lai_object_id_t object_id;
+
+    /**
+     * @brief Number of attributes, 1 for set, 0 for remove.
+     */
+    uint32_t attr_count;
+
+    /**
+     * @brief Attributes, values point to stored set.
+     */
+    const lai_attribute_t *attr_list;
+
+    /**
+     * @brief Object id returned by adapter when create was applied.
+     */
+    lai_object_id_t created_id;
+
+} lai_metadata_reconcile_op_t;
+
+/**
+ * @brief Operations of single kind and object type
+ */
+typedef struct _lai_metadata_reconcile_batch_t
+{
+    /**
+     * @brief Kind of operations.
+     */
+    lai_metadata_reconcile_op_kind_t kind;
+
+    /**
+     * @brief Object type of operations.
+     */
+    lai_object_type_t object_type;
+
+    /**
+     * @brief Index of first operation.
+     */
+    size_t first;
+
+    /**
+     * @brief Number of operations.
+     */
+    size_t count;
+
+} lai_metadata_reconcile_batch_t;
+
+/**
+ * @brief Reconciliation plan
+ */
+typedef struct _lai_metadata_reconcile_plan_t
+{
+    /**
+     * @brief Number of operations.
+     */
+    size_t count;
+
+    /**
+     * @brief Operations in execution order.
+     */
+    lai_metadata_reconcile_op_t *ops;
+
+    /**
+     * @brief Number of batches.
+     */
+    size_t batch_count;
+
+    /**
+     * @brief Batches in execution order.
+     */
+    lai_metadata_reconcile_batch_t *batches;
+
+    /**
+     * @brief Objects present in both sets without any change.
+     */
+    size_t unchanged;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_reconcile_plan_t;
+
+/**
+ * @brief Plans operations bringing live objects to stored configuration
+ *
+ * Attributes without isrecoverable metadata and read only attributes are
+ * ignored. Set only attributes are set only after create, they can't be
+ * read back. Attribute stored but missing in live set counts as changed,
+ * attribute live but missing in stored set is ignored. Objects created by
+ * adapter itself must be present in both sets, otherwise they are removed.
+ *
+ * Plan points to stored attributes, they must stay valid until plan is
+ * released.
+ *
+ * @param[in] stored_count Number of stored objects
+ * @param[in] stored Stored objects
+ * @param[in] live_count Number of live objects
+ * @param[in] live Live objects
+ * @param[out] plan Plan, must be released by lai_metadata_reconcile_plan_free()
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_INVALID_PARAMETER on
+ * duplicate object id or unknown attribute, failure status code on error
+ */
+extern lai_status_t lai_metadata_reconcile(
+        _In_ size_t stored_count,
+        _In_ const lai_metadata_reconcile_object_t *stored,
+        _In_ size_t live_count,
+        _In_ const lai_metadata_reconcile_object_t *live,
+        _Out_ lai_metadata_reconcile_plan_t *plan);
+
+/**
+ * @brief Applies plan through tables queried by lai_metadata_apis_query()
+ *
+ * Operations are applied in order, apply stops on first failure. Object ids
+ * of objects created by plan are translated in linecard id, object id and
+ * object id attribute values of all following operations.
+ *
+ * @param[inout] plan Plan, created ids are filled in
+ * @param[out] failed Index of failed operation, plan count on success
+ *
+ * @return #LAI_STATUS_SUCCESS on success, status of failed operation on error
+ */
+extern lai_status_t lai_metadata_reconcile_apply(
+        _Inout_ lai_metadata_reconcile_plan_t *plan,
+        _Out_ size_t *failed);
+
+/**
+ * @brief Releases plan
+ *
+ * @param[inout] plan Plan
+ */
+extern void lai_metadata_reconcile_plan_free(
+        _Inout_ lai_metadata_reconcile_plan_t *plan);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATARECONCILE_H_ */
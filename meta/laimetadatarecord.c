@@ -0,0 +1,1806 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatarecord.c
+ *
+ * @brief   This module implements LAI Metadata API Record and Replay
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <lai.h>
+#include "laimetadata.h"
+
+/*
+ * Record is built in buffer of calling thread, which grows up to
+ * RECORD_SCRATCH_MAX, and appended to ring of calling thread. Only owner
+ * thread appends to ring and only writer thread consumes it, so recorded
+ * call takes no lock. Every record in ring is preceded by sequence number
+ * taken when it is appended, writer merges rings by sequence number so
+ * file keeps order in which calls completed. Writer drains rings every
+ * RECORD_FLUSH_NS or when some ring gets half full, record is dropped
+ * when ring of calling thread is full.
+ */
+
+#define RECORD_BUFFER_SIZE      (1024 * 1024)
+#define RECORD_SCRATCH_SIZE     4096
+#define RECORD_SCRATCH_MAX      (16 * 1024 * 1024)
+#define RECORD_FLUSH_NS         100000000L
+#define RECORD_RECORD_MAX       (64 * 1024 * 1024)
+
+/* sequence number marking that rest of ring is skipped */
+#define RECORD_SEQ_SIZE         sizeof(uint64_t)
+#define RECORD_SEQ_WRAP         UINT64_MAX
+
+/* serialized size bounds, double alone may take over 300 characters */
+#define RECORD_VALUE_SIZE       1024
+#define RECORD_ELEMENT_SIZE     32
+#define RECORD_STRUCT_SIZE      1024
+
+#define RECORD_ALIGN(size, align)   (((size) + (align) - 1) & ~(size_t)((align) - 1))
+
+typedef struct _lai_metadata_record_ring_t
+{
+    struct _lai_metadata_record_ring_t *next;
+    char *data;
+
+    /* offsets grow without wrapping, position in data is offset modulo size */
+    size_t head;
+    size_t tail;
+
+    /* used by writer only */
+    size_t scan;
+    size_t limit;
+
+    bool busy;
+    bool orphaned;
+
+    lai_metadata_record_stats_t stats;
+
+} lai_metadata_record_ring_t;
+
+typedef struct _lai_metadata_record_scratch_t
+{
+    char *data;
+    size_t size;
+
+    lai_metadata_record_ring_t *ring;
+
+} lai_metadata_record_scratch_t;
+
+/*
+ * Caller notification pointers of linecard in slot of record tables,
+ * staged ones belong to create in progress.
+ */
+typedef struct _lai_metadata_record_notify_t
+{
+    struct _lai_metadata_record_notify_t *next;
+    size_t slot;
+    lai_object_id_t linecard_id;
+    pthread_t creator;
+    bool staged;
+
+    lai_linecard_notifications_t notifications;
+
+} lai_metadata_record_notify_t;
+
+typedef struct _lai_metadata_record_state_t
+{
+    pthread_mutex_t start_lock;
+    pthread_once_t once;
+    pthread_key_t key;
+
+    /* guards ring list, retired counters and draining */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool active;
+    bool running;
+    bool draining;
+    FILE *file;
+    pthread_t writer;
+    uint64_t start_ns;
+    uint64_t seq;
+
+    lai_metadata_record_ring_t *rings;
+    lai_metadata_record_stats_t retired;
+    uint64_t dropped;
+
+    pthread_rwlock_t notify_lock;
+    lai_metadata_record_notify_t *notify;
+
+} lai_metadata_record_state_t;
+
+/* writable state is exported like lai_metadata_log_level, never declared */
+lai_metadata_record_state_t lai_metadata_record_state = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_ONCE_INIT, 0,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, false, false, false, NULL, 0, 0, 0,
+    NULL, { 0, 0, 0 }, 0,
+    PTHREAD_RWLOCK_INITIALIZER, NULL };
+
+static uint64_t lai_metadata_record_now(
+        _In_ clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* lock must be held, ring must be drained */
+static void lai_metadata_record_ring_free(
+        _In_ lai_metadata_record_ring_t *ring)
+{
+    lai_metadata_record_ring_t **link = &lai_metadata_record_state.rings;
+
+    while (*link != ring)
+    {
+        link = &(*link)->next;
+    }
+
+    *link = ring->next;
+
+    lai_metadata_record_state.retired.recorded += ring->stats.recorded;
+    lai_metadata_record_state.retired.dropped += ring->stats.dropped;
+    lai_metadata_record_state.retired.bytes += ring->stats.bytes;
+
+    free(ring->data);
+    free(ring);
+}
+
+/* lock must be held */
+static void lai_metadata_record_ring_reap(void)
+{
+    lai_metadata_record_ring_t *ring = lai_metadata_record_state.rings;
+    lai_metadata_record_ring_t *next;
+
+    for (; ring != NULL; ring = next)
+    {
+        next = ring->next;
+
+        if (ring->orphaned && ring->head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+        {
+            lai_metadata_record_ring_free(ring);
+        }
+    }
+}
+
+static void lai_metadata_record_scratch_release(
+        _In_ void *arg)
+{
+    lai_metadata_record_scratch_t *scratch = (lai_metadata_record_scratch_t*)arg;
+
+    if (scratch->ring != NULL)
+    {
+        pthread_mutex_lock(&lai_metadata_record_state.lock);
+
+        /* writer may still read ring, it releases ring once drained */
+
+        if (lai_metadata_record_state.draining)
+        {
+            scratch->ring->orphaned = true;
+        }
+        else
+        {
+            lai_metadata_record_ring_free(scratch->ring);
+        }
+
+        pthread_mutex_unlock(&lai_metadata_record_state.lock);
+    }
+
+    free(scratch->data);
+    free(scratch);
+}
+
+static void lai_metadata_record_key_create(void)
+{
+    pthread_key_create(&lai_metadata_record_state.key, lai_metadata_record_scratch_release);
+}
+
+/* data may move, so callers keep offsets and call this again */
+static char* lai_metadata_record_reserve(
+        _In_ size_t size)
+{
+    lai_metadata_record_scratch_t *scratch;
+    size_t newsize;
+    char *data;
+
+    if (size > RECORD_SCRATCH_MAX)
+    {
+        return NULL;
+    }
+
+    scratch = (lai_metadata_record_scratch_t*)pthread_getspecific(lai_metadata_record_state.key);
+
+    if (scratch == NULL)
+    {
+        scratch = (lai_metadata_record_scratch_t*)calloc(1, sizeof(lai_metadata_record_scratch_t));
+
+        if (scratch == NULL)
+        {
+            return NULL;
+        }
+
+        pthread_setspecific(lai_metadata_record_state.key, scratch);
+    }
+
+    if (size <= scratch->size)
+    {
+        return scratch->data;
+    }
+
+    for (newsize = RECORD_SCRATCH_SIZE; newsize < size; newsize *= 2);
+
+    data = (char*)realloc(scratch->data, newsize);
+
+    if (data == NULL)
+    {
+        return NULL;
+    }
+
+    scratch->data = data;
+    scratch->size = newsize;
+
+    return data;
+}
+
+static size_t lai_metadata_record_value_size(
+        _In_ const lai_attr_metadata_t *meta,
+        _In_ const lai_attribute_value_t *value)
+{
+    size_t count;
+    size_t element = RECORD_ELEMENT_SIZE;
+
+    switch (meta->attrvaluetype)
+    {
+        case LAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            count = value->objlist.count;
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_UINT8_LIST:
+            count = value->u8list.count;
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_INT8_LIST:
+            count = value->s8list.count;
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_UINT16_LIST:
+            count = value->u16list.count;
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_INT16_LIST:
+            count = value->s16list.count;
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_UINT32_LIST:
+            count = value->u32list.count;
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_INT32_LIST:
+            count = value->s32list.count;
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_SPECTRUM_POWER_LIST:
+            count = value->spectrumpowerlist.count;
+            element = RECORD_STRUCT_SIZE;
+            break;
+
+        default:
+            return RECORD_VALUE_SIZE;
+    }
+
+    if (count > RECORD_SCRATCH_MAX / element)
+    {
+        return RECORD_SCRATCH_MAX;
+    }
+
+    return RECORD_VALUE_SIZE + count * element;
+}
+
+static lai_metadata_record_ring_t* lai_metadata_record_ring(void)
+{
+    lai_metadata_record_scratch_t *scratch;
+    lai_metadata_record_ring_t *ring;
+
+    scratch = (lai_metadata_record_scratch_t*)pthread_getspecific(lai_metadata_record_state.key);
+
+    if (scratch == NULL || scratch->ring != NULL)
+    {
+        return (scratch != NULL) ? scratch->ring : NULL;
+    }
+
+    ring = (lai_metadata_record_ring_t*)calloc(1, sizeof(lai_metadata_record_ring_t));
+
+    if (ring == NULL)
+    {
+        return NULL;
+    }
+
+    ring->data = (char*)malloc(RECORD_BUFFER_SIZE);
+
+    if (ring->data == NULL)
+    {
+        free(ring);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&lai_metadata_record_state.lock);
+
+    ring->next = lai_metadata_record_state.rings;
+    lai_metadata_record_state.rings = ring;
+
+    pthread_mutex_unlock(&lai_metadata_record_state.lock);
+
+    scratch->ring = ring;
+
+    return ring;
+}
+
+static void lai_metadata_record_drop(void)
+{
+    __atomic_fetch_add(&lai_metadata_record_state.dropped, 1, __ATOMIC_RELAXED);
+}
+
+static void lai_metadata_record_append(
+        _In_ const char *record,
+        _In_ size_t size)
+{
+    lai_metadata_record_ring_t *ring = lai_metadata_record_ring();
+    uint64_t seq = RECORD_SEQ_WRAP;
+    size_t used;
+    size_t pos;
+    size_t skip;
+
+    if (ring == NULL)
+    {
+        lai_metadata_record_drop();
+        return;
+    }
+
+    /* stop waits while ring is busy, so nothing is appended after final drain */
+
+    __atomic_store_n(&ring->busy, true, __ATOMIC_SEQ_CST);
+
+    if (!__atomic_load_n(&lai_metadata_record_state.active, __ATOMIC_SEQ_CST))
+    {
+        __atomic_store_n(&ring->busy, false, __ATOMIC_RELEASE);
+        return;
+    }
+
+    used = ring->tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    pos = ring->tail % RECORD_BUFFER_SIZE;
+
+    /* record is never split, rest of ring is skipped instead */
+
+    skip = (RECORD_BUFFER_SIZE - pos < RECORD_SEQ_SIZE + size) ? RECORD_BUFFER_SIZE - pos : 0;
+
+    if (RECORD_SEQ_SIZE + size > RECORD_BUFFER_SIZE - used - skip)
+    {
+        __atomic_store_n(&ring->stats.dropped, ring->stats.dropped + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&ring->busy, false, __ATOMIC_RELEASE);
+        return;
+    }
+
+    if (skip != 0)
+    {
+        memcpy(ring->data + pos, &seq, RECORD_SEQ_SIZE);
+        pos = 0;
+    }
+
+    seq = __atomic_fetch_add(&lai_metadata_record_state.seq, 1, __ATOMIC_ACQ_REL);
+
+    memcpy(ring->data + pos, &seq, RECORD_SEQ_SIZE);
+    memcpy(ring->data + pos + RECORD_SEQ_SIZE, record, size);
+
+    __atomic_store_n(&ring->tail, ring->tail + skip + RECORD_SEQ_SIZE + size, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&ring->stats.recorded, ring->stats.recorded + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->stats.bytes, ring->stats.bytes + size, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->busy, false, __ATOMIC_RELEASE);
+
+    if (used < RECORD_BUFFER_SIZE / 2 && used + skip + RECORD_SEQ_SIZE + size >= RECORD_BUFFER_SIZE / 2)
+    {
+        pthread_cond_signal(&lai_metadata_record_state.cond);
+    }
+}
+
+static void lai_metadata_record_finish(
+        _Inout_ lai_metadata_record_header_t *header,
+        _In_ size_t offset,
+        _In_ uint64_t begin,
+        _In_ uint64_t end)
+{
+    size_t size = RECORD_ALIGN(offset, 8);
+    char *data = lai_metadata_record_reserve(size);
+    uint64_t start = lai_metadata_record_state.start_ns;
+
+    if (data == NULL || size > UINT32_MAX)
+    {
+        lai_metadata_record_drop();
+        return;
+    }
+
+    memset(data + offset, 0, size - offset);
+
+    header->size = (uint32_t)size;
+    header->timestamp_ns = (begin > start) ? begin - start : 0;
+    header->duration_ns = (end > begin) ? end - begin : 0;
+
+    memcpy(data, header, sizeof(lai_metadata_record_header_t));
+
+    lai_metadata_record_append(data, size);
+}
+
+/*
+ * Writes records of all rings in sequence order. Cutoff is read before ring
+ * list, so ring registered later has no record below cutoff. Call which
+ * starts after other recorded call returned has higher sequence number and
+ * its record is appended after the other one, so record below cutoff is
+ * never written before record it follows.
+ */
+static void lai_metadata_record_drain(void)
+{
+    lai_metadata_record_header_t header;
+    lai_metadata_record_ring_t *rings;
+    lai_metadata_record_ring_t *ring;
+    lai_metadata_record_ring_t *next;
+    uint64_t cutoff;
+    uint64_t first = 0;
+    uint64_t seq;
+    size_t written = 0;
+    size_t failed = 0;
+    size_t pos;
+
+    cutoff = __atomic_load_n(&lai_metadata_record_state.seq, __ATOMIC_ACQUIRE);
+
+    pthread_mutex_lock(&lai_metadata_record_state.lock);
+
+    rings = lai_metadata_record_state.rings;
+
+    pthread_mutex_unlock(&lai_metadata_record_state.lock);
+
+    /* only writer unlinks rings, so list stays valid without lock */
+
+    for (ring = rings; ring != NULL; ring = ring->next)
+    {
+        ring->scan = ring->head;
+        ring->limit = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    }
+
+    for (;;)
+    {
+        next = NULL;
+
+        for (ring = rings; ring != NULL; ring = ring->next)
+        {
+            if (ring->scan == ring->limit)
+            {
+                continue;
+            }
+
+            pos = ring->scan % RECORD_BUFFER_SIZE;
+
+            memcpy(&seq, ring->data + pos, RECORD_SEQ_SIZE);
+
+            if (seq == RECORD_SEQ_WRAP)
+            {
+                ring->scan += RECORD_BUFFER_SIZE - pos;
+
+                if (ring->scan == ring->limit)
+                {
+                    continue;
+                }
+
+                memcpy(&seq, ring->data, RECORD_SEQ_SIZE);
+            }
+
+            if (seq < cutoff && (next == NULL || seq < first))
+            {
+                next = ring;
+                first = seq;
+            }
+        }
+
+        if (next == NULL)
+        {
+            break;
+        }
+
+        pos = next->scan % RECORD_BUFFER_SIZE + RECORD_SEQ_SIZE;
+
+        memcpy(&header, next->data + pos, sizeof(header));
+
+        if (fwrite(next->data + pos, 1, header.size, lai_metadata_record_state.file) != header.size)
+        {
+            failed += header.size;
+        }
+
+        next->scan += RECORD_SEQ_SIZE + header.size;
+        written += header.size;
+    }
+
+    for (ring = rings; ring != NULL; ring = ring->next)
+    {
+        __atomic_store_n(&ring->head, ring->scan, __ATOMIC_RELEASE);
+    }
+
+    if (written != 0 && (failed != 0 || fflush(lai_metadata_record_state.file) != 0))
+    {
+        LAI_META_LOG_ERROR("failed to write %zu bytes of records", written);
+    }
+}
+
+static void* lai_metadata_record_writer_run(
+        _In_ void *arg)
+{
+    struct timespec deadline;
+    bool running = true;
+
+    while (running)
+    {
+        pthread_mutex_lock(&lai_metadata_record_state.lock);
+
+        lai_metadata_record_ring_reap();
+
+        if (lai_metadata_record_state.running)
+        {
+            clock_gettime(CLOCK_REALTIME, &deadline);
+
+            deadline.tv_nsec += RECORD_FLUSH_NS;
+
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+
+            pthread_cond_timedwait(&lai_metadata_record_state.cond, &lai_metadata_record_state.lock, &deadline);
+        }
+
+        /* stop clears running only when no call is appending, last drain takes all */
+
+        running = lai_metadata_record_state.running;
+
+        pthread_mutex_unlock(&lai_metadata_record_state.lock);
+
+        lai_metadata_record_drain();
+    }
+
+    return NULL;
+}
+
+lai_status_t lai_metadata_record_start(
+        _In_ const char *file_name)
+{
+    lai_metadata_record_file_header_t header;
+    lai_metadata_record_ring_t *ring;
+
+    pthread_once(&lai_metadata_record_state.once, lai_metadata_record_key_create);
+
+    pthread_mutex_lock(&lai_metadata_record_state.start_lock);
+
+    if (lai_metadata_record_state.running)
+    {
+        pthread_mutex_unlock(&lai_metadata_record_state.start_lock);
+
+        LAI_META_LOG_ERROR("recording is already started");
+        return LAI_STATUS_FAILURE;
+    }
+
+    lai_metadata_record_state.file = fopen(file_name, "wb");
+
+    if (lai_metadata_record_state.file == NULL)
+    {
+        pthread_mutex_unlock(&lai_metadata_record_state.start_lock);
+
+        LAI_META_LOG_ERROR("failed to open %s", file_name);
+        return LAI_STATUS_FAILURE;
+    }
+
+    header.magic = LAI_METADATA_RECORD_MAGIC;
+    header.version = LAI_METADATA_RECORD_VERSION;
+    header.start_ns = lai_metadata_record_now(CLOCK_REALTIME);
+
+    if (fwrite(&header, sizeof(header), 1, lai_metadata_record_state.file) != 1)
+    {
+        fclose(lai_metadata_record_state.file);
+
+        pthread_mutex_unlock(&lai_metadata_record_state.start_lock);
+
+        LAI_META_LOG_ERROR("failed to start recording into %s", file_name);
+        return LAI_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&lai_metadata_record_state.lock);
+
+    /* no call appends while recording is stopped */
+
+    for (ring = lai_metadata_record_state.rings; ring != NULL; ring = ring->next)
+    {
+        memset(&ring->stats, 0, sizeof(lai_metadata_record_stats_t));
+    }
+
+    memset(&lai_metadata_record_state.retired, 0, sizeof(lai_metadata_record_stats_t));
+
+    __atomic_store_n(&lai_metadata_record_state.dropped, 0, __ATOMIC_RELAXED);
+
+    lai_metadata_record_state.start_ns = lai_metadata_record_now(CLOCK_MONOTONIC);
+    lai_metadata_record_state.running = true;
+    lai_metadata_record_state.draining = true;
+
+    if (pthread_create(&lai_metadata_record_state.writer, NULL, lai_metadata_record_writer_run, NULL) != 0)
+    {
+        lai_metadata_record_state.running = false;
+        lai_metadata_record_state.draining = false;
+
+        pthread_mutex_unlock(&lai_metadata_record_state.lock);
+
+        fclose(lai_metadata_record_state.file);
+
+        pthread_mutex_unlock(&lai_metadata_record_state.start_lock);
+
+        LAI_META_LOG_ERROR("failed to create record writer thread");
+        return LAI_STATUS_FAILURE;
+    }
+
+    __atomic_store_n(&lai_metadata_record_state.active, true, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_unlock(&lai_metadata_record_state.lock);
+    pthread_mutex_unlock(&lai_metadata_record_state.start_lock);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_record_stop(void)
+{
+    lai_metadata_record_ring_t *ring;
+
+    pthread_mutex_lock(&lai_metadata_record_state.start_lock);
+
+    if (!lai_metadata_record_state.running)
+    {
+        pthread_mutex_unlock(&lai_metadata_record_state.start_lock);
+        return;
+    }
+
+    /* records appended after this point are discarded by append */
+
+    __atomic_store_n(&lai_metadata_record_state.active, false, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_lock(&lai_metadata_record_state.lock);
+
+    for (ring = lai_metadata_record_state.rings; ring != NULL; ring = ring->next)
+    {
+        while (__atomic_load_n(&ring->busy, __ATOMIC_SEQ_CST))
+        {
+            sched_yield();
+        }
+    }
+
+    lai_metadata_record_state.running = false;
+
+    pthread_cond_signal(&lai_metadata_record_state.cond);
+    pthread_mutex_unlock(&lai_metadata_record_state.lock);
+
+    pthread_join(lai_metadata_record_state.writer, NULL);
+
+    pthread_mutex_lock(&lai_metadata_record_state.lock);
+
+    lai_metadata_record_state.draining = false;
+
+    lai_metadata_record_ring_reap();
+
+    pthread_mutex_unlock(&lai_metadata_record_state.lock);
+
+    fclose(lai_metadata_record_state.file);
+
+    lai_metadata_record_state.file = NULL;
+
+    pthread_mutex_unlock(&lai_metadata_record_state.start_lock);
+}
+
+void lai_metadata_record_get_stats(
+        _Out_ lai_metadata_record_stats_t *stats)
+{
+    lai_metadata_record_ring_t *ring;
+
+    pthread_mutex_lock(&lai_metadata_record_state.lock);
+
+    *stats = lai_metadata_record_state.retired;
+
+    stats->dropped += __atomic_load_n(&lai_metadata_record_state.dropped, __ATOMIC_RELAXED);
+
+    for (ring = lai_metadata_record_state.rings; ring != NULL; ring = ring->next)
+    {
+        stats->recorded += __atomic_load_n(&ring->stats.recorded, __ATOMIC_RELAXED);
+        stats->dropped += __atomic_load_n(&ring->stats.dropped, __ATOMIC_RELAXED);
+        stats->bytes += __atomic_load_n(&ring->stats.bytes, __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_unlock(&lai_metadata_record_state.lock);
+}
+
+uint64_t lai_metadata_record_begin(void)
+{
+    if (!__atomic_load_n(&lai_metadata_record_state.active, __ATOMIC_ACQUIRE))
+    {
+        return 0;
+    }
+
+    return lai_metadata_record_now(CLOCK_MONOTONIC);
+}
+
+void lai_metadata_record_call(
+        _In_ lai_metadata_record_kind_t kind,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_status_t status,
+        _In_ uint64_t begin,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    lai_metadata_record_header_t header;
+    const lai_attr_metadata_t *meta;
+    uint64_t end;
+    size_t offset = sizeof(lai_metadata_record_header_t);
+    size_t size;
+    uint32_t entry[2];
+    uint32_t idx;
+    char *data;
+    int ret;
+
+    if (begin == 0)
+    {
+        return;
+    }
+
+    end = lai_metadata_record_now(CLOCK_MONOTONIC);
+
+    for (idx = 0; idx < attr_count && attr_list != NULL; idx++)
+    {
+        meta = lai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+
+        if (meta != NULL && meta->attrvaluetype == LAI_ATTR_VALUE_TYPE_POINTER)
+        {
+            meta = NULL;
+        }
+
+        if (kind == LAI_METADATA_RECORD_KIND_GET && status != LAI_STATUS_SUCCESS)
+        {
+            meta = NULL;
+        }
+
+        size = (meta != NULL) ? lai_metadata_record_value_size(meta, &attr_list[idx].value) : 0;
+
+        data = lai_metadata_record_reserve(offset + sizeof(entry) + size);
+
+        if (data == NULL && meta != NULL)
+        {
+            meta = NULL;
+            data = lai_metadata_record_reserve(offset + sizeof(entry));
+        }
+
+        if (data == NULL)
+        {
+            lai_metadata_record_drop();
+            return;
+        }
+
+        entry[0] = attr_list[idx].id;
+        entry[1] = LAI_METADATA_RECORD_NO_VALUE;
+
+        if (meta != NULL)
+        {
+            ret = lai_serialize_attribute_value(data + offset + sizeof(entry), meta, &attr_list[idx].value);
+
+            if (ret >= 0)
+            {
+                entry[1] = (uint32_t)ret + 1;
+            }
+        }
+
+        memcpy(data + offset, entry, sizeof(entry));
+
+        offset += sizeof(entry);
+
+        if (entry[1] != LAI_METADATA_RECORD_NO_VALUE)
+        {
+            offset += RECORD_ALIGN(entry[1], 4);
+        }
+    }
+
+    header.kind = kind;
+    header.object_type = object_type;
+    header.status = status;
+    header.object_id = object_id;
+    header.linecard_id = linecard_id;
+    header.count = (attr_list != NULL) ? attr_count : 0;
+    header.mode = 0;
+
+    lai_metadata_record_finish(&header, offset, begin, end);
+}
+
+void lai_metadata_record_stats(
+        _In_ lai_metadata_record_kind_t kind,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ lai_status_t status,
+        _In_ uint64_t begin,
+        _In_ uint32_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids,
+        _In_ lai_stats_mode_t mode)
+{
+    lai_metadata_record_header_t header;
+    uint64_t end;
+    size_t size;
+    char *data;
+
+    if (begin == 0)
+    {
+        return;
+    }
+
+    end = lai_metadata_record_now(CLOCK_MONOTONIC);
+
+    if (counter_ids == NULL)
+    {
+        number_of_counters = 0;
+    }
+
+    size = (size_t)number_of_counters * sizeof(lai_stat_id_t);
+
+    data = lai_metadata_record_reserve(sizeof(lai_metadata_record_header_t) + size);
+
+    if (data == NULL)
+    {
+        lai_metadata_record_drop();
+        return;
+    }
+
+    if (size != 0)
+    {
+        memcpy(data + sizeof(lai_metadata_record_header_t), counter_ids, size);
+    }
+
+    header.kind = kind;
+    header.object_type = object_type;
+    header.status = status;
+    header.object_id = object_id;
+    header.linecard_id = LAI_NULL_OBJECT_ID;
+    header.count = number_of_counters;
+    header.mode = (uint32_t)mode;
+
+    lai_metadata_record_finish(&header, sizeof(lai_metadata_record_header_t) + size, begin, end);
+}
+
+char* lai_metadata_record_buffer(
+        _In_ size_t size)
+{
+    size_t offset = sizeof(lai_metadata_record_header_t) + sizeof(uint32_t);
+    char *data;
+
+    if (!__atomic_load_n(&lai_metadata_record_state.active, __ATOMIC_ACQUIRE))
+    {
+        return NULL;
+    }
+
+    data = lai_metadata_record_reserve(offset + size);
+
+    return (data != NULL) ? data + offset : NULL;
+}
+
+void lai_metadata_record_notification(
+        _In_ int notification_type,
+        _In_ lai_object_id_t linecard_id,
+        _In_ const char *buffer,
+        _In_ int length)
+{
+    lai_metadata_record_header_t header;
+    size_t offset = sizeof(lai_metadata_record_header_t) + sizeof(uint32_t);
+    uint64_t now = lai_metadata_record_now(CLOCK_MONOTONIC);
+    uint32_t size = (length >= 0) ? (uint32_t)length + 1 : LAI_METADATA_RECORD_NO_VALUE;
+    char *data = lai_metadata_record_reserve(offset);
+
+    if (data == NULL || buffer != data + offset)
+    {
+        return;
+    }
+
+    memcpy(data + sizeof(lai_metadata_record_header_t), &size, sizeof(size));
+
+    if (size != LAI_METADATA_RECORD_NO_VALUE)
+    {
+        offset += size;
+    }
+
+    header.kind = LAI_METADATA_RECORD_KIND_NOTIFICATION;
+    header.object_type = (uint32_t)notification_type;
+    header.status = LAI_STATUS_SUCCESS;
+    header.object_id = LAI_NULL_OBJECT_ID;
+    header.linecard_id = linecard_id;
+    header.count = 1;
+    header.mode = 0;
+
+    lai_metadata_record_finish(&header, offset, now, now);
+}
+
+/* notify lock must be held */
+static lai_metadata_record_notify_t** lai_metadata_record_notify_find(
+        _In_ size_t slot,
+        _In_ lai_object_id_t linecard_id,
+        _In_ bool staged)
+{
+    lai_metadata_record_notify_t **link = &lai_metadata_record_state.notify;
+
+    for (; *link != NULL; link = &(*link)->next)
+    {
+        if ((*link)->slot != slot)
+        {
+            continue;
+        }
+
+        if (staged && (*link)->staged && pthread_equal((*link)->creator, pthread_self()))
+        {
+            break;
+        }
+
+        if (!staged && !(*link)->staged && (*link)->linecard_id == linecard_id)
+        {
+            break;
+        }
+    }
+
+    return link;
+}
+
+lai_attribute_t* lai_metadata_record_notify_attr_list(
+        _In_ lai_metadata_record_kind_t kind,
+        _In_ size_t slot,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    const lai_attr_metadata_t *meta;
+    lai_linecard_notifications_t notifications;
+    lai_metadata_record_notify_t *entry;
+    lai_attribute_t *copy = NULL;
+    uint32_t idx;
+
+    memset(&notifications, 0, sizeof(notifications));
+
+    for (idx = 0; idx < attr_count && attr_list != NULL; idx++)
+    {
+        meta = lai_metadata_get_attr_metadata(LAI_OBJECT_TYPE_LINECARD, attr_list[idx].id);
+
+        if (meta == NULL || meta->notificationtype < 0)
+        {
+            continue;
+        }
+
+        if (copy == NULL)
+        {
+            copy = (lai_attribute_t*)malloc(attr_count * sizeof(lai_attribute_t));
+
+            if (copy == NULL)
+            {
+                return NULL;
+            }
+
+            memcpy(copy, attr_list, attr_count * sizeof(lai_attribute_t));
+        }
+
+        copy[idx].value.ptr = lai_metadata_record_notify(copy[idx].id, copy[idx].value.ptr, slot, &notifications);
+    }
+
+    if (copy == NULL || kind != LAI_METADATA_RECORD_KIND_CREATE)
+    {
+        return copy;
+    }
+
+    entry = (lai_metadata_record_notify_t*)calloc(1, sizeof(lai_metadata_record_notify_t));
+
+    if (entry == NULL)
+    {
+        /* caller pointers are passed to adapter, notifications are not recorded */
+
+        free(copy);
+        return NULL;
+    }
+
+    entry->slot = slot;
+    entry->creator = pthread_self();
+    entry->staged = true;
+    entry->notifications = notifications;
+
+    pthread_rwlock_wrlock(&lai_metadata_record_state.notify_lock);
+
+    entry->next = lai_metadata_record_state.notify;
+    lai_metadata_record_state.notify = entry;
+
+    pthread_rwlock_unlock(&lai_metadata_record_state.notify_lock);
+
+    return copy;
+}
+
+void lai_metadata_record_notify_commit(
+        _In_ lai_metadata_record_kind_t kind,
+        _In_ size_t slot,
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_status_t status,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    const lai_attr_metadata_t *meta;
+    lai_metadata_record_notify_t **link;
+    lai_metadata_record_notify_t *entry;
+    lai_metadata_record_notify_t *old;
+    uint32_t idx;
+
+    pthread_rwlock_wrlock(&lai_metadata_record_state.notify_lock);
+
+    if (kind == LAI_METADATA_RECORD_KIND_CREATE)
+    {
+        link = lai_metadata_record_notify_find(slot, LAI_NULL_OBJECT_ID, true);
+        entry = *link;
+
+        if (entry != NULL)
+        {
+            *link = entry->next;
+
+            if (status == LAI_STATUS_SUCCESS)
+            {
+                link = lai_metadata_record_notify_find(slot, linecard_id, false);
+                old = *link;
+
+                if (old != NULL)
+                {
+                    *link = old->next;
+                    free(old);
+                }
+
+                entry->staged = false;
+                entry->linecard_id = linecard_id;
+                entry->next = lai_metadata_record_state.notify;
+
+                lai_metadata_record_state.notify = entry;
+            }
+            else
+            {
+                free(entry);
+            }
+        }
+    }
+    else if (kind == LAI_METADATA_RECORD_KIND_REMOVE && status == LAI_STATUS_SUCCESS)
+    {
+        link = lai_metadata_record_notify_find(slot, linecard_id, false);
+        entry = *link;
+
+        if (entry != NULL)
+        {
+            *link = entry->next;
+            free(entry);
+        }
+    }
+    else if (kind == LAI_METADATA_RECORD_KIND_SET && status == LAI_STATUS_SUCCESS)
+    {
+        for (idx = 0; idx < attr_count && attr_list != NULL; idx++)
+        {
+            meta = lai_metadata_get_attr_metadata(LAI_OBJECT_TYPE_LINECARD, attr_list[idx].id);
+
+            if (meta == NULL || meta->notificationtype < 0)
+            {
+                continue;
+            }
+
+            link = lai_metadata_record_notify_find(slot, linecard_id, false);
+
+            if (*link == NULL)
+            {
+                *link = (lai_metadata_record_notify_t*)calloc(1, sizeof(lai_metadata_record_notify_t));
+
+                if (*link == NULL)
+                {
+                    LAI_META_LOG_ERROR("failed to save notification pointers of linecard 0x%llx", (unsigned long long)linecard_id);
+                    break;
+                }
+
+                (*link)->slot = slot;
+                (*link)->linecard_id = linecard_id;
+            }
+
+            lai_metadata_record_notify(attr_list[idx].id, attr_list[idx].value.ptr, slot, &(*link)->notifications);
+        }
+    }
+
+    pthread_rwlock_unlock(&lai_metadata_record_state.notify_lock);
+}
+
+/*
+ * Declared by generated header, which defines notifications struct. Gets
+ * pointers committed for linecard in slot, staged ones of slot when
+ * linecard is being created, all NULL when there are none.
+ */
+void lai_metadata_record_get_notifications(
+        _In_ size_t slot,
+        _In_ lai_object_id_t linecard_id,
+        _Out_ lai_linecard_notifications_t *notifications)
+{
+    lai_metadata_record_notify_t *entry;
+
+    pthread_rwlock_rdlock(&lai_metadata_record_state.notify_lock);
+
+    entry = *lai_metadata_record_notify_find(slot, linecard_id, false);
+
+    /* linecard not created yet, notification is sent during create */
+
+    if (entry == NULL)
+    {
+        for (entry = lai_metadata_record_state.notify; entry != NULL && !(entry->staged && entry->slot == slot); entry = entry->next);
+    }
+
+    if (entry != NULL)
+    {
+        *notifications = entry->notifications;
+    }
+    else
+    {
+        memset(notifications, 0, sizeof(lai_linecard_notifications_t));
+    }
+
+    pthread_rwlock_unlock(&lai_metadata_record_state.notify_lock);
+}
+
+/*
+ * Replay
+ */
+
+typedef struct _lai_metadata_record_oid_map_t
+{
+    lai_object_id_t *keys;
+    lai_object_id_t *values;
+    size_t size;
+    size_t count;
+
+} lai_metadata_record_oid_map_t;
+
+static size_t lai_metadata_record_oid_slot(
+        _In_ const lai_metadata_record_oid_map_t *map,
+        _In_ lai_object_id_t oid)
+{
+    size_t idx = (size_t)((oid * 0x9e3779b97f4a7c15ULL) >> 32) & (map->size - 1);
+
+    while (map->keys[idx] != LAI_NULL_OBJECT_ID && map->keys[idx] != oid)
+    {
+        idx = (idx + 1) & (map->size - 1);
+    }
+
+    return idx;
+}
+
+static lai_object_id_t lai_metadata_record_oid_get(
+        _In_ const lai_metadata_record_oid_map_t *map,
+        _In_ lai_object_id_t oid)
+{
+    size_t idx;
+
+    if (oid == LAI_NULL_OBJECT_ID || map->size == 0)
+    {
+        return oid;
+    }
+
+    idx = lai_metadata_record_oid_slot(map, oid);
+
+    return (map->keys[idx] == oid) ? map->values[idx] : oid;
+}
+
+static bool lai_metadata_record_oid_put(
+        _Inout_ lai_metadata_record_oid_map_t *map,
+        _In_ lai_object_id_t oid,
+        _In_ lai_object_id_t value)
+{
+    lai_metadata_record_oid_map_t grown;
+    size_t idx;
+
+    if ((map->count + 1) * 2 > map->size)
+    {
+        grown.size = (map->size == 0) ? 64 : map->size * 2;
+        grown.count = 0;
+        grown.keys = (lai_object_id_t*)calloc(grown.size, sizeof(lai_object_id_t));
+        grown.values = (lai_object_id_t*)calloc(grown.size, sizeof(lai_object_id_t));
+
+        if (grown.keys == NULL || grown.values == NULL)
+        {
+            free(grown.keys);
+            free(grown.values);
+            return false;
+        }
+
+        for (idx = 0; idx < map->size; idx++)
+        {
+            if (map->keys[idx] != LAI_NULL_OBJECT_ID)
+            {
+                size_t slot = lai_metadata_record_oid_slot(&grown, map->keys[idx]);
+
+                grown.keys[slot] = map->keys[idx];
+                grown.values[slot] = map->values[idx];
+                grown.count++;
+            }
+        }
+
+        free(map->keys);
+        free(map->values);
+
+        *map = grown;
+    }
+
+    idx = lai_metadata_record_oid_slot(map, oid);
+
+    if (map->keys[idx] == LAI_NULL_OBJECT_ID)
+    {
+        map->keys[idx] = oid;
+        map->count++;
+    }
+
+    map->values[idx] = value;
+
+    return true;
+}
+
+/* allocates missing get buffers or releases deserialized lists */
+static void lai_metadata_record_value_lists(
+        _In_ const lai_attr_metadata_t *meta,
+        _Inout_ lai_attribute_value_t *value,
+        _In_ bool allocate)
+{
+
+#define RECORD_VALUE_LIST(l)                                        \
+    if (!allocate)                                                  \
+    {                                                               \
+        free(l.list);                                               \
+        l.list = NULL;                                              \
+    }                                                               \
+    else if (l.list == NULL && l.count != 0)                        \
+    {                                                               \
+        l.list = calloc(l.count, sizeof(*l.list));                  \
+        l.count = (l.list != NULL) ? l.count : 0;                   \
+    }                                                               \
+    break;
+
+    switch (meta->attrvaluetype)
+    {
+        case LAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            RECORD_VALUE_LIST(value->objlist)
+
+        case LAI_ATTR_VALUE_TYPE_UINT8_LIST:
+            RECORD_VALUE_LIST(value->u8list)
+
+        case LAI_ATTR_VALUE_TYPE_INT8_LIST:
+            RECORD_VALUE_LIST(value->s8list)
+
+        case LAI_ATTR_VALUE_TYPE_UINT16_LIST:
+            RECORD_VALUE_LIST(value->u16list)
+
+        case LAI_ATTR_VALUE_TYPE_INT16_LIST:
+            RECORD_VALUE_LIST(value->s16list)
+
+        case LAI_ATTR_VALUE_TYPE_UINT32_LIST:
+            RECORD_VALUE_LIST(value->u32list)
+
+        case LAI_ATTR_VALUE_TYPE_INT32_LIST:
+            RECORD_VALUE_LIST(value->s32list)
+
+        case LAI_ATTR_VALUE_TYPE_SPECTRUM_POWER_LIST:
+            RECORD_VALUE_LIST(value->spectrumpowerlist)
+
+        default:
+            break;
+    }
+
+#undef RECORD_VALUE_LIST
+}
+
+static void lai_metadata_record_free_attrs(
+        _In_ lai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list)
+{
+    const lai_attr_metadata_t *meta;
+    uint32_t idx;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        meta = lai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+
+        if (meta != NULL)
+        {
+            lai_metadata_record_value_lists(meta, &attr_list[idx].value, false);
+        }
+    }
+
+    free(attr_list);
+}
+
+/*
+ * Deserializes attributes of record, pointer attributes and attributes
+ * without value are left out except for get.
+ */
+static lai_status_t lai_metadata_record_read_attrs(
+        _In_ const lai_metadata_record_header_t *header,
+        _In_ const char *payload,
+        _In_ const lai_metadata_record_oid_map_t *map,
+        _Out_ uint32_t *attr_count,
+        _Out_ lai_attribute_t **attr_list)
+{
+    lai_object_type_t object_type = (lai_object_type_t)header->object_type;
+    bool get = header->kind == LAI_METADATA_RECORD_KIND_GET;
+    size_t size = header->size - sizeof(lai_metadata_record_header_t);
+    size_t offset = 0;
+    const lai_attr_metadata_t *meta;
+    lai_attribute_t *attr;
+    lai_attribute_t *list;
+    uint32_t entry[2];
+    uint32_t count = 0;
+    uint32_t idx;
+    uint32_t item;
+
+    list = (lai_attribute_t*)calloc(header->count + 1, sizeof(lai_attribute_t));
+
+    if (list == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < header->count; idx++)
+    {
+        if (offset + sizeof(entry) > size)
+        {
+            break;
+        }
+
+        memcpy(entry, payload + offset, sizeof(entry));
+
+        offset += sizeof(entry);
+
+        meta = lai_metadata_get_attr_metadata(object_type, entry[0]);
+
+        if (meta == NULL)
+        {
+            break;
+        }
+
+        attr = &list[count];
+        attr->id = entry[0];
+
+        if (entry[1] == LAI_METADATA_RECORD_NO_VALUE)
+        {
+            if (get)
+            {
+                count++;
+            }
+
+            continue;
+        }
+
+        if (entry[1] == 0 || entry[1] > size - offset || payload[offset + entry[1] - 1] != 0)
+        {
+            break;
+        }
+
+        if (lai_deserialize_attribute_value(payload + offset, meta, &attr->value) < 0)
+        {
+            lai_metadata_record_value_lists(meta, &attr->value, false);
+            break;
+        }
+
+        offset += RECORD_ALIGN(entry[1], 4);
+        count++;
+
+        if (get)
+        {
+            lai_metadata_record_value_lists(meta, &attr->value, true);
+        }
+        else if (meta->attrvaluetype == LAI_ATTR_VALUE_TYPE_OBJECT_ID)
+        {
+            attr->value.oid = lai_metadata_record_oid_get(map, attr->value.oid);
+        }
+        else if (meta->attrvaluetype == LAI_ATTR_VALUE_TYPE_OBJECT_LIST && attr->value.objlist.list != NULL)
+        {
+            for (item = 0; item < attr->value.objlist.count; item++)
+            {
+                attr->value.objlist.list[item] = lai_metadata_record_oid_get(map, attr->value.objlist.list[item]);
+            }
+        }
+    }
+
+    if (idx != header->count)
+    {
+        LAI_META_LOG_WARN("failed to read attribute %u of record", idx);
+
+        lai_metadata_record_free_attrs(object_type, count, list);
+        return LAI_STATUS_FAILURE;
+    }
+
+    *attr_count = count;
+    *attr_list = list;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_metadata_record_replay_one(
+        _In_ const lai_metadata_record_header_t *header,
+        _In_ const char *payload,
+        _Inout_ lai_metadata_record_oid_map_t *map,
+        _Out_ lai_status_t *status,
+        _Out_ uint64_t *duration)
+{
+    lai_object_type_t object_type = (lai_object_type_t)header->object_type;
+    const lai_object_type_info_t *info;
+    lai_object_meta_key_t meta_key;
+    lai_attribute_t *attr_list = NULL;
+    lai_stat_value_t *counters = NULL;
+    uint32_t attr_count = 0;
+    uint64_t begin;
+    lai_status_t ret;
+
+    if (!lai_metadata_is_object_type_valid(object_type))
+    {
+        return LAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    info = lai_metadata_get_object_type_info(object_type);
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = object_type;
+    meta_key.objectkey.key.object_id = lai_metadata_record_oid_get(map, header->object_id);
+
+    switch (header->kind)
+    {
+        case LAI_METADATA_RECORD_KIND_CREATE:
+        case LAI_METADATA_RECORD_KIND_SET:
+        case LAI_METADATA_RECORD_KIND_GET:
+
+            ret = lai_metadata_record_read_attrs(header, payload, map, &attr_count, &attr_list);
+
+            if (ret != LAI_STATUS_SUCCESS)
+            {
+                return ret;
+            }
+
+            if (header->kind == LAI_METADATA_RECORD_KIND_SET && attr_count != 1)
+            {
+                lai_metadata_record_free_attrs(object_type, attr_count, attr_list);
+                return LAI_STATUS_NOT_SUPPORTED;
+            }
+
+            break;
+
+        case LAI_METADATA_RECORD_KIND_GET_STATS:
+        case LAI_METADATA_RECORD_KIND_GET_STATS_EXT:
+        case LAI_METADATA_RECORD_KIND_CLEAR_STATS:
+
+            if ((size_t)header->count * sizeof(lai_stat_id_t) > header->size - sizeof(lai_metadata_record_header_t))
+            {
+                return LAI_STATUS_FAILURE;
+            }
+
+            counters = (lai_stat_value_t*)calloc(header->count + 1, sizeof(lai_stat_value_t));
+
+            if (counters == NULL)
+            {
+                return LAI_STATUS_NO_MEMORY;
+            }
+
+            break;
+
+        default:
+            break;
+    }
+
+    begin = lai_metadata_record_now(CLOCK_MONOTONIC);
+
+    switch (header->kind)
+    {
+        case LAI_METADATA_RECORD_KIND_CREATE:
+
+            *status = info->create(&meta_key, lai_metadata_record_oid_get(map, header->linecard_id), attr_count, attr_list);
+            break;
+
+        case LAI_METADATA_RECORD_KIND_REMOVE:
+
+            *status = info->remove(&meta_key);
+            break;
+
+        case LAI_METADATA_RECORD_KIND_SET:
+
+            *status = info->set(&meta_key, attr_list);
+            break;
+
+        case LAI_METADATA_RECORD_KIND_GET:
+
+            *status = info->get(&meta_key, attr_count, attr_list);
+            break;
+
+        case LAI_METADATA_RECORD_KIND_GET_STATS:
+
+            *status = info->getstats(&meta_key, header->count,
+                    (const lai_stat_id_t*)(const void*)payload, counters);
+            break;
+
+        case LAI_METADATA_RECORD_KIND_GET_STATS_EXT:
+
+            *status = info->getstatsext(&meta_key, header->count,
+                    (const lai_stat_id_t*)(const void*)payload, (lai_stats_mode_t)header->mode, counters);
+            break;
+
+        case LAI_METADATA_RECORD_KIND_CLEAR_STATS:
+
+            *status = info->clearstats(&meta_key, header->count,
+                    (const lai_stat_id_t*)(const void*)payload);
+            break;
+
+        default:
+            return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    *duration = lai_metadata_record_now(CLOCK_MONOTONIC) - begin;
+
+    if (header->kind == LAI_METADATA_RECORD_KIND_CREATE && *status == LAI_STATUS_SUCCESS &&
+            header->object_id != LAI_NULL_OBJECT_ID)
+    {
+        lai_metadata_record_oid_put(map, header->object_id, meta_key.objectkey.key.object_id);
+
+        if (!lai_metadata_is_object_id_compliant(object_type,
+                    lai_metadata_record_oid_get(map, header->linecard_id), meta_key.objectkey.key.object_id))
+        {
+            LAI_META_LOG_WARN("created object id 0x%llx does not follow object id layout",
+                    (unsigned long long)meta_key.objectkey.key.object_id);
+        }
+    }
+
+    if (attr_list != NULL)
+    {
+        lai_metadata_record_free_attrs(object_type, attr_count, attr_list);
+    }
+
+    free(counters);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_metadata_record_replay_entry_t* lai_metadata_record_replay_entry(
+        _Inout_ lai_metadata_record_replay_report_t *report,
+        _In_ const lai_metadata_record_header_t *header)
+{
+    lai_metadata_record_replay_entry_t *entries;
+    size_t idx;
+
+    for (idx = 0; idx < report->count; idx++)
+    {
+        if (report->entries[idx].kind == header->kind && report->entries[idx].object_type == header->object_type)
+        {
+            return &report->entries[idx];
+        }
+    }
+
+    entries = (lai_metadata_record_replay_entry_t*)realloc(report->entries,
+            (report->count + 1) * sizeof(lai_metadata_record_replay_entry_t));
+
+    if (entries == NULL)
+    {
+        return NULL;
+    }
+
+    report->entries = entries;
+
+    memset(&entries[report->count], 0, sizeof(lai_metadata_record_replay_entry_t));
+
+    entries[report->count].kind = (lai_metadata_record_kind_t)header->kind;
+    entries[report->count].object_type = header->object_type;
+
+    return &entries[report->count++];
+}
+
+static int lai_metadata_record_replay_compare(
+        _In_ const void *a,
+        _In_ const void *b)
+{
+    const lai_metadata_record_replay_entry_t *ea = (const lai_metadata_record_replay_entry_t*)a;
+    const lai_metadata_record_replay_entry_t *eb = (const lai_metadata_record_replay_entry_t*)b;
+
+    if (ea->kind != eb->kind)
+    {
+        return (ea->kind < eb->kind) ? -1 : 1;
+    }
+
+    return (ea->object_type < eb->object_type) ? -1 : (ea->object_type > eb->object_type);
+}
+
+static void lai_metadata_record_replay_wait(
+        _In_ uint64_t target)
+{
+    uint64_t now = lai_metadata_record_now(CLOCK_MONOTONIC);
+    struct timespec ts;
+
+    if (now >= target)
+    {
+        return;
+    }
+
+    ts.tv_sec = (time_t)((target - now) / 1000000000ULL);
+    ts.tv_nsec = (long)((target - now) % 1000000000ULL);
+
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR);
+}
+
+lai_status_t lai_metadata_record_replay(
+        _In_ const char *file_name,
+        _In_ double speed,
+        _Out_ lai_metadata_record_replay_report_t *report)
+{
+    lai_metadata_record_file_header_t file_header;
+    lai_metadata_record_header_t header;
+    lai_metadata_record_oid_map_t map;
+    lai_metadata_record_replay_entry_t *entry;
+    lai_status_t status = LAI_STATUS_SUCCESS;
+    lai_status_t replayed;
+    uint64_t duration;
+    uint64_t start;
+    uint64_t target;
+    uint64_t now;
+    char *payload = NULL;
+    size_t capacity = 0;
+    size_t size;
+    FILE *file;
+
+    memset(report, 0, sizeof(lai_metadata_record_replay_report_t));
+    memset(&map, 0, sizeof(map));
+
+    file = fopen(file_name, "rb");
+
+    if (file == NULL)
+    {
+        LAI_META_LOG_ERROR("failed to open %s", file_name);
+        return LAI_STATUS_FAILURE;
+    }
+
+    if (fread(&file_header, sizeof(file_header), 1, file) != 1 ||
+            file_header.magic != LAI_METADATA_RECORD_MAGIC ||
+            file_header.version != LAI_METADATA_RECORD_VERSION)
+    {
+        fclose(file);
+
+        LAI_META_LOG_ERROR("%s is not record file of version %d", file_name, LAI_METADATA_RECORD_VERSION);
+        return LAI_STATUS_FAILURE;
+    }
+
+    start = lai_metadata_record_now(CLOCK_MONOTONIC);
+
+    while (fread(&header, sizeof(header), 1, file) == 1)
+    {
+        if (header.size < sizeof(header) || header.size > RECORD_RECORD_MAX)
+        {
+            LAI_META_LOG_ERROR("invalid record size %u", header.size);
+            status = LAI_STATUS_FAILURE;
+            break;
+        }
+
+        size = header.size - sizeof(header);
+
+        if (size > capacity)
+        {
+            char *grown = (char*)realloc(payload, size);
+
+            if (grown == NULL)
+            {
+                status = LAI_STATUS_NO_MEMORY;
+                break;
+            }
+
+            payload = grown;
+            capacity = size;
+        }
+
+        if (size != 0 && fread(payload, 1, size, file) != size)
+        {
+            LAI_META_LOG_WARN("record file %s is truncated", file_name);
+            break;
+        }
+
+        report->records++;
+
+        if (speed > 0)
+        {
+            target = start + (uint64_t)((double)header.timestamp_ns / speed);
+
+            lai_metadata_record_replay_wait(target);
+
+            now = lai_metadata_record_now(CLOCK_MONOTONIC);
+
+            if (now > target && now - target > report->max_lag_ns)
+            {
+                report->max_lag_ns = now - target;
+            }
+        }
+
+        entry = lai_metadata_record_replay_entry(report, &header);
+
+        if (entry == NULL)
+        {
+            status = LAI_STATUS_NO_MEMORY;
+            break;
+        }
+
+        replayed = (lai_status_t)header.status;
+        duration = 0;
+
+        if (header.kind != LAI_METADATA_RECORD_KIND_NOTIFICATION &&
+                lai_metadata_record_replay_one(&header, payload, &map, &replayed, &duration) != LAI_STATUS_SUCCESS)
+        {
+            report->skipped++;
+            continue;
+        }
+
+        entry->calls++;
+        entry->mismatches += (replayed != header.status);
+        entry->recorded_ns += header.duration_ns;
+        entry->replayed_ns += duration;
+
+        if (header.duration_ns > entry->recorded_max_ns)
+        {
+            entry->recorded_max_ns = header.duration_ns;
+        }
+
+        if (duration > entry->replayed_max_ns)
+        {
+            entry->replayed_max_ns = duration;
+        }
+    }
+
+    fclose(file);
+    free(payload);
+    free(map.keys);
+    free(map.values);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        lai_metadata_record_replay_report_free(report);
+        return status;
+    }
+
+    if (report->count != 0)
+    {
+        qsort(report->entries, report->count, sizeof(lai_metadata_record_replay_entry_t),
+                lai_metadata_record_replay_compare);
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_record_replay_report_free(
+        _Inout_ lai_metadata_record_replay_report_t *report)
+{
+    free(report->entries);
+
+    memset(report, 0, sizeof(lai_metadata_record_replay_report_t));
+}
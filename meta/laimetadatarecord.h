@@ -0,0 +1,462 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatarecord.h
+ *
+ * @brief   This module defines LAI Metadata API Record and Replay
+ */
+
+#ifndef __LAIMETADATARECORD_H_
+#define __LAIMETADATARECORD_H_
+
+#include <lai.h>
+
+/**
+ * @defgroup LAIMETADATARECORD LAI - Metadata API Record and Replay Definitions
+ *
+ * Generated lai_metadata_record_apis() replaces method tables returned by
+ * lai_metadata_apis_query() with tables of generated wrappers. While
+ * recording is started, every create, remove, set, get and statistics call
+ * and every linecard notification is appended to record file.
+ *
+ * Like instrumentation, every recorded #lai_apis_t keeps adapter tables and
+ * notification wrappers in own slot of #lai_metadata_api_slots_t, so
+ * notifications reach pointers passed by creator of linecard. Recording
+ * more than #LAI_METADATA_API_SLOTS structs fails with
+ * #LAI_STATUS_INSUFFICIENT_RESOURCES.
+ *
+ * Calling thread serializes attributes into its own buffer and appends
+ * record to its own ring without taking any lock, background thread merges
+ * rings in order in which calls completed and writes them to file. Record
+ * is dropped when ring of calling thread is full.
+ *
+ * Record file starts with #lai_metadata_record_file_header_t, every record
+ * starts with #lai_metadata_record_header_t and is padded to 8 bytes. All
+ * numbers are in host byte order.
+ *
+ * @{
+ */
+
+/**
+ * @brief Record file magic, "LAIR" in host byte order
+ */
+#define LAI_METADATA_RECORD_MAGIC               0x5249414c
+
+/**
+ * @brief Record file version
+ */
+#define LAI_METADATA_RECORD_VERSION             1
+
+/**
+ * @brief Attribute value length of attribute recorded without value
+ */
+#define LAI_METADATA_RECORD_NO_VALUE            0xffffffff
+
+/**
+ * @brief Kind of record
+ */
+typedef enum _lai_metadata_record_kind_t
+{
+    LAI_METADATA_RECORD_KIND_CREATE,
+
+    LAI_METADATA_RECORD_KIND_REMOVE,
+
+    LAI_METADATA_RECORD_KIND_SET,
+
+    LAI_METADATA_RECORD_KIND_GET,
+
+    LAI_METADATA_RECORD_KIND_GET_STATS,
+
+    LAI_METADATA_RECORD_KIND_GET_STATS_EXT,
+
+    LAI_METADATA_RECORD_KIND_CLEAR_STATS,
+
+    LAI_METADATA_RECORD_KIND_NOTIFICATION,
+
+    LAI_METADATA_RECORD_KIND_MAX,
+
+} lai_metadata_record_kind_t;
+
+/**
+ * @brief Header of record file
+ */
+typedef struct _lai_metadata_record_file_header_t
+{
+    /**
+     * @brief Always #LAI_METADATA_RECORD_MAGIC.
+     */
+    uint32_t magic;
+
+    /**
+     * @brief Always #LAI_METADATA_RECORD_VERSION.
+     */
+    uint32_t version;
+
+    /**
+     * @brief Wall clock time in nanoseconds when recording started.
+     */
+    uint64_t start_ns;
+
+} lai_metadata_record_file_header_t;
+
+/**
+ * @brief Header of one record
+ *
+ * Header of create, remove, set and get is followed by count attributes,
+ * each is attribute id and value length as two uint32_t followed by value
+ * serialized by lai_serialize_attribute_value() including terminating zero
+ * and padded to 4 bytes. Value of get is recorded only on success and
+ * pointer values are never recorded, length is then
+ * #LAI_METADATA_RECORD_NO_VALUE and no value follows.
+ *
+ * Header of statistics call is followed by count statistic ids as uint32_t.
+ *
+ * Header of notification is followed by one value length and notification
+ * parameters serialized by generated notification serializer.
+ */
+typedef struct _lai_metadata_record_header_t
+{
+    /**
+     * @brief Size of record including header and padding.
+     */
+    uint32_t size;
+
+    /**
+     * @brief Kind #lai_metadata_record_kind_t.
+     */
+    uint32_t kind;
+
+    /**
+     * @brief Object type, notification type for notification.
+     */
+    uint32_t object_type;
+
+    /**
+     * @brief Status returned by adapter.
+     */
+    int32_t status;
+
+    /**
+     * @brief Call start in nanoseconds since recording started.
+     */
+    uint64_t timestamp_ns;
+
+    /**
+     * @brief Call duration in nanoseconds.
+     */
+    uint64_t duration_ns;
+
+    /**
+     * @brief Object id, created object id for successful create.
+     */
+    uint64_t object_id;
+
+    /**
+     * @brief Linecard id of create and notification.
+     */
+    uint64_t linecard_id;
+
+    /**
+     * @brief Number of attributes or statistic ids.
+     */
+    uint32_t count;
+
+    /**
+     * @brief Statistics mode of get statistics extended.
+     */
+    uint32_t mode;
+
+} lai_metadata_record_header_t;
+
+/**
+ * @brief Recording counters
+ */
+typedef struct _lai_metadata_record_stats_t
+{
+    /**
+     * @brief Records written or waiting in buffers.
+     */
+    uint64_t recorded;
+
+    /**
+     * @brief Records dropped because ring was full.
+     */
+    uint64_t dropped;
+
+    /**
+     * @brief Bytes of records written or waiting in buffers.
+     */
+    uint64_t bytes;
+
+} lai_metadata_record_stats_t;
+
+/**
+ * @brief Replay result of one object type and kind
+ */
+typedef struct _lai_metadata_record_replay_entry_t
+{
+    /**
+     * @brief Object type, notification type for notification.
+     */
+    uint32_t object_type;
+
+    /**
+     * @brief Kind of record.
+     */
+    lai_metadata_record_kind_t kind;
+
+    /**
+     * @brief Number of replayed records.
+     */
+    uint64_t calls;
+
+    /**
+     * @brief Calls which returned different status than recorded.
+     */
+    uint64_t mismatches;
+
+    /**
+     * @brief Sum of recorded durations in nanoseconds.
+     */
+    uint64_t recorded_ns;
+
+    /**
+     * @brief Sum of replayed durations in nanoseconds.
+     */
+    uint64_t replayed_ns;
+
+    /**
+     * @brief Maximal recorded duration in nanoseconds.
+     */
+    uint64_t recorded_max_ns;
+
+    /**
+     * @brief Maximal replayed duration in nanoseconds.
+     */
+    uint64_t replayed_max_ns;
+
+} lai_metadata_record_replay_entry_t;
+
+/**
+ * @brief Replay report
+ */
+typedef struct _lai_metadata_record_replay_report_t
+{
+    /**
+     * @brief Number of entries.
+     */
+    size_t count;
+
+    /**
+     * @brief Entries sorted by kind and object type.
+     */
+    lai_metadata_record_replay_entry_t *entries;
+
+    /**
+     * @brief Records read from file.
+     */
+    uint64_t records;
+
+    /**
+     * @brief Records which could not be replayed.
+     */
+    uint64_t skipped;
+
+    /**
+     * @brief Time in nanoseconds replay fell behind recorded pace at most.
+     */
+    uint64_t max_lag_ns;
+
+} lai_metadata_record_replay_report_t;
+
+/**
+ * @brief Starts recording into file
+ *
+ * Calls are recorded only through tables installed by
+ * lai_metadata_record_apis().
+ *
+ * @param[in] file_name Record file name, file is truncated
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_record_start(
+        _In_ const char *file_name);
+
+/**
+ * @brief Stops recording, writes buffered records and closes file
+ */
+extern void lai_metadata_record_stop(void);
+
+/**
+ * @brief Gets recording counters since last start
+ *
+ * @param[out] stats Recording counters
+ */
+extern void lai_metadata_record_get_stats(
+        _Out_ lai_metadata_record_stats_t *stats);
+
+/**
+ * @brief Gets start time of recorded call
+ *
+ * @return Monotonic time in nanoseconds, 0 when recording is stopped
+ */
+extern uint64_t lai_metadata_record_begin(void);
+
+/**
+ * @brief Records create, remove, set or get call
+ *
+ * @param[in] kind Kind of record
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[in] linecard_id Linecard id
+ * @param[in] status Status returned by adapter
+ * @param[in] begin Value returned by lai_metadata_record_begin()
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attributes
+ */
+extern void lai_metadata_record_call(
+        _In_ lai_metadata_record_kind_t kind,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_status_t status,
+        _In_ uint64_t begin,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list);
+
+/**
+ * @brief Records statistics call
+ *
+ * @param[in] kind Kind of record
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[in] status Status returned by adapter
+ * @param[in] begin Value returned by lai_metadata_record_begin()
+ * @param[in] number_of_counters Number of statistic ids
+ * @param[in] counter_ids Statistic ids
+ * @param[in] mode Statistics mode
+ */
+extern void lai_metadata_record_stats(
+        _In_ lai_metadata_record_kind_t kind,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ lai_status_t status,
+        _In_ uint64_t begin,
+        _In_ uint32_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids,
+        _In_ lai_stats_mode_t mode);
+
+/**
+ * @brief Gets buffer for serialized notification
+ *
+ * @param[in] size Maximal serialized size
+ *
+ * @return Buffer of calling thread, NULL when recording is stopped
+ */
+extern char* lai_metadata_record_buffer(
+        _In_ size_t size);
+
+/**
+ * @brief Records notification serialized into lai_metadata_record_buffer()
+ *
+ * @param[in] notification_type Notification type
+ * @param[in] linecard_id Linecard id
+ * @param[in] buffer Buffer returned by lai_metadata_record_buffer()
+ * @param[in] length Length returned by serializer
+ */
+extern void lai_metadata_record_notification(
+        _In_ int notification_type,
+        _In_ lai_object_id_t linecard_id,
+        _In_ const char *buffer,
+        _In_ int length);
+
+/**
+ * @brief Replaces linecard notification pointers by recording wrappers
+ *
+ * Pointers passed to create are staged for calling thread, wrappers
+ * deliver notifications of linecard not known yet to pointers staged in
+ * their slot, so notifications sent by adapter during create reach caller.
+ *
+ * @param[in] kind Create or set
+ * @param[in] slot Slot of record tables called
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Linecard attributes
+ *
+ * @return Copy of attributes to be released by free(), NULL when there
+ * is no notification attribute
+ */
+extern lai_attribute_t* lai_metadata_record_notify_attr_list(
+        _In_ lai_metadata_record_kind_t kind,
+        _In_ size_t slot,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list);
+
+/**
+ * @brief Commits caller notification pointers of linecard
+ *
+ * Called after adapter call returned. Successful create replaces pointers
+ * of linecard by staged ones, successful set updates pointers passed in
+ * attribute and successful remove drops pointers of linecard. Staged
+ * pointers are dropped when create fails, pointers are not changed when
+ * set fails.
+ *
+ * @param[in] kind Create, set or remove
+ * @param[in] slot Slot of record tables called
+ * @param[in] linecard_id Linecard id, ignored on failure
+ * @param[in] status Status returned by adapter
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Linecard attributes as passed by caller
+ */
+extern void lai_metadata_record_notify_commit(
+        _In_ lai_metadata_record_kind_t kind,
+        _In_ size_t slot,
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_status_t status,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list);
+
+/**
+ * @brief Replays record file through tables queried by
+ * lai_metadata_apis_query()
+ *
+ * Object ids created during replay replace recorded ones in all following
+ * records, ids of objects created before recording started are used as
+ * recorded. Notifications and pointer attributes are not replayed.
+ *
+ * @param[in] file_name Record file name
+ * @param[in] speed Pace relative to recording, 1 is original pace, 0 issues
+ * records without waiting
+ * @param[out] report Replay report, must be released by
+ * lai_metadata_record_replay_report_free()
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_record_replay(
+        _In_ const char *file_name,
+        _In_ double speed,
+        _Out_ lai_metadata_record_replay_report_t *report);
+
+/**
+ * @brief Releases replay report
+ *
+ * @param[inout] report Replay report
+ */
+extern void lai_metadata_record_replay_report_free(
+        _Inout_ lai_metadata_record_replay_report_t *report);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATARECORD_H_ */
@@ -0,0 +1,579 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataspectrum.c
+ *
+ * @brief   This module implements LAI Metadata OCM Spectrum Analytics
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <lai.h>
+#include "laimetadataspectrum.h"
+#include "laimetadata.h"
+
+/*
+ * dB conversions are the hot path, sweep has hundreds of slices and each
+ * of them needs 10^(x/10). Conversions use own exp2 and log2, built from
+ * exponent bits of double and short polynomial, so loops have no calls.
+ * Exponent moves between double and integer through low bits of round
+ * magic instead of int64 conversion, and selects are plain ?: on doubles.
+ * Both loops are vectorized by gcc 12 for plain x86-64 at -O3 with
+ * -fno-trapping-math, which the Makefile uses for this module (checked
+ * with -fopt-info-vec), trapping math keeps ?: as branches. Accuracy
+ * against libm is covered by laimetadatatest.
+ *
+ * Channel accumulators are kept in structure of arrays form, per channel
+ * sorted by frequency, results are scattered to caller order at the end.
+ */
+
+#define SPECTRUM_LOG2_10_DIV_10     0.33219280948873623479
+#define SPECTRUM_10_LOG10_2         3.01029995663981195214
+#define SPECTRUM_LN2                0.69314718055994530942
+#define SPECTRUM_LOG2_E             1.44269504088896340736
+#define SPECTRUM_SQRT2              1.41421356237309504880
+#define SPECTRUM_ROUND_MAGIC        6755399441055744.0
+#define SPECTRUM_ROUND_MAGIC_BITS   0x4338000000000000ULL
+#define SPECTRUM_DBL_MIN            2.2250738585072013831e-308
+#define SPECTRUM_DBL_MAX            1.7976931348623157081e+308
+#define SPECTRUM_MHZ_PER_THZ        1000000.0
+
+#define SPECTRUM_EXPONENT_MASK      0x7FFULL
+#define SPECTRUM_MANTISSA_MASK      0x000FFFFFFFFFFFFFULL
+#define SPECTRUM_ONE_EXPONENT       0x3FF0000000000000ULL
+#define SPECTRUM_EXPONENT_BIAS      1023
+#define SPECTRUM_MANTISSA_BITS      52
+
+typedef struct _lai_metadata_spectrum_range_t
+{
+    lai_uint64_t lower;
+    lai_uint64_t upper;
+    size_t index;
+
+} lai_metadata_spectrum_range_t;
+
+typedef struct _lai_metadata_spectrum_state_t
+{
+    /* channels sorted by lower frequency */
+
+    lai_metadata_spectrum_range_t *ranges;
+
+    /* per sorted channel */
+
+    double *sum;
+    double *peak;
+    double *first;
+    double *last;
+    double *ratio;
+    size_t *slices;
+
+    /* sweep powers in mW */
+
+    double *mw;
+    size_t capacity;
+
+} lai_metadata_spectrum_state_t;
+
+static double lai_metadata_spectrum_exp2(
+        _In_ double x)
+{
+    double t;
+    double r;
+    double y;
+    double p;
+    double scale;
+    uint64_t bits;
+
+    /*
+     * Scale is 2^(k-1) and doubled at the end, so k of 1024 still gives
+     * finite results below 2^1024, k of -1022 gives exponent bits of zero.
+     */
+
+    x = (x < -1022.0) ? -1022.0 : x;
+    x = (x > 1024.0) ? 1024.0 : x;
+
+    /* round to nearest, x = k + f, |f| <= 0.5, k is in low bits of t */
+
+    t = x + SPECTRUM_ROUND_MAGIC;
+    r = t - SPECTRUM_ROUND_MAGIC;
+
+    memcpy(&bits, &t, sizeof(bits));
+
+    y = (x - r) * SPECTRUM_LN2;
+
+    /* e^y, |y| <= 0.35, Taylor series to y^11 */
+
+    p = 1.0 / 39916800.0;
+    p = p * y + 1.0 / 3628800.0;
+    p = p * y + 1.0 / 362880.0;
+    p = p * y + 1.0 / 40320.0;
+    p = p * y + 1.0 / 5040.0;
+    p = p * y + 1.0 / 720.0;
+    p = p * y + 1.0 / 120.0;
+    p = p * y + 1.0 / 24.0;
+    p = p * y + 1.0 / 6.0;
+    p = p * y + 0.5;
+    p = p * y + 1.0;
+    p = p * y + 1.0;
+
+    bits = (bits - SPECTRUM_ROUND_MAGIC_BITS + SPECTRUM_EXPONENT_BIAS - 1) << SPECTRUM_MANTISSA_BITS;
+
+    memcpy(&scale, &bits, sizeof(scale));
+
+    return (p * 2.0) * scale;
+}
+
+static double lai_metadata_spectrum_log2(
+        _In_ double x)
+{
+    double m;
+    double e;
+    double s;
+    double s2;
+    double p;
+    uint64_t bits;
+    uint64_t ebits;
+    double adjust;
+
+    memcpy(&bits, &x, sizeof(bits));
+
+    /* exponent is put in low bits of magic, so it is read without conversion */
+
+    ebits = ((bits >> SPECTRUM_MANTISSA_BITS) & SPECTRUM_EXPONENT_MASK) | SPECTRUM_ROUND_MAGIC_BITS;
+
+    memcpy(&e, &ebits, sizeof(e));
+
+    e = e - SPECTRUM_ROUND_MAGIC - SPECTRUM_EXPONENT_BIAS;
+
+    bits = (bits & SPECTRUM_MANTISSA_MASK) | SPECTRUM_ONE_EXPONENT;
+
+    memcpy(&m, &bits, sizeof(m));
+
+    /* m in [sqrt(2)/2, sqrt(2)) */
+
+    adjust = (m > SPECTRUM_SQRT2) ? 1.0 : 0.0;
+
+    m = m * (1.0 - 0.5 * adjust);
+    e = e + adjust;
+
+    /* ln(m) = 2 atanh(s), |s| <= 0.172, series to s^15 */
+
+    s = (m - 1.0) / (m + 1.0);
+    s2 = s * s;
+
+    p = 1.0 / 15.0;
+    p = p * s2 + 1.0 / 13.0;
+    p = p * s2 + 1.0 / 11.0;
+    p = p * s2 + 1.0 / 9.0;
+    p = p * s2 + 1.0 / 7.0;
+    p = p * s2 + 1.0 / 5.0;
+    p = p * s2 + 1.0 / 3.0;
+    p = p * s2 + 1.0;
+
+    return e + 2.0 * s * p * SPECTRUM_LOG2_E;
+}
+
+void lai_metadata_spectrum_dbm_to_mw(
+        _In_ size_t count,
+        _In_ const lai_double_t *dbm,
+        _Out_ lai_double_t *mw)
+{
+    size_t i = 0;
+
+    for (; i < count; ++i)
+    {
+        /* exp2 saturates to 0 and infinity, NaN passes through */
+
+        mw[i] = lai_metadata_spectrum_exp2(dbm[i] * SPECTRUM_LOG2_10_DIV_10);
+    }
+}
+
+void lai_metadata_spectrum_mw_to_dbm(
+        _In_ size_t count,
+        _In_ const lai_double_t *mw,
+        _Out_ lai_double_t *dbm)
+{
+    size_t i = 0;
+
+    for (; i < count; ++i)
+    {
+        double x = mw[i];
+        double v = lai_metadata_spectrum_log2(x) * SPECTRUM_10_LOG10_2;
+
+        /* exponent bits of NaN and infinity look finite, x - x is NaN for them */
+
+        v = v + (x - x);
+
+        v = (x < SPECTRUM_DBL_MIN) ? -__builtin_inf() : v;
+        v = (x > SPECTRUM_DBL_MAX) ? __builtin_inf() : v;
+        v = (x < 0.0) ? __builtin_nan("") : v;
+
+        dbm[i] = v;
+    }
+}
+
+static int lai_metadata_spectrum_range_compare(
+        _In_ const void *lhs,
+        _In_ const void *rhs)
+{
+    const lai_metadata_spectrum_range_t *l = (const lai_metadata_spectrum_range_t*)lhs;
+    const lai_metadata_spectrum_range_t *r = (const lai_metadata_spectrum_range_t*)rhs;
+
+    if (l->lower != r->lower)
+    {
+        return l->lower < r->lower ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static void *lai_metadata_spectrum_alloc(
+        _In_ size_t count,
+        _In_ size_t size)
+{
+    if (count == 0)
+    {
+        count = 1;
+    }
+
+    if (count > ((size_t)-1) / size)
+    {
+        return NULL;
+    }
+
+    return calloc(count, size);
+}
+
+void lai_metadata_spectrum_free(
+        _Inout_ lai_metadata_spectrum_t *spectrum)
+{
+    lai_metadata_spectrum_state_t *state;
+
+    if (spectrum == NULL)
+    {
+        return;
+    }
+
+    state = (lai_metadata_spectrum_state_t*)spectrum->state;
+
+    if (state != NULL)
+    {
+        free(state->ranges);
+        free(state->sum);
+        free(state->peak);
+        free(state->first);
+        free(state->last);
+        free(state->ratio);
+        free(state->slices);
+        free(state->mw);
+        free(state);
+    }
+
+    free(spectrum->channels);
+
+    memset(spectrum, 0, sizeof(lai_metadata_spectrum_t));
+}
+
+lai_status_t lai_metadata_spectrum_init(
+        _Out_ lai_metadata_spectrum_t *spectrum,
+        _In_ size_t channel_count,
+        _In_ const lai_metadata_spectrum_channel_t *channels)
+{
+    lai_metadata_spectrum_state_t *state;
+    size_t n = channel_count;
+    size_t idx;
+
+    if (spectrum == NULL || (channel_count != 0 && channels == NULL))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: spectrum or channels");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(spectrum, 0, sizeof(lai_metadata_spectrum_t));
+
+    spectrum->channel_count = n;
+    spectrum->tilt = __builtin_nan("");
+
+    state = (lai_metadata_spectrum_state_t*)calloc(1, sizeof(lai_metadata_spectrum_state_t));
+
+    spectrum->state = state;
+    spectrum->channels = (lai_metadata_spectrum_channel_power_t*)lai_metadata_spectrum_alloc(n, sizeof(lai_metadata_spectrum_channel_power_t));
+
+    if (state == NULL || spectrum->channels == NULL)
+    {
+        lai_metadata_spectrum_free(spectrum);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    state->ranges = (lai_metadata_spectrum_range_t*)lai_metadata_spectrum_alloc(n, sizeof(lai_metadata_spectrum_range_t));
+    state->sum = (double*)lai_metadata_spectrum_alloc(n, sizeof(double));
+    state->peak = (double*)lai_metadata_spectrum_alloc(n, sizeof(double));
+    state->first = (double*)lai_metadata_spectrum_alloc(n, sizeof(double));
+    state->last = (double*)lai_metadata_spectrum_alloc(n, sizeof(double));
+    state->ratio = (double*)lai_metadata_spectrum_alloc(n, sizeof(double));
+    state->slices = (size_t*)lai_metadata_spectrum_alloc(n, sizeof(size_t));
+
+    if (state->ranges == NULL || state->sum == NULL || state->peak == NULL || state->first == NULL ||
+            state->last == NULL || state->ratio == NULL || state->slices == NULL)
+    {
+        LAI_META_LOG_ERROR("failed to allocate spectrum for %zu channels", channel_count);
+
+        lai_metadata_spectrum_free(spectrum);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < n; ++idx)
+    {
+        if (channels[idx].lower_frequency >= channels[idx].upper_frequency)
+        {
+            LAI_META_LOG_ERROR("channel %zu has empty frequency range", idx);
+
+            lai_metadata_spectrum_free(spectrum);
+
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+
+        state->ranges[idx].lower = channels[idx].lower_frequency;
+        state->ranges[idx].upper = channels[idx].upper_frequency;
+        state->ranges[idx].index = idx;
+
+        spectrum->channels[idx].power = __builtin_nan("");
+        spectrum->channels[idx].peak = __builtin_nan("");
+        spectrum->channels[idx].osnr = __builtin_nan("");
+    }
+
+    qsort(state->ranges, n, sizeof(lai_metadata_spectrum_range_t), lai_metadata_spectrum_range_compare);
+
+    for (idx = 1; idx < n; ++idx)
+    {
+        if (state->ranges[idx].lower < state->ranges[idx - 1].upper)
+        {
+            LAI_META_LOG_ERROR("channels %zu and %zu overlap", state->ranges[idx - 1].index, state->ranges[idx].index);
+
+            lai_metadata_spectrum_free(spectrum);
+
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+/*
+ * Finds first channel ending above frequency, channels don't overlap so
+ * upper frequencies are sorted as well.
+ */
+
+static size_t lai_metadata_spectrum_find(
+        _In_ const lai_metadata_spectrum_range_t *ranges,
+        _In_ size_t count,
+        _In_ lai_uint64_t frequency)
+{
+    size_t low = 0;
+    size_t high = count;
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        if (ranges[mid].upper <= frequency)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static void lai_metadata_spectrum_integrate(
+        _Inout_ lai_metadata_spectrum_state_t *state,
+        _In_ size_t channel_count,
+        _In_ const lai_spectrum_power_list_t *sweep)
+{
+    const lai_metadata_spectrum_range_t *ranges = state->ranges;
+    lai_uint64_t previous = 0;
+    size_t cursor = 0;
+    size_t i = 0;
+
+    for (; i < sweep->count; ++i)
+    {
+        lai_uint64_t lower = sweep->list[i].lower_frequency;
+        lai_uint64_t upper = sweep->list[i].upper_frequency;
+        double density;
+        size_t c;
+
+        if (lower >= upper)
+        {
+            continue;
+        }
+
+        if (lower < previous)
+        {
+            cursor = lai_metadata_spectrum_find(ranges, channel_count, lower);
+        }
+
+        while (cursor < channel_count && ranges[cursor].upper <= lower)
+        {
+            cursor++;
+        }
+
+        previous = lower;
+
+        density = state->mw[i] / (double)(upper - lower);
+
+        for (c = cursor; c < channel_count && ranges[c].lower < upper; ++c)
+        {
+            lai_uint64_t from = lower > ranges[c].lower ? lower : ranges[c].lower;
+            lai_uint64_t to = upper < ranges[c].upper ? upper : ranges[c].upper;
+
+            state->sum[c] += density * (double)(to - from);
+            state->peak[c] = state->mw[i] > state->peak[c] ? state->mw[i] : state->peak[c];
+            state->first[c] = state->slices[c] == 0 ? density : state->first[c];
+            state->last[c] = density;
+            state->slices[c]++;
+        }
+    }
+}
+
+static double lai_metadata_spectrum_tilt(
+        _In_ const lai_metadata_spectrum_state_t *state,
+        _In_ size_t channel_count)
+{
+    double sx = 0;
+    double sy = 0;
+    double sxx = 0;
+    double sxy = 0;
+    double n = 0;
+    size_t c;
+
+    for (c = 0; c < channel_count; ++c)
+    {
+        if (state->slices[c] != 0 && __builtin_isfinite(state->sum[c]))
+        {
+            sx += (double)(state->ranges[c].lower + state->ranges[c].upper) / (2 * SPECTRUM_MHZ_PER_THZ);
+            sy += state->sum[c];
+            n += 1;
+        }
+    }
+
+    if (n < 2)
+    {
+        return __builtin_nan("");
+    }
+
+    sx /= n;
+    sy /= n;
+
+    for (c = 0; c < channel_count; ++c)
+    {
+        if (state->slices[c] != 0 && __builtin_isfinite(state->sum[c]))
+        {
+            double dx = (double)(state->ranges[c].lower + state->ranges[c].upper) / (2 * SPECTRUM_MHZ_PER_THZ) - sx;
+
+            sxx += dx * dx;
+            sxy += dx * (state->sum[c] - sy);
+        }
+    }
+
+    return sxx > 0 ? sxy / sxx : __builtin_nan("");
+}
+
+lai_status_t lai_metadata_spectrum_update(
+        _Inout_ lai_metadata_spectrum_t *spectrum,
+        _In_ const lai_spectrum_power_list_t *sweep)
+{
+    lai_metadata_spectrum_state_t *state;
+    size_t n;
+    size_t c;
+    size_t i;
+
+    if (spectrum == NULL || spectrum->state == NULL || sweep == NULL || (sweep->count != 0 && sweep->list == NULL))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: spectrum or sweep");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    state = (lai_metadata_spectrum_state_t*)spectrum->state;
+    n = spectrum->channel_count;
+
+    if (sweep->count > state->capacity)
+    {
+        double *mw = (double*)realloc(state->mw, sweep->count * sizeof(double));
+
+        if (mw == NULL)
+        {
+            LAI_META_LOG_ERROR("failed to allocate sweep of %u slices", sweep->count);
+
+            return LAI_STATUS_NO_MEMORY;
+        }
+
+        state->mw = mw;
+        state->capacity = sweep->count;
+    }
+
+    for (i = 0; i < sweep->count; ++i)
+    {
+        state->mw[i] = sweep->list[i].power;
+    }
+
+    lai_metadata_spectrum_dbm_to_mw(sweep->count, state->mw, state->mw);
+
+    memset(state->sum, 0, n * sizeof(double));
+    memset(state->peak, 0, n * sizeof(double));
+    memset(state->slices, 0, n * sizeof(size_t));
+
+    lai_metadata_spectrum_integrate(state, n, sweep);
+
+    /* signal is channel power without noise floor under the whole channel */
+
+    for (c = 0; c < n; ++c)
+    {
+        double noise = state->first[c] < state->last[c] ? state->first[c] : state->last[c];
+        double width = (double)(state->ranges[c].upper - state->ranges[c].lower);
+        double signal = state->sum[c] - noise * width;
+        double ratio = signal / (noise * LAI_METADATA_SPECTRUM_OSNR_REFERENCE_BANDWIDTH);
+
+        state->ratio[c] = (state->slices[c] < 2 || signal <= 0) ? __builtin_nan("") : ratio;
+    }
+
+    lai_metadata_spectrum_mw_to_dbm(n, state->sum, state->sum);
+    lai_metadata_spectrum_mw_to_dbm(n, state->peak, state->peak);
+    lai_metadata_spectrum_mw_to_dbm(n, state->ratio, state->ratio);
+
+    for (c = 0; c < n; ++c)
+    {
+        lai_metadata_spectrum_channel_power_t *result = &spectrum->channels[state->ranges[c].index];
+
+        int covered = state->slices[c] != 0;
+
+        result->slices = state->slices[c];
+        result->power = covered ? state->sum[c] : __builtin_nan("");
+        result->peak = covered ? state->peak[c] : __builtin_nan("");
+        result->osnr = state->ratio[c];
+    }
+
+    spectrum->tilt = lai_metadata_spectrum_tilt(state, n);
+
+    return LAI_STATUS_SUCCESS;
+}
@@ -0,0 +1,193 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataspectrum.h
+ *
+ * @brief   This module defines LAI Metadata OCM Spectrum Analytics
+ */
+
+#ifndef __LAIMETADATASPECTRUM_H_
+#define __LAIMETADATASPECTRUM_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATASPECTRUM LAI - Metadata OCM Spectrum Analytics Definitions
+ *
+ * Spectrum analytics integrates OCM sweep reported as
+ * #lai_spectrum_power_list_t into media channels given by
+ * #LAI_MEDIACHANNEL_ATTR_LOWER_FREQUENCY and
+ * #LAI_MEDIACHANNEL_ATTR_UPPER_FREQUENCY. Each slice power is power
+ * integrated over slice frequency range, slice overlapping channel boundary
+ * contributes to channel in proportion to overlap.
+ *
+ * OSNR is estimated from noise density of the first and the last slice of
+ * channel, which lay in channel guard band, referenced to 12.5 GHz. Tilt is
+ * least squares slope of channel powers over channel center frequencies.
+ *
+ * @{
+ */
+
+/**
+ * @brief OSNR reference bandwidth in MHz, 0.1 nm at 1550 nm
+ */
+#define LAI_METADATA_SPECTRUM_OSNR_REFERENCE_BANDWIDTH 12500
+
+/**
+ * @brief Media channel frequency range
+ */
+typedef struct _lai_metadata_spectrum_channel_t
+{
+    /**
+     * @brief Lower frequency in MHz.
+     */
+    lai_uint64_t lower_frequency;
+
+    /**
+     * @brief Upper frequency in MHz.
+     */
+    lai_uint64_t upper_frequency;
+
+} lai_metadata_spectrum_channel_t;
+
+/**
+ * @brief Media channel power computed from sweep
+ *
+ * Values are NaN when channel is not covered by sweep, OSNR is NaN also
+ * when channel is covered by less than 2 slices or noise exceeds signal.
+ */
+typedef struct _lai_metadata_spectrum_channel_power_t
+{
+    /**
+     * @brief Number of slices overlapping channel.
+     */
+    size_t slices;
+
+    /**
+     * @brief Channel power in dBm.
+     */
+    lai_double_t power;
+
+    /**
+     * @brief Highest slice power in dBm.
+     */
+    lai_double_t peak;
+
+    /**
+     * @brief Estimated OSNR in dB.
+     */
+    lai_double_t osnr;
+
+} lai_metadata_spectrum_channel_power_t;
+
+/**
+ * @brief Spectrum analytics of single OCM
+ */
+typedef struct _lai_metadata_spectrum_t
+{
+    /**
+     * @brief Number of media channels.
+     */
+    size_t channel_count;
+
+    /**
+     * @brief Results in order of channels passed at initialization.
+     */
+    lai_metadata_spectrum_channel_power_t *channels;
+
+    /**
+     * @brief Tilt in dB per THz, NaN for less than 2 covered channels.
+     */
+    lai_double_t tilt;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_spectrum_t;
+
+/**
+ * @brief Initializes spectrum analytics
+ *
+ * @param[out] spectrum Spectrum analytics to be initialized
+ * @param[in] channel_count Number of media channels
+ * @param[in] channels Media channels, must not overlap
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_INVALID_PARAMETER on
+ * empty or overlapping channels, failure status code on error
+ */
+extern lai_status_t lai_metadata_spectrum_init(
+        _Out_ lai_metadata_spectrum_t *spectrum,
+        _In_ size_t channel_count,
+        _In_ const lai_metadata_spectrum_channel_t *channels);
+
+/**
+ * @brief Releases spectrum analytics
+ *
+ * @param[inout] spectrum Spectrum analytics to be released
+ */
+extern void lai_metadata_spectrum_free(
+        _Inout_ lai_metadata_spectrum_t *spectrum);
+
+/**
+ * @brief Computes all channel results from single sweep
+ *
+ * Sweep ordered by frequency is processed in one pass, unordered sweep
+ * falls back to binary search of channel per slice.
+ *
+ * @param[inout] spectrum Spectrum analytics
+ * @param[in] sweep OCM sweep, power in dBm
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_spectrum_update(
+        _Inout_ lai_metadata_spectrum_t *spectrum,
+        _In_ const lai_spectrum_power_list_t *sweep);
+
+/**
+ * @brief Converts powers from dBm to mW
+ *
+ * Relative error is below 1e-12 for results from 2^-1021 mW up to range
+ * of double, smaller results flush to zero, larger give infinity.
+ *
+ * @param[in] count Number of values
+ * @param[in] dbm Powers in dBm
+ * @param[out] mw Powers in mW, may be the same array as input
+ */
+extern void lai_metadata_spectrum_dbm_to_mw(
+        _In_ size_t count,
+        _In_ const lai_double_t *dbm,
+        _Out_ lai_double_t *mw);
+
+/**
+ * @brief Converts powers from mW to dBm
+ *
+ * Absolute error is below 1e-9 dB, zero and subnormal powers give minus
+ * infinity, negative powers give NaN, NaN stays NaN.
+ *
+ * @param[in] count Number of values
+ * @param[in] mw Powers in mW
+ * @param[out] dbm Powers in dBm, may be the same array as input
+ */
+extern void lai_metadata_spectrum_mw_to_dbm(
+        _In_ size_t count,
+        _In_ const lai_double_t *mw,
+        _Out_ lai_double_t *dbm);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATASPECTRUM_H_ */
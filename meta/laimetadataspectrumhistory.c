@@ -0,0 +1,880 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataspectrumhistory.c
+ *
+ * @brief   This module implements LAI Metadata OCM Spectrum History
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <lai.h>
+#include "laimetadataspectrumhistory.h"
+#include "laimetadata.h"
+
+/*
+ * Each OCM keeps ring of sweeps. Quantized powers of the oldest sweep are
+ * kept in base, every following slot holds delta stream against previous
+ * sweep, so sweep is decoded by applying deltas from base forward. When
+ * the oldest sweep is dropped, delta of the next one is applied to base.
+ * Quantized powers of the latest sweep are kept as well, for encoding of
+ * next delta and for the latest sweep queries.
+ *
+ * Delta stream is sequence of varints, odd token N * 2 + 1 skips N
+ * unchanged slices, even token Z * 2 carries zigzag encoded non zero
+ * delta Z of single slice.
+ */
+
+#define HISTORY_QUANT_LIMIT     1073741824.0
+#define HISTORY_QUANT_INVALID   INT32_MIN
+#define HISTORY_VARINT_MAX      10
+
+typedef struct _lai_metadata_spectrum_history_slot_t
+{
+    uint64_t timestamp;
+    uint8_t *data;
+    size_t length;
+
+} lai_metadata_spectrum_history_slot_t;
+
+typedef struct _lai_metadata_spectrum_history_ocm_t
+{
+    lai_object_id_t ocm_id;
+
+    /* frequency grid */
+
+    uint32_t count;
+    lai_uint64_t *lower;
+    lai_uint64_t *upper;
+    bool sorted;
+
+    int32_t *base;
+    int32_t *latest;
+
+    /* ring of sweeps, head is the oldest one */
+
+    lai_metadata_spectrum_history_slot_t *slots;
+    size_t head;
+    size_t used;
+
+} lai_metadata_spectrum_history_ocm_t;
+
+typedef struct _lai_metadata_spectrum_history_state_t
+{
+    /* sorted by OCM id */
+
+    lai_metadata_spectrum_history_ocm_t **ocms;
+
+    /* scratch buffers, sized to the largest grid */
+
+    int32_t *values;
+    uint8_t *stream;
+    lai_spectrum_power_t *slices;
+    size_t scratch;
+
+} lai_metadata_spectrum_history_state_t;
+
+static size_t lai_metadata_spectrum_history_find(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id)
+{
+    const lai_metadata_spectrum_history_state_t *state = (const lai_metadata_spectrum_history_state_t*)history->state;
+    size_t low = 0;
+    size_t high = history->ocm_count;
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        if (state->ocms[mid]->ocm_id < ocm_id)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static lai_metadata_spectrum_history_ocm_t* lai_metadata_spectrum_history_get_ocm(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id)
+{
+    const lai_metadata_spectrum_history_state_t *state = (const lai_metadata_spectrum_history_state_t*)history->state;
+    size_t pos = lai_metadata_spectrum_history_find(history, ocm_id);
+
+    if (pos < history->ocm_count && state->ocms[pos]->ocm_id == ocm_id)
+    {
+        return state->ocms[pos];
+    }
+
+    return NULL;
+}
+
+static size_t lai_metadata_spectrum_history_ocm_memory(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _In_ const lai_metadata_spectrum_history_ocm_t *ocm)
+{
+    size_t memory = sizeof(lai_metadata_spectrum_history_ocm_t);
+    size_t idx;
+
+    memory += (size_t)ocm->count * (2 * sizeof(lai_uint64_t) + 2 * sizeof(int32_t));
+    memory += history->capacity * sizeof(lai_metadata_spectrum_history_slot_t);
+
+    for (idx = 0; idx < history->capacity; idx++)
+    {
+        memory += ocm->slots[idx].length;
+    }
+
+    return memory;
+}
+
+static void lai_metadata_spectrum_history_ocm_clear(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _Inout_ lai_metadata_spectrum_history_ocm_t *ocm)
+{
+    size_t idx;
+
+    for (idx = 0; idx < history->capacity; idx++)
+    {
+        free(ocm->slots[idx].data);
+    }
+
+    memset(ocm->slots, 0, history->capacity * sizeof(lai_metadata_spectrum_history_slot_t));
+
+    free(ocm->lower);
+    free(ocm->upper);
+    free(ocm->base);
+    free(ocm->latest);
+
+    ocm->lower = NULL;
+    ocm->upper = NULL;
+    ocm->base = NULL;
+    ocm->latest = NULL;
+    ocm->count = 0;
+    ocm->head = 0;
+    ocm->used = 0;
+}
+
+static void lai_metadata_spectrum_history_ocm_free(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _Inout_ lai_metadata_spectrum_history_ocm_t *ocm)
+{
+    lai_metadata_spectrum_history_ocm_clear(history, ocm);
+
+    free(ocm->slots);
+    free(ocm);
+}
+
+void lai_metadata_spectrum_history_free(
+        _Inout_ lai_metadata_spectrum_history_t *history)
+{
+    lai_metadata_spectrum_history_state_t *state;
+    size_t idx;
+
+    if (history == NULL)
+    {
+        return;
+    }
+
+    state = (lai_metadata_spectrum_history_state_t*)history->state;
+
+    if (state != NULL)
+    {
+        for (idx = 0; idx < history->ocm_count; idx++)
+        {
+            lai_metadata_spectrum_history_ocm_free(history, state->ocms[idx]);
+        }
+
+        free(state->ocms);
+        free(state->values);
+        free(state->stream);
+        free(state->slices);
+        free(state);
+    }
+
+    memset(history, 0, sizeof(lai_metadata_spectrum_history_t));
+}
+
+lai_status_t lai_metadata_spectrum_history_init(
+        _Out_ lai_metadata_spectrum_history_t *history,
+        _In_ size_t capacity,
+        _In_ lai_double_t resolution)
+{
+    if (history == NULL || capacity == 0 || !(resolution > 0))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: history, capacity or resolution");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(history, 0, sizeof(lai_metadata_spectrum_history_t));
+
+    history->capacity = capacity;
+    history->resolution = resolution;
+    history->state = calloc(1, sizeof(lai_metadata_spectrum_history_state_t));
+
+    if (history->state == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static int32_t lai_metadata_spectrum_history_quantize(
+        _In_ double power,
+        _In_ double resolution)
+{
+    double q = power / resolution;
+
+    if (__builtin_isnan(q))
+    {
+        return HISTORY_QUANT_INVALID;
+    }
+
+    q = q < -HISTORY_QUANT_LIMIT ? -HISTORY_QUANT_LIMIT : q;
+    q = q > HISTORY_QUANT_LIMIT ? HISTORY_QUANT_LIMIT : q;
+
+    return (int32_t)(q < 0 ? q - 0.5 : q + 0.5);
+}
+
+static size_t lai_metadata_spectrum_history_put_varint(
+        _Out_ uint8_t *stream,
+        _In_ uint64_t value)
+{
+    size_t length = 0;
+
+    while (value >= 0x80)
+    {
+        stream[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    stream[length++] = (uint8_t)value;
+
+    return length;
+}
+
+static size_t lai_metadata_spectrum_history_encode(
+        _In_ uint32_t count,
+        _In_ const int32_t *previous,
+        _In_ const int32_t *current,
+        _Out_ uint8_t *stream)
+{
+    size_t length = 0;
+    uint64_t run = 0;
+    uint32_t idx;
+
+    for (idx = 0; idx < count; idx++)
+    {
+        int64_t delta = (int64_t)current[idx] - (int64_t)previous[idx];
+        uint64_t zigzag;
+
+        if (delta == 0)
+        {
+            run++;
+            continue;
+        }
+
+        if (run != 0)
+        {
+            length += lai_metadata_spectrum_history_put_varint(&stream[length], run << 1 | 1);
+            run = 0;
+        }
+
+        zigzag = delta < 0 ? ~((uint64_t)delta << 1) : (uint64_t)delta << 1;
+
+        length += lai_metadata_spectrum_history_put_varint(&stream[length], zigzag << 1);
+    }
+
+    /* trailing run is implied */
+
+    return length;
+}
+
+static void lai_metadata_spectrum_history_decode(
+        _In_ uint32_t count,
+        _In_ const uint8_t *stream,
+        _In_ size_t length,
+        _Inout_ int32_t *values)
+{
+    size_t pos = 0;
+    uint64_t idx = 0;
+
+    while (pos < length && idx < count)
+    {
+        uint64_t token = 0;
+        unsigned shift = 0;
+        uint64_t zigzag;
+
+        do
+        {
+            token |= (uint64_t)(stream[pos] & 0x7F) << shift;
+            shift += 7;
+        }
+        while (stream[pos++] & 0x80);
+
+        if (token & 1)
+        {
+            idx += token >> 1;
+            continue;
+        }
+
+        zigzag = token >> 1;
+
+        values[idx] = (int32_t)((int64_t)values[idx] + ((zigzag & 1) ? -(int64_t)(zigzag >> 1) - 1 : (int64_t)(zigzag >> 1)));
+
+        idx++;
+    }
+}
+
+static lai_status_t lai_metadata_spectrum_history_reserve(
+        _Inout_ lai_metadata_spectrum_history_state_t *state,
+        _In_ uint32_t count)
+{
+    int32_t *values;
+    uint8_t *stream;
+    lai_spectrum_power_t *slices;
+
+    if (count <= state->scratch)
+    {
+        return LAI_STATUS_SUCCESS;
+    }
+
+    values = (int32_t*)realloc(state->values, count * sizeof(int32_t));
+
+    if (values == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    state->values = values;
+
+    stream = (uint8_t*)realloc(state->stream, (size_t)count * HISTORY_VARINT_MAX);
+
+    if (stream == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    state->stream = stream;
+
+    slices = (lai_spectrum_power_t*)realloc(state->slices, count * sizeof(lai_spectrum_power_t));
+
+    if (slices == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    state->slices = slices;
+    state->scratch = count;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static bool lai_metadata_spectrum_history_same_grid(
+        _In_ const lai_metadata_spectrum_history_ocm_t *ocm,
+        _In_ const lai_spectrum_power_list_t *sweep)
+{
+    uint32_t idx;
+
+    if (ocm->count != sweep->count || ocm->lower == NULL)
+    {
+        return false;
+    }
+
+    for (idx = 0; idx < sweep->count; idx++)
+    {
+        if (ocm->lower[idx] != sweep->list[idx].lower_frequency ||
+                ocm->upper[idx] != sweep->list[idx].upper_frequency)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static lai_status_t lai_metadata_spectrum_history_set_grid(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _Inout_ lai_metadata_spectrum_history_ocm_t *ocm,
+        _In_ const lai_spectrum_power_list_t *sweep)
+{
+    size_t n = sweep->count == 0 ? 1 : sweep->count;
+    uint32_t idx;
+
+    lai_metadata_spectrum_history_ocm_clear(history, ocm);
+
+    ocm->lower = (lai_uint64_t*)malloc(n * sizeof(lai_uint64_t));
+    ocm->upper = (lai_uint64_t*)malloc(n * sizeof(lai_uint64_t));
+    ocm->base = (int32_t*)malloc(n * sizeof(int32_t));
+    ocm->latest = (int32_t*)malloc(n * sizeof(int32_t));
+
+    if (ocm->lower == NULL || ocm->upper == NULL || ocm->base == NULL || ocm->latest == NULL)
+    {
+        lai_metadata_spectrum_history_ocm_clear(history, ocm);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    ocm->count = sweep->count;
+    ocm->sorted = true;
+
+    for (idx = 0; idx < sweep->count; idx++)
+    {
+        ocm->lower[idx] = sweep->list[idx].lower_frequency;
+        ocm->upper[idx] = sweep->list[idx].upper_frequency;
+
+        if (idx != 0 && (ocm->lower[idx] < ocm->upper[idx - 1] || ocm->lower[idx] < ocm->lower[idx - 1]))
+        {
+            ocm->sorted = false;
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_metadata_spectrum_history_insert(
+        _Inout_ lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id,
+        _Out_ lai_metadata_spectrum_history_ocm_t **inserted)
+{
+    lai_metadata_spectrum_history_state_t *state = (lai_metadata_spectrum_history_state_t*)history->state;
+    lai_metadata_spectrum_history_ocm_t **ocms;
+    lai_metadata_spectrum_history_ocm_t *ocm;
+    size_t pos = lai_metadata_spectrum_history_find(history, ocm_id);
+
+    ocms = (lai_metadata_spectrum_history_ocm_t**)realloc(state->ocms, (history->ocm_count + 1) * sizeof(lai_metadata_spectrum_history_ocm_t*));
+
+    if (ocms == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    state->ocms = ocms;
+
+    ocm = (lai_metadata_spectrum_history_ocm_t*)calloc(1, sizeof(lai_metadata_spectrum_history_ocm_t));
+
+    if (ocm == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    ocm->slots = (lai_metadata_spectrum_history_slot_t*)calloc(history->capacity, sizeof(lai_metadata_spectrum_history_slot_t));
+
+    if (ocm->slots == NULL)
+    {
+        free(ocm);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    ocm->ocm_id = ocm_id;
+
+    memmove(&ocms[pos + 1], &ocms[pos], (history->ocm_count - pos) * sizeof(lai_metadata_spectrum_history_ocm_t*));
+
+    ocms[pos] = ocm;
+
+    history->ocm_count++;
+    history->memory += lai_metadata_spectrum_history_ocm_memory(history, ocm);
+
+    *inserted = ocm;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_spectrum_history_add(
+        _Inout_ lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id,
+        _In_ uint64_t timestamp,
+        _In_ const lai_spectrum_power_list_t *sweep)
+{
+    lai_metadata_spectrum_history_state_t *state;
+    lai_metadata_spectrum_history_ocm_t *ocm;
+    lai_metadata_spectrum_history_slot_t *slot;
+    size_t length;
+    uint32_t idx;
+    lai_status_t status;
+
+    if (history == NULL || history->state == NULL || sweep == NULL || (sweep->count != 0 && sweep->list == NULL))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: history or sweep");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    state = (lai_metadata_spectrum_history_state_t*)history->state;
+
+    status = lai_metadata_spectrum_history_reserve(state, sweep->count);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    ocm = lai_metadata_spectrum_history_get_ocm(history, ocm_id);
+
+    if (ocm == NULL)
+    {
+        status = lai_metadata_spectrum_history_insert(history, ocm_id, &ocm);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    history->memory -= lai_metadata_spectrum_history_ocm_memory(history, ocm);
+
+    if (ocm->used != 0 && timestamp < ocm->slots[(ocm->head + ocm->used - 1) % history->capacity].timestamp)
+    {
+        LAI_META_LOG_ERROR("sweep of OCM 0x%llx is older than previous one", (unsigned long long)ocm_id);
+
+        history->memory += lai_metadata_spectrum_history_ocm_memory(history, ocm);
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!lai_metadata_spectrum_history_same_grid(ocm, sweep))
+    {
+        if (ocm->used != 0)
+        {
+            LAI_META_LOG_NOTICE("frequency grid of OCM 0x%llx changed, history restarted", (unsigned long long)ocm_id);
+        }
+
+        status = lai_metadata_spectrum_history_set_grid(history, ocm, sweep);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            history->memory += lai_metadata_spectrum_history_ocm_memory(history, ocm);
+
+            return status;
+        }
+    }
+
+    for (idx = 0; idx < sweep->count; idx++)
+    {
+        state->values[idx] = lai_metadata_spectrum_history_quantize(sweep->list[idx].power, history->resolution);
+    }
+
+    if (ocm->used == history->capacity)
+    {
+        /* drop the oldest sweep, base moves to the next one */
+
+        ocm->head = (ocm->head + 1) % history->capacity;
+        ocm->used--;
+
+        slot = &ocm->slots[ocm->head];
+
+        lai_metadata_spectrum_history_decode(ocm->count, slot->data, slot->length, ocm->base);
+
+        free(slot->data);
+
+        slot->data = NULL;
+        slot->length = 0;
+    }
+
+    slot = &ocm->slots[(ocm->head + ocm->used) % history->capacity];
+
+    free(slot->data);
+
+    slot->data = NULL;
+    slot->length = 0;
+    slot->timestamp = timestamp;
+
+    if (ocm->used == 0)
+    {
+        memcpy(ocm->base, state->values, ocm->count * sizeof(int32_t));
+    }
+    else
+    {
+        length = lai_metadata_spectrum_history_encode(ocm->count, ocm->latest, state->values, state->stream);
+
+        if (length != 0)
+        {
+            slot->data = (uint8_t*)malloc(length);
+
+            if (slot->data == NULL)
+            {
+                history->memory += lai_metadata_spectrum_history_ocm_memory(history, ocm);
+
+                return LAI_STATUS_NO_MEMORY;
+            }
+
+            memcpy(slot->data, state->stream, length);
+
+            slot->length = length;
+        }
+    }
+
+    memcpy(ocm->latest, state->values, ocm->count * sizeof(int32_t));
+
+    ocm->used++;
+
+    history->memory += lai_metadata_spectrum_history_ocm_memory(history, ocm);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_spectrum_history_remove(
+        _Inout_ lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id)
+{
+    lai_metadata_spectrum_history_state_t *state;
+    size_t pos;
+
+    if (history == NULL || history->state == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    state = (lai_metadata_spectrum_history_state_t*)history->state;
+
+    pos = lai_metadata_spectrum_history_find(history, ocm_id);
+
+    if (pos == history->ocm_count || state->ocms[pos]->ocm_id != ocm_id)
+    {
+        return LAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    history->memory -= lai_metadata_spectrum_history_ocm_memory(history, state->ocms[pos]);
+
+    lai_metadata_spectrum_history_ocm_free(history, state->ocms[pos]);
+
+    history->ocm_count--;
+
+    memmove(&state->ocms[pos], &state->ocms[pos + 1], (history->ocm_count - pos) * sizeof(lai_metadata_spectrum_history_ocm_t*));
+
+    return LAI_STATUS_SUCCESS;
+}
+
+/*
+ * Fills slices overlapping frequency range, sorted grid starts at first
+ * overlapping slice found by binary search. Returns number of slices in
+ * range, only up to capacity of slices are written.
+ */
+
+static uint32_t lai_metadata_spectrum_history_fill(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _In_ const lai_metadata_spectrum_history_ocm_t *ocm,
+        _In_ const int32_t *values,
+        _In_ lai_uint64_t lower_frequency,
+        _In_ lai_uint64_t upper_frequency,
+        _In_ uint32_t capacity,
+        _Out_ lai_spectrum_power_t *slices)
+{
+    uint32_t idx = 0;
+    uint32_t count = 0;
+
+    if (ocm->sorted)
+    {
+        uint32_t high = ocm->count;
+
+        while (idx < high)
+        {
+            uint32_t mid = idx + (high - idx) / 2;
+
+            if (ocm->upper[mid] <= lower_frequency)
+            {
+                idx = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+    }
+
+    for (; idx < ocm->count; idx++)
+    {
+        if (ocm->lower[idx] >= upper_frequency)
+        {
+            if (ocm->sorted)
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        if (ocm->upper[idx] <= lower_frequency)
+        {
+            continue;
+        }
+
+        if (count < capacity)
+        {
+            slices[count].lower_frequency = ocm->lower[idx];
+            slices[count].upper_frequency = ocm->upper[idx];
+            slices[count].power = values[idx] == HISTORY_QUANT_INVALID ? __builtin_nan("") : (double)values[idx] * history->resolution;
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+lai_status_t lai_metadata_spectrum_history_get(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id,
+        _In_ uint64_t timestamp,
+        _In_ lai_uint64_t lower_frequency,
+        _In_ lai_uint64_t upper_frequency,
+        _Out_ uint64_t *sweep_timestamp,
+        _Inout_ lai_spectrum_power_list_t *sweep)
+{
+    lai_metadata_spectrum_history_state_t *state;
+    const lai_metadata_spectrum_history_ocm_t *ocm;
+    const int32_t *values;
+    size_t low = 0;
+    size_t high;
+    size_t age;
+    uint32_t count;
+
+    if (history == NULL || history->state == NULL || sweep_timestamp == NULL || sweep == NULL ||
+            (sweep->count != 0 && sweep->list == NULL))
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    state = (lai_metadata_spectrum_history_state_t*)history->state;
+
+    ocm = lai_metadata_spectrum_history_get_ocm(history, ocm_id);
+
+    if (ocm == NULL || ocm->used == 0 || ocm->slots[ocm->head].timestamp > timestamp)
+    {
+        return LAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    /* the last sweep at or before timestamp */
+
+    high = ocm->used;
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+
+        if (ocm->slots[(ocm->head + mid) % history->capacity].timestamp <= timestamp)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    age = low - 1;
+
+    if (age == ocm->used - 1)
+    {
+        values = ocm->latest;
+    }
+    else
+    {
+        size_t idx;
+
+        memcpy(state->values, ocm->base, ocm->count * sizeof(int32_t));
+
+        for (idx = 1; idx <= age; idx++)
+        {
+            const lai_metadata_spectrum_history_slot_t *slot = &ocm->slots[(ocm->head + idx) % history->capacity];
+
+            lai_metadata_spectrum_history_decode(ocm->count, slot->data, slot->length, state->values);
+        }
+
+        values = state->values;
+    }
+
+    *sweep_timestamp = ocm->slots[(ocm->head + age) % history->capacity].timestamp;
+
+    count = lai_metadata_spectrum_history_fill(history, ocm, values, lower_frequency, upper_frequency, sweep->count, sweep->list);
+
+    if (count > sweep->count)
+    {
+        sweep->count = count;
+
+        return LAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    sweep->count = count;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_spectrum_history_query(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id,
+        _In_ uint64_t from_timestamp,
+        _In_ uint64_t to_timestamp,
+        _In_ lai_uint64_t lower_frequency,
+        _In_ lai_uint64_t upper_frequency,
+        _In_ lai_metadata_spectrum_history_sweep_fn callback,
+        _Inout_ void *context)
+{
+    lai_metadata_spectrum_history_state_t *state;
+    const lai_metadata_spectrum_history_ocm_t *ocm;
+    lai_spectrum_power_list_t sweep;
+    size_t age;
+
+    if (history == NULL || history->state == NULL || callback == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    state = (lai_metadata_spectrum_history_state_t*)history->state;
+
+    ocm = lai_metadata_spectrum_history_get_ocm(history, ocm_id);
+
+    if (ocm == NULL)
+    {
+        return LAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    memcpy(state->values, ocm->base, ocm->count * sizeof(int32_t));
+
+    for (age = 0; age < ocm->used; age++)
+    {
+        const lai_metadata_spectrum_history_slot_t *slot = &ocm->slots[(ocm->head + age) % history->capacity];
+
+        if (slot->timestamp > to_timestamp)
+        {
+            break;
+        }
+
+        if (age != 0)
+        {
+            lai_metadata_spectrum_history_decode(ocm->count, slot->data, slot->length, state->values);
+        }
+
+        if (slot->timestamp < from_timestamp)
+        {
+            continue;
+        }
+
+        sweep.list = state->slices;
+        sweep.count = lai_metadata_spectrum_history_fill(history, ocm, state->values, lower_frequency, upper_frequency, ocm->count, state->slices);
+
+        callback(context, ocm_id, slot->timestamp, &sweep);
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
@@ -0,0 +1,197 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataspectrumhistory.h
+ *
+ * @brief   This module defines LAI Metadata OCM Spectrum History
+ */
+
+#ifndef __LAIMETADATASPECTRUMHISTORY_H_
+#define __LAIMETADATASPECTRUMHISTORY_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATASPECTRUMHISTORY LAI - Metadata OCM Spectrum History Definitions
+ *
+ * History keeps last sweeps of each OCM object. Frequency grid is stored
+ * once per OCM, powers are quantized to history resolution and each sweep
+ * is stored as difference against previous sweep, where runs of unchanged
+ * slices take single byte. Quiet sweep of hundreds of slices takes few
+ * bytes instead of 24 bytes per slice.
+ *
+ * Sweep with different frequency grid than previous one restarts history
+ * of its OCM. History is not thread safe, caller serializes all calls.
+ *
+ * @{
+ */
+
+/**
+ * @brief Called for each sweep of time window query
+ *
+ * Sweep memory is valid only during the call, callback must not call
+ * history functions.
+ *
+ * @param[inout] context Context passed to query
+ * @param[in] ocm_id OCM object id
+ * @param[in] timestamp Sweep time
+ * @param[in] sweep Slices of sweep in queried frequency range
+ */
+typedef void (*lai_metadata_spectrum_history_sweep_fn)(
+        _Inout_ void *context,
+        _In_ lai_object_id_t ocm_id,
+        _In_ uint64_t timestamp,
+        _In_ const lai_spectrum_power_list_t *sweep);
+
+/**
+ * @brief Spectrum history of all OCM objects
+ */
+typedef struct _lai_metadata_spectrum_history_t
+{
+    /**
+     * @brief Number of sweeps kept per OCM.
+     */
+    size_t capacity;
+
+    /**
+     * @brief Power quantization step in dB.
+     */
+    lai_double_t resolution;
+
+    /**
+     * @brief Number of OCM objects in history.
+     */
+    size_t ocm_count;
+
+    /**
+     * @brief Bytes used by grids and sweeps.
+     */
+    size_t memory;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_spectrum_history_t;
+
+/**
+ * @brief Initializes spectrum history
+ *
+ * @param[out] history History to be initialized
+ * @param[in] capacity Number of sweeps kept per OCM
+ * @param[in] resolution Power quantization step in dB, for example 0.01
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_spectrum_history_init(
+        _Out_ lai_metadata_spectrum_history_t *history,
+        _In_ size_t capacity,
+        _In_ lai_double_t resolution);
+
+/**
+ * @brief Releases spectrum history
+ *
+ * @param[inout] history History to be released
+ */
+extern void lai_metadata_spectrum_history_free(
+        _Inout_ lai_metadata_spectrum_history_t *history);
+
+/**
+ * @brief Adds sweep of OCM, the oldest sweep is dropped when history is full
+ *
+ * NaN power is kept as NaN, other powers are clamped to quantization range.
+ *
+ * @param[inout] history Spectrum history
+ * @param[in] ocm_id OCM object id
+ * @param[in] timestamp Sweep time, not lower than time of previous sweep
+ * @param[in] sweep OCM sweep, power in dBm
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_spectrum_history_add(
+        _Inout_ lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id,
+        _In_ uint64_t timestamp,
+        _In_ const lai_spectrum_power_list_t *sweep);
+
+/**
+ * @brief Removes all sweeps of OCM
+ *
+ * @param[inout] history Spectrum history
+ * @param[in] ocm_id OCM object id
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_ITEM_NOT_FOUND if OCM
+ * has no history
+ */
+extern lai_status_t lai_metadata_spectrum_history_remove(
+        _Inout_ lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id);
+
+/**
+ * @brief Gets the latest sweep taken at or before timestamp
+ *
+ * Only slices overlapping frequency range are returned.
+ *
+ * @param[in] history Spectrum history
+ * @param[in] ocm_id OCM object id
+ * @param[in] timestamp Time, UINT64_MAX for the latest sweep
+ * @param[in] lower_frequency Lower frequency of range in MHz
+ * @param[in] upper_frequency Upper frequency of range in MHz
+ * @param[out] sweep_timestamp Time of returned sweep
+ * @param[inout] sweep Slices, count is set to required number on overflow
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_ITEM_NOT_FOUND if
+ * there is no such sweep, #LAI_STATUS_BUFFER_OVERFLOW if list size
+ * insufficient, failure status code on error
+ */
+extern lai_status_t lai_metadata_spectrum_history_get(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id,
+        _In_ uint64_t timestamp,
+        _In_ lai_uint64_t lower_frequency,
+        _In_ lai_uint64_t upper_frequency,
+        _Out_ uint64_t *sweep_timestamp,
+        _Inout_ lai_spectrum_power_list_t *sweep);
+
+/**
+ * @brief Calls callback for each sweep in time window, oldest first
+ *
+ * @param[in] history Spectrum history
+ * @param[in] ocm_id OCM object id
+ * @param[in] from_timestamp Start of time window, inclusive
+ * @param[in] to_timestamp End of time window, inclusive
+ * @param[in] lower_frequency Lower frequency of range in MHz
+ * @param[in] upper_frequency Upper frequency of range in MHz
+ * @param[in] callback Callback called for each sweep
+ * @param[inout] context Context passed to callback
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_ITEM_NOT_FOUND if OCM
+ * has no history, failure status code on error
+ */
+extern lai_status_t lai_metadata_spectrum_history_query(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _In_ lai_object_id_t ocm_id,
+        _In_ uint64_t from_timestamp,
+        _In_ uint64_t to_timestamp,
+        _In_ lai_uint64_t lower_frequency,
+        _In_ lai_uint64_t upper_frequency,
+        _In_ lai_metadata_spectrum_history_sweep_fn callback,
+        _Inout_ void *context);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATASPECTRUMHISTORY_H_ */
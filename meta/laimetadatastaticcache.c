@@ -0,0 +1,595 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatastaticcache.c
+ *
+ * @brief   This module implements LAI Metadata Static Attribute Cache
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <lai.h>
+#include "laimetadatastaticcache.h"
+#include "laimetadata.h"
+
+#define STATIC_CACHE_INITIAL_CAPACITY 64
+
+typedef struct _lai_metadata_static_cache_value_t
+{
+    lai_attr_id_t attr_id;
+
+    lai_attribute_value_t value;
+
+} lai_metadata_static_cache_value_t;
+
+/*
+ * Epoch is incremented by every invalidation, get started before
+ * invalidation does not store values read from replaced module.
+ */
+
+typedef struct _lai_metadata_static_cache_object_t
+{
+    lai_object_id_t object_id;
+
+    uint64_t epoch;
+
+    bool present_known;
+
+    int32_t present;
+
+    size_t count;
+
+    size_t capacity;
+
+    /* sorted by attribute id */
+
+    lai_metadata_static_cache_value_t *values;
+
+} lai_metadata_static_cache_object_t;
+
+typedef struct _lai_metadata_static_cache_internal_t
+{
+    pthread_mutex_t lock;
+
+    size_t count;
+
+    /* open addressing by object id, power of 2 */
+
+    size_t capacity;
+
+    lai_metadata_static_cache_object_t **objects;
+
+} lai_metadata_static_cache_internal_t;
+
+static size_t lai_metadata_static_cache_hash(
+        _In_ lai_object_id_t object_id,
+        _In_ size_t mask)
+{
+    uint64_t hash = object_id * 0x9E3779B97F4A7C15ULL;
+
+    return (size_t)(hash ^ (hash >> 29)) & mask;
+}
+
+static lai_metadata_static_cache_object_t* lai_metadata_static_cache_find(
+        _In_ const lai_metadata_static_cache_internal_t *internal,
+        _In_ lai_object_id_t object_id)
+{
+    size_t mask = internal->capacity - 1;
+    size_t idx;
+
+    for (idx = lai_metadata_static_cache_hash(object_id, mask);
+            internal->objects[idx] != NULL;
+            idx = (idx + 1) & mask)
+    {
+        if (internal->objects[idx]->object_id == object_id)
+        {
+            return internal->objects[idx];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Objects are never removed from table, invalidation only drops their
+ * values, so table keeps one entry per object ever read.
+ */
+
+static lai_metadata_static_cache_object_t* lai_metadata_static_cache_insert(
+        _Inout_ lai_metadata_static_cache_internal_t *internal,
+        _In_ lai_object_id_t object_id)
+{
+    lai_metadata_static_cache_object_t *object;
+    size_t mask;
+    size_t idx;
+
+    if (2 * (internal->count + 1) > internal->capacity)
+    {
+        size_t capacity = 2 * internal->capacity;
+        lai_metadata_static_cache_object_t **objects;
+
+        objects = (lai_metadata_static_cache_object_t**)calloc(capacity, sizeof(lai_metadata_static_cache_object_t*));
+
+        if (objects == NULL)
+        {
+            return NULL;
+        }
+
+        mask = capacity - 1;
+
+        for (idx = 0; idx < internal->capacity; idx++)
+        {
+            size_t pos;
+
+            if (internal->objects[idx] == NULL)
+            {
+                continue;
+            }
+
+            for (pos = lai_metadata_static_cache_hash(internal->objects[idx]->object_id, mask);
+                    objects[pos] != NULL;
+                    pos = (pos + 1) & mask)
+            {
+            }
+
+            objects[pos] = internal->objects[idx];
+        }
+
+        free(internal->objects);
+
+        internal->objects = objects;
+        internal->capacity = capacity;
+    }
+
+    object = (lai_metadata_static_cache_object_t*)calloc(1, sizeof(lai_metadata_static_cache_object_t));
+
+    if (object == NULL)
+    {
+        return NULL;
+    }
+
+    object->object_id = object_id;
+
+    mask = internal->capacity - 1;
+
+    for (idx = lai_metadata_static_cache_hash(object_id, mask);
+            internal->objects[idx] != NULL;
+            idx = (idx + 1) & mask)
+    {
+    }
+
+    internal->objects[idx] = object;
+    internal->count++;
+
+    return object;
+}
+
+static size_t lai_metadata_static_cache_lower_bound(
+        _In_ const lai_metadata_static_cache_object_t *object,
+        _In_ lai_attr_id_t attr_id)
+{
+    size_t lo = 0;
+    size_t hi = object->count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (object->values[mid].attr_id < attr_id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static const lai_attribute_value_t* lai_metadata_static_cache_lookup(
+        _In_ const lai_metadata_static_cache_object_t *object,
+        _In_ lai_attr_id_t attr_id)
+{
+    size_t pos = lai_metadata_static_cache_lower_bound(object, attr_id);
+
+    if (pos < object->count && object->values[pos].attr_id == attr_id)
+    {
+        return &object->values[pos].value;
+    }
+
+    return NULL;
+}
+
+static void lai_metadata_static_cache_store(
+        _Inout_ lai_metadata_static_cache_t *cache,
+        _Inout_ lai_metadata_static_cache_object_t *object,
+        _In_ const lai_attribute_t *attr)
+{
+    size_t pos = lai_metadata_static_cache_lower_bound(object, attr->id);
+
+    if (pos < object->count && object->values[pos].attr_id == attr->id)
+    {
+        object->values[pos].value = attr->value;
+        return;
+    }
+
+    if (object->count == object->capacity)
+    {
+        size_t capacity = object->capacity == 0 ? 8 : 2 * object->capacity;
+        lai_metadata_static_cache_value_t *values;
+
+        values = (lai_metadata_static_cache_value_t*)realloc(object->values, capacity * sizeof(lai_metadata_static_cache_value_t));
+
+        if (values == NULL)
+        {
+            /* value is read from adapter again next time */
+
+            return;
+        }
+
+        object->values = values;
+        object->capacity = capacity;
+    }
+
+    memmove(&object->values[pos + 1], &object->values[pos], (object->count - pos) * sizeof(lai_metadata_static_cache_value_t));
+
+    object->values[pos].attr_id = attr->id;
+    object->values[pos].value = attr->value;
+    object->count++;
+
+    cache->count++;
+}
+
+static void lai_metadata_static_cache_drop(
+        _Inout_ lai_metadata_static_cache_t *cache,
+        _Inout_ lai_metadata_static_cache_object_t *object)
+{
+    cache->count -= object->count;
+
+    free(object->values);
+
+    object->values = NULL;
+    object->count = 0;
+    object->capacity = 0;
+    object->present_known = false;
+    object->epoch++;
+}
+
+/*
+ * Adapter reports failing attribute as index into list it got, which is
+ * index of miss here.
+ */
+
+static lai_status_t lai_metadata_static_cache_map_status(
+        _In_ lai_status_t status,
+        _In_ uint32_t count,
+        _In_ const uint32_t *misses)
+{
+    const lai_status_t bases[] = {
+        LAI_STATUS_INVALID_ATTRIBUTE_0,
+        LAI_STATUS_INVALID_ATTR_VALUE_0,
+        LAI_STATUS_ATTR_NOT_IMPLEMENTED_0,
+        LAI_STATUS_UNKNOWN_ATTRIBUTE_0,
+        LAI_STATUS_ATTR_NOT_SUPPORTED_0,
+    };
+
+    size_t idx;
+
+    for (idx = 0; idx < sizeof(bases)/sizeof(bases[0]); idx++)
+    {
+        int64_t offset = (int64_t)status - (int64_t)bases[idx];
+
+        if (offset >= 0 && offset < (int64_t)count)
+        {
+            return (lai_status_t)(bases[idx] + (lai_status_t)misses[offset]);
+        }
+    }
+
+    return status;
+}
+
+lai_status_t lai_metadata_static_cache_init(
+        _Out_ lai_metadata_static_cache_t *cache)
+{
+    lai_metadata_static_cache_internal_t *internal;
+
+    if (cache == NULL)
+    {
+        LAI_META_LOG_ERROR("cache parameter is NULL");
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(cache, 0, sizeof(*cache));
+
+    internal = (lai_metadata_static_cache_internal_t*)calloc(1, sizeof(lai_metadata_static_cache_internal_t));
+
+    if (internal == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    internal->capacity = STATIC_CACHE_INITIAL_CAPACITY;
+    internal->objects = (lai_metadata_static_cache_object_t**)calloc(internal->capacity, sizeof(lai_metadata_static_cache_object_t*));
+
+    if (internal->objects == NULL)
+    {
+        free(internal);
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    pthread_mutex_init(&internal->lock, NULL);
+
+    cache->state = internal;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_static_cache_free(
+        _Inout_ lai_metadata_static_cache_t *cache)
+{
+    lai_metadata_static_cache_internal_t *internal;
+    size_t idx;
+
+    if (cache == NULL || cache->state == NULL)
+    {
+        return;
+    }
+
+    internal = (lai_metadata_static_cache_internal_t*)cache->state;
+
+    for (idx = 0; idx < internal->capacity; idx++)
+    {
+        if (internal->objects[idx] != NULL)
+        {
+            free(internal->objects[idx]->values);
+            free(internal->objects[idx]);
+        }
+    }
+
+    pthread_mutex_destroy(&internal->lock);
+
+    free(internal->objects);
+    free(internal);
+
+    memset(cache, 0, sizeof(*cache));
+}
+
+lai_status_t lai_metadata_static_cache_get(
+        _Inout_ lai_metadata_static_cache_t *cache,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list)
+{
+    lai_metadata_static_cache_internal_t *internal;
+    lai_metadata_static_cache_object_t *object;
+    const lai_object_type_info_t *info;
+    lai_object_meta_key_t meta_key;
+    lai_attribute_t *attrs;
+    uint32_t *misses;
+    uint32_t count = 0;
+    uint32_t idx;
+    uint64_t epoch = 0;
+    int32_t present = 0;
+    bool has_present = false;
+    lai_status_t status;
+
+    if (cache == NULL || cache->state == NULL || (attr_count != 0 && attr_list == NULL))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: cache or attr_list");
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    info = lai_metadata_get_object_type_info(object_type);
+
+    if (info == NULL || info->get == NULL)
+    {
+        LAI_META_LOG_ERROR("object type %d has no get", object_type);
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    internal = (lai_metadata_static_cache_internal_t*)cache->state;
+
+    misses = (uint32_t*)calloc((size_t)attr_count + 1, sizeof(uint32_t));
+
+    if (misses == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        if (object_type == LAI_OBJECT_TYPE_TRANSCEIVER && attr_list[idx].id == LAI_TRANSCEIVER_ATTR_PRESENT)
+        {
+            has_present = true;
+        }
+    }
+
+    pthread_mutex_lock(&internal->lock);
+
+    object = lai_metadata_static_cache_find(internal, object_id);
+
+    if (object == NULL)
+    {
+        object = lai_metadata_static_cache_insert(internal, object_id);
+    }
+
+    if (object != NULL)
+    {
+        epoch = object->epoch;
+    }
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const lai_attribute_value_t *value = NULL;
+
+        if (object != NULL && !has_present)
+        {
+            value = lai_metadata_static_cache_lookup(object, attr_list[idx].id);
+        }
+
+        if (value != NULL)
+        {
+            attr_list[idx].value = *value;
+            cache->hits++;
+        }
+        else
+        {
+            misses[count++] = idx;
+        }
+    }
+
+    cache->misses += count;
+
+    pthread_mutex_unlock(&internal->lock);
+
+    if (count == 0)
+    {
+        free(misses);
+        return LAI_STATUS_SUCCESS;
+    }
+
+    attrs = (lai_attribute_t*)calloc(count, sizeof(lai_attribute_t));
+
+    if (attrs == NULL)
+    {
+        free(misses);
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < count; idx++)
+    {
+        attrs[idx] = attr_list[misses[idx]];
+    }
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = object_type;
+    meta_key.objectkey.key.object_id = object_id;
+
+    status = info->get(&meta_key, count, attrs);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        attr_list[misses[idx]] = attrs[idx];
+
+        if (has_present && attrs[idx].id == LAI_TRANSCEIVER_ATTR_PRESENT)
+        {
+            present = attrs[idx].value.s32;
+        }
+    }
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        status = lai_metadata_static_cache_map_status(status, count, misses);
+    }
+
+    if (status == LAI_STATUS_SUCCESS && object != NULL)
+    {
+        pthread_mutex_lock(&internal->lock);
+
+        if (has_present && object->epoch == epoch)
+        {
+            if (object->present_known && object->present != present)
+            {
+                lai_metadata_static_cache_drop(cache, object);
+
+                epoch = object->epoch;
+            }
+
+            object->present_known = true;
+            object->present = present;
+        }
+
+        if (object->epoch == epoch && (!has_present || present == LAI_TRANSCEIVER_PRESENT_PRESENT))
+        {
+            for (idx = 0; idx < count; idx++)
+            {
+                const lai_attr_metadata_t *md = lai_metadata_get_attr_metadata(object_type, attrs[idx].id);
+
+                if (md != NULL && md->isstatic)
+                {
+                    lai_metadata_static_cache_store(cache, object, &attrs[idx]);
+                }
+            }
+        }
+
+        pthread_mutex_unlock(&internal->lock);
+    }
+
+    free(attrs);
+    free(misses);
+
+    return status;
+}
+
+void lai_metadata_static_cache_invalidate(
+        _Inout_ lai_metadata_static_cache_t *cache,
+        _In_ lai_object_id_t object_id)
+{
+    lai_metadata_static_cache_internal_t *internal;
+    lai_metadata_static_cache_object_t *object;
+    size_t idx;
+
+    if (cache == NULL || cache->state == NULL)
+    {
+        return;
+    }
+
+    internal = (lai_metadata_static_cache_internal_t*)cache->state;
+
+    pthread_mutex_lock(&internal->lock);
+
+    if (object_id == LAI_NULL_OBJECT_ID)
+    {
+        for (idx = 0; idx < internal->capacity; idx++)
+        {
+            if (internal->objects[idx] != NULL)
+            {
+                lai_metadata_static_cache_drop(cache, internal->objects[idx]);
+            }
+        }
+    }
+    else
+    {
+        object = lai_metadata_static_cache_find(internal, object_id);
+
+        if (object != NULL)
+        {
+            lai_metadata_static_cache_drop(cache, object);
+        }
+    }
+
+    pthread_mutex_unlock(&internal->lock);
+}
+
+void lai_metadata_static_cache_alarm(
+        _Inout_ lai_metadata_static_cache_t *cache,
+        _In_ lai_alarm_type_t alarm_type,
+        _In_ const lai_alarm_info_t *alarm_info)
+{
+    if (alarm_type != LAI_ALARM_TYPE_PLUG_IN && alarm_type != LAI_ALARM_TYPE_PLUG_OFF)
+    {
+        return;
+    }
+
+    lai_metadata_static_cache_invalidate(cache, alarm_info == NULL ? LAI_NULL_OBJECT_ID : alarm_info->resource_oid);
+}
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatastaticcache.h
+ *
+ * @brief   This module defines LAI Metadata Static Attribute Cache
+ */
+
+#ifndef __LAIMETADATASTATICCACHE_H_
+#define __LAIMETADATASTATICCACHE_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATASTATICCACHE LAI - Metadata Static Attribute Cache Definitions
+ *
+ * Attributes with isstatic metadata, like transceiver vendor, part and
+ * serial number, are read from module over slow management bus but change
+ * only when module is replaced. Cache serves them from memory, the first get
+ * of object reads them from adapter and every later get is answered without
+ * adapter call. Other attributes of the same get are read from adapter in
+ * single call, so mixed gets still cost one adapter call.
+ *
+ * Cached values of object are dropped on #LAI_ALARM_TYPE_PLUG_IN and
+ * #LAI_ALARM_TYPE_PLUG_OFF alarm of the object and when get returns changed
+ * #LAI_TRANSCEIVER_ATTR_PRESENT. Get which reads presence never uses cached
+ * values, so values returned with presence always belong to that module.
+ *
+ * All functions may be called from any thread, adapter is never called with
+ * cache lock held.
+ *
+ * @{
+ */
+
+/**
+ * @brief Static attribute cache
+ */
+typedef struct _lai_metadata_static_cache_t
+{
+    /**
+     * @brief Number of attributes served from cache.
+     */
+    uint64_t hits;
+
+    /**
+     * @brief Number of attributes read from adapter.
+     */
+    uint64_t misses;
+
+    /**
+     * @brief Number of cached values.
+     */
+    size_t count;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_static_cache_t;
+
+/**
+ * @brief Initializes static attribute cache
+ *
+ * @param[out] cache Cache to be initialized
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_static_cache_init(
+        _Out_ lai_metadata_static_cache_t *cache);
+
+/**
+ * @brief Releases static attribute cache
+ *
+ * @param[inout] cache Cache to be released
+ */
+extern void lai_metadata_static_cache_free(
+        _Inout_ lai_metadata_static_cache_t *cache);
+
+/**
+ * @brief Gets attributes, static ones from cache
+ *
+ * Attributes not found in cache are read by get of object type info, static
+ * ones are cached when whole get succeeds. Attribute index in returned
+ * status refers to attr_list.
+ *
+ * @param[inout] cache Static attribute cache
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[in] attr_count Number of attributes
+ * @param[inout] attr_list Attributes
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_static_cache_get(
+        _Inout_ lai_metadata_static_cache_t *cache,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list);
+
+/**
+ * @brief Drops cached values of object
+ *
+ * @param[inout] cache Static attribute cache
+ * @param[in] object_id Object id, #LAI_NULL_OBJECT_ID drops all objects
+ */
+extern void lai_metadata_static_cache_invalidate(
+        _Inout_ lai_metadata_static_cache_t *cache,
+        _In_ lai_object_id_t object_id);
+
+/**
+ * @brief Handles linecard alarm notification
+ *
+ * Plug in and plug off alarms drop cached values of alarm resource, or of
+ * all objects when alarm has no resource. Other alarms are ignored.
+ *
+ * @param[inout] cache Static attribute cache
+ * @param[in] alarm_type Alarm type
+ * @param[in] alarm_info Alarm information
+ */
+extern void lai_metadata_static_cache_alarm(
+        _Inout_ lai_metadata_static_cache_t *cache,
+        _In_ lai_alarm_type_t alarm_type,
+        _In_ const lai_alarm_info_t *alarm_info);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATASTATICCACHE_H_ */
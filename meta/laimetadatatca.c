@@ -0,0 +1,457 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatatca.c
+ *
+ * @brief   This module implements LAI Metadata Threshold Crossing Alerts
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <lai.h>
+#include "laimetadatatca.h"
+#include "laimetadata.h"
+
+#define TCA(ot, thr, hyst, stat, high, sev) \
+    { LAI_OBJECT_TYPE_ ## ot, thr, hyst, stat, high, LAI_ALARM_SEVERITY_ ## sev }
+
+#define NO_HYSTERESIS LAI_INVALID_ATTRIBUTE_ID
+
+#define TCA_NO_RULE ((size_t)-1)
+
+/*
+ * Transceiver VCC thresholds are not listed since there is no supply
+ * voltage statistics to compare them with.
+ */
+
+const lai_metadata_tca_threshold_info_t lai_metadata_tca_threshold_infos[] = {
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_RX_TOTAL_POWER_HIGH_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_INPUT_POWER, true, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_RX_TOTAL_POWER_HIGH_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_INPUT_POWER, true, WARNING),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_RX_TOTAL_POWER_LOW_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_INPUT_POWER, false, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_RX_TOTAL_POWER_LOW_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_INPUT_POWER, false, WARNING),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_OA_PUMP_CURRENT_HIGH_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_EDFA_BIAS_CURRENT, true, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_OA_PUMP_CURRENT_HIGH_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_EDFA_BIAS_CURRENT, true, WARNING),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_OA_PUMP_CURRENT_LOW_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_EDFA_BIAS_CURRENT, false, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_OA_PUMP_CURRENT_LOW_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_EDFA_BIAS_CURRENT, false, WARNING),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TX_BAIS_HIGH_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_LASER_BIAS_CURRENT, true, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TX_BAIS_HIGH_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_LASER_BIAS_CURRENT, true, WARNING),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TX_BAIS_LOW_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_LASER_BIAS_CURRENT, false, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TX_BAIS_LOW_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_LASER_BIAS_CURRENT, false, WARNING),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TX_POWER_HIGH_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_OUTPUT_POWER, true, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TX_POWER_LOW_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_OUTPUT_POWER, false, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TX_POWER_HIGH_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_OUTPUT_POWER, true, WARNING),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TX_POWER_LOW_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_OUTPUT_POWER, false, WARNING),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TEMP_HIGH_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_TEMPERATURE, true, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TEMP_HIGH_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_TEMPERATURE, true, WARNING),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TEMP_LOW_ALARM_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_TEMPERATURE, false, MAJOR),
+    TCA(TRANSCEIVER, LAI_TRANSCEIVER_ATTR_TEMP_LOW_WARN_THRESHOLD, NO_HYSTERESIS, LAI_TRANSCEIVER_STAT_TEMPERATURE, false, WARNING),
+    TCA(OA, LAI_OA_ATTR_INPUT_LOS_THRESHOLD, LAI_OA_ATTR_INPUT_LOS_HYSTERESIS, LAI_OA_STAT_INPUT_POWER_TOTAL, false, CRITICAL),
+    TCA(OA, LAI_OA_ATTR_OUTPUT_LOS_THRESHOLD, LAI_OA_ATTR_OUTPUT_LOS_HYSTERESIS, LAI_OA_STAT_OUTPUT_POWER_TOTAL, false, CRITICAL),
+    TCA(OA, LAI_OA_ATTR_GAIN_LOW_THRESHOLD, LAI_OA_ATTR_GAIN_LOW_HYSTERESIS, LAI_OA_STAT_ACTUAL_GAIN, false, MAJOR),
+    TCA(OA, LAI_OA_ATTR_INPUT_LOW_THRESHOLD, NO_HYSTERESIS, LAI_OA_STAT_INPUT_POWER_TOTAL, false, MINOR),
+    TCA(OA, LAI_OA_ATTR_OUTPUT_LOW_THRESHOLD, NO_HYSTERESIS, LAI_OA_STAT_OUTPUT_POWER_TOTAL, false, MINOR),
+    TCA(OSC, LAI_OSC_ATTR_RX_LOW_THRESHOLD, NO_HYSTERESIS, LAI_OSC_STAT_INPUT_POWER, false, MINOR),
+    TCA(OSC, LAI_OSC_ATTR_RX_HIGH_THRESHOLD, NO_HYSTERESIS, LAI_OSC_STAT_INPUT_POWER, true, MINOR),
+    TCA(OSC, LAI_OSC_ATTR_TX_LOW_THRESHOLD, NO_HYSTERESIS, LAI_OSC_STAT_OUTPUT_POWER, false, MINOR),
+};
+
+const size_t lai_metadata_tca_threshold_infos_count =
+    sizeof(lai_metadata_tca_threshold_infos)/sizeof(lai_metadata_tca_threshold_infos[0]);
+
+/*
+ * Rules are kept in structure of arrays form. Evaluation first gathers
+ * guarded values from snapshot, then compares all rules in loop without
+ * branches and only then walks changed rules. Flags are kept as doubles 0.0
+ * or 1.0 and combined by selects, so compare loop has no narrowing and is
+ * vectorized for plain x86-64 by gcc 12 at -O3, which Makefile uses for
+ * this module (checked with -fopt-info-vec).
+ *
+ * Low thresholds are evaluated as high thresholds on negated values, so
+ * single compare handles both directions.
+ */
+
+typedef struct _lai_metadata_tca_state_t
+{
+    size_t capacity;
+
+    lai_stat_id_t *counter_ids;
+    const lai_stat_metadata_t **stat_metadata;
+
+    /* per object first rule, rules of object are chained by next */
+
+    size_t *head;
+
+    /* per rule */
+
+    size_t *next;
+    size_t *offset;
+    const lai_metadata_tca_threshold_info_t **info;
+    double *sign;
+    double *threshold;
+    double *hysteresis;
+    double *value;
+    double *active;
+    double *changed;
+
+} lai_metadata_tca_state_t;
+
+const lai_metadata_tca_threshold_info_t* lai_metadata_tca_get_threshold_info(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_attr_id_t attr_id)
+{
+    size_t idx = 0;
+
+    for (; idx < lai_metadata_tca_threshold_infos_count; ++idx)
+    {
+        const lai_metadata_tca_threshold_info_t *info = &lai_metadata_tca_threshold_infos[idx];
+
+        if (info->object_type == object_type && info->threshold_attr_id == attr_id)
+        {
+            return info;
+        }
+    }
+
+    return NULL;
+}
+
+void lai_metadata_tca_free(
+        _Inout_ lai_metadata_tca_t *tca)
+{
+    if (tca == NULL)
+    {
+        return;
+    }
+
+    lai_metadata_tca_state_t *state = (lai_metadata_tca_state_t*)tca->state;
+
+    if (state != NULL)
+    {
+        free(state->counter_ids);
+        free((void*)state->stat_metadata);
+        free(state->head);
+        free(state->next);
+        free(state->offset);
+        free((void*)state->info);
+        free(state->sign);
+        free(state->threshold);
+        free(state->hysteresis);
+        free(state->value);
+        free(state->active);
+        free(state->changed);
+        free(state);
+    }
+
+    memset(tca, 0, sizeof(lai_metadata_tca_t));
+}
+
+lai_status_t lai_metadata_tca_init(
+        _Out_ lai_metadata_tca_t *tca,
+        _In_ lai_object_type_t object_type,
+        _In_ size_t object_count,
+        _In_ size_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids)
+{
+    if (tca == NULL || counter_ids == NULL || number_of_counters == 0)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: tca or counter ids");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(tca, 0, sizeof(lai_metadata_tca_t));
+
+    lai_metadata_tca_state_t *state = (lai_metadata_tca_state_t*)calloc(1, sizeof(lai_metadata_tca_state_t));
+
+    if (state == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    tca->object_type = object_type;
+    tca->object_count = object_count;
+    tca->stat_count = number_of_counters;
+    tca->state = state;
+
+    state->counter_ids = (lai_stat_id_t*)calloc(number_of_counters, sizeof(lai_stat_id_t));
+    state->stat_metadata = (const lai_stat_metadata_t**)calloc(number_of_counters, sizeof(lai_stat_metadata_t*));
+    state->head = (size_t*)calloc(object_count ? object_count : 1, sizeof(size_t));
+
+    if (state->counter_ids == NULL || state->stat_metadata == NULL || state->head == NULL)
+    {
+        lai_metadata_tca_free(tca);
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    size_t idx = 0;
+
+    for (; idx < object_count; ++idx)
+    {
+        state->head[idx] = TCA_NO_RULE;
+    }
+
+    for (idx = 0; idx < number_of_counters; ++idx)
+    {
+        const lai_stat_metadata_t *md = lai_metadata_get_stat_metadata(object_type, counter_ids[idx]);
+
+        if (md == NULL)
+        {
+            LAI_META_LOG_ERROR("invalid stat id %d for object type %d", counter_ids[idx], object_type);
+
+            lai_metadata_tca_free(tca);
+
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+
+        state->counter_ids[idx] = counter_ids[idx];
+        state->stat_metadata[idx] = md;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+#define TCA_GROW(field, type) \
+    {\
+        void *p = realloc((void*)state->field, capacity * sizeof(type));\
+        if (p == NULL) return LAI_STATUS_NO_MEMORY;\
+        state->field = (type*)p;\
+    }
+
+static lai_status_t lai_metadata_tca_reserve(
+        _Inout_ lai_metadata_tca_state_t *state,
+        _In_ size_t count)
+{
+    if (count <= state->capacity)
+    {
+        return LAI_STATUS_SUCCESS;
+    }
+
+    size_t capacity = state->capacity ? 2 * state->capacity : 64;
+
+    while (capacity < count)
+    {
+        capacity *= 2;
+    }
+
+    TCA_GROW(next, size_t);
+    TCA_GROW(offset, size_t);
+    TCA_GROW(info, const lai_metadata_tca_threshold_info_t*);
+    TCA_GROW(sign, double);
+    TCA_GROW(threshold, double);
+    TCA_GROW(hysteresis, double);
+    TCA_GROW(value, double);
+    TCA_GROW(active, double);
+    TCA_GROW(changed, double);
+
+    state->capacity = capacity;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_metadata_tca_load_thresholds(
+        _Inout_ lai_metadata_tca_t *tca,
+        _In_ size_t object_index,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    if (tca == NULL || tca->state == NULL || (attr_count && attr_list == NULL) || object_index >= tca->object_count)
+    {
+        LAI_META_LOG_ERROR("invalid parameter: tca, attr list or object index");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    lai_metadata_tca_state_t *state = (lai_metadata_tca_state_t*)tca->state;
+
+    uint32_t idx = 0;
+
+    for (; idx < attr_count; ++idx)
+    {
+        const lai_metadata_tca_threshold_info_t *info = lai_metadata_tca_get_threshold_info(tca->object_type, attr_list[idx].id);
+
+        if (info == NULL)
+        {
+            continue;
+        }
+
+        size_t col = 0;
+
+        while (col < tca->stat_count && state->counter_ids[col] != info->stat_id)
+        {
+            col++;
+        }
+
+        if (col == tca->stat_count)
+        {
+            LAI_META_LOG_WARN("threshold %d guards stat %d which is not in snapshot", info->threshold_attr_id, info->stat_id);
+            continue;
+        }
+
+        size_t offset = object_index * tca->stat_count + col;
+
+        size_t rule = state->head[object_index];
+
+        while (rule != TCA_NO_RULE && state->info[rule] != info)
+        {
+            rule = state->next[rule];
+        }
+
+        if (rule == TCA_NO_RULE)
+        {
+            rule = tca->rule_count;
+
+            lai_status_t status = lai_metadata_tca_reserve(state, rule + 1);
+
+            if (status != LAI_STATUS_SUCCESS)
+            {
+                return status;
+            }
+
+            state->next[rule] = state->head[object_index];
+            state->head[object_index] = rule;
+            state->offset[rule] = offset;
+            state->info[rule] = info;
+            state->sign[rule] = info->high ? 1.0 : -1.0;
+            state->hysteresis[rule] = 0.0;
+            state->active[rule] = 0.0;
+
+            tca->rule_count++;
+        }
+
+        state->threshold[rule] = state->sign[rule] * attr_list[idx].value.d64;
+
+        if (info->hysteresis_attr_id == LAI_INVALID_ATTRIBUTE_ID)
+        {
+            continue;
+        }
+
+        uint32_t h = 0;
+
+        for (; h < attr_count; ++h)
+        {
+            if (attr_list[h].id == info->hysteresis_attr_id)
+            {
+                double v = attr_list[h].value.d64;
+
+                state->hysteresis[rule] = (v < 0.0) ? -v : v;
+            }
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static double lai_metadata_tca_to_double(
+        _In_ const lai_stat_metadata_t *md,
+        _In_ const lai_stat_value_t *value)
+{
+    switch (md->statvaluetype)
+    {
+        case LAI_STAT_VALUE_TYPE_INT32:
+            return value->s32;
+
+        case LAI_STAT_VALUE_TYPE_UINT32:
+            return value->u32;
+
+        case LAI_STAT_VALUE_TYPE_INT64:
+            return (double)value->s64;
+
+        case LAI_STAT_VALUE_TYPE_UINT64:
+            return (double)value->u64;
+
+        default:
+            return value->d64;
+    }
+}
+
+lai_status_t lai_metadata_tca_evaluate(
+        _Inout_ lai_metadata_tca_t *tca,
+        _In_ const lai_stat_value_t *counters,
+        _Out_ lai_metadata_tca_crossing_t *crossings,
+        _Out_ size_t *count)
+{
+    if (tca == NULL || tca->state == NULL || counters == NULL || count == NULL || (tca->rule_count && crossings == NULL))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: tca, counters, crossings or count is NULL");
+
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    lai_metadata_tca_state_t *state = (lai_metadata_tca_state_t*)tca->state;
+
+    size_t n = tca->rule_count;
+    size_t r = 0;
+
+    /* gather */
+
+    for (; r < n; ++r)
+    {
+        size_t offset = state->offset[r];
+
+        state->value[r] = lai_metadata_tca_to_double(state->stat_metadata[offset % tca->stat_count], &counters[offset]);
+    }
+
+    /* compare */
+
+    const double *sign = state->sign;
+    const double *thr = state->threshold;
+    const double *hyst = state->hysteresis;
+    const double *value = state->value;
+    double *active = state->active;
+    double *changed = state->changed;
+
+    for (r = 0; r < n; ++r)
+    {
+        double x = sign[r] * value[r];
+
+        /* active rule is kept above threshold less hysteresis, NaN keeps state */
+
+        double was = active[r];
+        double raise = (x > thr[r]) ? 1.0 : 0.0;
+        double keep = (x > thr[r] - hyst[r]) ? 1.0 : 0.0;
+
+        double now = (was > 0.5) ? keep : raise;
+
+        now = __builtin_isunordered(x, x) ? was : now;
+
+        changed[r] = (now > was || now < was) ? 1.0 : 0.0;
+        active[r] = now;
+    }
+
+    /* report */
+
+    size_t c = 0;
+
+    for (r = 0; r < n; ++r)
+    {
+        if (changed[r] < 0.5)
+        {
+            continue;
+        }
+
+        crossings[c].object_index = state->offset[r] / tca->stat_count;
+        crossings[c].info = state->info[r];
+        crossings[c].value = value[r];
+        crossings[c].threshold = sign[r] * thr[r];
+        crossings[c].raised = active[r] > 0.5;
+
+        c++;
+    }
+
+    *count = c;
+
+    return LAI_STATUS_SUCCESS;
+}
@@ -0,0 +1,234 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatatca.h
+ *
+ * @brief   This module defines LAI Metadata Threshold Crossing Alerts
+ */
+
+#ifndef __LAIMETADATATCA_H_
+#define __LAIMETADATATCA_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATATCA LAI - Metadata Threshold Crossing Alerts Definitions
+ *
+ * Threshold attributes of transceiver, OA and OSC objects are bound to
+ * statistics they guard by #lai_metadata_tca_threshold_infos table. Engine
+ * loads threshold values of many objects and evaluates whole statistics
+ * snapshots, reporting only thresholds which were crossed since previous
+ * evaluation.
+ *
+ * Threshold is raised when value goes above high threshold (below low
+ * threshold) and cleared when value goes back by more than hysteresis.
+ *
+ * @{
+ */
+
+/**
+ * @brief Threshold attribute binding to statistics
+ */
+typedef struct _lai_metadata_tca_threshold_info_t
+{
+    /**
+     * @brief Object type.
+     */
+    lai_object_type_t object_type;
+
+    /**
+     * @brief Threshold attribute id.
+     */
+    lai_attr_id_t threshold_attr_id;
+
+    /**
+     * @brief Hysteresis attribute id or #LAI_INVALID_ATTRIBUTE_ID.
+     */
+    lai_attr_id_t hysteresis_attr_id;
+
+    /**
+     * @brief Statistics guarded by threshold.
+     */
+    lai_stat_id_t stat_id;
+
+    /**
+     * @brief True for high threshold, false for low threshold.
+     */
+    bool high;
+
+    /**
+     * @brief Severity of threshold crossing.
+     */
+    lai_alarm_severity_t severity;
+
+} lai_metadata_tca_threshold_info_t;
+
+/**
+ * @brief All known threshold attribute bindings
+ */
+extern const lai_metadata_tca_threshold_info_t lai_metadata_tca_threshold_infos[];
+
+/**
+ * @brief Number of known threshold attribute bindings
+ */
+extern const size_t lai_metadata_tca_threshold_infos_count;
+
+/**
+ * @brief Single threshold crossing
+ */
+typedef struct _lai_metadata_tca_crossing_t
+{
+    /**
+     * @brief Object index.
+     */
+    size_t object_index;
+
+    /**
+     * @brief Threshold binding.
+     */
+    const lai_metadata_tca_threshold_info_t *info;
+
+    /**
+     * @brief Statistics value which caused crossing.
+     */
+    lai_double_t value;
+
+    /**
+     * @brief Threshold value.
+     */
+    lai_double_t threshold;
+
+    /**
+     * @brief True when threshold was raised, false when cleared.
+     */
+    bool raised;
+
+} lai_metadata_tca_crossing_t;
+
+/**
+ * @brief Threshold crossing engine
+ */
+typedef struct _lai_metadata_tca_t
+{
+    /**
+     * @brief Object type of evaluated objects.
+     */
+    lai_object_type_t object_type;
+
+    /**
+     * @brief Number of evaluated objects.
+     */
+    size_t object_count;
+
+    /**
+     * @brief Number of statistics per object in snapshot.
+     */
+    size_t stat_count;
+
+    /**
+     * @brief Number of loaded thresholds of all objects.
+     */
+    size_t rule_count;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_tca_t;
+
+/**
+ * @brief Gets threshold binding for threshold attribute
+ *
+ * @param[in] object_type Object type
+ * @param[in] attr_id Threshold attribute id
+ *
+ * @return Pointer to threshold binding or NULL if attribute is not threshold
+ */
+extern const lai_metadata_tca_threshold_info_t* lai_metadata_tca_get_threshold_info(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_attr_id_t attr_id);
+
+/**
+ * @brief Initializes threshold crossing engine
+ *
+ * @param[out] tca Engine to be initialized
+ * @param[in] object_type Object type of evaluated objects
+ * @param[in] object_count Number of evaluated objects
+ * @param[in] number_of_counters Number of statistics per object in snapshot
+ * @param[in] counter_ids Statistics ids, the same for each object
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_tca_init(
+        _Out_ lai_metadata_tca_t *tca,
+        _In_ lai_object_type_t object_type,
+        _In_ size_t object_count,
+        _In_ size_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids);
+
+/**
+ * @brief Releases threshold crossing engine
+ *
+ * @param[inout] tca Engine to be released
+ */
+extern void lai_metadata_tca_free(
+        _Inout_ lai_metadata_tca_t *tca);
+
+/**
+ * @brief Loads thresholds of single object
+ *
+ * Attribute list is typically result of get attribute call with threshold
+ * and hysteresis attributes. Attributes which are not thresholds or guard
+ * statistics not present in snapshot are ignored. Threshold value NaN
+ * disables threshold. Loading threshold again keeps its raised state.
+ *
+ * @param[inout] tca Threshold crossing engine
+ * @param[in] object_index Object index
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Threshold and hysteresis attributes
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_tca_load_thresholds(
+        _Inout_ lai_metadata_tca_t *tca,
+        _In_ size_t object_index,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list);
+
+/**
+ * @brief Evaluates statistics snapshot of all objects
+ *
+ * Snapshot layout is object after object, each object has statistics in
+ * the same order as passed at initialization. Value NaN keeps threshold
+ * state unchanged.
+ *
+ * @param[inout] tca Threshold crossing engine
+ * @param[in] counters Statistics values, array of object_count * stat_count elements
+ * @param[out] crossings Crossings, array of at least rule_count elements
+ * @param[out] count Number of crossings
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t lai_metadata_tca_evaluate(
+        _Inout_ lai_metadata_tca_t *tca,
+        _In_ const lai_stat_value_t *counters,
+        _Out_ lai_metadata_tca_crossing_t *crossings,
+        _Out_ size_t *count);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATATCA_H_ */
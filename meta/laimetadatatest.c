@@ -0,0 +1,2588 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadatatest.c
+ *
+ * @brief   This module implements LAI Metadata tests
+ *
+ * Usage: laimetadatatest [name]...
+ *
+ * Runs metadata helpers through their public functions, adapter tables
+ * are replaced by test tables where helper calls adapter. Runs all tests
+ * or tests given by name, prints result of every test and exits with
+ * failure when any test fails.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <math.h>
+#include <lai.h>
+#include "laimetadata.h"
+
+#define TEST_THREADS        4
+#define TEST_ITERATIONS     2000
+
+#define TEST_ASSERT(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            return false; \
+        } \
+    } while (0)
+
+typedef bool (*lai_test_fn)(void);
+
+typedef struct _lai_test_t
+{
+    const char *name;
+    lai_test_fn fn;
+
+} lai_test_t;
+/*
+ * Fixed point: doubles round half away from zero exactly at +-0.5 and
+ * above 2^52, saturate at the largest convertible value, NaN maps to the
+ * lowest integer and back, 18 decimals need 64 bits and unknown precision
+ * is rejected.
+ */
+
+#define TEST_FIXED_ROUNDING     8
+#define TEST_FIXED_EDGES        5
+
+static bool lai_test_fixed_point_rounding(
+        _In_ const lai_stat_metadata_t *md)
+{
+    static const double doubles[TEST_FIXED_ROUNDING] = {
+        0.5, -0.5, 0.49999999999999994, -0.49999999999999994, 1.5, -2.5, 2.4999999999999996, 4503599627370497.0,
+    };
+
+    static const int64_t rounded[TEST_FIXED_ROUNDING] = { 1, -1, 0, 0, 2, -3, 2, 4503599627370497 };
+
+    lai_stat_value_t values[TEST_FIXED_ROUNDING];
+    int64_t fixed64[TEST_FIXED_ROUNDING];
+    int32_t fixed32[TEST_FIXED_ROUNDING];
+    size_t idx;
+
+    for (idx = 0; idx < TEST_FIXED_ROUNDING; idx++)
+    {
+        values[idx].d64 = doubles[idx];
+    }
+
+    TEST_ASSERT(lai_metadata_stat_values_to_fixed_s64(md, TEST_FIXED_ROUNDING, values, fixed64) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_metadata_stat_values_to_fixed_s32(md, TEST_FIXED_ROUNDING, values, fixed32) == LAI_STATUS_SUCCESS);
+
+    for (idx = 0; idx < TEST_FIXED_ROUNDING; idx++)
+    {
+        TEST_ASSERT(fixed64[idx] == rounded[idx]);
+        TEST_ASSERT(idx == TEST_FIXED_ROUNDING - 1 ? fixed32[idx] == INT32_MAX : fixed32[idx] == rounded[idx]);
+    }
+
+    return true;
+}
+
+static bool lai_test_fixed_point_edges(
+        _In_ const lai_stat_metadata_t *md)
+{
+    lai_stat_value_t values[TEST_FIXED_EDGES];
+    int64_t fixed64[TEST_FIXED_EDGES];
+    int32_t fixed32[TEST_FIXED_EDGES];
+
+    values[0].d64 = 1e300;
+    values[1].d64 = -1e300;
+    values[2].d64 = __builtin_inf();
+    values[3].d64 = __builtin_nan("");
+    values[4].d64 = 1.5;
+
+    TEST_ASSERT(lai_metadata_stat_values_to_fixed_s64(md, TEST_FIXED_EDGES, values, fixed64) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(fixed64[0] == 9223372036854774784LL && fixed64[1] == -9223372036854774784LL);
+    TEST_ASSERT(fixed64[2] == 9223372036854774784LL);
+    TEST_ASSERT(fixed64[3] == LAI_METADATA_FIXED_POINT_S64_INVALID && fixed64[3] == INT64_MIN);
+    TEST_ASSERT(fixed64[4] == 2);
+
+    TEST_ASSERT(lai_metadata_stat_values_to_fixed_s32(md, TEST_FIXED_EDGES, values, fixed32) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(fixed32[0] == INT32_MAX && fixed32[1] == -INT32_MAX && fixed32[2] == INT32_MAX);
+    TEST_ASSERT(fixed32[3] == LAI_METADATA_FIXED_POINT_S32_INVALID && fixed32[3] == INT32_MIN);
+
+    /* invalid values convert back to NaN */
+
+    TEST_ASSERT(lai_metadata_fixed_s64_to_stat_values(md, TEST_FIXED_EDGES, fixed64, values) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(__builtin_isnan(values[3].d64) && values[4].d64 > 1.99 && values[4].d64 < 2.01);
+
+    TEST_ASSERT(lai_metadata_fixed_s32_to_stat_values(md, TEST_FIXED_EDGES, fixed32, values) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(__builtin_isnan(values[3].d64) && values[0].d64 > 2147483646.5);
+
+    return true;
+}
+
+static bool lai_test_fixed_point(void)
+{
+    static const lai_stat_metadata_t precision0 = {
+        LAI_OBJECT_TYPE_OA, LAI_OA_STAT_ACTUAL_GAIN, "GAIN", "gain", "gain",
+        LAI_STAT_VALUE_TYPE_DOUBLE, LAI_STAT_VALUE_UNIT_DB, LAI_STAT_VALUE_PRECISION_0, false
+    };
+
+    static const lai_stat_metadata_t precision18 = {
+        LAI_OBJECT_TYPE_OA, LAI_OA_STAT_ACTUAL_GAIN, "GAIN", "gain", "gain",
+        LAI_STAT_VALUE_TYPE_DOUBLE, LAI_STAT_VALUE_UNIT_DB, LAI_STAT_VALUE_PRECISION_18, false
+    };
+
+    static const lai_stat_metadata_t unknown = {
+        LAI_OBJECT_TYPE_OA, LAI_OA_STAT_ACTUAL_GAIN, "GAIN", "gain", "gain",
+        LAI_STAT_VALUE_TYPE_DOUBLE, LAI_STAT_VALUE_UNIT_DB, (lai_stat_value_precision_t)(LAI_STAT_VALUE_PRECISION_18 + 1), false
+    };
+
+    lai_stat_value_t value;
+    int64_t fixed64;
+    int32_t fixed32;
+
+    TEST_ASSERT(lai_test_fixed_point_rounding(&precision0));
+    TEST_ASSERT(lai_test_fixed_point_edges(&precision0));
+
+    value.d64 = 1.5;
+
+    TEST_ASSERT(lai_metadata_stat_values_to_fixed_s64(&precision18, 1, &value, &fixed64) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(fixed64 == 1500000000000000000LL);
+    TEST_ASSERT(lai_metadata_stat_values_to_fixed_s32(&precision18, 1, &value, &fixed32) == LAI_STATUS_NOT_SUPPORTED);
+
+    TEST_ASSERT(lai_metadata_get_stat_fixed_point_scale(&unknown) == 0);
+    TEST_ASSERT(lai_metadata_stat_values_to_fixed_s64(&unknown, 1, &value, &fixed64) == LAI_STATUS_NOT_SUPPORTED);
+    TEST_ASSERT(lai_metadata_stat_values_to_fixed_s32(&unknown, 1, &value, &fixed32) == LAI_STATUS_NOT_SUPPORTED);
+    TEST_ASSERT(lai_metadata_fixed_s64_to_stat_values(&unknown, 1, &fixed64, &value) == LAI_STATUS_NOT_SUPPORTED);
+
+    return true;
+}
+
+/*
+ * Reconcile recreate: changed create only attribute of linecard recreates
+ * OA placed on it, OA is removed first and created last. Changed create
+ * only attribute of OA recreates only OA.
+ */
+
+static bool lai_test_reconcile_plan(
+        _In_ bool init_linecard,
+        _In_ uint32_t oa_index,
+        _In_ size_t expected_count,
+        _In_ const lai_metadata_reconcile_op_kind_t *expected_kinds,
+        _In_ const lai_object_type_t *expected_types,
+        _In_ size_t expected_unchanged)
+{
+    lai_metadata_reconcile_object_t stored[2];
+    lai_metadata_reconcile_object_t live[2];
+    lai_metadata_reconcile_plan_t plan;
+    lai_attribute_t stored_attrs[4];
+    lai_attribute_t live_attrs[4];
+    bool passed;
+    size_t idx;
+
+    stored_attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(stored_attrs[0].value.chardata, "P230C");
+    stored_attrs[1].id = LAI_LINECARD_ATTR_INIT_LINECARD;
+    stored_attrs[1].value.booldata = true;
+    stored_attrs[2].id = LAI_OA_ATTR_ID;
+    stored_attrs[2].value.u32 = 1;
+    stored_attrs[3].id = LAI_OA_ATTR_TARGET_GAIN;
+    stored_attrs[3].value.d64 = 10.0;
+
+    memcpy(live_attrs, stored_attrs, sizeof(live_attrs));
+
+    live_attrs[1].value.booldata = init_linecard;
+    live_attrs[2].value.u32 = oa_index;
+
+    stored[0].object_type = LAI_OBJECT_TYPE_LINECARD;
+    stored[0].object_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_LINECARD, 0, 0);
+    stored[0].attr_count = 2;
+    stored[0].attr_list = &stored_attrs[0];
+    stored[1].object_type = LAI_OBJECT_TYPE_OA;
+    stored[1].object_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_OA, 0, 1);
+    stored[1].attr_count = 2;
+    stored[1].attr_list = &stored_attrs[2];
+
+    memcpy(live, stored, sizeof(live));
+
+    live[0].attr_list = &live_attrs[0];
+    live[1].attr_list = &live_attrs[2];
+
+    TEST_ASSERT(lai_metadata_reconcile(2, stored, 2, live, &plan) == LAI_STATUS_SUCCESS);
+
+    passed = plan.count == expected_count && plan.unchanged == expected_unchanged;
+
+    for (idx = 0; passed && idx < expected_count; idx++)
+    {
+        passed = plan.ops[idx].kind == expected_kinds[idx] && plan.ops[idx].object_type == expected_types[idx];
+    }
+
+    lai_metadata_reconcile_plan_free(&plan);
+
+    TEST_ASSERT(passed);
+
+    return true;
+}
+
+static bool lai_test_reconcile_recreate(void)
+{
+    static const lai_metadata_reconcile_op_kind_t cascade_kinds[] = {
+        LAI_METADATA_RECONCILE_OP_KIND_REMOVE,
+        LAI_METADATA_RECONCILE_OP_KIND_REMOVE,
+        LAI_METADATA_RECONCILE_OP_KIND_CREATE,
+        LAI_METADATA_RECONCILE_OP_KIND_CREATE,
+    };
+    static const lai_object_type_t cascade_types[] = {
+        LAI_OBJECT_TYPE_OA,
+        LAI_OBJECT_TYPE_LINECARD,
+        LAI_OBJECT_TYPE_LINECARD,
+        LAI_OBJECT_TYPE_OA,
+    };
+    static const lai_metadata_reconcile_op_kind_t single_kinds[] = {
+        LAI_METADATA_RECONCILE_OP_KIND_REMOVE,
+        LAI_METADATA_RECONCILE_OP_KIND_CREATE,
+    };
+    static const lai_object_type_t single_types[] = {
+        LAI_OBJECT_TYPE_OA,
+        LAI_OBJECT_TYPE_OA,
+    };
+
+    TEST_ASSERT(lai_test_reconcile_plan(true, 1, 0, NULL, NULL, 2));
+    TEST_ASSERT(lai_test_reconcile_plan(false, 1, 4, cascade_kinds, cascade_types, 0));
+    TEST_ASSERT(lai_test_reconcile_plan(true, 2, 2, single_kinds, single_types, 1));
+
+    return true;
+}
+
+/*
+ * Spectrum conversions: dBm to mW and back agree with libm pow and log10
+ * across whole range of double, saturate at its ends, keep NaN, give
+ * minus infinity for zero and NaN for negative powers, and channel power
+ * and peak of sweep match sum computed with libm.
+ */
+
+#define TEST_SPECTRUM_DBM       14
+#define TEST_SPECTRUM_MW        10
+#define TEST_SPECTRUM_SLICES    6
+
+static bool lai_test_spectrum_dbm(void)
+{
+    static const lai_double_t dbm[TEST_SPECTRUM_DBM] = {
+        -3070.0, -150.0, -60.0, -3.0103, -0.5, -1e-9, 0.0, 1e-9, 0.5, 3.0, 17.3, 30.0, 3000.0, 3082.0,
+    };
+
+    static const lai_double_t edges[3] = { -4000.0, 4000.0, 0.0 };
+
+    lai_double_t mw[TEST_SPECTRUM_DBM];
+    lai_double_t in[3];
+    lai_double_t out[3];
+    double expected;
+    size_t idx;
+
+    lai_metadata_spectrum_dbm_to_mw(TEST_SPECTRUM_DBM, dbm, mw);
+
+    for (idx = 0; idx < TEST_SPECTRUM_DBM; idx++)
+    {
+        expected = pow(10.0, dbm[idx] / 10.0);
+
+        TEST_ASSERT(mw[idx] > expected * (1.0 - 1e-12) && mw[idx] < expected * (1.0 + 1e-12));
+    }
+
+    memcpy(in, edges, sizeof(in));
+
+    in[2] = __builtin_nan("");
+
+    lai_metadata_spectrum_dbm_to_mw(3, in, out);
+
+    TEST_ASSERT(out[0] >= 0.0 && out[0] <= 0.0);
+    TEST_ASSERT(__builtin_isinf(out[1]) && out[1] > 0.0);
+    TEST_ASSERT(__builtin_isnan(out[2]));
+
+    return true;
+}
+
+static bool lai_test_spectrum_mw(void)
+{
+    static const lai_double_t mw[TEST_SPECTRUM_MW] = {
+        2.3e-308, 1e-30, 1e-6, 0.5, 0.999999999, 1.0, 2.0, 1000.0, 1e300, 1.7976931348623157e308,
+    };
+
+    static const lai_double_t edges[3] = { 0.0, -1e-6, -1.0 };
+
+    lai_double_t dbm[TEST_SPECTRUM_MW];
+    lai_double_t in[6];
+    lai_double_t out[6];
+    double expected;
+    size_t idx;
+
+    lai_metadata_spectrum_mw_to_dbm(TEST_SPECTRUM_MW, mw, dbm);
+
+    for (idx = 0; idx < TEST_SPECTRUM_MW; idx++)
+    {
+        expected = 10.0 * log10(mw[idx]);
+
+        TEST_ASSERT(dbm[idx] > expected - 1e-9 && dbm[idx] < expected + 1e-9);
+    }
+
+    memcpy(in, edges, sizeof(edges));
+
+    in[3] = -__builtin_inf();
+    in[4] = __builtin_inf();
+    in[5] = __builtin_nan("");
+
+    lai_metadata_spectrum_mw_to_dbm(6, in, out);
+
+    TEST_ASSERT(__builtin_isinf(out[0]) && out[0] < 0.0);
+    TEST_ASSERT(__builtin_isnan(out[1]) && __builtin_isnan(out[2]) && __builtin_isnan(out[3]));
+    TEST_ASSERT(__builtin_isinf(out[4]) && out[4] > 0.0);
+    TEST_ASSERT(__builtin_isnan(out[5]));
+
+    return true;
+}
+
+static bool lai_test_spectrum(void)
+{
+    static const lai_double_t powers[TEST_SPECTRUM_SLICES] = { -30.0, -12.5, -3.25, -4.0, -28.0, 1.5 };
+
+    lai_metadata_spectrum_channel_t channels[2];
+    lai_spectrum_power_t slices[TEST_SPECTRUM_SLICES];
+    lai_spectrum_power_list_t sweep;
+    lai_metadata_spectrum_t spectrum;
+    double sum = 0;
+    double peak = -1e300;
+    size_t idx;
+
+    TEST_ASSERT(lai_test_spectrum_dbm());
+    TEST_ASSERT(lai_test_spectrum_mw());
+
+    /* first channel covers 4 slices and half of 5th, second only 6th */
+
+    channels[0].lower_frequency = 193000000;
+    channels[0].upper_frequency = 193225000;
+    channels[1].lower_frequency = 193250000;
+    channels[1].upper_frequency = 193300000;
+
+    for (idx = 0; idx < TEST_SPECTRUM_SLICES; idx++)
+    {
+        slices[idx].lower_frequency = 193000000 + idx * 50000;
+        slices[idx].upper_frequency = slices[idx].lower_frequency + 50000;
+        slices[idx].power = powers[idx];
+
+        if (idx < 5)
+        {
+            sum += pow(10.0, powers[idx] / 10.0) * (idx < 4 ? 1.0 : 0.5);
+            peak = powers[idx] > peak ? powers[idx] : peak;
+        }
+    }
+
+    sweep.count = TEST_SPECTRUM_SLICES;
+    sweep.list = slices;
+
+    TEST_ASSERT(lai_metadata_spectrum_init(&spectrum, 2, channels) == LAI_STATUS_SUCCESS);
+
+    if (lai_metadata_spectrum_update(&spectrum, &sweep) != LAI_STATUS_SUCCESS)
+    {
+        lai_metadata_spectrum_free(&spectrum);
+        return false;
+    }
+
+    sum = 10.0 * log10(sum);
+
+    TEST_ASSERT(spectrum.channels[0].slices == 5 && spectrum.channels[1].slices == 1);
+    TEST_ASSERT(spectrum.channels[0].power > sum - 1e-9 && spectrum.channels[0].power < sum + 1e-9);
+    TEST_ASSERT(spectrum.channels[0].peak > peak - 1e-9 && spectrum.channels[0].peak < peak + 1e-9);
+    TEST_ASSERT(spectrum.channels[1].power > powers[5] - 1e-9 && spectrum.channels[1].power < powers[5] + 1e-9);
+
+    lai_metadata_spectrum_free(&spectrum);
+
+    return true;
+}
+
+/*
+ * Spectrum history: every kept sweep decodes to its powers quantized to
+ * history resolution, including NaN, wide jumps and runs of unchanged
+ * slices, the oldest sweeps are dropped and changed grid restarts history.
+ */
+
+#define TEST_HISTORY_SLICES     8
+#define TEST_HISTORY_SWEEPS     5
+#define TEST_HISTORY_CAPACITY   3
+
+static lai_double_t lai_test_history_power(
+        _In_ uint32_t sweep,
+        _In_ uint32_t slice)
+{
+    if (sweep == 3 && slice == 5)
+    {
+        return __builtin_nan("");
+    }
+
+    if (sweep == 4 && slice == 0)
+    {
+        return 10.0;
+    }
+
+    if (sweep == 2 && slice == 0)
+    {
+        return -60.0;
+    }
+
+    /* sweep 3 repeats sweep 2 except few slices */
+
+    if (sweep == 3 && slice != 2)
+    {
+        sweep = 2;
+    }
+
+    return -20.0 + (lai_double_t)((sweep * 7 + slice * 3) % 11) * 0.377;
+}
+
+static bool lai_test_history_check(
+        _In_ const lai_metadata_spectrum_history_t *history,
+        _In_ uint32_t sweep,
+        _In_ uint32_t first,
+        _In_ uint32_t count)
+{
+    lai_spectrum_power_t slices[TEST_HISTORY_SLICES];
+    lai_spectrum_power_list_t list;
+    uint64_t timestamp;
+    lai_double_t power;
+    uint32_t idx;
+
+    list.count = TEST_HISTORY_SLICES;
+    list.list = slices;
+
+    TEST_ASSERT(lai_metadata_spectrum_history_get(history, 1, 1000 + sweep * 10 + 5,
+                191350000 + first * 50000, 191350000 + (first + count) * 50000 - 1, &timestamp, &list) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(timestamp == 1000 + sweep * 10);
+    TEST_ASSERT(list.count == count);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        power = lai_test_history_power(sweep, first + idx);
+
+        TEST_ASSERT(slices[idx].lower_frequency == 191350000 + (first + idx) * 50000);
+
+        if (__builtin_isnan(power))
+        {
+            TEST_ASSERT(__builtin_isnan(slices[idx].power));
+            continue;
+        }
+
+        TEST_ASSERT(slices[idx].power > power - 0.0051 && slices[idx].power < power + 0.0051);
+    }
+
+    return true;
+}
+
+static void lai_test_history_count(
+        _Inout_ void *context,
+        _In_ lai_object_id_t ocm_id,
+        _In_ uint64_t timestamp,
+        _In_ const lai_spectrum_power_list_t *sweep)
+{
+    (*(uint32_t*)context)++;
+}
+
+static bool lai_test_spectrum_history(void)
+{
+    lai_metadata_spectrum_history_t history;
+    lai_spectrum_power_t slices[TEST_HISTORY_SLICES];
+    lai_spectrum_power_list_t list;
+    uint64_t timestamp;
+    uint32_t sweeps = 0;
+    uint32_t sweep;
+    uint32_t idx;
+
+    TEST_ASSERT(lai_metadata_spectrum_history_init(&history, TEST_HISTORY_CAPACITY, 0.01) == LAI_STATUS_SUCCESS);
+
+    list.list = slices;
+
+    for (sweep = 0; sweep < TEST_HISTORY_SWEEPS; sweep++)
+    {
+        for (idx = 0; idx < TEST_HISTORY_SLICES; idx++)
+        {
+            slices[idx].lower_frequency = 191350000 + idx * 50000;
+            slices[idx].upper_frequency = slices[idx].lower_frequency + 50000;
+            slices[idx].power = lai_test_history_power(sweep, idx);
+        }
+
+        list.count = TEST_HISTORY_SLICES;
+
+        TEST_ASSERT(lai_metadata_spectrum_history_add(&history, 1, 1000 + sweep * 10, &list) == LAI_STATUS_SUCCESS);
+    }
+
+    for (sweep = TEST_HISTORY_SWEEPS - TEST_HISTORY_CAPACITY; sweep < TEST_HISTORY_SWEEPS; sweep++)
+    {
+        TEST_ASSERT(lai_test_history_check(&history, sweep, 0, TEST_HISTORY_SLICES));
+        TEST_ASSERT(lai_test_history_check(&history, sweep, 3, 4));
+    }
+
+    list.count = TEST_HISTORY_SLICES;
+
+    TEST_ASSERT(lai_metadata_spectrum_history_get(&history, 1, 1015, 0, UINT64_MAX, &timestamp, &list) == LAI_STATUS_ITEM_NOT_FOUND);
+    TEST_ASSERT(lai_metadata_spectrum_history_query(&history, 1, 0, UINT64_MAX, 0, UINT64_MAX,
+                lai_test_history_count, &sweeps) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(sweeps == TEST_HISTORY_CAPACITY);
+
+    /* wider slices make different grid */
+
+    for (idx = 0; idx < TEST_HISTORY_SLICES; idx++)
+    {
+        slices[idx].upper_frequency = slices[idx].lower_frequency + 100000;
+    }
+
+    list.count = TEST_HISTORY_SLICES;
+    sweeps = 0;
+
+    TEST_ASSERT(lai_metadata_spectrum_history_add(&history, 1, 2000, &list) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_metadata_spectrum_history_query(&history, 1, 0, UINT64_MAX, 0, UINT64_MAX,
+                lai_test_history_count, &sweeps) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(sweeps == 1);
+
+    TEST_ASSERT(lai_metadata_spectrum_history_remove(&history, 1) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_metadata_spectrum_history_remove(&history, 1) == LAI_STATUS_ITEM_NOT_FOUND);
+
+    lai_metadata_spectrum_history_free(&history);
+
+    return true;
+}
+
+/*
+ * Media channel plan: ranges are half open, overlaps conflict only on
+ * shared port and never between super channel and its channel, duplicate
+ * IDs and channels outside their parent conflict, queries match brute
+ * force over pruned tree, and failed create removes created channels in
+ * reverse order with parents created first.
+ */
+
+#define TEST_MEDIACHANNEL_ATTRS     7
+#define TEST_MEDIACHANNEL_PLAN      11
+#define TEST_MEDIACHANNEL_GRID      64
+#define TEST_MEDIACHANNEL_APPLY     4
+
+typedef struct _lai_test_mediachannel_t
+{
+    uint32_t id;
+
+    lai_uint64_t lower;
+
+    lai_uint64_t upper;
+
+    bool super_channel;
+
+    /* parent ID, 0 when channel has no parent */
+
+    uint32_t parent;
+
+    const char *source;
+
+    const char *dest;
+
+} lai_test_mediachannel_t;
+
+typedef struct _lai_test_mediachannel_api_t
+{
+    size_t creates;
+
+    size_t fail_at;
+
+    uint32_t created[TEST_MEDIACHANNEL_APPLY];
+
+    size_t removes;
+
+    lai_object_id_t removed[TEST_MEDIACHANNEL_APPLY];
+
+} lai_test_mediachannel_api_t;
+
+typedef bool (*lai_test_mediachannel_check_fn)(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _In_ const lai_test_mediachannel_t *specs);
+
+static lai_test_mediachannel_api_t lai_test_mediachannel_api_state;
+
+/*
+ * Plans channels of specs and runs check on plan.
+ */
+
+static bool lai_test_mediachannel_run(
+        _In_ size_t count,
+        _In_ const lai_test_mediachannel_t *specs,
+        _In_ lai_test_mediachannel_check_fn check)
+{
+    lai_attribute_t (*attrs)[TEST_MEDIACHANNEL_ATTRS];
+    lai_metadata_mediachannel_t *channels;
+    lai_metadata_mediachannel_plan_t plan;
+    lai_status_t status;
+    uint32_t attr_count;
+    size_t idx;
+    bool passed = false;
+
+    attrs = (lai_attribute_t(*)[TEST_MEDIACHANNEL_ATTRS])calloc(count, sizeof(*attrs));
+    channels = (lai_metadata_mediachannel_t*)calloc(count, sizeof(lai_metadata_mediachannel_t));
+
+    for (idx = 0; attrs != NULL && channels != NULL && idx < count; idx++)
+    {
+        attr_count = 0;
+
+        attrs[idx][attr_count].id = LAI_MEDIACHANNEL_ATTR_ID;
+        attrs[idx][attr_count++].value.u32 = specs[idx].id;
+        attrs[idx][attr_count].id = LAI_MEDIACHANNEL_ATTR_LOWER_FREQUENCY;
+        attrs[idx][attr_count++].value.u64 = specs[idx].lower;
+        attrs[idx][attr_count].id = LAI_MEDIACHANNEL_ATTR_UPPER_FREQUENCY;
+        attrs[idx][attr_count++].value.u64 = specs[idx].upper;
+        attrs[idx][attr_count].id = LAI_MEDIACHANNEL_ATTR_SUPER_CHANNEL;
+        attrs[idx][attr_count++].value.booldata = specs[idx].super_channel;
+        attrs[idx][attr_count].id = LAI_MEDIACHANNEL_ATTR_SOURCE_PORT_NAME;
+        strcpy(attrs[idx][attr_count++].value.chardata, specs[idx].source);
+        attrs[idx][attr_count].id = LAI_MEDIACHANNEL_ATTR_DEST_PORT_NAME;
+        strcpy(attrs[idx][attr_count++].value.chardata, specs[idx].dest);
+
+        if (specs[idx].parent != 0)
+        {
+            attrs[idx][attr_count].id = LAI_MEDIACHANNEL_ATTR_SUPER_CHANNEL_PARENT;
+            attrs[idx][attr_count++].value.u32 = specs[idx].parent;
+        }
+
+        channels[idx].attr_count = attr_count;
+        channels[idx].attr_list = attrs[idx];
+    }
+
+    if (attrs != NULL && channels != NULL)
+    {
+        status = lai_metadata_mediachannel_plan(count, channels, &plan);
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            passed = check(&plan, specs);
+
+            lai_metadata_mediachannel_plan_free(&plan);
+        }
+    }
+
+    free(channels);
+    free(attrs);
+
+    return passed;
+}
+
+static bool lai_test_mediachannel_conflicts(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _In_ const lai_test_mediachannel_t *specs)
+{
+    /* channel 0 and 1 only share boundary, channel 3 overlaps on other ports, 5 is inside its parent */
+
+    static const lai_metadata_mediachannel_conflict_t expected[] = {
+        { LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_OVERLAP, 1, 2 },
+        { LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_ID, 2, 7 },
+        { LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_PARENT, 6, 4 },
+        { LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_FREQUENCY, 8, 8 },
+        { LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_PORT, 9, 9 },
+        { LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_PARENT, 10, 10 },
+    };
+
+    size_t indexes[4];
+    size_t count = 2;
+    size_t failed;
+    size_t idx;
+
+    (void)specs;
+
+    TEST_ASSERT(plan->conflict_count == sizeof(expected) / sizeof(expected[0]));
+
+    for (idx = 0; idx < plan->conflict_count; idx++)
+    {
+        TEST_ASSERT(plan->conflicts[idx].kind == expected[idx].kind);
+        TEST_ASSERT(plan->conflicts[idx].index == expected[idx].index && plan->conflicts[idx].other == expected[idx].other);
+    }
+
+    /* ranges are half open on both ends, invalid range is never returned */
+
+    TEST_ASSERT(lai_metadata_mediachannel_plan_query(plan, 1500, 2600, &count, indexes) == LAI_STATUS_BUFFER_OVERFLOW);
+    TEST_ASSERT(count == 4 && indexes[0] == 0 && indexes[1] == 1);
+    TEST_ASSERT(lai_metadata_mediachannel_plan_query(plan, 1500, 2600, &count, indexes) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(count == 4 && indexes[0] == 0 && indexes[1] == 1 && indexes[2] == 2 && indexes[3] == 3);
+
+    TEST_ASSERT(lai_metadata_mediachannel_plan_query(plan, 2000, 2500, &count, indexes) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(count == 1 && indexes[0] == 1);
+
+    count = 4;
+
+    TEST_ASSERT(lai_metadata_mediachannel_plan_query(plan, 8000, 9600, &count, indexes) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(count == 1 && indexes[0] == 9);
+
+    TEST_ASSERT(lai_metadata_mediachannel_plan_apply(plan, LAI_NULL_OBJECT_ID, &failed) == LAI_STATUS_INVALID_PARAMETER);
+
+    return true;
+}
+
+/*
+ * Grid channels are planned in order of lower frequency except the last,
+ * wide one, which starts with channel 0 and ends above it.
+ */
+
+static bool lai_test_mediachannel_grid(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _In_ const lai_test_mediachannel_t *specs)
+{
+    size_t indexes[TEST_MEDIACHANNEL_GRID + 1];
+    size_t order[TEST_MEDIACHANNEL_GRID + 1];
+    lai_uint64_t lower;
+    lai_uint64_t upper;
+    size_t expected;
+    size_t count;
+    size_t idx;
+    size_t pos;
+
+    order[0] = 0;
+    order[1] = TEST_MEDIACHANNEL_GRID;
+
+    for (idx = 1; idx < TEST_MEDIACHANNEL_GRID; idx++)
+    {
+        order[idx + 1] = idx;
+    }
+
+    TEST_ASSERT(plan->conflict_count == (TEST_MEDIACHANNEL_GRID + 1) / 3);
+
+    for (idx = 0; idx < plan->conflict_count; idx++)
+    {
+        TEST_ASSERT(plan->conflicts[idx].kind == LAI_METADATA_MEDIACHANNEL_CONFLICT_KIND_OVERLAP);
+        TEST_ASSERT(plan->conflicts[idx].index == 3 * idx && plan->conflicts[idx].other == 3 * idx + 1);
+    }
+
+    for (lower = 0; lower < 100 * TEST_MEDIACHANNEL_GRID + 200; lower += 70)
+    {
+        for (upper = lower + 1; upper <= lower + 1000; upper = lower + 10 * (upper - lower))
+        {
+            count = TEST_MEDIACHANNEL_GRID + 1;
+            expected = 0;
+
+            TEST_ASSERT(lai_metadata_mediachannel_plan_query(plan, lower, upper, &count, indexes) == LAI_STATUS_SUCCESS);
+
+            for (pos = 0; pos <= TEST_MEDIACHANNEL_GRID; pos++)
+            {
+                idx = order[pos];
+
+                if (specs[idx].lower < upper && specs[idx].upper > lower)
+                {
+                    TEST_ASSERT(expected < count && indexes[expected] == idx);
+
+                    expected++;
+                }
+            }
+
+            TEST_ASSERT(count == expected);
+        }
+    }
+
+    return true;
+}
+
+static lai_status_t lai_test_mediachannel_create(
+        _Out_ lai_object_id_t *mediachannel_id,
+        _In_ lai_object_id_t linecard_id,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    lai_test_mediachannel_api_t *state = &lai_test_mediachannel_api_state;
+
+    (void)linecard_id;
+
+    if (attr_count == 0 || attr_list[0].id != LAI_MEDIACHANNEL_ATTR_ID || state->creates == TEST_MEDIACHANNEL_APPLY)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (++state->creates == state->fail_at)
+    {
+        return LAI_STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    state->created[state->creates - 1] = attr_list[0].value.u32;
+
+    *mediachannel_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_MEDIACHANNEL, 0, attr_list[0].value.u32);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_test_mediachannel_remove(
+        _In_ lai_object_id_t mediachannel_id)
+{
+    lai_test_mediachannel_api_t *state = &lai_test_mediachannel_api_state;
+
+    if (state->removes == TEST_MEDIACHANNEL_APPLY)
+    {
+        return LAI_STATUS_FAILURE;
+    }
+
+    state->removed[state->removes++] = mediachannel_id;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_test_mediachannel_query(
+        _In_ lai_api_t lai_api_id,
+        _Out_ void** api_method_table)
+{
+    static lai_mediachannel_api_t api;
+
+    if (lai_api_id != LAI_API_MEDIACHANNEL)
+    {
+        return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    memset(&api, 0, sizeof(api));
+
+    api.create_mediachannel = lai_test_mediachannel_create;
+    api.remove_mediachannel = lai_test_mediachannel_remove;
+
+    *api_method_table = &api;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static bool lai_test_mediachannel_apply(
+        _Inout_ lai_metadata_mediachannel_plan_t *plan,
+        _In_ const lai_test_mediachannel_t *specs)
+{
+    lai_test_mediachannel_api_t *state = &lai_test_mediachannel_api_state;
+    size_t failed;
+    size_t idx;
+
+    TEST_ASSERT(plan->conflict_count == 0);
+
+    /* parent ID 3 is created before its channel ID 1, third create fails */
+
+    memset(state, 0, sizeof(*state));
+
+    state->fail_at = 3;
+
+    TEST_ASSERT(lai_metadata_mediachannel_plan_apply(plan, LAI_NULL_OBJECT_ID, &failed) == LAI_STATUS_INSUFFICIENT_RESOURCES);
+    TEST_ASSERT(failed == 3 && state->creates == 3);
+    TEST_ASSERT(state->created[0] == 2 && state->created[1] == 3);
+    TEST_ASSERT(state->removes == 2);
+    TEST_ASSERT(state->removed[0] == LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_MEDIACHANNEL, 0, 3));
+    TEST_ASSERT(state->removed[1] == LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_MEDIACHANNEL, 0, 2));
+
+    for (idx = 0; idx < TEST_MEDIACHANNEL_APPLY; idx++)
+    {
+        TEST_ASSERT(plan->object_ids[idx] == LAI_NULL_OBJECT_ID);
+    }
+
+    memset(state, 0, sizeof(*state));
+
+    TEST_ASSERT(lai_metadata_mediachannel_plan_apply(plan, LAI_NULL_OBJECT_ID, &failed) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(failed == TEST_MEDIACHANNEL_APPLY && state->removes == 0);
+    TEST_ASSERT(state->created[0] == 2 && state->created[1] == 3 && state->created[2] == 4 && state->created[3] == 1);
+
+    for (idx = 0; idx < TEST_MEDIACHANNEL_APPLY; idx++)
+    {
+        TEST_ASSERT(plan->object_ids[idx] == LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_MEDIACHANNEL, 0, specs[idx].id));
+    }
+
+    return true;
+}
+
+static bool lai_test_mediachannel(void)
+{
+    static const lai_test_mediachannel_t conflicts[TEST_MEDIACHANNEL_PLAN] = {
+        { 1, 1000, 2000, false, 0, "A", "B" },
+        { 2, 2000, 3000, false, 0, "A", "B" },
+        { 3, 2500, 3500, false, 0, "A", "C" },
+        { 4, 2500, 3500, false, 0, "D", "E" },
+        { 10, 5000, 6000, true, 0, "A", "B" },
+        { 11, 5100, 5200, false, 10, "A", "B" },
+        { 12, 5900, 6100, false, 10, "F", "G" },
+        { 3, 7000, 8000, false, 0, "H", "I" },
+        { 20, 9000, 8000, false, 0, "J", "K" },
+        { 21, 9500, 9600, false, 0, "L", "L" },
+        { 22, 5150, 5250, false, 99, "M", "N" },
+    };
+
+    static const lai_test_mediachannel_t apply[TEST_MEDIACHANNEL_APPLY] = {
+        { 1, 1000, 1100, false, 3, "A", "B" },
+        { 2, 2000, 2100, false, 0, "A", "B" },
+        { 3, 900, 1200, true, 0, "A", "B" },
+        { 4, 3000, 3100, false, 0, "A", "B" },
+    };
+
+    /* every third grid channel overlaps the next one on the same port */
+
+    lai_test_mediachannel_t grid[TEST_MEDIACHANNEL_GRID + 1];
+    lai_apis_t apis;
+    size_t idx;
+    bool passed;
+
+    for (idx = 0; idx < TEST_MEDIACHANNEL_GRID; idx++)
+    {
+        grid[idx].id = (uint32_t)idx + 1;
+        grid[idx].lower = 100 * idx;
+        grid[idx].upper = 100 * idx + (idx % 3 == 0 ? 150 : 100);
+        grid[idx].super_channel = false;
+        grid[idx].parent = 0;
+        grid[idx].source = "A";
+        grid[idx].dest = "B";
+    }
+
+    grid[idx] = grid[0];
+    grid[idx].id = (uint32_t)idx + 1;
+    grid[idx].upper = 100 * TEST_MEDIACHANNEL_GRID;
+    grid[idx].source = "C";
+    grid[idx].dest = "D";
+
+    TEST_ASSERT(lai_test_mediachannel_run(TEST_MEDIACHANNEL_PLAN, conflicts, lai_test_mediachannel_conflicts));
+    TEST_ASSERT(lai_test_mediachannel_run(TEST_MEDIACHANNEL_GRID + 1, grid, lai_test_mediachannel_grid));
+
+    lai_metadata_apis_query(lai_test_mediachannel_query, &apis);
+
+    passed = lai_test_mediachannel_run(TEST_MEDIACHANNEL_APPLY, apply, lai_test_mediachannel_apply);
+
+    lai_metadata_apis_query(NULL, &apis);
+
+    return passed;
+}
+
+/*
+ * OTDR compare: events are aligned by distance within tolerance with fiber
+ * sections skipped and closer next event taking the match, loss and
+ * reflection changes above thresholds mark event changed, fiber drift is
+ * checked against its own thresholds, and traces are compared sample by
+ * sample or at baseline positions on other grid.
+ */
+
+#define TEST_OTDR_SAMPLES       8
+
+static void lai_test_otdr_result(
+        _Out_ lai_otdr_result_t *result,
+        _In_ lai_otdr_event_t *events,
+        _In_ uint32_t count,
+        _In_ double span_distance,
+        _In_ double span_loss)
+{
+    memset(result, 0, sizeof(lai_otdr_result_t));
+
+    result->events.span_distance = span_distance;
+    result->events.span_loss = span_loss;
+    result->events.events.count = count;
+    result->events.events.list = events;
+}
+
+static bool lai_test_otdr_diff(
+        _In_ const lai_metadata_otdr_comparison_t *comparison,
+        _In_ size_t idx,
+        _In_ lai_metadata_otdr_event_change_t change,
+        _In_ int32_t baseline_index,
+        _In_ int32_t result_index)
+{
+    TEST_ASSERT(idx < comparison->count);
+    TEST_ASSERT(comparison->events[idx].change == change);
+    TEST_ASSERT(comparison->events[idx].baseline_index == baseline_index);
+    TEST_ASSERT(comparison->events[idx].result_index == result_index);
+
+    return true;
+}
+
+static bool lai_test_otdr_compare_events(
+        _In_ const lai_metadata_otdr_trace_format_t *format,
+        _In_ const lai_metadata_otdr_thresholds_t *thresholds)
+{
+    /* type, length, loss, reflection, accumulated loss */
+
+    static lai_otdr_event_t baseline_events[] = {
+        { LAI_OTDR_EVENT_TYPE_NON_REFLECTION, 10.0, 0.3, 0.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_NON_REFLECTION, 1.0, 0.2, 0.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_FIBER_SECTION, 20.0, 5.0, 0.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_REFLECTION, 5.0, 0.5, -40.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_NON_REFLECTION, 5.08, 0.1, 0.0, 0.0 },
+    };
+
+    static lai_otdr_event_t result_events[] = {
+        { LAI_OTDR_EVENT_TYPE_NON_REFLECTION, 1.05, 0.6, 0.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_REFLECTION, 5.01, 0.5, -36.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_NON_REFLECTION, 5.07, 0.7, 0.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_NON_REFLECTION, 7.0, 0.1, 0.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_FIBER_SECTION, 20.0, 5.0, 0.0, 0.0 },
+    };
+
+    /* baseline event at 5.06 is closer to the second result event */
+
+    static lai_otdr_event_t close_events[] = {
+        { LAI_OTDR_EVENT_TYPE_NON_REFLECTION, 5.0, 0.1, 0.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_NON_REFLECTION, 5.08, 0.1, 0.0, 0.0 },
+        { LAI_OTDR_EVENT_TYPE_NON_REFLECTION, 5.06, 0.1, 0.0, 0.0 },
+    };
+
+    lai_metadata_otdr_comparison_t comparison;
+    lai_otdr_result_t baseline;
+    lai_otdr_result_t result;
+    bool passed;
+
+    /* loss change 0.4 is within 0.5 threshold, 0.6 is not, reflection change 4 is above 3 */
+
+    lai_test_otdr_result(&baseline, baseline_events, 5, 20.0, 5.0);
+    lai_test_otdr_result(&result, result_events, 5, 20.05, 6.2);
+
+    TEST_ASSERT(lai_metadata_otdr_compare(&baseline, &result, format, thresholds, &comparison) == LAI_STATUS_SUCCESS);
+
+    passed = comparison.count == 5 && comparison.new_events == 1 && comparison.removed_events == 1 &&
+        comparison.changed_events == 2 &&
+        lai_test_otdr_diff(&comparison, 0, LAI_METADATA_OTDR_EVENT_CHANGE_NONE, 1, 0) &&
+        lai_test_otdr_diff(&comparison, 1, LAI_METADATA_OTDR_EVENT_CHANGE_CHANGED, 3, 1) &&
+        lai_test_otdr_diff(&comparison, 2, LAI_METADATA_OTDR_EVENT_CHANGE_CHANGED, 4, 2) &&
+        lai_test_otdr_diff(&comparison, 3, LAI_METADATA_OTDR_EVENT_CHANGE_NEW, -1, 3) &&
+        lai_test_otdr_diff(&comparison, 4, LAI_METADATA_OTDR_EVENT_CHANGE_REMOVED, 0, -1) &&
+        !comparison.span_distance_changed && comparison.span_loss_changed &&
+        comparison.trace_samples == 0 && __builtin_isnan(comparison.trace_rms_delta);
+
+    lai_metadata_otdr_comparison_free(&comparison);
+
+    TEST_ASSERT(passed);
+
+    lai_test_otdr_result(&result, result_events, 5, 20.2, 5.5);
+
+    TEST_ASSERT(lai_metadata_otdr_compare(&baseline, &result, format, thresholds, &comparison) == LAI_STATUS_SUCCESS);
+
+    passed = comparison.span_distance_changed && !comparison.span_loss_changed;
+
+    lai_metadata_otdr_comparison_free(&comparison);
+
+    TEST_ASSERT(passed);
+
+    /* closer next result event takes the match, baseline event is removed */
+
+    lai_test_otdr_result(&baseline, close_events, 2, 0.0, 0.0);
+    lai_test_otdr_result(&result, close_events + 2, 1, 0.0, 0.0);
+
+    TEST_ASSERT(lai_metadata_otdr_compare(&baseline, &result, format, thresholds, &comparison) == LAI_STATUS_SUCCESS);
+
+    passed = comparison.count == 2 &&
+        lai_test_otdr_diff(&comparison, 0, LAI_METADATA_OTDR_EVENT_CHANGE_REMOVED, 0, -1) &&
+        lai_test_otdr_diff(&comparison, 1, LAI_METADATA_OTDR_EVENT_CHANGE_NONE, 1, 0);
+
+    lai_metadata_otdr_comparison_free(&comparison);
+
+    TEST_ASSERT(passed);
+
+    /* and the same with roles swapped */
+
+    TEST_ASSERT(lai_metadata_otdr_compare(&result, &baseline, format, thresholds, &comparison) == LAI_STATUS_SUCCESS);
+
+    passed = comparison.count == 2 &&
+        lai_test_otdr_diff(&comparison, 0, LAI_METADATA_OTDR_EVENT_CHANGE_NEW, -1, 0) &&
+        lai_test_otdr_diff(&comparison, 1, LAI_METADATA_OTDR_EVENT_CHANGE_NONE, 0, 1);
+
+    lai_metadata_otdr_comparison_free(&comparison);
+
+    return passed;
+}
+
+static bool lai_test_otdr_compare_trace(
+        _In_ const lai_metadata_otdr_trace_format_t *format,
+        _In_ const lai_metadata_otdr_thresholds_t *thresholds)
+{
+    uint8_t baseline_data[TEST_OTDR_SAMPLES / 2] = { 10, 10, 10, 10 };
+    uint8_t result_data[TEST_OTDR_SAMPLES] = { 10, 12, 10, 10, 10, 10, 10, 10 };
+    lai_metadata_otdr_comparison_t comparison;
+    lai_otdr_result_t baseline;
+    lai_otdr_result_t result;
+    bool passed;
+
+    lai_test_otdr_result(&baseline, NULL, 0, 0.0, 0.0);
+    lai_test_otdr_result(&result, NULL, 0, 0.0, 0.0);
+
+    baseline.scanning_profile.distance_range = 4;
+    baseline.trace.data.count = TEST_OTDR_SAMPLES / 2;
+    baseline.trace.data.list = baseline_data;
+
+    result.scanning_profile.distance_range = 4;
+    result.trace.data.count = TEST_OTDR_SAMPLES / 2;
+    result.trace.data.list = result_data;
+
+    /* 2 levels of 0.5 dB at 1 km is at threshold, not above */
+
+    TEST_ASSERT(lai_metadata_otdr_compare(&baseline, &result, format, thresholds, &comparison) == LAI_STATUS_SUCCESS);
+
+    passed = comparison.trace_samples == 4 && !comparison.trace_changed &&
+        comparison.trace_max_delta > 0.99 && comparison.trace_max_delta < 1.01 &&
+        comparison.trace_rms_delta > 0.49 && comparison.trace_rms_delta < 0.51 &&
+        comparison.trace_max_distance > 0.99 && comparison.trace_max_distance < 1.01;
+
+    lai_metadata_otdr_comparison_free(&comparison);
+
+    TEST_ASSERT(passed);
+
+    result_data[1] = 7;
+
+    TEST_ASSERT(lai_metadata_otdr_compare(&baseline, &result, format, thresholds, &comparison) == LAI_STATUS_SUCCESS);
+
+    passed = comparison.trace_changed && comparison.trace_max_delta > 1.49 && comparison.trace_max_delta < 1.51;
+
+    lai_metadata_otdr_comparison_free(&comparison);
+
+    TEST_ASSERT(passed);
+
+    /* twice as many result samples are compared at every other position */
+
+    result.trace.data.count = TEST_OTDR_SAMPLES;
+
+    TEST_ASSERT(lai_metadata_otdr_compare(&baseline, &result, format, thresholds, &comparison) == LAI_STATUS_SUCCESS);
+
+    passed = comparison.trace_samples == 4 && !comparison.trace_changed &&
+        comparison.trace_max_delta > -0.01 && comparison.trace_max_delta < 0.01;
+
+    lai_metadata_otdr_comparison_free(&comparison);
+
+    return passed;
+}
+
+static bool lai_test_otdr_compare(void)
+{
+    lai_metadata_otdr_thresholds_t thresholds;
+    lai_metadata_otdr_trace_format_t format;
+    lai_metadata_otdr_comparison_t comparison;
+    lai_otdr_result_t result;
+
+    memset(&format, 0, sizeof(format));
+
+    format.sample = LAI_METADATA_OTDR_SAMPLE_UINT8;
+    format.scale = -0.5;
+
+    lai_metadata_otdr_thresholds_init(&thresholds);
+
+    TEST_ASSERT(lai_test_otdr_compare_events(&format, &thresholds));
+    TEST_ASSERT(lai_test_otdr_compare_trace(&format, &thresholds));
+
+    lai_test_otdr_result(&result, NULL, 0, 0.0, 0.0);
+
+    thresholds.loss = -1.0;
+
+    TEST_ASSERT(lai_metadata_otdr_compare(&result, &result, &format, &thresholds, &comparison) == LAI_STATUS_INVALID_PARAMETER);
+
+    return true;
+}
+
+/*
+ * OTDR trace: two byte samples decode in their byte order with odd trailing
+ * byte ignored and samples beyond distance range dropped, downsampling keeps
+ * end points and reflection spike, zoom keeps points of its window.
+ */
+
+#define TEST_TRACE_POINTS       100
+#define TEST_TRACE_SPIKE        37
+
+static bool lai_test_otdr_decode(void)
+{
+    uint8_t bytes[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09 };
+    lai_metadata_otdr_trace_format_t format;
+    lai_metadata_otdr_trace_t decoded;
+    lai_otdr_result_trace_t trace;
+
+    memset(&trace, 0, sizeof(trace));
+    memset(&format, 0, sizeof(format));
+
+    trace.data.count = sizeof(bytes);
+    trace.data.list = bytes;
+
+    format.sample = LAI_METADATA_OTDR_SAMPLE_UINT16_BE;
+    format.scale = 0.001;
+    format.offset = -10.0;
+    format.sampling_resolution = 500.0;
+
+    TEST_ASSERT(lai_metadata_otdr_trace_decode(&trace, &format, &decoded) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(decoded.count == 4);
+    TEST_ASSERT(decoded.power[1] > -10.0 + 0x0304 * 0.001 - 1e-9 && decoded.power[1] < -10.0 + 0x0304 * 0.001 + 1e-9);
+    TEST_ASSERT(decoded.distance[3] > 1.5 - 1e-9 && decoded.distance[3] < 1.5 + 1e-9);
+
+    lai_metadata_otdr_trace_free(&decoded);
+
+    format.sample = LAI_METADATA_OTDR_SAMPLE_UINT16_LE;
+    format.distance_range = 1;
+
+    TEST_ASSERT(lai_metadata_otdr_trace_decode(&trace, &format, &decoded) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(decoded.count == 3);
+    TEST_ASSERT(decoded.power[1] > -10.0 + 0x0403 * 0.001 - 1e-9 && decoded.power[1] < -10.0 + 0x0403 * 0.001 + 1e-9);
+
+    lai_metadata_otdr_trace_free(&decoded);
+
+    format.sampling_resolution = 0;
+    format.distance_range = 0;
+
+    TEST_ASSERT(lai_metadata_otdr_trace_decode(&trace, &format, &decoded) == LAI_STATUS_INVALID_PARAMETER);
+
+    return true;
+}
+
+static bool lai_test_otdr_trace(void)
+{
+    uint8_t bytes[TEST_TRACE_POINTS];
+    lai_metadata_otdr_trace_format_t format;
+    lai_metadata_otdr_trace_t decoded;
+    lai_metadata_otdr_trace_t reduced;
+    lai_otdr_result_trace_t trace;
+    bool spike = false;
+    size_t idx;
+
+    TEST_ASSERT(lai_test_otdr_decode());
+
+    for (idx = 0; idx < TEST_TRACE_POINTS; idx++)
+    {
+        bytes[idx] = (uint8_t)(idx == TEST_TRACE_SPIKE ? 250 : 200 - idx);
+    }
+
+    memset(&trace, 0, sizeof(trace));
+    memset(&format, 0, sizeof(format));
+
+    trace.data.count = TEST_TRACE_POINTS;
+    trace.data.list = bytes;
+
+    format.sample = LAI_METADATA_OTDR_SAMPLE_UINT8;
+    format.scale = 0.1;
+    format.sampling_resolution = 100.0;
+
+    TEST_ASSERT(lai_metadata_otdr_trace_decode(&trace, &format, &decoded) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(decoded.count == TEST_TRACE_POINTS);
+
+    TEST_ASSERT(lai_metadata_otdr_trace_downsample(&decoded, 10, &reduced) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(reduced.count == 10);
+    TEST_ASSERT(reduced.distance[0] < 1e-9);
+    TEST_ASSERT(reduced.distance[9] > decoded.distance[TEST_TRACE_POINTS - 1] - 1e-9);
+
+    for (idx = 0; idx < reduced.count; idx++)
+    {
+        TEST_ASSERT(idx == 0 || reduced.distance[idx] > reduced.distance[idx - 1]);
+
+        spike = spike || reduced.power[idx] > 24.9;
+    }
+
+    TEST_ASSERT(spike);
+
+    lai_metadata_otdr_trace_free(&reduced);
+
+    TEST_ASSERT(lai_metadata_otdr_trace_zoom(&decoded, 1.95, 4.05, 0, &reduced) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(reduced.count == 21);
+    TEST_ASSERT(reduced.distance[0] > 2.0 - 1e-9 && reduced.distance[20] < 4.0 + 1e-9);
+
+    lai_metadata_otdr_trace_free(&reduced);
+    lai_metadata_otdr_trace_free(&decoded);
+
+    return true;
+}
+
+/*
+ * Static cache: transceiver adapter is replaced by test table. Vendor is
+ * served from cache until plug alarm, value read while module was being
+ * replaced is not cached, and changed presence drops cached values.
+ */
+
+typedef struct _lai_test_module_t
+{
+    const char *vendor;
+    int32_t present;
+    uint32_t reads;
+
+    /* plug alarm raised during next read */
+
+    lai_metadata_static_cache_t *plug;
+
+} lai_test_module_t;
+
+static lai_test_module_t lai_test_module;
+
+static lai_status_t lai_test_module_get(
+        _In_ lai_object_id_t transceiver_id,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list)
+{
+    lai_alarm_info_t info;
+    uint32_t idx;
+
+    lai_test_module.reads++;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        if (attr_list[idx].id == LAI_TRANSCEIVER_ATTR_VENDOR)
+        {
+            strcpy(attr_list[idx].value.chardata, lai_test_module.vendor);
+        }
+        else if (attr_list[idx].id == LAI_TRANSCEIVER_ATTR_PRESENT)
+        {
+            attr_list[idx].value.s32 = lai_test_module.present;
+        }
+        else
+        {
+            return LAI_STATUS_ATTR_NOT_SUPPORTED_0 + (lai_status_t)idx;
+        }
+    }
+
+    if (lai_test_module.plug != NULL)
+    {
+        memset(&info, 0, sizeof(info));
+
+        info.resource_oid = transceiver_id;
+
+        lai_test_module.vendor = "REPLACED";
+
+        lai_metadata_static_cache_alarm(lai_test_module.plug, LAI_ALARM_TYPE_PLUG_IN, &info);
+
+        lai_test_module.plug = NULL;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_test_module_query(
+        _In_ lai_api_t lai_api_id,
+        _Out_ void** api_method_table)
+{
+    static lai_transceiver_api_t api;
+
+    if (lai_api_id != LAI_API_TRANSCEIVER)
+    {
+        return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    memset(&api, 0, sizeof(api));
+
+    api.get_transceiver_attribute = lai_test_module_get;
+
+    *api_method_table = &api;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static bool lai_test_vendor(
+        _Inout_ lai_metadata_static_cache_t *cache,
+        _In_ bool with_present,
+        _In_ const char *vendor,
+        _In_ uint32_t reads)
+{
+    lai_object_id_t transceiver_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_TRANSCEIVER, 0, 1);
+    lai_attribute_t attrs[2];
+
+    attrs[0].id = LAI_TRANSCEIVER_ATTR_VENDOR;
+    attrs[1].id = LAI_TRANSCEIVER_ATTR_PRESENT;
+
+    TEST_ASSERT(lai_metadata_static_cache_get(cache, LAI_OBJECT_TYPE_TRANSCEIVER, transceiver_id,
+                with_present ? 2 : 1, attrs) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(strcmp(attrs[0].value.chardata, vendor) == 0);
+    TEST_ASSERT(lai_test_module.reads == reads);
+
+    return true;
+}
+
+static bool lai_test_static_cache(void)
+{
+    lai_object_id_t transceiver_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_TRANSCEIVER, 0, 1);
+    lai_metadata_static_cache_t cache;
+    lai_alarm_info_t info;
+    lai_apis_t apis;
+
+    memset(&lai_test_module, 0, sizeof(lai_test_module));
+
+    lai_test_module.vendor = "ORIGINAL";
+    lai_test_module.present = LAI_TRANSCEIVER_PRESENT_PRESENT;
+
+    lai_metadata_apis_query(lai_test_module_query, &apis);
+
+    TEST_ASSERT(lai_metadata_static_cache_init(&cache) == LAI_STATUS_SUCCESS);
+
+    TEST_ASSERT(lai_test_vendor(&cache, false, "ORIGINAL", 1));
+    TEST_ASSERT(lai_test_vendor(&cache, false, "ORIGINAL", 1));
+    TEST_ASSERT(cache.hits == 1 && cache.misses == 1 && cache.count == 1);
+
+    /* module is replaced while its vendor is being read */
+
+    memset(&info, 0, sizeof(info));
+
+    info.resource_oid = transceiver_id;
+
+    lai_metadata_static_cache_alarm(&cache, LAI_ALARM_TYPE_PLUG_OFF, &info);
+
+    TEST_ASSERT(cache.count == 0);
+
+    lai_test_module.plug = &cache;
+
+    TEST_ASSERT(lai_test_vendor(&cache, false, "ORIGINAL", 2));
+    TEST_ASSERT(cache.count == 0);
+    TEST_ASSERT(lai_test_vendor(&cache, false, "REPLACED", 3));
+    TEST_ASSERT(lai_test_vendor(&cache, false, "REPLACED", 3));
+
+    /* presence is always read, its change drops values */
+
+    TEST_ASSERT(lai_test_vendor(&cache, true, "REPLACED", 4));
+
+    lai_test_module.present = LAI_TRANSCEIVER_PRESENT_NOT_PRESENT;
+    lai_test_module.vendor = "";
+
+    TEST_ASSERT(lai_test_vendor(&cache, true, "", 5));
+    TEST_ASSERT(cache.count == 0);
+    TEST_ASSERT(lai_test_vendor(&cache, false, "", 6));
+
+    lai_metadata_static_cache_free(&cache);
+
+    lai_metadata_apis_query(NULL, &apis);
+
+    return true;
+}
+
+/*
+ * Deferred logger: threads log concurrently into their rings, every message
+ * recorded is formatted with its own arguments, messages of each thread
+ * reach sink in order and no message is lost without being counted.
+ */
+
+#define TEST_LOG_MESSAGES       2000
+
+typedef struct _lai_test_logger_t
+{
+    uint32_t received;
+    uint32_t errors;
+    int64_t last[TEST_THREADS];
+
+} lai_test_logger_t;
+
+static lai_test_logger_t lai_test_logger;
+
+static void lai_test_logger_sink(
+        _In_ lai_log_level_t log_level,
+        _In_ const char *file,
+        _In_ int line,
+        _In_ const char *function,
+        _In_ const char *format,
+        ...)
+{
+    char text[32];
+    char expected[32];
+    const char *message;
+    unsigned thread;
+    unsigned seq;
+    double half;
+    va_list ap;
+
+    va_start(ap, format);
+    message = va_arg(ap, const char*);
+    va_end(ap);
+
+    message = strstr(message, "logger ");
+
+    if (message == NULL)
+    {
+        return;
+    }
+
+    lai_test_logger.received++;
+
+    if (sscanf(message, "logger %u %u %31s %lf", &thread, &seq, text, &half) != 4 || thread >= TEST_THREADS)
+    {
+        lai_test_logger.errors++;
+        return;
+    }
+
+    snprintf(expected, sizeof(expected), "thread-%u", thread);
+
+    if (strcmp(text, expected) != 0 || (int64_t)seq <= lai_test_logger.last[thread] ||
+            !(half > (double)seq / 2 - 0.01 && half < (double)seq / 2 + 0.01))
+    {
+        lai_test_logger.errors++;
+    }
+
+    lai_test_logger.last[thread] = seq;
+}
+
+static void* lai_test_logger_thread(
+        _In_ void *arg)
+{
+    unsigned thread = (unsigned)(uintptr_t)arg;
+    char text[32];
+    unsigned seq;
+
+    snprintf(text, sizeof(text), "thread-%u", thread);
+
+    for (seq = 0; seq < TEST_LOG_MESSAGES; seq++)
+    {
+        LAI_META_LOG_NOTICE("logger %u %u %s %.2f", thread, seq, text, (double)seq / 2);
+    }
+
+    return NULL;
+}
+
+static bool lai_test_logger_deferred(void)
+{
+    pthread_t threads[TEST_THREADS];
+    lai_metadata_log_stats_t before;
+    lai_metadata_log_stats_t after;
+    lai_log_level_t level = lai_metadata_log_level;
+    uintptr_t idx;
+
+    memset(&lai_test_logger, 0, sizeof(lai_test_logger));
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        lai_test_logger.last[idx] = -1;
+    }
+
+    lai_metadata_log_get_stats(&before);
+    lai_metadata_log_set_level(LAI_LOG_LEVEL_NOTICE);
+    lai_metadata_log_set_sink(lai_test_logger_sink);
+
+    TEST_ASSERT(lai_metadata_log_set_mode(LAI_METADATA_LOG_MODE_DEFERRED) == LAI_STATUS_SUCCESS);
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        TEST_ASSERT(pthread_create(&threads[idx], NULL, lai_test_logger_thread, (void*)idx) == 0);
+    }
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        pthread_join(threads[idx], NULL);
+    }
+
+    /* switching back drains all rings */
+
+    TEST_ASSERT(lai_metadata_log_set_mode(LAI_METADATA_LOG_MODE_SYNC) == LAI_STATUS_SUCCESS);
+
+    lai_metadata_log_get_stats(&after);
+    lai_metadata_log_set_sink(NULL);
+    lai_metadata_log_set_level(level);
+
+    TEST_ASSERT(lai_test_logger.errors == 0);
+    TEST_ASSERT(lai_test_logger.received != 0);
+    TEST_ASSERT(after.recorded - before.recorded == lai_test_logger.received);
+    TEST_ASSERT(after.recorded - before.recorded + after.dropped - before.dropped == TEST_THREADS * TEST_LOG_MESSAGES);
+    TEST_ASSERT(after.truncated == before.truncated);
+
+    return true;
+}
+
+/*
+ * Instrumentation: threads record calls into their own tables while
+ * snapshots are taken, counters never go back, and after threads exit
+ * every call is counted exactly once, also by later snapshots.
+ */
+
+#define TEST_INSTRUMENT_ID      0x7777
+
+static void* lai_test_instrument_thread(
+        _In_ void *arg)
+{
+    uint32_t idx;
+
+    for (idx = 0; idx < TEST_ITERATIONS; idx++)
+    {
+        lai_metadata_instrument_end(LAI_OBJECT_TYPE_OA, LAI_METADATA_INSTRUMENT_OP_SET, TEST_INSTRUMENT_ID,
+                idx % 4 ? LAI_STATUS_SUCCESS : LAI_STATUS_FAILURE, lai_metadata_instrument_begin());
+        lai_metadata_instrument_end(LAI_OBJECT_TYPE_OA, LAI_METADATA_INSTRUMENT_OP_GET, TEST_INSTRUMENT_ID,
+                LAI_STATUS_SUCCESS, lai_metadata_instrument_begin());
+    }
+
+    return NULL;
+}
+
+static const lai_metadata_instrument_entry_t* lai_test_instrument_find(
+        _In_ const lai_metadata_instrument_snapshot_t *snapshot,
+        _In_ lai_metadata_instrument_op_t op)
+{
+    size_t idx;
+
+    for (idx = 0; idx < snapshot->count; idx++)
+    {
+        if (snapshot->entries[idx].object_type == LAI_OBJECT_TYPE_OA &&
+                snapshot->entries[idx].op == op && snapshot->entries[idx].id == TEST_INSTRUMENT_ID)
+        {
+            return &snapshot->entries[idx];
+        }
+    }
+
+    return NULL;
+}
+
+static bool lai_test_instrument_check(
+        _In_ uint64_t calls)
+{
+    lai_metadata_instrument_snapshot_t snapshot;
+    const lai_metadata_instrument_entry_t *set;
+    const lai_metadata_instrument_entry_t *get;
+    uint64_t histogram = 0;
+    size_t idx;
+
+    TEST_ASSERT(lai_metadata_instrument_snapshot(&snapshot) == LAI_STATUS_SUCCESS);
+
+    set = lai_test_instrument_find(&snapshot, LAI_METADATA_INSTRUMENT_OP_SET);
+    get = lai_test_instrument_find(&snapshot, LAI_METADATA_INSTRUMENT_OP_GET);
+
+    TEST_ASSERT(set != NULL && get != NULL);
+    TEST_ASSERT(set->calls == calls && get->calls == calls);
+    TEST_ASSERT(set->errors == calls / 4 && get->errors == 0);
+    TEST_ASSERT(set->status[0] == LAI_STATUS_FAILURE && set->status_count[0] == calls / 4);
+
+    for (idx = 0; idx < LAI_METADATA_INSTRUMENT_BUCKETS; idx++)
+    {
+        histogram += set->histogram[idx];
+    }
+
+    TEST_ASSERT(histogram == calls);
+
+    lai_metadata_instrument_snapshot_free(&snapshot);
+
+    return true;
+}
+
+static bool lai_test_instrument(void)
+{
+    pthread_t threads[TEST_THREADS];
+    lai_metadata_instrument_snapshot_t snapshot;
+    const lai_metadata_instrument_entry_t *set;
+    uint64_t last = 0;
+    uint32_t failures = 0;
+    size_t idx;
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        TEST_ASSERT(pthread_create(&threads[idx], NULL, lai_test_instrument_thread, NULL) == 0);
+    }
+
+    for (idx = 0; idx < 100; idx++)
+    {
+        if (lai_metadata_instrument_snapshot(&snapshot) != LAI_STATUS_SUCCESS)
+        {
+            failures++;
+            continue;
+        }
+
+        set = lai_test_instrument_find(&snapshot, LAI_METADATA_INSTRUMENT_OP_SET);
+
+        if (set != NULL)
+        {
+            failures += (set->calls < last || set->errors > set->calls);
+
+            last = set->calls;
+        }
+
+        lai_metadata_instrument_snapshot_free(&snapshot);
+    }
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        pthread_join(threads[idx], NULL);
+    }
+
+    TEST_ASSERT(failures == 0);
+
+    /* tables of exited threads are retired once */
+
+    TEST_ASSERT(lai_test_instrument_check(TEST_THREADS * TEST_ITERATIONS));
+    TEST_ASSERT(lai_test_instrument_check(TEST_THREADS * TEST_ITERATIONS));
+
+    return true;
+}
+
+/*
+ * Upgrade: transceiver downloads are completed from another thread, at
+ * most parallelism units run at once, pause keeps pending units waiting,
+ * stale completion is ignored and failed download fails only its unit.
+ */
+
+#define TEST_UPGRADE_UNITS      6
+#define TEST_UPGRADE_PARALLEL   2
+#define TEST_UPGRADE_FAILED     3
+
+typedef struct _lai_test_upgrade_t
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    lai_metadata_upgrade_t *upgrade;
+
+    /* started requests not yet completed */
+
+    lai_object_id_t queue[TEST_UPGRADE_UNITS];
+    lai_request_id_t requests[TEST_UPGRADE_UNITS];
+    size_t queued;
+
+    lai_object_id_t started[TEST_UPGRADE_UNITS];
+    size_t starts;
+
+    lai_request_id_t next_request;
+
+    bool stop;
+
+} lai_test_upgrade_t;
+
+static lai_test_upgrade_t lai_test_upgrade_state = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, { 0 }, { 0 }, 0, { 0 }, 0, 0, false };
+
+static lai_status_t lai_test_upgrade_set_async(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ const lai_attribute_t *attr,
+        _Out_ lai_request_id_t *request_id)
+{
+    lai_test_upgrade_t *state = &lai_test_upgrade_state;
+
+    if (object_type != LAI_OBJECT_TYPE_TRANSCEIVER || attr->id != LAI_TRANSCEIVER_ATTR_UPGRADE_DOWNLOAD)
+    {
+        return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    pthread_mutex_lock(&state->lock);
+
+    if (state->queued == TEST_UPGRADE_UNITS || state->starts == TEST_UPGRADE_UNITS)
+    {
+        pthread_mutex_unlock(&state->lock);
+        return LAI_STATUS_FAILURE;
+    }
+
+    *request_id = ++state->next_request;
+
+    state->queue[state->queued] = object_id;
+    state->requests[state->queued] = *request_id;
+    state->queued++;
+    state->started[state->starts++] = object_id;
+
+    pthread_cond_signal(&state->cond);
+    pthread_mutex_unlock(&state->lock);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static void* lai_test_upgrade_thread(
+        _In_ void *arg)
+{
+    lai_test_upgrade_t *state = (lai_test_upgrade_t*)arg;
+    lai_object_id_t object_id;
+    lai_request_id_t request_id;
+
+    pthread_mutex_lock(&state->lock);
+
+    while (true)
+    {
+        while (state->queued == 0 && !state->stop)
+        {
+            pthread_cond_wait(&state->cond, &state->lock);
+        }
+
+        if (state->queued == 0)
+        {
+            break;
+        }
+
+        object_id = state->queue[0];
+        request_id = state->requests[0];
+
+        state->queued--;
+
+        memmove(state->queue, state->queue + 1, state->queued * sizeof(state->queue[0]));
+        memmove(state->requests, state->requests + 1, state->queued * sizeof(state->requests[0]));
+
+        pthread_mutex_unlock(&state->lock);
+
+        lai_metadata_upgrade_notify(state->upgrade, request_id, object_id, false, LAI_STATUS_SUCCESS, 50);
+        lai_metadata_upgrade_notify(state->upgrade, request_id + 1000, object_id, true, LAI_STATUS_FAILURE, 0);
+        lai_metadata_upgrade_notify(state->upgrade, request_id, object_id, true,
+                LAI_OBJECT_ID_INDEX(object_id) == TEST_UPGRADE_FAILED ? LAI_STATUS_FAILURE : LAI_STATUS_SUCCESS, 100);
+
+        pthread_mutex_lock(&state->lock);
+    }
+
+    pthread_mutex_unlock(&state->lock);
+
+    return NULL;
+}
+
+static lai_status_t lai_test_upgrade_get(
+        _In_ lai_object_id_t transceiver_id,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list)
+{
+    if (attr_count != 1 || attr_list[0].id != LAI_TRANSCEIVER_ATTR_UPGRADE_STATE)
+    {
+        return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    attr_list[0].value.s32 = LAI_TRANSCEIVER_UPGRADE_STATE_IDLE;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t lai_test_upgrade_query(
+        _In_ lai_api_t lai_api_id,
+        _Out_ void** api_method_table)
+{
+    static lai_transceiver_api_t api;
+
+    if (lai_api_id != LAI_API_TRANSCEIVER)
+    {
+        return LAI_STATUS_NOT_SUPPORTED;
+    }
+
+    memset(&api, 0, sizeof(api));
+
+    api.get_transceiver_attribute = lai_test_upgrade_get;
+
+    *api_method_table = &api;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+/*
+ * Ticks until upgrade is finished or, when paused, until no unit runs.
+ */
+
+static bool lai_test_upgrade_run(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _Inout_ uint64_t *now)
+{
+    struct timespec delay = { 0, 1000000 };
+    uint32_t failures = 0;
+    uint32_t running;
+    uint32_t iteration;
+    size_t idx;
+
+    for (iteration = 0; iteration < 5000; iteration++)
+    {
+        if (lai_metadata_upgrade_tick(upgrade, *now) == 0 || (upgrade->paused && upgrade->active == 0))
+        {
+            break;
+        }
+
+        running = 0;
+
+        for (idx = 0; idx < upgrade->count; idx++)
+        {
+            running += upgrade->units[idx].state == LAI_METADATA_UPGRADE_STATE_DOWNLOADING;
+        }
+
+        failures += (upgrade->active > TEST_UPGRADE_PARALLEL || running != upgrade->active);
+
+        *now += 10;
+
+        nanosleep(&delay, NULL);
+    }
+
+    TEST_ASSERT(iteration < 5000);
+    TEST_ASSERT(failures == 0);
+
+    return true;
+}
+
+static bool lai_test_upgrade(void)
+{
+    lai_test_upgrade_t *state = &lai_test_upgrade_state;
+    lai_object_meta_key_t objects[TEST_UPGRADE_UNITS];
+    lai_metadata_upgrade_config_t config;
+    lai_metadata_upgrade_t upgrade;
+    lai_apis_t apis;
+    pthread_t thread;
+    uint64_t now = 1;
+    size_t idx;
+
+    memset(objects, 0, sizeof(objects));
+    memset(&config, 0, sizeof(config));
+
+    for (idx = 0; idx < TEST_UPGRADE_UNITS; idx++)
+    {
+        objects[idx].objecttype = LAI_OBJECT_TYPE_TRANSCEIVER;
+        objects[idx].objectkey.key.object_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_TRANSCEIVER, 0, idx);
+    }
+
+    config.parallelism = TEST_UPGRADE_PARALLEL;
+
+    lai_metadata_apis_query(lai_test_upgrade_query, &apis);
+
+    TEST_ASSERT(lai_metadata_upgrade_init(&upgrade, &config, TEST_UPGRADE_UNITS, objects,
+                lai_test_upgrade_set_async) == LAI_STATUS_SUCCESS);
+
+    state->upgrade = &upgrade;
+
+    TEST_ASSERT(pthread_create(&thread, NULL, lai_test_upgrade_thread, state) == 0);
+
+    /* pause after the first units are started */
+
+    TEST_ASSERT(lai_metadata_upgrade_tick(&upgrade, now) == TEST_UPGRADE_UNITS);
+    TEST_ASSERT(upgrade.active == TEST_UPGRADE_PARALLEL);
+    TEST_ASSERT(lai_metadata_upgrade_pause(&upgrade) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_test_upgrade_run(&upgrade, &now));
+
+    for (idx = 0; idx < TEST_UPGRADE_UNITS; idx++)
+    {
+        TEST_ASSERT(upgrade.units[idx].state ==
+                (idx < TEST_UPGRADE_PARALLEL ? LAI_METADATA_UPGRADE_STATE_DONE : LAI_METADATA_UPGRADE_STATE_PENDING));
+    }
+
+    TEST_ASSERT(lai_metadata_upgrade_resume(&upgrade) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_test_upgrade_run(&upgrade, &now));
+
+    pthread_mutex_lock(&state->lock);
+
+    state->stop = true;
+
+    pthread_cond_signal(&state->cond);
+    pthread_mutex_unlock(&state->lock);
+
+    pthread_join(thread, NULL);
+
+    /* units start in given order */
+
+    TEST_ASSERT(state->starts == TEST_UPGRADE_UNITS);
+
+    for (idx = 0; idx < TEST_UPGRADE_UNITS; idx++)
+    {
+        TEST_ASSERT(state->started[idx] == objects[idx].objectkey.key.object_id);
+
+        if (idx == TEST_UPGRADE_FAILED)
+        {
+            TEST_ASSERT(upgrade.units[idx].state == LAI_METADATA_UPGRADE_STATE_FAILED);
+            TEST_ASSERT(upgrade.units[idx].status == LAI_STATUS_FAILURE);
+        }
+        else
+        {
+            TEST_ASSERT(upgrade.units[idx].state == LAI_METADATA_UPGRADE_STATE_DONE);
+            TEST_ASSERT(upgrade.units[idx].status == LAI_STATUS_SUCCESS && upgrade.units[idx].progress == 100);
+        }
+    }
+
+    TEST_ASSERT(upgrade.active == 0);
+
+    lai_metadata_upgrade_free(&upgrade);
+
+    lai_metadata_apis_query(NULL, &apis);
+
+    return true;
+}
+
+/*
+ * Object id layout: ids decode into type, linecard and index, compliance
+ * rejects null id, types out of range or other than expected, linecard
+ * with non-zero index and objects of other linecard.
+ */
+
+static bool lai_test_object_id(void)
+{
+    lai_object_id_t linecard_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_LINECARD, 3, 0);
+    lai_object_id_t oa_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_OA, 3, 5);
+
+    TEST_ASSERT(LAI_OBJECT_ID_TYPE(oa_id) == LAI_OBJECT_TYPE_OA);
+    TEST_ASSERT(LAI_OBJECT_ID_LINECARD_INDEX(oa_id) == 3 && LAI_OBJECT_ID_INDEX(oa_id) == 5);
+    TEST_ASSERT(LAI_OBJECT_ID_LINECARD(oa_id) == linecard_id);
+    TEST_ASSERT(LAI_OBJECT_ID_LINECARD(LAI_NULL_OBJECT_ID) == LAI_NULL_OBJECT_ID);
+
+    TEST_ASSERT(lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_LINECARD, LAI_NULL_OBJECT_ID, linecard_id));
+    TEST_ASSERT(lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_LINECARD, linecard_id, linecard_id));
+    TEST_ASSERT(lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_OA, LAI_NULL_OBJECT_ID, oa_id));
+    TEST_ASSERT(lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_OA, linecard_id, oa_id));
+
+    TEST_ASSERT(!lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_OA, LAI_NULL_OBJECT_ID, LAI_NULL_OBJECT_ID));
+    TEST_ASSERT(!lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_MAX, LAI_NULL_OBJECT_ID,
+                LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_MAX, 3, 5)));
+    TEST_ASSERT(!lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_NULL, LAI_NULL_OBJECT_ID,
+                LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_NULL, 3, 5)));
+    TEST_ASSERT(!lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_LINECARD, LAI_NULL_OBJECT_ID,
+                LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_LINECARD, 3, 1)));
+    TEST_ASSERT(!lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_LINECARD, LAI_NULL_OBJECT_ID, oa_id));
+    TEST_ASSERT(!lai_metadata_is_object_id_compliant(LAI_OBJECT_TYPE_OA, linecard_id,
+                LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_OA, 4, 5)));
+
+    return true;
+}
+
+/*
+ * Profile cache: values are parsed into their types, reload notifies
+ * changed, added and removed variables and bumps version only when some
+ * variable changed, lazy cache asks host once for every name also when
+ * threads look up concurrently.
+ */
+
+#define TEST_PROFILE_ID         7
+#define TEST_PROFILE_VARIABLES  5
+#define TEST_PROFILE_LOOKUPS    200
+
+typedef struct _lai_test_profile_t
+{
+    const char *values[TEST_PROFILE_VARIABLES];
+
+    size_t next;
+
+    /* lazy lookups call host under lock of cache */
+
+    uint32_t asked;
+
+    uint32_t notified;
+    uint32_t errors;
+
+} lai_test_profile_t;
+
+static const char* const lai_test_profile_names[TEST_PROFILE_VARIABLES] = {
+    "TEST_INT", "TEST_HEX", "TEST_DOUBLE", "TEST_BOOL", "TEST_ADDED",
+};
+
+static lai_test_profile_t lai_test_profile_host;
+
+static const char* lai_test_profile_get_value(
+        _In_ lai_linecard_profile_id_t profile_id,
+        _In_ const char *variable)
+{
+    size_t idx;
+
+    lai_test_profile_host.asked++;
+
+    for (idx = 0; idx < TEST_PROFILE_VARIABLES; idx++)
+    {
+        if (strcmp(variable, lai_test_profile_names[idx]) == 0)
+        {
+            return lai_test_profile_host.values[idx];
+        }
+    }
+
+    return NULL;
+}
+
+static int lai_test_profile_get_next_value(
+        _In_ lai_linecard_profile_id_t profile_id,
+        _Out_ const char **variable,
+        _Out_ const char **value)
+{
+    size_t idx;
+
+    if (variable == NULL)
+    {
+        lai_test_profile_host.next = 0;
+        return -1;
+    }
+
+    for (idx = lai_test_profile_host.next; idx < TEST_PROFILE_VARIABLES; idx++)
+    {
+        if (lai_test_profile_host.values[idx] != NULL)
+        {
+            *variable = lai_test_profile_names[idx];
+            *value = lai_test_profile_host.values[idx];
+
+            lai_test_profile_host.next = idx + 1;
+
+            return 0;
+        }
+    }
+
+    lai_test_profile_host.next = TEST_PROFILE_VARIABLES;
+
+    return -1;
+}
+
+static void lai_test_profile_changed(
+        _In_ lai_linecard_profile_id_t profile_id,
+        _In_ const char *variable,
+        _In_ const lai_metadata_profile_value_t *value)
+{
+    const char *expected = NULL;
+    size_t idx;
+
+    lai_test_profile_host.notified++;
+
+    for (idx = 0; idx < TEST_PROFILE_VARIABLES; idx++)
+    {
+        if (strcmp(variable, lai_test_profile_names[idx]) == 0)
+        {
+            expected = lai_test_profile_host.values[idx];
+        }
+    }
+
+    if (profile_id != TEST_PROFILE_ID || (value == NULL) != (expected == NULL) ||
+            (value != NULL && strcmp(value->chardata, expected) != 0))
+    {
+        lai_test_profile_host.errors++;
+    }
+}
+
+static void lai_test_profile_reset(void)
+{
+    memset(&lai_test_profile_host, 0, sizeof(lai_test_profile_host));
+
+    lai_test_profile_host.values[0] = "42";
+    lai_test_profile_host.values[1] = "0x10";
+    lai_test_profile_host.values[2] = "1.5";
+    lai_test_profile_host.values[3] = "true";
+}
+
+static bool lai_test_profile_reload(
+        _Inout_ lai_metadata_profile_t *profile)
+{
+    lai_metadata_profile_key_t keys[TEST_PROFILE_VARIABLES];
+    uint64_t version = profile->version;
+    size_t idx;
+
+    for (idx = 0; idx < TEST_PROFILE_VARIABLES; idx++)
+    {
+        lai_metadata_profile_key_init(&keys[idx], lai_test_profile_names[idx]);
+    }
+
+    TEST_ASSERT(profile->count == 4);
+    TEST_ASSERT(lai_metadata_profile_get_int(profile, &keys[0], 0) == 42);
+    TEST_ASSERT(lai_metadata_profile_get_int(profile, &keys[1], 0) == 16);
+    TEST_ASSERT(lai_metadata_profile_get_int(profile, &keys[2], 0) == 0);
+    TEST_ASSERT(lai_metadata_profile_get_double(profile, &keys[2], 0) > 1.49);
+    TEST_ASSERT(lai_metadata_profile_get_double(profile, &keys[2], 0) < 1.51);
+    TEST_ASSERT(lai_metadata_profile_get_bool(profile, &keys[3], false));
+    TEST_ASSERT(lai_metadata_profile_get(profile, &keys[4]) == NULL);
+
+    lai_metadata_profile_set_change_handler(profile, lai_test_profile_changed);
+
+    /* unchanged profile notifies nothing */
+
+    TEST_ASSERT(lai_metadata_profile_reload(profile) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_test_profile_host.notified == 0 && profile->version == version);
+
+    lai_test_profile_host.values[0] = "43";
+    lai_test_profile_host.values[3] = NULL;
+    lai_test_profile_host.values[4] = "added";
+
+    TEST_ASSERT(lai_metadata_profile_reload(profile) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_test_profile_host.notified == 3 && lai_test_profile_host.errors == 0);
+    TEST_ASSERT(profile->version == version + 1 && profile->count == 4);
+    TEST_ASSERT(lai_metadata_profile_get_int(profile, &keys[0], 0) == 43);
+    TEST_ASSERT(!lai_metadata_profile_get_bool(profile, &keys[3], false));
+    TEST_ASSERT(strcmp(lai_metadata_profile_get_string(profile, &keys[4], ""), "added") == 0);
+
+    return true;
+}
+
+static void* lai_test_profile_thread(
+        _In_ void *arg)
+{
+    const lai_metadata_profile_t *profile = (const lai_metadata_profile_t*)arg;
+    lai_metadata_profile_key_t key;
+    uintptr_t failures = 0;
+    size_t lookup;
+
+    for (lookup = 0; lookup < TEST_PROFILE_LOOKUPS; lookup++)
+    {
+        lai_metadata_profile_key_init(&key, lai_test_profile_names[lookup % TEST_PROFILE_VARIABLES]);
+
+        switch (lookup % TEST_PROFILE_VARIABLES)
+        {
+            case 0:
+                failures += (lai_metadata_profile_get_int(profile, &key, 0) != 42);
+                break;
+
+            case 1:
+                failures += (lai_metadata_profile_get_int(profile, &key, 0) != 16);
+                break;
+
+            case 3:
+                failures += !lai_metadata_profile_get_bool(profile, &key, false);
+                break;
+
+            case 4:
+                failures += (lai_metadata_profile_get(profile, &key) != NULL);
+                break;
+
+            default:
+                failures += (lai_metadata_profile_get(profile, &key) == NULL);
+                break;
+        }
+    }
+
+    return (void*)failures;
+}
+
+static bool lai_test_profile_lazy(
+        _Inout_ lai_metadata_profile_t *profile)
+{
+    pthread_t threads[TEST_THREADS];
+    void *failures;
+    uint64_t version = profile->version;
+    size_t idx;
+
+    TEST_ASSERT(lai_test_profile_host.asked == 0);
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        TEST_ASSERT(pthread_create(&threads[idx], NULL, lai_test_profile_thread, profile) == 0);
+    }
+
+    for (idx = 0; idx < TEST_THREADS; idx++)
+    {
+        pthread_join(threads[idx], &failures);
+
+        TEST_ASSERT(failures == NULL);
+    }
+
+    /* missing variable is cached too */
+
+    TEST_ASSERT(lai_test_profile_host.asked == TEST_PROFILE_VARIABLES);
+
+    lai_metadata_profile_set_change_handler(profile, lai_test_profile_changed);
+
+    lai_test_profile_host.values[0] = "43";
+
+    TEST_ASSERT(lai_metadata_profile_reload(profile) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_test_profile_host.asked == 2 * TEST_PROFILE_VARIABLES);
+    TEST_ASSERT(lai_test_profile_host.notified == 1 && lai_test_profile_host.errors == 0);
+    TEST_ASSERT(profile->version == version + 1);
+
+    return true;
+}
+
+static bool lai_test_profile(void)
+{
+    lai_service_method_table_t services;
+    lai_metadata_profile_t profile;
+    bool passed;
+
+    lai_test_profile_reset();
+
+    services.profile_get_value = lai_test_profile_get_value;
+    services.profile_get_next_value = lai_test_profile_get_next_value;
+
+    TEST_ASSERT(lai_metadata_profile_load(&profile, TEST_PROFILE_ID, &services) == LAI_STATUS_SUCCESS);
+
+    passed = lai_test_profile_reload(&profile);
+
+    lai_metadata_profile_free(&profile);
+
+    TEST_ASSERT(passed);
+
+    lai_test_profile_reset();
+
+    services.profile_get_next_value = NULL;
+
+    TEST_ASSERT(lai_metadata_profile_load(&profile, TEST_PROFILE_ID, &services) == LAI_STATUS_SUCCESS);
+
+    passed = lai_test_profile_lazy(&profile);
+
+    lai_metadata_profile_free(&profile);
+
+    return passed;
+}
+
+/*
+ * Performance monitoring bins: counters read cumulatively accumulate
+ * differences and count from zero after reset, ring keeps history + 1
+ * bins with skipped intervals as empty bins, and gauges skip NaN samples
+ * in min, max, average and last value.
+ */
+
+#define TEST_PM_OBJECTS     3
+#define TEST_PM_STEPS       5
+
+static bool lai_test_pm_total(
+        _In_ const lai_metadata_pm_bins_t *bins,
+        _In_ size_t bin,
+        _In_ uint64_t start_time,
+        _In_ uint64_t samples,
+        _In_ const uint64_t *totals)
+{
+    lai_metadata_pm_value_t value;
+    size_t idx;
+
+    for (idx = 0; idx < TEST_PM_OBJECTS; idx++)
+    {
+        TEST_ASSERT(lai_metadata_pm_bins_get(bins, bin, idx, 0, &value) == LAI_STATUS_SUCCESS);
+        TEST_ASSERT(value.start_time == start_time);
+        TEST_ASSERT(value.samples == samples);
+        TEST_ASSERT(value.total == (samples ? totals[idx] : 0));
+    }
+
+    return true;
+}
+
+static bool lai_test_pm_counters(
+        _Inout_ lai_metadata_pm_bins_t *bins)
+{
+    static const uint64_t timestamps[TEST_PM_STEPS] = { 100, 105, 110, 130, 1000 };
+
+    static const uint64_t raw[TEST_PM_STEPS][TEST_PM_OBJECTS] = {
+        { 100, 5, UINT64_MAX - 1 },
+        { 150, 2, 3 },
+        { 160, 4, 4 },
+        { 170, 6, 5 },
+        { 175, 1, 9 },
+    };
+
+    /* first sample has no previous value, object 1 is reset at 105 and 1000, object 2 at 105 */
+
+    static const uint64_t first[TEST_PM_OBJECTS] = { 50, 2, 3 };
+    static const uint64_t second[TEST_PM_OBJECTS] = { 10, 2, 1 };
+    static const uint64_t last[TEST_PM_OBJECTS] = { 5, 1, 4 };
+
+    lai_stat_value_t counters[TEST_PM_OBJECTS];
+    lai_metadata_pm_value_t value;
+    size_t step;
+    size_t idx;
+
+    for (step = 0; step < TEST_PM_STEPS; step++)
+    {
+        for (idx = 0; idx < TEST_PM_OBJECTS; idx++)
+        {
+            counters[idx].u64 = raw[step][idx];
+        }
+
+        TEST_ASSERT(lai_metadata_pm_bins_update(bins, timestamps[step], counters) == LAI_STATUS_SUCCESS);
+
+        if (step == 1)
+        {
+            TEST_ASSERT(lai_test_pm_total(bins, 0, 100, 2, first));
+            TEST_ASSERT(lai_metadata_pm_bins_get(bins, 1, 0, 0, &value) == LAI_STATUS_ITEM_NOT_FOUND);
+        }
+
+        if (step == 3)
+        {
+            /* ring of 3 bins keeps 130, empty 120 and 110, bin 100 is overwritten */
+
+            TEST_ASSERT(lai_test_pm_total(bins, 0, 130, 1, second));
+            TEST_ASSERT(lai_test_pm_total(bins, 1, 120, 0, second));
+            TEST_ASSERT(lai_test_pm_total(bins, 2, 110, 1, second));
+            TEST_ASSERT(lai_metadata_pm_bins_get(bins, 3, 0, 0, &value) == LAI_STATUS_ITEM_NOT_FOUND);
+        }
+    }
+
+    /* long gap leaves only empty bins behind current one */
+
+    TEST_ASSERT(lai_test_pm_total(bins, 0, 1000, 1, last));
+    TEST_ASSERT(lai_test_pm_total(bins, 1, 990, 0, last));
+    TEST_ASSERT(lai_test_pm_total(bins, 2, 980, 0, last));
+    TEST_ASSERT(lai_metadata_pm_bins_update(bins, 995, counters) == LAI_STATUS_INVALID_PARAMETER);
+
+    return true;
+}
+
+static bool lai_test_pm_gauges(
+        _Inout_ lai_metadata_pm_bins_t *bins)
+{
+    /* values below -99 stand for NaN samples */
+
+    static const double raw[3][TEST_PM_OBJECTS] = {
+        { 1.0, -100.0, 5.0 },
+        { 3.0, -100.0, -100.0 },
+        { -100.0, -100.0, -1.0 },
+    };
+
+    lai_stat_value_t gauges[TEST_PM_OBJECTS];
+    lai_metadata_pm_value_t value;
+    uint64_t step;
+    size_t idx;
+
+    for (step = 0; step < 3; step++)
+    {
+        for (idx = 0; idx < TEST_PM_OBJECTS; idx++)
+        {
+            gauges[idx].d64 = raw[step][idx] < -99.0 ? __builtin_nan("") : raw[step][idx];
+        }
+
+        TEST_ASSERT(lai_metadata_pm_bins_update(bins, step, gauges) == LAI_STATUS_SUCCESS);
+    }
+
+    TEST_ASSERT(lai_metadata_pm_bins_get(bins, 0, 0, 0, &value) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(value.samples == 2);
+    TEST_ASSERT(value.min > 0.99 && value.min < 1.01);
+    TEST_ASSERT(value.max > 2.99 && value.max < 3.01);
+    TEST_ASSERT(value.avg > 1.99 && value.avg < 2.01);
+    TEST_ASSERT(value.last > 2.99 && value.last < 3.01);
+
+    TEST_ASSERT(lai_metadata_pm_bins_get(bins, 0, 1, 0, &value) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(value.samples == 0);
+    TEST_ASSERT(__builtin_isnan(value.min) && __builtin_isnan(value.max));
+    TEST_ASSERT(__builtin_isnan(value.avg) && __builtin_isnan(value.last));
+
+    TEST_ASSERT(lai_metadata_pm_bins_get(bins, 0, 2, 0, &value) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(value.samples == 2);
+    TEST_ASSERT(value.min > -1.01 && value.min < -0.99);
+    TEST_ASSERT(value.max > 4.99 && value.max < 5.01);
+    TEST_ASSERT(value.avg > 1.99 && value.avg < 2.01);
+    TEST_ASSERT(value.last > -1.01 && value.last < -0.99);
+
+    return true;
+}
+
+static bool lai_test_pm(void)
+{
+    const lai_stat_id_t counter_id = LAI_ETHERNET_STAT_IN_MAC_CONTROL_FRAMES;
+    const lai_stat_id_t gauge_id = LAI_OA_STAT_ACTUAL_GAIN;
+    lai_metadata_pm_bins_t bins;
+    bool passed;
+
+    TEST_ASSERT(lai_metadata_pm_bins_init(&bins, LAI_OBJECT_TYPE_ETHERNET, TEST_PM_OBJECTS, 1, &counter_id,
+                10, 2, LAI_STATS_MODE_READ) == LAI_STATUS_SUCCESS);
+
+    passed = lai_test_pm_counters(&bins);
+
+    lai_metadata_pm_bins_free(&bins);
+
+    TEST_ASSERT(passed);
+    TEST_ASSERT(lai_metadata_pm_bins_init(&bins, LAI_OBJECT_TYPE_OA, TEST_PM_OBJECTS, 1, &gauge_id,
+                10, 0, LAI_STATS_MODE_READ) == LAI_STATUS_SUCCESS);
+
+    passed = lai_test_pm_gauges(&bins);
+
+    lai_metadata_pm_bins_free(&bins);
+
+    return passed;
+}
+
+/*
+ * Threshold crossing: low gain threshold with hysteresis is raised below
+ * threshold, kept within hysteresis and cleared above it, threshold
+ * without hysteresis clears as soon as value is back, low thresholds are
+ * reported positive and NaN sample keeps state.
+ */
+
+#define TEST_TCA_STEPS      6
+
+static bool lai_test_tca_load(
+        _Inout_ lai_metadata_tca_t *tca)
+{
+    lai_attribute_t attrs[2];
+
+    attrs[0].id = LAI_OA_ATTR_GAIN_LOW_THRESHOLD;
+    attrs[0].value.d64 = 10.0;
+    attrs[1].id = LAI_OA_ATTR_GAIN_LOW_HYSTERESIS;
+    attrs[1].value.d64 = 1.0;
+
+    TEST_ASSERT(lai_metadata_tca_load_thresholds(tca, 0, 2, attrs) == LAI_STATUS_SUCCESS);
+
+    attrs[0].value.d64 = 5.0;
+
+    TEST_ASSERT(lai_metadata_tca_load_thresholds(tca, 1, 1, attrs) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(tca->rule_count == 2);
+
+    return true;
+}
+
+static bool lai_test_tca(void)
+{
+    static const double gains[TEST_TCA_STEPS][2] = {
+        { 12.0, 6.0 },
+        { 9.5, 4.0 },
+        { 10.5, 5.5 },
+        { -1.0, 4.0 },
+        { 11.5, 5.5 },
+        { 10.5, 5.5 },
+    };
+
+    /* expected state of objects after every step, 1 raised */
+
+    static const int raised[TEST_TCA_STEPS][2] = {
+        { 0, 0 },
+        { 1, 1 },
+        { 1, 0 },
+        { 1, 1 },
+        { 0, 0 },
+        { 0, 0 },
+    };
+
+    const lai_stat_id_t counter_id = LAI_OA_STAT_ACTUAL_GAIN;
+    lai_metadata_tca_crossing_t crossings[2];
+    lai_stat_value_t counters[2];
+    lai_metadata_tca_t tca;
+    size_t count;
+    size_t step;
+    size_t idx;
+    int was[2] = { 0, 0 };
+
+    TEST_ASSERT(lai_metadata_tca_init(&tca, LAI_OBJECT_TYPE_OA, 2, 1, &counter_id) == LAI_STATUS_SUCCESS);
+
+    if (!lai_test_tca_load(&tca))
+    {
+        lai_metadata_tca_free(&tca);
+        return false;
+    }
+
+    for (step = 0; step < TEST_TCA_STEPS; step++)
+    {
+        for (idx = 0; idx < 2; idx++)
+        {
+            counters[idx].d64 = (gains[step][idx] < 0.0) ? __builtin_nan("") : gains[step][idx];
+        }
+
+        /* reload keeps raised state */
+
+        TEST_ASSERT(step != 2 || lai_test_tca_load(&tca));
+        TEST_ASSERT(lai_metadata_tca_evaluate(&tca, counters, crossings, &count) == LAI_STATUS_SUCCESS);
+
+        TEST_ASSERT(count == (size_t)(raised[step][0] != was[0]) + (size_t)(raised[step][1] != was[1]));
+
+        for (idx = 0; idx < count; idx++)
+        {
+            size_t object = crossings[idx].object_index;
+
+            TEST_ASSERT(object < 2 && raised[step][object] != was[object]);
+            TEST_ASSERT(crossings[idx].raised == (raised[step][object] != 0));
+            TEST_ASSERT(crossings[idx].info->threshold_attr_id == LAI_OA_ATTR_GAIN_LOW_THRESHOLD);
+            TEST_ASSERT(crossings[idx].threshold > (object ? 4.99 : 9.99) && crossings[idx].threshold < (object ? 5.01 : 10.01));
+            TEST_ASSERT(crossings[idx].value > gains[step][object] - 0.01 && crossings[idx].value < gains[step][object] + 0.01);
+        }
+
+        was[0] = raised[step][0];
+        was[1] = raised[step][1];
+    }
+
+    lai_metadata_tca_free(&tca);
+
+    return true;
+}
+
+static const lai_test_t lai_tests[] = {
+    { "fixed_point", lai_test_fixed_point },
+    { "instrument", lai_test_instrument },
+    { "logger_deferred", lai_test_logger_deferred },
+    { "mediachannel", lai_test_mediachannel },
+    { "object_id", lai_test_object_id },
+    { "otdr_compare", lai_test_otdr_compare },
+    { "otdr_trace", lai_test_otdr_trace },
+    { "pm", lai_test_pm },
+    { "profile", lai_test_profile },
+    { "reconcile_recreate", lai_test_reconcile_recreate },
+    { "spectrum", lai_test_spectrum },
+    { "spectrum_history", lai_test_spectrum_history },
+    { "static_cache", lai_test_static_cache },
+    { "tca", lai_test_tca },
+    { "upgrade", lai_test_upgrade },
+};
+
+int main(
+        int argc,
+        char **argv)
+{
+    size_t idx;
+    int arg;
+    int failed = 0;
+    bool selected;
+
+    for (idx = 0; idx < sizeof(lai_tests) / sizeof(lai_tests[0]); idx++)
+    {
+        selected = (argc < 2);
+
+        for (arg = 1; arg < argc; arg++)
+        {
+            selected = selected || strcmp(argv[arg], lai_tests[idx].name) == 0;
+        }
+
+        if (!selected)
+        {
+            continue;
+        }
+
+        if (lai_tests[idx].fn())
+        {
+            printf("PASS %s\n", lai_tests[idx].name);
+        }
+        else
+        {
+            printf("FAIL %s\n", lai_tests[idx].name);
+            failed++;
+        }
+    }
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1012,6 +1012,14 @@ typedef struct _lai_attr_metadata_t
      */
     bool                                        isrecoverable;
 
+    /**
+     * @brief Indicates whether attribute is static.
+     *
+     * If true, read only value changes only when hardware module is replaced,
+     * so host can serve get from cache until module is plugged out or in.
+     */
+    bool                                        isstatic;
+
 } lai_attr_metadata_t;
 
 /*
@@ -0,0 +1,907 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataupgrade.c
+ *
+ * @brief   This module implements LAI Metadata Upgrade Orchestrator
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <lai.h>
+#include "laimetadataupgrade.h"
+#include "laimetadata.h"
+
+/*
+ * Notification may come before started request id is stored, so notify
+ * keeps the last completed request of unit and tick matches it against
+ * running request. Lock protects only these fields, adapter is never
+ * called with lock held.
+ */
+
+typedef struct _lai_metadata_upgrade_step_t
+{
+    /* running request, valid while waiting */
+
+    lai_request_id_t request;
+
+    bool waiting;
+
+    /* status of finished step */
+
+    lai_status_t result;
+
+    /* written by notify */
+
+    lai_request_id_t completed;
+
+    lai_status_t completed_status;
+
+    lai_uint8_t progress;
+
+    /* last read of upgrade state */
+
+    uint64_t polled;
+
+    bool commit_started;
+
+} lai_metadata_upgrade_step_t;
+
+typedef struct _lai_metadata_upgrade_index_t
+{
+    lai_object_id_t object_id;
+
+    size_t index;
+
+} lai_metadata_upgrade_index_t;
+
+typedef struct _lai_metadata_upgrade_internal_t
+{
+    pthread_mutex_t lock;
+
+    lai_metadata_upgrade_set_async_fn set_async;
+
+    lai_metadata_upgrade_step_t *steps;
+
+    /* units sorted by object id */
+
+    lai_metadata_upgrade_index_t *index;
+
+} lai_metadata_upgrade_internal_t;
+
+static int lai_metadata_upgrade_index_cmp(
+        _In_ const void *lhs,
+        _In_ const void *rhs)
+{
+    lai_object_id_t l = ((const lai_metadata_upgrade_index_t*)lhs)->object_id;
+    lai_object_id_t r = ((const lai_metadata_upgrade_index_t*)rhs)->object_id;
+
+    return (l > r) - (l < r);
+}
+
+static size_t lai_metadata_upgrade_find(
+        _In_ const lai_metadata_upgrade_t *upgrade,
+        _In_ lai_object_id_t object_id)
+{
+    const lai_metadata_upgrade_internal_t *internal = (const lai_metadata_upgrade_internal_t*)upgrade->state;
+    size_t lo = 0;
+    size_t hi = upgrade->count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (internal->index[mid].object_id < object_id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    if (lo < upgrade->count && internal->index[lo].object_id == object_id)
+    {
+        return internal->index[lo].index;
+    }
+
+    return upgrade->count;
+}
+
+static bool lai_metadata_upgrade_is_finished(
+        _In_ lai_metadata_upgrade_state_t state)
+{
+    return state == LAI_METADATA_UPGRADE_STATE_DONE ||
+        state == LAI_METADATA_UPGRADE_STATE_FAILED ||
+        state == LAI_METADATA_UPGRADE_STATE_ROLLED_BACK;
+}
+
+static lai_status_t lai_metadata_upgrade_set(
+        _In_ const lai_metadata_upgrade_unit_t *unit,
+        _In_ const lai_attribute_t *attr)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(unit->object_type);
+    lai_object_meta_key_t meta_key;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = unit->object_type;
+    meta_key.objectkey.key.object_id = unit->object_id;
+
+    return info->set(&meta_key, attr);
+}
+
+static lai_status_t lai_metadata_upgrade_set_bool(
+        _In_ const lai_metadata_upgrade_unit_t *unit,
+        _In_ lai_attr_id_t attr_id)
+{
+    lai_attribute_t attr;
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.id = attr_id;
+    attr.value.booldata = true;
+
+    return lai_metadata_upgrade_set(unit, &attr);
+}
+
+static lai_status_t lai_metadata_upgrade_set_string(
+        _In_ const lai_metadata_upgrade_unit_t *unit,
+        _In_ lai_attr_id_t attr_id,
+        _In_ const char *value)
+{
+    lai_attribute_t attr;
+
+    if (value == NULL)
+    {
+        return LAI_STATUS_SUCCESS;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.id = attr_id;
+
+    strncpy(attr.value.chardata, value, sizeof(attr.value.chardata) - 1);
+
+    return lai_metadata_upgrade_set(unit, &attr);
+}
+
+static lai_status_t lai_metadata_upgrade_get_state(
+        _In_ const lai_metadata_upgrade_unit_t *unit,
+        _Out_ int32_t *state)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(unit->object_type);
+    lai_object_meta_key_t meta_key;
+    lai_attribute_t attr;
+    lai_status_t status;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+    memset(&attr, 0, sizeof(attr));
+
+    meta_key.objecttype = unit->object_type;
+    meta_key.objectkey.key.object_id = unit->object_id;
+
+    attr.id = unit->object_type == LAI_OBJECT_TYPE_LINECARD ?
+        (lai_attr_id_t)LAI_LINECARD_ATTR_UPGRADE_STATE : (lai_attr_id_t)LAI_TRANSCEIVER_ATTR_UPGRADE_STATE;
+
+    status = info->get(&meta_key, 1, &attr);
+
+    *state = attr.value.s32;
+
+    return status;
+}
+
+/*
+ * Starts step, step started by plain set is finished at once.
+ */
+
+static lai_status_t lai_metadata_upgrade_request(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ size_t idx,
+        _In_ lai_attr_id_t attr_id,
+        _In_ lai_metadata_upgrade_state_t next,
+        _In_ uint64_t now)
+{
+    lai_metadata_upgrade_internal_t *internal = (lai_metadata_upgrade_internal_t*)upgrade->state;
+    lai_metadata_upgrade_unit_t *unit = &upgrade->units[idx];
+    lai_metadata_upgrade_step_t *step = &internal->steps[idx];
+    lai_request_id_t request = 0;
+    lai_attribute_t attr;
+    lai_status_t status;
+
+    memset(&attr, 0, sizeof(attr));
+
+    attr.id = attr_id;
+    attr.value.booldata = true;
+
+    if (internal->set_async != NULL)
+    {
+        status = internal->set_async(unit->object_type, unit->object_id, &attr, &request);
+    }
+    else
+    {
+        status = lai_metadata_upgrade_set(unit, &attr);
+    }
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    pthread_mutex_lock(&internal->lock);
+
+    step->request = request;
+    step->waiting = internal->set_async != NULL;
+    step->result = LAI_STATUS_SUCCESS;
+    step->progress = 0;
+
+    pthread_mutex_unlock(&internal->lock);
+
+    step->polled = 0;
+
+    unit->state = next;
+    unit->progress = 0;
+    unit->started = now;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static void lai_metadata_upgrade_finish(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ size_t idx,
+        _In_ lai_metadata_upgrade_state_t state)
+{
+    lai_metadata_upgrade_unit_t *unit = &upgrade->units[idx];
+
+    if (state == LAI_METADATA_UPGRADE_STATE_DONE)
+    {
+        unit->progress = 100;
+    }
+
+    unit->state = state;
+
+    upgrade->active--;
+}
+
+/*
+ * Linecard with started commit is rolled back when configured, failure
+ * of rollback itself only fails unit.
+ */
+
+static void lai_metadata_upgrade_fail(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ size_t idx,
+        _In_ lai_status_t status,
+        _In_ uint64_t now)
+{
+    lai_metadata_upgrade_internal_t *internal = (lai_metadata_upgrade_internal_t*)upgrade->state;
+    lai_metadata_upgrade_unit_t *unit = &upgrade->units[idx];
+
+    LAI_META_LOG_ERROR("upgrade of 0x%llx failed in state %d: %d", (unsigned long long)unit->object_id, unit->state, status);
+
+    if (unit->status == LAI_STATUS_SUCCESS)
+    {
+        unit->status = status;
+    }
+
+    if (internal->steps[idx].commit_started && upgrade->config.rollback &&
+            unit->state != LAI_METADATA_UPGRADE_STATE_ROLLING_BACK &&
+            lai_metadata_upgrade_request(upgrade, idx, LAI_LINECARD_ATTR_UPGRADE_ROLLBACK,
+                LAI_METADATA_UPGRADE_STATE_ROLLING_BACK, now) == LAI_STATUS_SUCCESS)
+    {
+        return;
+    }
+
+    lai_metadata_upgrade_finish(upgrade, idx, LAI_METADATA_UPGRADE_STATE_FAILED);
+}
+
+static void lai_metadata_upgrade_start(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ size_t idx,
+        _In_ uint64_t now)
+{
+    const lai_metadata_upgrade_config_t *config = &upgrade->config;
+    lai_metadata_upgrade_unit_t *unit = &upgrade->units[idx];
+    lai_attribute_t attr;
+    lai_status_t status = LAI_STATUS_SUCCESS;
+
+    upgrade->active++;
+
+    unit->started = now;
+
+    if (unit->object_type == LAI_OBJECT_TYPE_LINECARD)
+    {
+        if (config->host_ip != 0)
+        {
+            memset(&attr, 0, sizeof(attr));
+
+            attr.id = LAI_LINECARD_ATTR_HOST_IP;
+            attr.value.u32 = config->host_ip;
+
+            status = lai_metadata_upgrade_set(unit, &attr);
+        }
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            status = lai_metadata_upgrade_set_string(unit, LAI_LINECARD_ATTR_USER_NAME, config->user_name);
+        }
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            status = lai_metadata_upgrade_set_string(unit, LAI_LINECARD_ATTR_USER_PASSWORD, config->user_password);
+        }
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            status = lai_metadata_upgrade_set_string(unit, LAI_LINECARD_ATTR_UPGRADE_FILE_NAME, config->file_name);
+        }
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            status = lai_metadata_upgrade_set_string(unit, LAI_LINECARD_ATTR_UPGRADE_FILE_PATH, config->file_path);
+        }
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            status = lai_metadata_upgrade_request(upgrade, idx, LAI_LINECARD_ATTR_UPGRADE_DOWNLOAD,
+                    LAI_METADATA_UPGRADE_STATE_DOWNLOADING, now);
+        }
+    }
+    else
+    {
+        status = lai_metadata_upgrade_request(upgrade, idx, LAI_TRANSCEIVER_ATTR_UPGRADE_DOWNLOAD,
+                LAI_METADATA_UPGRADE_STATE_DOWNLOADING, now);
+    }
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        lai_metadata_upgrade_fail(upgrade, idx, status, now);
+    }
+}
+
+/*
+ * Returns true when running request is completed, notified progress is
+ * copied to unit meanwhile.
+ */
+
+static bool lai_metadata_upgrade_completed(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ size_t idx)
+{
+    lai_metadata_upgrade_internal_t *internal = (lai_metadata_upgrade_internal_t*)upgrade->state;
+    lai_metadata_upgrade_step_t *step = &internal->steps[idx];
+    bool completed;
+
+    pthread_mutex_lock(&internal->lock);
+
+    if (step->waiting && step->completed == step->request)
+    {
+        step->waiting = false;
+        step->result = step->completed_status;
+    }
+
+    completed = !step->waiting;
+
+    upgrade->units[idx].progress = step->progress;
+
+    pthread_mutex_unlock(&internal->lock);
+
+    return completed;
+}
+
+static void lai_metadata_upgrade_commit_state(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ size_t idx,
+        _In_ int32_t state,
+        _In_ uint64_t now)
+{
+    lai_metadata_upgrade_unit_t *unit = &upgrade->units[idx];
+    lai_status_t status;
+
+    switch (state)
+    {
+        case LAI_LINECARD_UPGRADE_STATE_COMMITING:
+
+            if (!upgrade->paused)
+            {
+                unit->state = LAI_METADATA_UPGRADE_STATE_COMMITTING;
+            }
+            break;
+
+        case LAI_LINECARD_UPGRADE_STATE_COMMIT_PAUSE:
+            unit->state = LAI_METADATA_UPGRADE_STATE_PAUSED;
+            break;
+
+        case LAI_LINECARD_UPGRADE_STATE_ROLLBACKING:
+            unit->state = LAI_METADATA_UPGRADE_STATE_ROLLING_BACK;
+            break;
+
+        case LAI_LINECARD_UPGRADE_STATE_COMMIT_ERROR:
+        case LAI_LINECARD_UPGRADE_STATE_COMMIT_STOP:
+        case LAI_LINECARD_UPGRADE_STATE_REBOOT_ERROR:
+            lai_metadata_upgrade_fail(upgrade, idx, LAI_STATUS_FAILURE, now);
+            break;
+
+        default:
+
+            if (!upgrade->config.reboot)
+            {
+                lai_metadata_upgrade_finish(upgrade, idx, LAI_METADATA_UPGRADE_STATE_DONE);
+                break;
+            }
+
+            status = lai_metadata_upgrade_request(upgrade, idx, LAI_LINECARD_ATTR_UPGRADE_REBOOT,
+                    LAI_METADATA_UPGRADE_STATE_REBOOTING, now);
+
+            if (status != LAI_STATUS_SUCCESS)
+            {
+                lai_metadata_upgrade_fail(upgrade, idx, status, now);
+            }
+            break;
+    }
+}
+
+static void lai_metadata_upgrade_advance(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ size_t idx,
+        _In_ uint64_t now)
+{
+    lai_metadata_upgrade_internal_t *internal = (lai_metadata_upgrade_internal_t*)upgrade->state;
+    lai_metadata_upgrade_unit_t *unit = &upgrade->units[idx];
+    lai_metadata_upgrade_step_t *step = &internal->steps[idx];
+    int32_t state = 0;
+    lai_status_t status;
+
+    if (!lai_metadata_upgrade_completed(upgrade, idx) || step->result != LAI_STATUS_SUCCESS)
+    {
+        if (step->waiting && (upgrade->config.timeout == 0 || now - unit->started <= upgrade->config.timeout))
+        {
+            return;
+        }
+
+        step->waiting = false;
+
+        lai_metadata_upgrade_fail(upgrade, idx, step->result != LAI_STATUS_SUCCESS ? step->result : LAI_STATUS_FAILURE, now);
+        return;
+    }
+
+    /* linecard download finishes with its request, commit follows unless paused */
+
+    if (unit->state == LAI_METADATA_UPGRADE_STATE_DOWNLOADING && unit->object_type == LAI_OBJECT_TYPE_LINECARD)
+    {
+        if (upgrade->paused)
+        {
+            return;
+        }
+
+        status = lai_metadata_upgrade_request(upgrade, idx, LAI_LINECARD_ATTR_UPGRADE_COMMIT,
+                LAI_METADATA_UPGRADE_STATE_COMMITTING, now);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            lai_metadata_upgrade_fail(upgrade, idx, status, now);
+            return;
+        }
+
+        step->commit_started = true;
+
+        return;
+    }
+
+    if (step->polled != 0 && now - step->polled < upgrade->config.poll_interval)
+    {
+        return;
+    }
+
+    step->polled = now != 0 ? now : 1;
+
+    status = lai_metadata_upgrade_get_state(unit, &state);
+
+    if (status != LAI_STATUS_SUCCESS && unit->state != LAI_METADATA_UPGRADE_STATE_REBOOTING &&
+            unit->state != LAI_METADATA_UPGRADE_STATE_ROLLING_BACK)
+    {
+        lai_metadata_upgrade_fail(upgrade, idx, status, now);
+        return;
+    }
+
+    /* linecard is unreachable while rebooting, unchanged state is waited for until timeout */
+
+    if (status != LAI_STATUS_SUCCESS ||
+            (unit->object_type == LAI_OBJECT_TYPE_TRANSCEIVER && state != LAI_TRANSCEIVER_UPGRADE_STATE_IDLE) ||
+            (unit->state == LAI_METADATA_UPGRADE_STATE_REBOOTING && state == LAI_LINECARD_UPGRADE_STATE_REBOOTING) ||
+            (unit->state == LAI_METADATA_UPGRADE_STATE_ROLLING_BACK && state == LAI_LINECARD_UPGRADE_STATE_ROLLBACKING))
+    {
+        if (upgrade->config.timeout != 0 && now - unit->started > upgrade->config.timeout)
+        {
+            lai_metadata_upgrade_fail(upgrade, idx, LAI_STATUS_FAILURE, now);
+        }
+
+        return;
+    }
+
+    switch (unit->state)
+    {
+        case LAI_METADATA_UPGRADE_STATE_DOWNLOADING:
+            lai_metadata_upgrade_finish(upgrade, idx, LAI_METADATA_UPGRADE_STATE_DONE);
+            break;
+
+        case LAI_METADATA_UPGRADE_STATE_COMMITTING:
+        case LAI_METADATA_UPGRADE_STATE_PAUSED:
+
+            lai_metadata_upgrade_commit_state(upgrade, idx, state, now);
+
+            if (unit->state == LAI_METADATA_UPGRADE_STATE_COMMITTING && upgrade->config.timeout != 0 &&
+                    now - unit->started > upgrade->config.timeout)
+            {
+                lai_metadata_upgrade_fail(upgrade, idx, LAI_STATUS_FAILURE, now);
+            }
+            break;
+
+        case LAI_METADATA_UPGRADE_STATE_REBOOTING:
+
+            if (state == LAI_LINECARD_UPGRADE_STATE_REBOOT_ERROR)
+            {
+                lai_metadata_upgrade_fail(upgrade, idx, LAI_STATUS_FAILURE, now);
+            }
+            else
+            {
+                lai_metadata_upgrade_finish(upgrade, idx, LAI_METADATA_UPGRADE_STATE_DONE);
+            }
+            break;
+
+        case LAI_METADATA_UPGRADE_STATE_ROLLING_BACK:
+            lai_metadata_upgrade_finish(upgrade, idx, LAI_METADATA_UPGRADE_STATE_ROLLED_BACK);
+            break;
+
+        default:
+            break;
+    }
+}
+
+lai_status_t lai_metadata_upgrade_init(
+        _Out_ lai_metadata_upgrade_t *upgrade,
+        _In_ const lai_metadata_upgrade_config_t *config,
+        _In_ size_t count,
+        _In_ const lai_object_meta_key_t *objects,
+        _In_ lai_metadata_upgrade_set_async_fn set_async)
+{
+    lai_metadata_upgrade_internal_t *internal;
+    size_t idx;
+
+    if (upgrade == NULL || config == NULL || (count != 0 && objects == NULL))
+    {
+        LAI_META_LOG_ERROR("invalid parameter: upgrade, config or objects");
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(upgrade, 0, sizeof(*upgrade));
+
+    for (idx = 0; idx < count; idx++)
+    {
+        if (objects[idx].objecttype != LAI_OBJECT_TYPE_LINECARD && objects[idx].objecttype != LAI_OBJECT_TYPE_TRANSCEIVER)
+        {
+            LAI_META_LOG_ERROR("object %zu is not linecard or transceiver", idx);
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    internal = (lai_metadata_upgrade_internal_t*)calloc(1, sizeof(lai_metadata_upgrade_internal_t));
+
+    if (internal == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    internal->set_async = set_async;
+    internal->steps = (lai_metadata_upgrade_step_t*)calloc(count + 1, sizeof(lai_metadata_upgrade_step_t));
+    internal->index = (lai_metadata_upgrade_index_t*)calloc(count + 1, sizeof(lai_metadata_upgrade_index_t));
+    upgrade->units = (lai_metadata_upgrade_unit_t*)calloc(count + 1, sizeof(lai_metadata_upgrade_unit_t));
+
+    if (internal->steps == NULL || internal->index == NULL || upgrade->units == NULL)
+    {
+        free(internal->steps);
+        free(internal->index);
+        free(internal);
+        free(upgrade->units);
+
+        upgrade->units = NULL;
+
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    for (idx = 0; idx < count; idx++)
+    {
+        upgrade->units[idx].object_type = objects[idx].objecttype;
+        upgrade->units[idx].object_id = objects[idx].objectkey.key.object_id;
+
+        internal->index[idx].object_id = objects[idx].objectkey.key.object_id;
+        internal->index[idx].index = idx;
+    }
+
+    qsort(internal->index, count, sizeof(lai_metadata_upgrade_index_t), lai_metadata_upgrade_index_cmp);
+
+    for (idx = 1; idx < count; idx++)
+    {
+        if (internal->index[idx].object_id == internal->index[idx - 1].object_id)
+        {
+            LAI_META_LOG_ERROR("object 0x%llx is upgraded twice", (unsigned long long)internal->index[idx].object_id);
+
+            free(internal->steps);
+            free(internal->index);
+            free(internal);
+            free(upgrade->units);
+
+            upgrade->units = NULL;
+
+            return LAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    pthread_mutex_init(&internal->lock, NULL);
+
+    upgrade->config = *config;
+    upgrade->count = count;
+    upgrade->state = internal;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void lai_metadata_upgrade_free(
+        _Inout_ lai_metadata_upgrade_t *upgrade)
+{
+    lai_metadata_upgrade_internal_t *internal;
+
+    if (upgrade == NULL)
+    {
+        return;
+    }
+
+    internal = (lai_metadata_upgrade_internal_t*)upgrade->state;
+
+    if (internal != NULL)
+    {
+        pthread_mutex_destroy(&internal->lock);
+
+        free(internal->steps);
+        free(internal->index);
+        free(internal);
+    }
+
+    free(upgrade->units);
+
+    memset(upgrade, 0, sizeof(*upgrade));
+}
+
+void lai_metadata_upgrade_notify(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ lai_request_id_t request_id,
+        _In_ lai_object_id_t object_id,
+        _In_ bool completed,
+        _In_ lai_status_t status,
+        _In_ lai_uint8_t progress)
+{
+    lai_metadata_upgrade_internal_t *internal;
+    size_t idx;
+
+    if (upgrade == NULL || upgrade->state == NULL)
+    {
+        return;
+    }
+
+    internal = (lai_metadata_upgrade_internal_t*)upgrade->state;
+
+    idx = lai_metadata_upgrade_find(upgrade, object_id);
+
+    if (idx == upgrade->count)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&internal->lock);
+
+    if (completed)
+    {
+        internal->steps[idx].completed = request_id;
+        internal->steps[idx].completed_status = status;
+    }
+
+    if (!internal->steps[idx].waiting || internal->steps[idx].request == request_id)
+    {
+        internal->steps[idx].progress = progress;
+    }
+
+    pthread_mutex_unlock(&internal->lock);
+}
+
+size_t lai_metadata_upgrade_tick(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ uint64_t now)
+{
+    size_t unfinished = 0;
+    size_t idx;
+
+    if (upgrade == NULL || upgrade->state == NULL)
+    {
+        return 0;
+    }
+
+    for (idx = 0; idx < upgrade->count; idx++)
+    {
+        lai_metadata_upgrade_state_t state = upgrade->units[idx].state;
+
+        if (state != LAI_METADATA_UPGRADE_STATE_PENDING && !lai_metadata_upgrade_is_finished(state))
+        {
+            lai_metadata_upgrade_advance(upgrade, idx, now);
+        }
+    }
+
+    /* freed slots are refilled in the same tick */
+
+    for (idx = 0; idx < upgrade->count; idx++)
+    {
+        if (upgrade->paused || (upgrade->config.parallelism != 0 && upgrade->active >= upgrade->config.parallelism))
+        {
+            break;
+        }
+
+        if (upgrade->units[idx].state == LAI_METADATA_UPGRADE_STATE_PENDING)
+        {
+            lai_metadata_upgrade_start(upgrade, idx, now != 0 ? now : 1);
+        }
+    }
+
+    for (idx = 0; idx < upgrade->count; idx++)
+    {
+        if (!lai_metadata_upgrade_is_finished(upgrade->units[idx].state))
+        {
+            unfinished++;
+        }
+    }
+
+    return unfinished;
+}
+
+lai_status_t lai_metadata_upgrade_pause(
+        _Inout_ lai_metadata_upgrade_t *upgrade)
+{
+    lai_status_t result = LAI_STATUS_SUCCESS;
+    lai_status_t status;
+    size_t idx;
+
+    if (upgrade == NULL || upgrade->state == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    upgrade->paused = true;
+
+    for (idx = 0; idx < upgrade->count; idx++)
+    {
+        lai_metadata_upgrade_unit_t *unit = &upgrade->units[idx];
+
+        if (unit->state != LAI_METADATA_UPGRADE_STATE_COMMITTING)
+        {
+            continue;
+        }
+
+        status = lai_metadata_upgrade_set_bool(unit, LAI_LINECARD_ATTR_UPGRADE_COMMIT_PAUSE);
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            unit->state = LAI_METADATA_UPGRADE_STATE_PAUSED;
+        }
+        else if (result == LAI_STATUS_SUCCESS)
+        {
+            result = status;
+        }
+    }
+
+    return result;
+}
+
+lai_status_t lai_metadata_upgrade_resume(
+        _Inout_ lai_metadata_upgrade_t *upgrade)
+{
+    lai_status_t result = LAI_STATUS_SUCCESS;
+    lai_status_t status;
+    size_t idx;
+
+    if (upgrade == NULL || upgrade->state == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    upgrade->paused = false;
+
+    for (idx = 0; idx < upgrade->count; idx++)
+    {
+        lai_metadata_upgrade_unit_t *unit = &upgrade->units[idx];
+
+        if (unit->state != LAI_METADATA_UPGRADE_STATE_PAUSED)
+        {
+            continue;
+        }
+
+        status = lai_metadata_upgrade_set_bool(unit, LAI_LINECARD_ATTR_UPGRADE_COMMIT_RESUME);
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            unit->state = LAI_METADATA_UPGRADE_STATE_COMMITTING;
+        }
+        else if (result == LAI_STATUS_SUCCESS)
+        {
+            result = status;
+        }
+    }
+
+    return result;
+}
+
+lai_status_t lai_metadata_upgrade_rollback(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ lai_object_id_t object_id,
+        _In_ uint64_t now)
+{
+    lai_metadata_upgrade_internal_t *internal;
+    lai_metadata_upgrade_unit_t *unit;
+    lai_status_t status;
+    bool finished;
+    size_t idx;
+
+    if (upgrade == NULL || upgrade->state == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    internal = (lai_metadata_upgrade_internal_t*)upgrade->state;
+
+    idx = lai_metadata_upgrade_find(upgrade, object_id);
+
+    if (idx == upgrade->count)
+    {
+        return LAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    unit = &upgrade->units[idx];
+
+    if (!internal->steps[idx].commit_started ||
+            (unit->state != LAI_METADATA_UPGRADE_STATE_COMMITTING && unit->state != LAI_METADATA_UPGRADE_STATE_PAUSED &&
+             unit->state != LAI_METADATA_UPGRADE_STATE_DONE && unit->state != LAI_METADATA_UPGRADE_STATE_FAILED))
+    {
+        return LAI_STATUS_OBJECT_NOT_READY;
+    }
+
+    finished = lai_metadata_upgrade_is_finished(unit->state);
+
+    status = lai_metadata_upgrade_request(upgrade, idx, LAI_LINECARD_ATTR_UPGRADE_ROLLBACK,
+            LAI_METADATA_UPGRADE_STATE_ROLLING_BACK, now);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    if (finished)
+    {
+        upgrade->active++;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
@@ -0,0 +1,338 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laimetadataupgrade.h
+ *
+ * @brief   This module defines LAI Metadata Upgrade Orchestrator
+ */
+
+#ifndef __LAIMETADATAUPGRADE_H_
+#define __LAIMETADATAUPGRADE_H_
+
+#include "laimetadatatypes.h"
+
+/**
+ * @defgroup LAIMETADATAUPGRADE LAI - Metadata Upgrade Orchestrator Definitions
+ *
+ * Orchestrator runs firmware upgrade of many linecards and transceivers at
+ * once, at most parallelism units at a time. Linecard unit sets upgrade
+ * server and file, then downloads, commits and optionally reboots, each step
+ * started when previous one is finished. Transceiver unit only downloads.
+ *
+ * Download, commit, rollback and reboot are started by
+ * lai_set_attribute_async(), host forwards linecard
+ * #LAI_LINECARD_ATTR_LINECARD_ASYNC_OPERATION_NOTIFY to
+ * lai_metadata_upgrade_notify() and unit waits for completion without any
+ * polling. Only after completion, upgrade state is read to follow commit,
+ * rollback and reboot which continue inside linecard. Without asynchronous
+ * set, steps are started by plain set and complete at once.
+ *
+ * All units share pause, which stops starting new units and pauses running
+ * commits. Commit failure rolls linecard back when configured, rollback can
+ * be also requested per unit.
+ *
+ * Notify may be called from any thread, all other functions from single
+ * thread of the host.
+ *
+ * @{
+ */
+
+/**
+ * @brief State of upgrade unit
+ */
+typedef enum _lai_metadata_upgrade_state_t
+{
+    /** Unit waits for free slot */
+    LAI_METADATA_UPGRADE_STATE_PENDING,
+
+    /** Download is running */
+    LAI_METADATA_UPGRADE_STATE_DOWNLOADING,
+
+    /** Commit is running */
+    LAI_METADATA_UPGRADE_STATE_COMMITTING,
+
+    /** Commit is paused */
+    LAI_METADATA_UPGRADE_STATE_PAUSED,
+
+    /** Reboot is running */
+    LAI_METADATA_UPGRADE_STATE_REBOOTING,
+
+    /** Rollback is running */
+    LAI_METADATA_UPGRADE_STATE_ROLLING_BACK,
+
+    /** Upgrade is finished */
+    LAI_METADATA_UPGRADE_STATE_DONE,
+
+    /** Upgrade failed */
+    LAI_METADATA_UPGRADE_STATE_FAILED,
+
+    /** Upgrade failed and was rolled back */
+    LAI_METADATA_UPGRADE_STATE_ROLLED_BACK,
+
+} lai_metadata_upgrade_state_t;
+
+/**
+ * @brief Starts attribute set, lai_set_attribute_async() of adapter
+ *
+ * @param[in] object_type LAI object type
+ * @param[in] object_id Object id
+ * @param[in] attr Attribute
+ * @param[out] request_id Request id reported in notification
+ *
+ * @return #LAI_STATUS_SUCCESS if operation was started, failure status code on error
+ */
+typedef lai_status_t (*lai_metadata_upgrade_set_async_fn)(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ const lai_attribute_t *attr,
+        _Out_ lai_request_id_t *request_id);
+
+/**
+ * @brief Upgrade configuration
+ */
+typedef struct _lai_metadata_upgrade_config_t
+{
+    /**
+     * @brief Maximum number of units upgraded at once, 0 for all.
+     */
+    size_t parallelism;
+
+    /**
+     * @brief Upgrade server IPv4 address, 0 keeps linecard setting.
+     */
+    lai_uint32_t host_ip;
+
+    /**
+     * @brief Upgrade server user name, NULL keeps linecard setting.
+     */
+    const char *user_name;
+
+    /**
+     * @brief Upgrade server password, NULL keeps linecard setting.
+     */
+    const char *user_password;
+
+    /**
+     * @brief Linecard upgrade file name, NULL keeps linecard setting.
+     */
+    const char *file_name;
+
+    /**
+     * @brief Linecard upgrade file path, NULL keeps linecard setting.
+     */
+    const char *file_path;
+
+    /**
+     * @brief Reboot linecard after commit.
+     */
+    bool reboot;
+
+    /**
+     * @brief Roll linecard back when commit fails.
+     */
+    bool rollback;
+
+    /**
+     * @brief Minimum time in milliseconds between reads of upgrade state.
+     */
+    uint64_t poll_interval;
+
+    /**
+     * @brief Time in milliseconds after which step fails, 0 for no limit.
+     */
+    uint64_t timeout;
+
+} lai_metadata_upgrade_config_t;
+
+/**
+ * @brief Single upgraded object
+ */
+typedef struct _lai_metadata_upgrade_unit_t
+{
+    /**
+     * @brief Object type, linecard or transceiver.
+     */
+    lai_object_type_t object_type;
+
+    /**
+     * @brief Object id.
+     */
+    lai_object_id_t object_id;
+
+    /**
+     * @brief Unit state.
+     */
+    lai_metadata_upgrade_state_t state;
+
+    /**
+     * @brief Progress of running step in percent.
+     */
+    lai_uint8_t progress;
+
+    /**
+     * @brief Status of the first failure.
+     */
+    lai_status_t status;
+
+    /**
+     * @brief Time when running step started.
+     */
+    uint64_t started;
+
+} lai_metadata_upgrade_unit_t;
+
+/**
+ * @brief Upgrade of many objects
+ */
+typedef struct _lai_metadata_upgrade_t
+{
+    /**
+     * @brief Configuration, strings must stay valid until upgrade is released.
+     */
+    lai_metadata_upgrade_config_t config;
+
+    /**
+     * @brief Number of units.
+     */
+    size_t count;
+
+    /**
+     * @brief Units in start order.
+     */
+    lai_metadata_upgrade_unit_t *units;
+
+    /**
+     * @brief Number of units started and not yet finished.
+     */
+    size_t active;
+
+    /**
+     * @brief Pause is requested.
+     */
+    bool paused;
+
+    /**
+     * @brief Internal state.
+     */
+    void *state;
+
+} lai_metadata_upgrade_t;
+
+/**
+ * @brief Initializes upgrade
+ *
+ * Units are upgraded in given order.
+ *
+ * @param[out] upgrade Upgrade to be initialized
+ * @param[in] config Configuration
+ * @param[in] count Number of units
+ * @param[in] objects Linecards and transceivers to be upgraded
+ * @param[in] set_async Asynchronous set, NULL for plain set through object type info
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_INVALID_PARAMETER on
+ * other object type or duplicate object, failure status code on error
+ */
+extern lai_status_t lai_metadata_upgrade_init(
+        _Out_ lai_metadata_upgrade_t *upgrade,
+        _In_ const lai_metadata_upgrade_config_t *config,
+        _In_ size_t count,
+        _In_ const lai_object_meta_key_t *objects,
+        _In_ lai_metadata_upgrade_set_async_fn set_async);
+
+/**
+ * @brief Releases upgrade
+ *
+ * @param[inout] upgrade Upgrade
+ */
+extern void lai_metadata_upgrade_free(
+        _Inout_ lai_metadata_upgrade_t *upgrade);
+
+/**
+ * @brief Records asynchronous operation notification
+ *
+ * Notifications of objects not in upgrade are ignored.
+ *
+ * @param[inout] upgrade Upgrade
+ * @param[in] request_id Request id
+ * @param[in] object_id Object id
+ * @param[in] completed Operation is completed
+ * @param[in] status Final status of operation
+ * @param[in] progress Progress of operation in percent
+ */
+extern void lai_metadata_upgrade_notify(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ lai_request_id_t request_id,
+        _In_ lai_object_id_t object_id,
+        _In_ bool completed,
+        _In_ lai_status_t status,
+        _In_ lai_uint8_t progress);
+
+/**
+ * @brief Advances units whose step is completed and starts pending units
+ *
+ * @param[inout] upgrade Upgrade
+ * @param[in] now Current time in milliseconds
+ *
+ * @return Number of units not yet finished
+ */
+extern size_t lai_metadata_upgrade_tick(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ uint64_t now);
+
+/**
+ * @brief Pauses upgrade
+ *
+ * Pending units are not started and running commits are paused, downloads
+ * and reboots run to completion.
+ *
+ * @param[inout] upgrade Upgrade
+ *
+ * @return #LAI_STATUS_SUCCESS on success, status of the first failed commit pause on error
+ */
+extern lai_status_t lai_metadata_upgrade_pause(
+        _Inout_ lai_metadata_upgrade_t *upgrade);
+
+/**
+ * @brief Resumes paused upgrade
+ *
+ * @param[inout] upgrade Upgrade
+ *
+ * @return #LAI_STATUS_SUCCESS on success, status of the first failed commit resume on error
+ */
+extern lai_status_t lai_metadata_upgrade_resume(
+        _Inout_ lai_metadata_upgrade_t *upgrade);
+
+/**
+ * @brief Rolls linecard back
+ *
+ * Linecard must be committing, paused, done or failed after commit.
+ *
+ * @param[inout] upgrade Upgrade
+ * @param[in] object_id Linecard id
+ * @param[in] now Current time in milliseconds
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_ITEM_NOT_FOUND if
+ * linecard is not in upgrade, #LAI_STATUS_OBJECT_NOT_READY if linecard
+ * can't be rolled back, failure status code on error
+ */
+extern lai_status_t lai_metadata_upgrade_rollback(
+        _Inout_ lai_metadata_upgrade_t *upgrade,
+        _In_ lai_object_id_t object_id,
+        _In_ uint64_t now);
+
+/**
+ * @}
+ */
+#endif /** __LAIMETADATAUPGRADE_H_ */
@@ -280,6 +280,31 @@ bool lai_metadata_is_object_type_valid(
     return object_type > LAI_OBJECT_TYPE_NULL && object_type < LAI_OBJECT_TYPE_MAX;
 }
 
+bool lai_metadata_is_object_id_compliant(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_object_id_t object_id)
+{
+    if (object_id == LAI_NULL_OBJECT_ID ||
+            !lai_metadata_is_object_type_valid(object_type) ||
+            LAI_OBJECT_ID_TYPE(object_id) != object_type)
+    {
+        return false;
+    }
+
+    if (object_type == LAI_OBJECT_TYPE_LINECARD && LAI_OBJECT_ID_INDEX(object_id) != 0)
+    {
+        return false;
+    }
+
+    if (linecard_id == LAI_NULL_OBJECT_ID)
+    {
+        return true;
+    }
+
+    return LAI_OBJECT_ID_LINECARD(object_id) == linecard_id;
+}
+
 bool lai_metadata_is_condition_met(
         _In_ const lai_attr_metadata_t *metadata,
         _In_ uint32_t attr_count,
@@ -396,3 +421,196 @@ bool lai_metadata_is_condition_met(
     return met;
 }
 
+
+#define DEEPEQUAL_LIST(l)                                           \
+    if (lhs->value.l.count != rhs->value.l.count)                   \
+    {                                                               \
+        *result = false;                                            \
+    }                                                               \
+    else if (lhs->value.l.count == 0)                               \
+    {                                                               \
+        *result = true;                                             \
+    }                                                               \
+    else if (lhs->value.l.list == NULL || rhs->value.l.list == NULL)\
+    {                                                               \
+        *result = (lhs->value.l.list == rhs->value.l.list);         \
+    }                                                               \
+    else                                                            \
+    {                                                               \
+        for (idx = 0; idx < lhs->value.l.count; idx++)              \
+        {                                                           \
+            if (lhs->value.l.list[idx] != rhs->value.l.list[idx])   \
+            {                                                       \
+                *result = false;                                    \
+                return LAI_STATUS_SUCCESS;                          \
+            }                                                       \
+        }                                                           \
+        *result = true;                                             \
+    }                                                               \
+    break;
+
+lai_status_t lai_metadata_deepequal_attr_value(
+        _In_ const lai_attr_metadata_t *metadata,
+        _In_ const lai_attribute_t *lhs,
+        _In_ const lai_attribute_t *rhs,
+        _Out_ bool *result)
+{
+    const lai_spectrum_power_t *lp;
+    const lai_spectrum_power_t *rp;
+    uint32_t idx;
+
+    if (metadata == NULL || lhs == NULL || rhs == NULL || result == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (lhs->id != rhs->id)
+    {
+        *result = false;
+        return LAI_STATUS_SUCCESS;
+    }
+
+    switch (metadata->attrvaluetype)
+    {
+        case LAI_ATTR_VALUE_TYPE_BOOL:
+            *result = (lhs->value.booldata == rhs->value.booldata);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_CHARDATA:
+            *result = (strncmp(lhs->value.chardata, rhs->value.chardata, sizeof(lhs->value.chardata)) == 0);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_UINT8:
+            *result = (lhs->value.u8 == rhs->value.u8);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_INT8:
+            *result = (lhs->value.s8 == rhs->value.s8);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_UINT16:
+            *result = (lhs->value.u16 == rhs->value.u16);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_INT16:
+            *result = (lhs->value.s16 == rhs->value.s16);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_UINT32:
+            *result = (lhs->value.u32 == rhs->value.u32);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_INT32:
+            *result = (lhs->value.s32 == rhs->value.s32);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_UINT64:
+            *result = (lhs->value.u64 == rhs->value.u64);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_INT64:
+            *result = (lhs->value.s64 == rhs->value.s64);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_DOUBLE:
+
+            /* bitwise, so NaN read back equals NaN stored */
+
+            *result = (memcmp(&lhs->value.d64, &rhs->value.d64, sizeof(lhs->value.d64)) == 0);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_POINTER:
+            *result = (lhs->value.ptr == rhs->value.ptr);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_OBJECT_ID:
+            *result = (lhs->value.oid == rhs->value.oid);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            DEEPEQUAL_LIST(objlist)
+
+        case LAI_ATTR_VALUE_TYPE_UINT8_LIST:
+            DEEPEQUAL_LIST(u8list)
+
+        case LAI_ATTR_VALUE_TYPE_INT8_LIST:
+            DEEPEQUAL_LIST(s8list)
+
+        case LAI_ATTR_VALUE_TYPE_UINT16_LIST:
+            DEEPEQUAL_LIST(u16list)
+
+        case LAI_ATTR_VALUE_TYPE_INT16_LIST:
+            DEEPEQUAL_LIST(s16list)
+
+        case LAI_ATTR_VALUE_TYPE_UINT32_LIST:
+            DEEPEQUAL_LIST(u32list)
+
+        case LAI_ATTR_VALUE_TYPE_INT32_LIST:
+            DEEPEQUAL_LIST(s32list)
+
+        case LAI_ATTR_VALUE_TYPE_UINT32_RANGE:
+            *result = (lhs->value.u32range.min == rhs->value.u32range.min &&
+                    lhs->value.u32range.max == rhs->value.u32range.max);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_INT32_RANGE:
+            *result = (lhs->value.s32range.min == rhs->value.s32range.min &&
+                    lhs->value.s32range.max == rhs->value.s32range.max);
+            break;
+
+        case LAI_ATTR_VALUE_TYPE_SPECTRUM_POWER_LIST:
+
+            lp = lhs->value.spectrumpowerlist.list;
+            rp = rhs->value.spectrumpowerlist.list;
+
+            *result = (lhs->value.spectrumpowerlist.count == rhs->value.spectrumpowerlist.count);
+
+            for (idx = 0; *result && lp != rp && idx < lhs->value.spectrumpowerlist.count; idx++)
+            {
+                *result = (lp != NULL && rp != NULL &&
+                        lp[idx].lower_frequency == rp[idx].lower_frequency &&
+                        lp[idx].upper_frequency == rp[idx].upper_frequency &&
+                        memcmp(&lp[idx].power, &rp[idx].power, sizeof(lp[idx].power)) == 0);
+            }
+
+            break;
+
+        default:
+
+            LAI_META_LOG_ERROR("attribute value type %d is not supported", metadata->attrvaluetype);
+
+            return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+#undef DEEPEQUAL_LIST
+
+size_t lai_metadata_api_slots_alloc(
+        _Inout_ lai_metadata_api_slots_t *slots)
+{
+    if (slots->count == LAI_METADATA_API_SLOTS)
+    {
+        return LAI_METADATA_API_SLOTS;
+    }
+
+    return slots->count++;
+}
+
+void lai_metadata_api_slots_bind(
+        _Inout_ lai_metadata_api_slots_t *slots,
+        _In_ lai_object_id_t linecard_id,
+        _In_ size_t slot)
+{
+    /* calls on other linecards read slots meanwhile */
+
+    __atomic_store_n(&slots->linecards[LAI_OBJECT_ID_LINECARD_INDEX(linecard_id)], (uint8_t)slot, __ATOMIC_RELAXED);
+}
+
+size_t lai_metadata_api_slots_find(
+        _In_ const lai_metadata_api_slots_t *slots,
+        _In_ lai_object_id_t object_id)
+{
+    return __atomic_load_n(&slots->linecards[LAI_OBJECT_ID_LINECARD_INDEX(object_id)], __ATOMIC_RELAXED);
+}
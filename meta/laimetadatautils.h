@@ -145,6 +145,25 @@ extern const lai_object_type_info_t* lai_metadata_get_object_type_info(
 extern bool lai_metadata_is_object_type_valid(
         _In_ lai_object_type_t object_type);
 
+/**
+ * @brief Checks whether object id follows object id layout
+ *
+ * Object id must be encoded as described at #LAI_OBJECT_ID_TYPE_SHIFT with
+ * given object type, linecard object must have object index 0 and object
+ * must belong to given linecard.
+ *
+ * @param[in] object_type Expected object type
+ * @param[in] linecard_id Linecard of object, #LAI_NULL_OBJECT_ID skips
+ * linecard check
+ * @param[in] object_id Object id returned by adapter
+ *
+ * @return True if object id follows layout, false otherwise
+ */
+extern bool lai_metadata_is_object_id_compliant(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_object_id_t object_id);
+
 /**
  * @brief Checks whether object type is OID object type.
  *
@@ -273,6 +292,70 @@ extern lai_status_t lai_metadata_deepequal_attr_value(
         _In_ const lai_attribute_t *rhs,
         _Out_ bool *result);
 
+/**
+ * @brief Maximum number of method table sets wrapped by generated shims
+ */
+#define LAI_METADATA_API_SLOTS 16
+
+/**
+ * @brief Slots of method table sets wrapped by generated shim
+ *
+ * Generated instrumentation and record shims keep adapter tables of every
+ * wrapped #lai_apis_t in its own slot, since tables of different API
+ * contexts call different adapter functions. Linecard is bound to slot
+ * whose create made it and calls on its objects go to tables of that
+ * slot. Objects of linecards not created through shim go to first slot.
+ */
+typedef struct _lai_metadata_api_slots_t
+{
+    /**
+     * @brief Number of used slots
+     */
+    size_t count;
+
+    /**
+     * @brief Slot of every linecard index
+     */
+    uint8_t linecards[LAI_OBJECT_ID_LINECARD_MASK + 1];
+
+} lai_metadata_api_slots_t;
+
+/**
+ * @brief Takes next free slot
+ *
+ * Must not be called concurrently with itself for the same slots.
+ *
+ * @param[inout] slots Slots
+ *
+ * @return Slot, #LAI_METADATA_API_SLOTS when all slots are used
+ */
+extern size_t lai_metadata_api_slots_alloc(
+        _Inout_ lai_metadata_api_slots_t *slots);
+
+/**
+ * @brief Binds linecard to slot
+ *
+ * @param[inout] slots Slots
+ * @param[in] linecard_id Linecard created through tables of slot
+ * @param[in] slot Slot
+ */
+extern void lai_metadata_api_slots_bind(
+        _Inout_ lai_metadata_api_slots_t *slots,
+        _In_ lai_object_id_t linecard_id,
+        _In_ size_t slot);
+
+/**
+ * @brief Finds slot of object
+ *
+ * @param[in] slots Slots
+ * @param[in] object_id Object id, or id of linecard object is created on
+ *
+ * @return Slot linecard of object is bound to
+ */
+extern size_t lai_metadata_api_slots_find(
+        _In_ const lai_metadata_api_slots_t *slots,
+        _In_ lai_object_id_t object_id);
+
 /**
  * @}
  */
@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laireplay.c
+ *
+ * @brief   This module implements LAI record replay tool
+ *
+ * Usage: laireplay [-s speed] [-p name=value]... adapter.so record
+ *
+ * Loads adapter, replays record written by lai_metadata_record_start() and
+ * prints recorded and replayed latency of every object type and call kind.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <lai.h>
+#include "laimetadata.h"
+
+#define REPLAY_PROFILE_MAX  32
+
+typedef lai_status_t (*lai_replay_initialize_fn)(
+        _In_ uint64_t flags,
+        _In_ const lai_service_method_table_t *services);
+
+static const char *lai_replay_profile[REPLAY_PROFILE_MAX];
+static size_t lai_replay_profile_count;
+
+static const char* lai_replay_profile_get_value(
+        _In_ lai_linecard_profile_id_t profile_id,
+        _In_ const char *variable)
+{
+    size_t len = strlen(variable);
+    size_t idx;
+
+    for (idx = 0; idx < lai_replay_profile_count; idx++)
+    {
+        if (strncmp(lai_replay_profile[idx], variable, len) == 0 && lai_replay_profile[idx][len] == '=')
+        {
+            return lai_replay_profile[idx] + len + 1;
+        }
+    }
+
+    return NULL;
+}
+
+static const char* lai_replay_kind_name(
+        _In_ lai_metadata_record_kind_t kind)
+{
+    static const char* const names[] = {
+        "create", "remove", "set", "get", "get_stats", "get_stats_ext", "clear_stats", "notification" };
+
+    return ((size_t)kind < sizeof(names) / sizeof(names[0])) ? names[kind] : "unknown";
+}
+
+static double lai_replay_average_us(
+        _In_ uint64_t total_ns,
+        _In_ uint64_t calls)
+{
+    return (calls == 0) ? 0.0 : (double)total_ns / (double)calls / 1000.0;
+}
+
+static void lai_replay_print(
+        _In_ const lai_metadata_record_replay_report_t *report)
+{
+    const lai_metadata_record_replay_entry_t *entry;
+    const char *name;
+    double recorded;
+    double replayed;
+    size_t idx;
+
+    printf("%-13s %-36s %8s %8s %12s %12s %9s %12s %12s\n", "kind", "object type", "calls", "status",
+            "rec avg us", "rep avg us", "delta %", "rec max us", "rep max us");
+
+    for (idx = 0; idx < report->count; idx++)
+    {
+        entry = &report->entries[idx];
+
+        if (entry->kind == LAI_METADATA_RECORD_KIND_NOTIFICATION)
+        {
+            name = lai_metadata_get_enum_value_name(&lai_metadata_enum_lai_linecard_notification_type_t, (int)entry->object_type);
+        }
+        else
+        {
+            name = lai_metadata_get_enum_value_name(&lai_metadata_enum_lai_object_type_t, (int)entry->object_type);
+        }
+
+        recorded = lai_replay_average_us(entry->recorded_ns, entry->calls);
+        replayed = lai_replay_average_us(entry->replayed_ns, entry->calls);
+
+        printf("%-13s %-36s %8llu %8llu %12.1f %12.1f %9.1f %12.1f %12.1f\n",
+                lai_replay_kind_name(entry->kind),
+                (name != NULL) ? name : "unknown",
+                (unsigned long long)entry->calls,
+                (unsigned long long)entry->mismatches,
+                recorded,
+                replayed,
+                (recorded > 0) ? (replayed - recorded) * 100.0 / recorded : 0.0,
+                (double)entry->recorded_max_ns / 1000.0,
+                (double)entry->replayed_max_ns / 1000.0);
+    }
+
+    printf("records %llu, skipped %llu, maximal lag %.1f ms\n",
+            (unsigned long long)report->records,
+            (unsigned long long)report->skipped,
+            (double)report->max_lag_ns / 1000000.0);
+}
+
+static void lai_replay_usage(
+        _In_ const char *name)
+{
+    fprintf(stderr, "usage: %s [-s speed] [-p name=value]... adapter.so record\n", name);
+    fprintf(stderr, "  -s speed       pace relative to recording, 1 is original pace,\n");
+    fprintf(stderr, "                 0 replays without waiting (default 1)\n");
+    fprintf(stderr, "  -p name=value  adapter profile value\n");
+}
+
+int main(
+        int argc,
+        char **argv)
+{
+    lai_service_method_table_t services;
+    lai_metadata_record_replay_report_t report;
+    lai_replay_initialize_fn initialize;
+    lai_api_query_fn query;
+    lai_status_t status;
+    double speed = 1.0;
+    void *adapter;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:p:")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                speed = atof(optarg);
+                break;
+
+            case 'p':
+
+                if (lai_replay_profile_count == REPLAY_PROFILE_MAX || strchr(optarg, '=') == NULL)
+                {
+                    lai_replay_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+
+                lai_replay_profile[lai_replay_profile_count++] = optarg;
+                break;
+
+            default:
+                lai_replay_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind != 2)
+    {
+        lai_replay_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    adapter = dlopen(argv[optind], RTLD_NOW | RTLD_LOCAL);
+
+    if (adapter == NULL)
+    {
+        fprintf(stderr, "failed to load %s: %s\n", argv[optind], dlerror());
+        return EXIT_FAILURE;
+    }
+
+    initialize = (lai_replay_initialize_fn)dlsym(adapter, "lai_api_initialize");
+    query = (lai_api_query_fn)dlsym(adapter, "lai_api_query");
+
+    if (initialize == NULL || query == NULL)
+    {
+        fprintf(stderr, "%s does not export lai_api_initialize and lai_api_query\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+
+    memset(&services, 0, sizeof(services));
+
+    services.profile_get_value = lai_replay_profile_get_value;
+
+    status = initialize(0, &services);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "lai_api_initialize failed: %d\n", status);
+        return EXIT_FAILURE;
+    }
+
+    lai_metadata_apis_query(query, &lai_metadata_apis);
+
+    status = lai_metadata_record_replay(argv[optind + 1], speed, &report);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "failed to replay %s: %d\n", argv[optind + 1], status);
+        return EXIT_FAILURE;
+    }
+
+    lai_replay_print(&report);
+
+    lai_metadata_record_replay_report_free(&report);
+
+    return EXIT_SUCCESS;
+}
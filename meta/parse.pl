@@ -63,6 +63,10 @@ our %OBJECT_TYPE_TO_ALARMS_MAP = ();
 our %ATTR_TO_CALLBACK = ();
 our %PRIMITIVE_TYPES = ();
 
+# must match LAI_METADATA_API_SLOTS of laimetadatautils.h
+
+our $API_SLOTS = 16;
+
 my $FLAGS = "MANDATORY_ON_CREATE|CREATE_ONLY|CREATE_AND_SET|READ_ONLY|SET_ONLY|KEY";
 
 # TAGS HANDLERS
@@ -72,6 +76,7 @@ my %ATTR_TAGS = (
         "precision"      , \&ProcessTagPrecision,
         "iscounter"      , \&ProcessTagIsCounter,
         "isrecoverable"  , \&ProcessTagIsRecoverable,
+        "isstatic"       , \&ProcessTagIsStatic,
         "type"           , \&ProcessTagType,
         "flags"          , \&ProcessTagFlags,
         "objects"        , \&ProcessTagObjects,
@@ -138,6 +143,15 @@ sub ProcessTagIsRecoverable
     return undef;
 }
 
+sub ProcessTagIsStatic
+{
+    my ($type, $value, $val) = @_;
+    return $val if $val =~ /^(true|false)$/i;
+
+    LogError "isstatic tag value '$val', expected true/false";
+    return undef;
+}
+
 sub ProcessTagType
 {
     my ($type, $value, $val) = @_;
@@ -431,7 +445,7 @@ sub ProcessDescription
 
     return if scalar@order == 0;
 
-    my $rightOrder = 'type:flags(:isrecoverable)?(:objects)?(:allownull)?(:default)?(:range)?(:condition|:validonly)?(:isresourcetype)?(:deprecated)?';
+    my $rightOrder = 'type:flags(:isrecoverable)?(:isstatic)?(:objects)?(:allownull)?(:default)?(:range)?(:condition|:validonly)?(:isresourcetype)?(:deprecated)?';
 
     my $order = join(":",@order);
 
@@ -1414,6 +1428,25 @@ sub ProcessIsRecoverable
     return "true";
 }
 
+sub ProcessIsStatic
+{
+    my ($value,$isstatic,$flags,$type) = @_;
+
+    return "false" if not defined $isstatic or $isstatic eq "false";
+
+    if (not defined $flags or $flags ne "READ_ONLY")
+    {
+        LogError "isstatic tag is allowed only on READ_ONLY attribute $value";
+    }
+
+    if ($type =~ /_list_t/)
+    {
+        LogError "isstatic tag is not allowed on list attribute $value";
+    }
+
+    return $isstatic;
+}
+
 sub ProcessIsResourceType
 {
     my ($value,$isresourcetype) = @_;
@@ -2095,6 +2128,7 @@ sub ProcessSingleObjectType
         my $attrname        = ProcessAttrName($attr, $meta{type});
         my $flags           = ProcessFlags($attr, $meta{flags});
         my $isrecoverable   = ProcessIsRecoverable($attr, $meta{isrecoverable});
+        my $isstatic        = ProcessIsStatic($attr, $meta{isstatic}, $meta{flags}, $meta{type});
         my $allownull       = ProcessAllowNull($attr, $meta{allownull});
         my $objects         = ProcessObjects($attr, $meta{objects});
         my $objectslen      = ProcessObjectsLen($attr, $meta{objects});
@@ -2144,6 +2178,7 @@ sub ProcessSingleObjectType
         WriteSource ".attrvaluetype                 = $type,";
         WriteSource ".flags                         = $flags,";
         WriteSource ".isrecoverable                 = $isrecoverable,";
+        WriteSource ".isstatic                      = $isstatic,";
         WriteSource ".allowedobjecttypes            = $objects,";
         WriteSource ".allowedobjecttypeslength      = $objectslen,";
         WriteSource ".allowrepetitiononlist         = $allowrepeat,";
@@ -3109,6 +3144,547 @@ sub CreateApisQuery
     WriteHeader "_Inout_ lai_apis_t *apis);";
 }
 
+sub ProcessSlotTrampolines
+{
+    my ($ret, $type, $fn, $params) = @_;
+
+    # function taking slot can't be put in table or passed to adapter, so
+    # every slot gets trampoline passing its slot, array is indexed by slot
+
+    my @fns = ();
+
+    my $args = join(", ", map { /(\w+),?$/ } @{ $params });
+
+    my $return = ($ret eq "void") ? "" : "return ";
+
+    for my $idx (0 .. $API_SLOTS - 1)
+    {
+        my @trampoline = @{ $params };
+
+        $trampoline[-1] .= ")";
+
+        WriteSource "$ret ${fn}_$idx(";
+
+        WriteSource $_ for @trampoline;
+
+        WriteSource "{";
+        WriteSource "$return$fn($idx, $args);";
+        WriteSource "}";
+
+        push @fns, "${fn}_$idx";
+    }
+
+    WriteSource "const $type ${fn}s[LAI_METADATA_API_SLOTS] = {";
+
+    WriteSource "$_," for @fns;
+
+    WriteSource "};";
+
+    return "${fn}s[slot]";
+}
+
+sub ProcessInstrumentWrapper
+{
+    my ($ot, $api, $op, $name, $params, $args, $id, $slot) = @_;
+
+    my $fn = "lai_metadata_instrument_" . lc($op) . "_$ot";
+
+    my @params = @{ $params };
+
+    # linecard create has no object id to find slot from, so it gets slot
+    # as parameter and is bound to slot by wrapper per slot
+
+    if ($slot eq "slot")
+    {
+        $fn .= "_slot";
+
+        unshift @params, "_In_ size_t slot,";
+    }
+
+    $params[-1] .= ")";
+
+    WriteSource "lai_status_t $fn(";
+
+    WriteSource $_ for @params;
+
+    WriteSource "{";
+    WriteSource "const lai_${api}_api_t *api = lai_metadata_instrument_lai_${api}_api[$slot];";
+    WriteSource "uint64_t begin;";
+    WriteSource "lai_status_t status;";
+    WriteSource "if (api == NULL || api->${name} == NULL)";
+    WriteSource "{";
+    WriteSource "return LAI_STATUS_NOT_IMPLEMENTED;";
+    WriteSource "}";
+    WriteSource "begin = lai_metadata_instrument_begin();";
+    WriteSource "status = api->${name}($args);";
+    WriteSource "lai_metadata_instrument_end($ot, LAI_METADATA_INSTRUMENT_OP_$op, $id, status, begin);";
+
+    if ($slot eq "slot")
+    {
+        WriteSource "if (status == LAI_STATUS_SUCCESS && object_id != NULL)";
+        WriteSource "{";
+        WriteSource "lai_metadata_api_slots_bind(&lai_metadata_instrument_slots, *object_id, slot);";
+        WriteSource "}";
+    }
+
+    WriteSource "return status;";
+    WriteSource "}";
+
+    return $fn if $slot ne "slot";
+
+    my ($small) = $name =~ /^create_(\w+)$/;
+
+    return ProcessSlotTrampolines("lai_status_t", "lai_create_${small}_fn", $fn, $params);
+}
+
+sub CreateInstrumentation
+{
+    WriteSectionComment "LAI API instrumentation";
+
+    # wrappers are kept in tables copied from adapter tables, so members
+    # which are not wrapped still point to adapter, every wrapped apis
+    # struct has its own tables in slot and wrappers call adapter tables
+    # of slot which created linecard of object
+
+    my $any = "LAI_METADATA_INSTRUMENT_ID_ANY";
+
+    my $counters = "(number_of_counters == 1 && counter_ids != NULL) ? counter_ids[0] : $any";
+
+    my $find = "lai_metadata_api_slots_find(&lai_metadata_instrument_slots, object_id)";
+
+    my %wrappers = ();
+
+    WriteSource "lai_metadata_api_slots_t lai_metadata_instrument_slots;";
+
+    for my $api (sort keys %APITOOBJMAP)
+    {
+        WriteSource "lai_${api}_api_t *lai_metadata_instrument_lai_${api}_api[LAI_METADATA_API_SLOTS];";
+        WriteSource "lai_${api}_api_t lai_metadata_instrument_${api}_api[LAI_METADATA_API_SLOTS];";
+
+        for my $ot (@{ $APITOOBJMAP{$api} })
+        {
+            next if defined $NON_OBJECT_ID_STRUCTS{$ot};
+
+            my $small = lc($1) if $ot =~ /LAI_OBJECT_TYPE_(\w+)/;
+
+            my @create = ("_Out_ lai_object_id_t *object_id,", "_In_ lai_object_id_t linecard_id,", "_In_ uint32_t attr_count,", "_In_ const lai_attribute_t *attr_list");
+            my $createargs = "object_id, linecard_id, attr_count, attr_list";
+            my $createslot = "lai_metadata_api_slots_find(&lai_metadata_instrument_slots, linecard_id)";
+
+            if ($ot eq "LAI_OBJECT_TYPE_LINECARD")
+            {
+                splice @create, 1, 1;
+                $createargs = "object_id, attr_count, attr_list";
+                $createslot = "slot";
+            }
+
+            my @stats = ("_In_ lai_object_id_t object_id,", "_In_ uint32_t number_of_counters,", "_In_ const lai_stat_id_t *counter_ids,");
+
+            $wrappers{$api}{"create_${small}"} = ProcessInstrumentWrapper($ot, $api, "CREATE", "create_${small}",
+                    \@create, $createargs, $any, $createslot);
+
+            $wrappers{$api}{"remove_${small}"} = ProcessInstrumentWrapper($ot, $api, "REMOVE", "remove_${small}",
+                    ["_In_ lai_object_id_t object_id"], "object_id", $any, $find);
+
+            $wrappers{$api}{"set_${small}_attribute"} = ProcessInstrumentWrapper($ot, $api, "SET", "set_${small}_attribute",
+                    ["_In_ lai_object_id_t object_id,", "_In_ const lai_attribute_t *attr"],
+                    "object_id, attr", "(attr != NULL) ? attr->id : $any", $find);
+
+            $wrappers{$api}{"get_${small}_attribute"} = ProcessInstrumentWrapper($ot, $api, "GET", "get_${small}_attribute",
+                    ["_In_ lai_object_id_t object_id,", "_In_ uint32_t attr_count,", "_Inout_ lai_attribute_t *attr_list"],
+                    "object_id, attr_count, attr_list", "(attr_count == 1 && attr_list != NULL) ? attr_list[0].id : $any", $find);
+
+            $wrappers{$api}{"get_${small}_stats"} = ProcessInstrumentWrapper($ot, $api, "GET_STATS", "get_${small}_stats",
+                    [@stats, "_Out_ lai_stat_value_t *counters"],
+                    "object_id, number_of_counters, counter_ids, counters", $counters, $find);
+
+            $wrappers{$api}{"get_${small}_stats_ext"} = ProcessInstrumentWrapper($ot, $api, "GET_STATS_EXT", "get_${small}_stats_ext",
+                    [@stats, "_In_ lai_stats_mode_t mode,", "_Out_ lai_stat_value_t *counters"],
+                    "object_id, number_of_counters, counter_ids, mode, counters", $counters, $find);
+
+            my @clear = @stats;
+
+            $clear[-1] =~ s/,$//;
+
+            $wrappers{$api}{"clear_${small}_stats"} = ProcessInstrumentWrapper($ot, $api, "CLEAR_STATS", "clear_${small}_stats",
+                    \@clear, "object_id, number_of_counters, counter_ids", $counters, $find);
+        }
+    }
+
+    WriteSource "lai_status_t lai_metadata_instrument_apis(";
+    WriteSource "_Inout_ lai_apis_t *apis)";
+    WriteSource "{";
+    WriteSource "size_t slot = lai_metadata_api_slots_alloc(&lai_metadata_instrument_slots);";
+    WriteSource "size_t idx;";
+    WriteSource "if (slot == LAI_METADATA_API_SLOTS)";
+    WriteSource "{";
+    WriteSource "LAI_META_LOG_ERROR(\"all %d instrumentation slots are used\", LAI_METADATA_API_SLOTS);";
+    WriteSource "return LAI_STATUS_INSUFFICIENT_RESOURCES;";
+    WriteSource "}";
+
+    for my $api (sort keys %APITOOBJMAP)
+    {
+        # table instrumented by earlier call is kept, slot calls adapter
+        # table wrapped there
+
+        WriteSource "for (idx = 0; idx < slot && apis->${api}_api != &lai_metadata_instrument_${api}_api[idx]; idx++);";
+        WriteSource "if (idx < slot)";
+        WriteSource "{";
+        WriteSource "lai_metadata_instrument_lai_${api}_api[slot] = lai_metadata_instrument_lai_${api}_api[idx];";
+        WriteSource "}";
+        WriteSource "else if (apis->${api}_api != NULL)";
+        WriteSource "{";
+        WriteSource "lai_metadata_instrument_lai_${api}_api[slot] = apis->${api}_api;";
+        WriteSource "lai_metadata_instrument_${api}_api[slot] = *apis->${api}_api;";
+
+        for my $member (sort keys %{ $wrappers{$api} })
+        {
+            # members left NULL by adapter stay NULL, so caller still sees
+            # not implemented function instead of wrapper calling NULL
+
+            WriteSource "if (lai_metadata_instrument_${api}_api[slot].$member != NULL)";
+            WriteSource "{";
+            WriteSource "lai_metadata_instrument_${api}_api[slot].$member = $wrappers{$api}{$member};";
+            WriteSource "}";
+        }
+
+        WriteSource "apis->${api}_api = &lai_metadata_instrument_${api}_api[slot];";
+        WriteSource "lai_metadata_lai_${api}_api = &lai_metadata_instrument_${api}_api[slot];";
+        WriteSource "}";
+    }
+
+    WriteSource "return LAI_STATUS_SUCCESS;";
+    WriteSource "}";
+
+    WriteHeader "extern lai_status_t lai_metadata_instrument_apis(";
+    WriteHeader "_Inout_ lai_apis_t *apis);";
+}
+
+sub ProcessRecordWrapper
+{
+    my ($ot, $api, $op, $name, $params, $call, $record, $slot) = @_;
+
+    my $fn = "lai_metadata_record_" . lc($op) . "_$ot";
+
+    my @params = @{ $params };
+
+    if ($slot eq "slot")
+    {
+        $fn .= "_slot";
+
+        unshift @params, "_In_ size_t slot,";
+    }
+
+    $params[-1] .= ")";
+
+    # linecard notification pointers are replaced, so notifications can be
+    # recorded, attributes are recorded as passed by caller, caller pointers
+    # are committed per linecard only when adapter call succeeds
+
+    my $notify = ($ot eq "LAI_OBJECT_TYPE_LINECARD" and $op =~ /^(CREATE|SET|REMOVE)$/);
+
+    WriteSource "lai_status_t $fn(";
+
+    WriteSource $_ for @params;
+
+    WriteSource "{";
+    WriteSource "const lai_${api}_api_t *api = lai_metadata_record_lai_${api}_api[$slot];";
+    WriteSource "uint64_t begin;";
+    WriteSource "lai_status_t status;";
+    WriteSource "lai_attribute_t *notify;" if $notify and $op ne "REMOVE";
+    WriteSource "if (api == NULL || api->${name} == NULL)";
+    WriteSource "{";
+    WriteSource "return LAI_STATUS_NOT_IMPLEMENTED;";
+    WriteSource "}";
+    WriteSource "begin = lai_metadata_record_begin();";
+
+    if ($notify)
+    {
+        my %lists = (CREATE => "attr_count, attr_list", SET => "(attr != NULL) ? 1 : 0, attr", REMOVE => "0, NULL");
+
+        my $list = $lists{$op};
+
+        my $id = ($op eq "CREATE") ? "(status == LAI_STATUS_SUCCESS && object_id != NULL) ? *object_id : LAI_NULL_OBJECT_ID" : "object_id";
+
+        WriteSource "notify = lai_metadata_record_notify_attr_list(LAI_METADATA_RECORD_KIND_$op, $slot, $list);" if $op ne "REMOVE";
+        WriteSource "status = api->${name}($call);";
+        WriteSource "lai_metadata_record_notify_commit(LAI_METADATA_RECORD_KIND_$op, $slot, $id, status, $list);";
+        WriteSource "free(notify);" if $op ne "REMOVE";
+    }
+    else
+    {
+        WriteSource "status = api->${name}($call);";
+    }
+
+    if ($slot eq "slot")
+    {
+        WriteSource "if (status == LAI_STATUS_SUCCESS && object_id != NULL)";
+        WriteSource "{";
+        WriteSource "lai_metadata_api_slots_bind(&lai_metadata_record_slots, *object_id, slot);";
+        WriteSource "}";
+    }
+
+    WriteSource "$record;";
+    WriteSource "return status;";
+    WriteSource "}";
+
+    return $fn if $slot ne "slot";
+
+    my ($small) = $name =~ /^create_(\w+)$/;
+
+    return ProcessSlotTrampolines("lai_status_t", "lai_create_${small}_fn", $fn, $params);
+}
+
+sub GetRecordNotificationSize
+{
+    my $refNtf = shift;
+
+    # serialized notification must fit, double alone may take over 300
+    # characters, so every list element is given 1024 bytes
+
+    my @size = ("4096");
+
+    for my $name (@{ $refNtf->{keys} })
+    {
+        my $member = $refNtf->{membersHash}{$name};
+
+        if ($member->{type} =~ /\*/ and defined $member->{count})
+        {
+            push @size, "(size_t)$member->{count} * 1024";
+        }
+        elsif ($member->{type} =~ /_list_t$/)
+        {
+            push @size, "(size_t)$name.count * 1024";
+        }
+        elsif ($member->{type} eq "lai_otdr_result_t")
+        {
+            push @size, "(size_t)$name.events.events.count * 1024 + (size_t)$name.trace.data.count * 4";
+        }
+    }
+
+    return join(" + ", @size);
+}
+
+sub CreateRecordNotifications
+{
+    my @wrapped = ();
+
+    for my $name (sort keys %NOTIFICATIONS)
+    {
+        next if not $name =~ /^lai_(\w+)_notification_fn/;
+
+        my $short = $1;
+
+        my $ntf = $NOTIFICATIONS{$name};
+
+        my @keys = @{ $ntf->{keys} };
+
+        my @params = map { "_In_ $ntf->{membersHash}{$_}{type} $_," } @keys;
+
+        $params[-1] =~ s/,$//;
+
+        my $args = join(", ", @keys);
+
+        my $size = GetRecordNotificationSize($ntf);
+
+        my $fn = "lai_metadata_record_${short}_notification_slot";
+
+        # every slot has own wrapper, so notification sent while linecard
+        # is being created reaches pointers staged by create of its slot
+
+        WriteSource "void $fn(";
+        WriteSource "_In_ size_t slot,";
+
+        WriteSource $_ for @params[0 .. $#params - 1];
+
+        WriteSource "$params[-1])";
+
+        WriteSource "{";
+        WriteSource "lai_linecard_notifications_t notifications;";
+        WriteSource "char *buf = lai_metadata_record_buffer($size);";
+        WriteSource "if (buf != NULL)";
+        WriteSource "{";
+        WriteSource "lai_metadata_record_notification(LAI_LINECARD_NOTIFICATION_TYPE_" . uc($short) . ", $keys[0], buf, lai_serialize_${short}_notification(buf, $args));";
+        WriteSource "}";
+        WriteSource "lai_metadata_record_get_notifications(slot, $keys[0], &notifications);";
+        WriteSource "if (notifications.on_$short != NULL)";
+        WriteSource "{";
+        WriteSource "notifications.on_$short($args);";
+        WriteSource "}";
+        WriteSource "}";
+
+        push @wrapped, [$name, $short, ProcessSlotTrampolines("void", $name, $fn, \@params)];
+    }
+
+    WriteSource "lai_pointer_t lai_metadata_record_notify(";
+    WriteSource "_In_ lai_attr_id_t attr_id,";
+    WriteSource "_In_ lai_pointer_t notify,";
+    WriteSource "_In_ size_t slot,";
+    WriteSource "_Inout_ lai_linecard_notifications_t *notifications)";
+    WriteSource "{";
+
+    for my $ref (@wrapped)
+    {
+        my ($name, $short, $fn) = @{ $ref };
+
+        WriteSource "if (attr_id == LAI_LINECARD_ATTR_" . uc($short) . "_NOTIFY)";
+        WriteSource "{";
+        WriteSource "notifications->on_$short = ($name)notify;";
+        WriteSource "return (notify == NULL) ? NULL : (lai_pointer_t)$fn;";
+        WriteSource "}";
+    }
+
+    WriteSource "return notify;";
+    WriteSource "}";
+
+    WriteHeader "extern lai_pointer_t lai_metadata_record_notify(";
+    WriteHeader "_In_ lai_attr_id_t attr_id,";
+    WriteHeader "_In_ lai_pointer_t notify,";
+    WriteHeader "_In_ size_t slot,";
+    WriteHeader "_Inout_ lai_linecard_notifications_t *notifications);";
+
+    # implemented in laimetadatarecord.c, declared here since it takes
+    # notifications struct, which is generated
+
+    WriteHeader "extern void lai_metadata_record_get_notifications(";
+    WriteHeader "_In_ size_t slot,";
+    WriteHeader "_In_ lai_object_id_t linecard_id,";
+    WriteHeader "_Out_ lai_linecard_notifications_t *notifications);";
+}
+
+sub CreateRecord
+{
+    WriteSectionComment "LAI API record";
+
+    # record wrappers call tables which were installed when recording
+    # tables were installed, so they may be combined with instrumentation,
+    # like instrumentation every wrapped apis struct has its own slot
+
+    my $null = "LAI_NULL_OBJECT_ID";
+
+    my $find = "lai_metadata_api_slots_find(&lai_metadata_record_slots, object_id)";
+
+    my %wrappers = ();
+
+    WriteSource "lai_metadata_api_slots_t lai_metadata_record_slots;";
+
+    for my $api (sort keys %APITOOBJMAP)
+    {
+        WriteSource "lai_${api}_api_t *lai_metadata_record_lai_${api}_api[LAI_METADATA_API_SLOTS];";
+        WriteSource "lai_${api}_api_t lai_metadata_record_${api}_api[LAI_METADATA_API_SLOTS];";
+
+        for my $ot (@{ $APITOOBJMAP{$api} })
+        {
+            next if defined $NON_OBJECT_ID_STRUCTS{$ot};
+
+            my $small = lc($1) if $ot =~ /LAI_OBJECT_TYPE_(\w+)/;
+
+            my @create = ("_Out_ lai_object_id_t *object_id,", "_In_ lai_object_id_t linecard_id,", "_In_ uint32_t attr_count,", "_In_ const lai_attribute_t *attr_list");
+            my $createargs = "object_id, linecard_id, attr_count, attr_list";
+            my $createslot = "lai_metadata_api_slots_find(&lai_metadata_record_slots, linecard_id)";
+            my $linecard = "linecard_id";
+
+            if ($ot eq "LAI_OBJECT_TYPE_LINECARD")
+            {
+                splice @create, 1, 1;
+                $createargs = "object_id, attr_count, (notify != NULL) ? notify : attr_list";
+                $createslot = "slot";
+                $linecard = $null;
+            }
+
+            my $created = "(status == LAI_STATUS_SUCCESS && object_id != NULL) ? *object_id : $null";
+
+            my @stats = ("_In_ lai_object_id_t object_id,", "_In_ uint32_t number_of_counters,", "_In_ const lai_stat_id_t *counter_ids,");
+
+            my $stats = "object_id, status, begin, number_of_counters, counter_ids";
+
+            $wrappers{$api}{"create_${small}"} = ProcessRecordWrapper($ot, $api, "CREATE", "create_${small}",
+                    \@create, $createargs,
+                    "lai_metadata_record_call(LAI_METADATA_RECORD_KIND_CREATE, $ot, $created, $linecard, status, begin, attr_count, attr_list)", $createslot);
+
+            $wrappers{$api}{"remove_${small}"} = ProcessRecordWrapper($ot, $api, "REMOVE", "remove_${small}",
+                    ["_In_ lai_object_id_t object_id"], "object_id",
+                    "lai_metadata_record_call(LAI_METADATA_RECORD_KIND_REMOVE, $ot, object_id, $null, status, begin, 0, NULL)", $find);
+
+            my $setargs = ($ot eq "LAI_OBJECT_TYPE_LINECARD") ? "object_id, (notify != NULL) ? notify : attr" : "object_id, attr";
+
+            $wrappers{$api}{"set_${small}_attribute"} = ProcessRecordWrapper($ot, $api, "SET", "set_${small}_attribute",
+                    ["_In_ lai_object_id_t object_id,", "_In_ const lai_attribute_t *attr"], $setargs,
+                    "lai_metadata_record_call(LAI_METADATA_RECORD_KIND_SET, $ot, object_id, $null, status, begin, (attr != NULL) ? 1 : 0, attr)", $find);
+
+            $wrappers{$api}{"get_${small}_attribute"} = ProcessRecordWrapper($ot, $api, "GET", "get_${small}_attribute",
+                    ["_In_ lai_object_id_t object_id,", "_In_ uint32_t attr_count,", "_Inout_ lai_attribute_t *attr_list"],
+                    "object_id, attr_count, attr_list",
+                    "lai_metadata_record_call(LAI_METADATA_RECORD_KIND_GET, $ot, object_id, $null, status, begin, attr_count, attr_list)", $find);
+
+            $wrappers{$api}{"get_${small}_stats"} = ProcessRecordWrapper($ot, $api, "GET_STATS", "get_${small}_stats",
+                    [@stats, "_Out_ lai_stat_value_t *counters"],
+                    "object_id, number_of_counters, counter_ids, counters",
+                    "lai_metadata_record_stats(LAI_METADATA_RECORD_KIND_GET_STATS, $ot, $stats, LAI_STATS_MODE_READ)", $find);
+
+            $wrappers{$api}{"get_${small}_stats_ext"} = ProcessRecordWrapper($ot, $api, "GET_STATS_EXT", "get_${small}_stats_ext",
+                    [@stats, "_In_ lai_stats_mode_t mode,", "_Out_ lai_stat_value_t *counters"],
+                    "object_id, number_of_counters, counter_ids, mode, counters",
+                    "lai_metadata_record_stats(LAI_METADATA_RECORD_KIND_GET_STATS_EXT, $ot, $stats, mode)", $find);
+
+            my @clear = @stats;
+
+            $clear[-1] =~ s/,$//;
+
+            $wrappers{$api}{"clear_${small}_stats"} = ProcessRecordWrapper($ot, $api, "CLEAR_STATS", "clear_${small}_stats",
+                    \@clear, "object_id, number_of_counters, counter_ids",
+                    "lai_metadata_record_stats(LAI_METADATA_RECORD_KIND_CLEAR_STATS, $ot, $stats, LAI_STATS_MODE_READ)", $find);
+        }
+    }
+
+    CreateRecordNotifications();
+
+    WriteSource "lai_status_t lai_metadata_record_apis(";
+    WriteSource "_Inout_ lai_apis_t *apis)";
+    WriteSource "{";
+    WriteSource "size_t slot = lai_metadata_api_slots_alloc(&lai_metadata_record_slots);";
+    WriteSource "size_t idx;";
+    WriteSource "if (slot == LAI_METADATA_API_SLOTS)";
+    WriteSource "{";
+    WriteSource "LAI_META_LOG_ERROR(\"all %d record slots are used\", LAI_METADATA_API_SLOTS);";
+    WriteSource "return LAI_STATUS_INSUFFICIENT_RESOURCES;";
+    WriteSource "}";
+
+    for my $api (sort keys %APITOOBJMAP)
+    {
+        # table wrapped by earlier call is kept, slot records calls of
+        # adapter table wrapped there
+
+        WriteSource "for (idx = 0; idx < slot && apis->${api}_api != &lai_metadata_record_${api}_api[idx]; idx++);";
+        WriteSource "if (idx < slot)";
+        WriteSource "{";
+        WriteSource "lai_metadata_record_lai_${api}_api[slot] = lai_metadata_record_lai_${api}_api[idx];";
+        WriteSource "}";
+        WriteSource "else if (apis->${api}_api != NULL)";
+        WriteSource "{";
+        WriteSource "lai_metadata_record_lai_${api}_api[slot] = apis->${api}_api;";
+        WriteSource "lai_metadata_record_${api}_api[slot] = *apis->${api}_api;";
+
+        for my $member (sort keys %{ $wrappers{$api} })
+        {
+            WriteSource "if (lai_metadata_record_${api}_api[slot].$member != NULL)";
+            WriteSource "{";
+            WriteSource "lai_metadata_record_${api}_api[slot].$member = $wrappers{$api}{$member};";
+            WriteSource "}";
+        }
+
+        WriteSource "apis->${api}_api = &lai_metadata_record_${api}_api[slot];";
+        WriteSource "lai_metadata_lai_${api}_api = &lai_metadata_record_${api}_api[slot];";
+        WriteSource "}";
+    }
+
+    WriteSource "return LAI_STATUS_SUCCESS;";
+    WriteSource "}";
+
+    WriteHeader "extern lai_status_t lai_metadata_record_apis(";
+    WriteHeader "_Inout_ lai_apis_t *apis);";
+}
+
 sub ProcessIsExperimental
 {
     my $ot = shift;
@@ -3805,8 +4381,8 @@ sub WriteLoggerVariables
     # - log level
     # - log function
     #
-    # we can extract this to another source file laimetadatalogger.c
-    # but now seems to be unnecessary
+    # they stay here and not in laimetadatalogger.c, so LAI_META_LOG
+    # works without linking deferred logger
     #
 
     WriteSectionComment "Loglevel variables";
@@ -4040,6 +4616,20 @@ sub WriteHeaderHeader
     WriteHeader "#include \"laimetadatautils.h\"";
     WriteHeader "#include \"laimetadatalogger.h\"";
     WriteHeader "#include \"laiserialize.h\"";
+    WriteHeader "#include \"laimetadatafixedpoint.h\"";
+    WriteHeader "#include \"laimetadatapm.h\"";
+    WriteHeader "#include \"laimetadataaccumulator.h\"";
+    WriteHeader "#include \"laimetadatatca.h\"";
+    WriteHeader "#include \"laimetadataprofile.h\"";
+    WriteHeader "#include \"laimetadatainstrument.h\"";
+    WriteHeader "#include \"laimetadatarecord.h\"";
+    WriteHeader "#include \"laimetadatareconcile.h\"";
+    WriteHeader "#include \"laimetadataspectrum.h\"";
+    WriteHeader "#include \"laimetadataspectrumhistory.h\"";
+    WriteHeader "#include \"laimetadataotdr.h\"";
+    WriteHeader "#include \"laimetadatamediachannel.h\"";
+    WriteHeader "#include \"laimetadataupgrade.h\"";
+    WriteHeader "#include \"laimetadatastaticcache.h\"";
 }
 
 sub WriteHeaderFotter
@@ -4303,6 +4893,8 @@ CreateGlobalApis();
 
 CreateApisQuery();
 
+CreateInstrumentation();
+
 CreateObjectInfo();
 
 CreateListOfAllAttributes();
@@ -4325,6 +4917,10 @@ CreateNotificationStruct();
 
 CreateNotificationEnum();
 
+# record uses notifications struct
+
+CreateRecord();
+
 CreateSwitchNotificationAttributesList();
 
 CreateSerializeMethods();
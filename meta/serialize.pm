@@ -278,6 +278,13 @@ sub GetTypeInfoForSerialize
         $TypeInfo{needQuote} = 1;
         $TypeInfo{deamp} = "&";
     }
+    elsif (defined $main::PRIMITIVE_TYPES{$type} and $main::PRIMITIVE_TYPES{$type}{isarray} == 0)
+    {
+        # like lai_status_t or lai_request_id_t
+
+        $TypeInfo{suffix} = $1 if $main::PRIMITIVE_TYPES{$type}{base} =~ /^(u?int\d+)_t$/;
+        $TypeInfo{deamp} = "&";
+    }
     elsif ($type =~ /^lai_attribute_t$/)
     {
         $TypeInfo{amp} = "&";
@@ -295,7 +295,7 @@ sub CheckFunctionsParams
         next if not $fname =~ /_fn$/; # below don't apply for global functions
 
         if (not $fnparams =~ /^(\w+)(| attr| attr_count attr_list| linecard_id attr_count attr_list)$/ and
-            not $fname =~ /_(stats|stats_ext|gauges|notification|event|handler|switch_info|report_result)_fn$|^lai_(send|allocate|free|recv|bulk)_|^lai_meta/)
+            not $fname =~ /_(stats|stats_ext|gauges|samples|notification|event|handler|switch_info|report_result)_fn$|^lai_(send|allocate|free|recv|bulk)_|^lai_meta/)
         {
             LogWarning "wrong param names: $fnparams: $fname";
             LogWarning " expected: $params[0](| attr| attr_count attr_list| linecard_id attr_count attr_list)";
@@ -449,7 +449,7 @@ sub CheckFunctionNaming
     my $typename = $1;
     my $name = $2;
 
-    if ($name =~ /^(recv_hostif_packet|send_hostif_packet|allocate_hostif_packet|free_hostif_packet|flush_fdb_entries|remove_all_neighbor_entries|profile_get_value|profile_get_next_value|switch_register_read|switch_register_write|switch_mdio_read|switch_mdio_write)$/)
+    if ($name =~ /^(recv_hostif_packet|send_hostif_packet|allocate_hostif_packet|free_hostif_packet|flush_fdb_entries|remove_all_neighbor_entries|profile_get_value|profile_get_next_value|switch_register_read|switch_register_write|switch_mdio_read|switch_mdio_write|drain_oa_samples)$/)
     {
         # ok
     }
@@ -483,7 +483,7 @@ sub CheckFunctionNaming
     if (not $name =~ /^(create|remove|get|set)_\w+?(_attribute)?$|^clear_\w+_(stats|gauges)$/)
     {
         # exceptions
-        return if $name =~ /^(profile_get_value|profile_get_next_value)$/;
+        return if $name =~ /^(profile_get_value|profile_get_next_value|drain_oa_samples)$/;
 
         LogWarning "function not follow convention in $header:$n:$line";
     }
@@ -0,0 +1,833 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laivs.c
+ *
+ * @brief   This module implements LAI Virtual Adapter API
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "laivs.h"
+
+pthread_mutex_t vs_global_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t vs_adapter_lock = PTHREAD_MUTEX_INITIALIZER;
+bool vs_initialized = false;
+
+/*
+ * Adapter is shared by lai_api_initialize() and API contexts, it is
+ * started by first of them and stopped after last one.
+ */
+
+static size_t vs_adapter_users = 0;
+static bool vs_api_initialized = false;
+
+/*
+ * Calls enter domain lock of their concurrency mode. Single threaded mode
+ * serializes all calls of domain on one lock, per object type mode
+ * serializes calls of the same object type, concurrent reads mode takes no
+ * domain lock and relies on linecard read-write lock. Locks are recursive,
+ * so notification called in caller thread may call back into adapter.
+ * Domain lock is always taken before linecard lock. Every domain keeps
+ * services and profile of its own, so linecards of context tick with
+ * notification interval of context profile.
+ */
+
+static pthread_once_t vs_domain_once = PTHREAD_ONCE_INIT;
+
+vs_domain_t vs_domains[VS_MAX_CONTEXTS + 1];
+
+/* profile keys are hashed once, domain profiles are looked up by them */
+
+static lai_metadata_profile_key_t vs_key_notify_interval;
+
+static void vs_domain_init(void)
+{
+    pthread_mutexattr_t attr;
+    size_t domain;
+    size_t ot;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+
+    for (domain = 0; domain <= VS_API_DOMAIN; domain++)
+    {
+        for (ot = 0; ot < LAI_OBJECT_TYPE_MAX; ot++)
+        {
+            pthread_mutex_init(&vs_domains[domain].locks[ot], &attr);
+        }
+    }
+
+    pthread_mutexattr_destroy(&attr);
+
+    lai_metadata_profile_key_init(&vs_key_notify_interval, VS_KEY_NOTIFY_INTERVAL);
+}
+
+static uint64_t vs_profile_get_u64(
+        _In_ const lai_metadata_profile_t *profile,
+        _In_ const lai_metadata_profile_key_t *key,
+        _In_ uint64_t defvalue)
+{
+    int64_t value = lai_metadata_profile_get_int(profile, key, -1);
+
+    return value < 0 ? defvalue : (uint64_t)value;
+}
+
+void vs_domain_open(
+        _In_ size_t domain,
+        _In_ lai_api_concurrency_mode_t mode,
+        _In_ const lai_service_method_table_t *services)
+{
+    vs_domain_t *dom = &vs_domains[domain];
+
+    pthread_once(&vs_domain_once, vs_domain_init);
+
+    memset(&dom->services, 0, sizeof(dom->services));
+
+    if (services != NULL)
+    {
+        dom->services = *services;
+    }
+
+    /* profile is parsed once, services without profile access give empty cache */
+
+    if (lai_metadata_profile_load(&dom->profile, (lai_linecard_profile_id_t)(domain == VS_API_DOMAIN ? 0 : domain),
+                &dom->services) != LAI_STATUS_SUCCESS)
+    {
+        memset(&dom->profile, 0, sizeof(dom->profile));
+    }
+
+    __atomic_store_n(&dom->notify_interval,
+            vs_profile_get_u64(&dom->profile, &vs_key_notify_interval, VS_DEFAULT_NOTIFY_INTERVAL), __ATOMIC_RELAXED);
+    __atomic_store_n(&dom->mode, mode, __ATOMIC_RELAXED);
+    __atomic_store_n(&dom->active, true, __ATOMIC_RELEASE);
+}
+
+void vs_domain_close(
+        _In_ size_t domain)
+{
+    vs_domain_t *dom = &vs_domains[domain];
+
+    __atomic_store_n(&dom->active, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&dom->notify_interval, 0, __ATOMIC_RELAXED);
+
+    lai_metadata_profile_free(&dom->profile);
+}
+
+vs_domain_t* vs_domain_get(
+        _In_ size_t linecard_index)
+{
+    if (linecard_index < VS_MAX_CONTEXTS &&
+            __atomic_load_n(&vs_domains[linecard_index].active, __ATOMIC_ACQUIRE))
+    {
+        return &vs_domains[linecard_index];
+    }
+
+    return &vs_domains[VS_API_DOMAIN];
+}
+
+pthread_mutex_t* vs_domain_enter(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id)
+{
+    vs_domain_t *domain = vs_domain_get(object_id == LAI_NULL_OBJECT_ID ?
+            VS_MAX_CONTEXTS : LAI_OBJECT_ID_LINECARD_INDEX(object_id));
+    pthread_mutex_t *lock;
+
+    if (!__atomic_load_n(&domain->active, __ATOMIC_ACQUIRE))
+    {
+        /* adapter is not initialized, call fails without touching state */
+
+        return NULL;
+    }
+
+    switch (__atomic_load_n(&domain->mode, __ATOMIC_RELAXED))
+    {
+        case LAI_API_CONCURRENCY_MODE_SINGLE_THREADED:
+            lock = &domain->locks[0];
+            break;
+
+        case LAI_API_CONCURRENCY_MODE_PER_OBJECT_TYPE:
+            lock = &domain->locks[lai_metadata_is_object_type_valid(object_type) ? object_type : 0];
+            break;
+
+        default:
+            return NULL;
+    }
+
+    pthread_mutex_lock(lock);
+
+    return lock;
+}
+
+void vs_domain_leave(
+        _In_ pthread_mutex_t *lock)
+{
+    if (lock != NULL)
+    {
+        pthread_mutex_unlock(lock);
+    }
+}
+
+/*
+ * Every object type has the same 7 functions, linecard create has no
+ * linecard id parameter and OA has also sampling ring drain. Failed create,
+ * remove and set fail open transaction of their linecard in store.
+ */
+
+#define VS_GENERIC_API(ot, name) \
+    static lai_status_t vs_remove_##name( \
+            _In_ lai_object_id_t object_id) \
+    VS_SERIALIZED(ot, object_id, vs_generic_remove(ot, object_id)) \
+    static lai_status_t vs_set_##name##_attribute( \
+            _In_ lai_object_id_t object_id, \
+            _In_ const lai_attribute_t *attr) \
+    VS_SERIALIZED(ot, object_id, vs_generic_set(ot, object_id, attr)) \
+    static lai_status_t vs_get_##name##_attribute( \
+            _In_ lai_object_id_t object_id, \
+            _In_ uint32_t attr_count, \
+            _Inout_ lai_attribute_t *attr_list) \
+    VS_SERIALIZED(ot, object_id, vs_generic_get(ot, object_id, attr_count, attr_list)) \
+    static lai_status_t vs_get_##name##_stats( \
+            _In_ lai_object_id_t object_id, \
+            _In_ uint32_t number_of_counters, \
+            _In_ const lai_stat_id_t *counter_ids, \
+            _Out_ lai_stat_value_t *counters) \
+    VS_SERIALIZED(ot, object_id, vs_generic_get_stats_ext(ot, object_id, number_of_counters, counter_ids, LAI_STATS_MODE_READ, counters)) \
+    static lai_status_t vs_get_##name##_stats_ext( \
+            _In_ lai_object_id_t object_id, \
+            _In_ uint32_t number_of_counters, \
+            _In_ const lai_stat_id_t *counter_ids, \
+            _In_ lai_stats_mode_t mode, \
+            _Out_ lai_stat_value_t *counters) \
+    VS_SERIALIZED(ot, object_id, vs_generic_get_stats_ext(ot, object_id, number_of_counters, counter_ids, mode, counters)) \
+    static lai_status_t vs_clear_##name##_stats( \
+            _In_ lai_object_id_t object_id, \
+            _In_ uint32_t number_of_counters, \
+            _In_ const lai_stat_id_t *counter_ids) \
+    VS_SERIALIZED(ot, object_id, vs_generic_clear_stats(ot, object_id, number_of_counters, counter_ids))
+
+#define VS_API(ot, name) \
+    static lai_status_t vs_create_##name( \
+            _Out_ lai_object_id_t *object_id, \
+            _In_ lai_object_id_t linecard_id, \
+            _In_ uint32_t attr_count, \
+            _In_ const lai_attribute_t *attr_list) \
+    VS_SERIALIZED(ot, linecard_id, vs_generic_create(ot, object_id, linecard_id, attr_count, attr_list)) \
+    VS_GENERIC_API(ot, name) \
+    static lai_##name##_api_t vs_##name##_api = { \
+        vs_create_##name, \
+        vs_remove_##name, \
+        vs_set_##name##_attribute, \
+        vs_get_##name##_attribute, \
+        vs_get_##name##_stats, \
+        vs_get_##name##_stats_ext, \
+        vs_clear_##name##_stats, \
+    };
+
+static lai_status_t vs_create_linecard(
+        _Out_ lai_object_id_t *object_id,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+VS_SERIALIZED(LAI_OBJECT_TYPE_LINECARD, LAI_NULL_OBJECT_ID,
+        vs_generic_create(LAI_OBJECT_TYPE_LINECARD, object_id, LAI_NULL_OBJECT_ID, attr_count, attr_list))
+
+VS_GENERIC_API(LAI_OBJECT_TYPE_LINECARD, linecard)
+
+static lai_linecard_api_t vs_linecard_api = {
+    vs_create_linecard,
+    vs_remove_linecard,
+    vs_set_linecard_attribute,
+    vs_get_linecard_attribute,
+    vs_get_linecard_stats,
+    vs_get_linecard_stats_ext,
+    vs_clear_linecard_stats,
+};
+
+VS_API(LAI_OBJECT_TYPE_PORT, port)
+VS_API(LAI_OBJECT_TYPE_TRANSCEIVER, transceiver)
+VS_API(LAI_OBJECT_TYPE_LOGICALCHANNEL, logicalchannel)
+VS_API(LAI_OBJECT_TYPE_OTN, otn)
+VS_API(LAI_OBJECT_TYPE_ETHERNET, ethernet)
+VS_API(LAI_OBJECT_TYPE_PHYSICALCHANNEL, physicalchannel)
+VS_API(LAI_OBJECT_TYPE_OCH, och)
+VS_API(LAI_OBJECT_TYPE_LLDP, lldp)
+VS_API(LAI_OBJECT_TYPE_ASSIGNMENT, assignment)
+VS_API(LAI_OBJECT_TYPE_INTERFACE, interface)
+static lai_status_t vs_create_oa(
+        _Out_ lai_object_id_t *object_id,
+        _In_ lai_object_id_t linecard_id,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+VS_SERIALIZED(LAI_OBJECT_TYPE_OA, linecard_id,
+        vs_generic_create(LAI_OBJECT_TYPE_OA, object_id, linecard_id, attr_count, attr_list))
+
+VS_GENERIC_API(LAI_OBJECT_TYPE_OA, oa)
+
+static lai_status_t vs_drain_oa_samples(
+        _In_ lai_object_id_t oa_id,
+        _Inout_ uint32_t *count,
+        _Out_ uint64_t *timestamps,
+        _Out_ lai_stat_value_t *counters,
+        _Out_ uint64_t *dropped)
+VS_SERIALIZED(LAI_OBJECT_TYPE_OA, oa_id, vs_stats_drain_oa_samples(oa_id, count, timestamps, counters, dropped))
+
+static lai_oa_api_t vs_oa_api = {
+    vs_create_oa,
+    vs_remove_oa,
+    vs_set_oa_attribute,
+    vs_get_oa_attribute,
+    vs_get_oa_stats,
+    vs_get_oa_stats_ext,
+    vs_clear_oa_stats,
+    vs_drain_oa_samples,
+};
+
+VS_API(LAI_OBJECT_TYPE_OSC, osc)
+VS_API(LAI_OBJECT_TYPE_APS, aps)
+VS_API(LAI_OBJECT_TYPE_APSPORT, apsport)
+VS_API(LAI_OBJECT_TYPE_ATTENUATOR, attenuator)
+VS_API(LAI_OBJECT_TYPE_WSS, wss)
+VS_API(LAI_OBJECT_TYPE_MEDIACHANNEL, mediachannel)
+VS_API(LAI_OBJECT_TYPE_OCM, ocm)
+VS_API(LAI_OBJECT_TYPE_OTDR, otdr)
+
+void* const vs_api_tables[LAI_API_MAX] = {
+    NULL,
+    &vs_linecard_api,
+    &vs_port_api,
+    &vs_transceiver_api,
+    &vs_logicalchannel_api,
+    &vs_otn_api,
+    &vs_ethernet_api,
+    &vs_physicalchannel_api,
+    &vs_och_api,
+    &vs_lldp_api,
+    &vs_assignment_api,
+    &vs_interface_api,
+    &vs_oa_api,
+    &vs_osc_api,
+    &vs_aps_api,
+    &vs_apsport_api,
+    &vs_attenuator_api,
+    &vs_wss_api,
+    &vs_mediachannel_api,
+    &vs_ocm_api,
+    &vs_otdr_api,
+};
+
+lai_status_t vs_adapter_acquire(void)
+{
+    size_t idx;
+    lai_status_t status;
+    pthread_rwlockattr_t attr;
+
+    if (vs_adapter_users != 0)
+    {
+        vs_adapter_users++;
+        return LAI_STATUS_SUCCESS;
+    }
+
+    pthread_mutex_lock(&vs_global_lock);
+
+    /*
+     * Writers are preferred, otherwise continuous statistics polling would
+     * starve configuration.
+     */
+
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+
+    for (idx = 0; idx < VS_MAX_LINECARDS; idx++)
+    {
+        memset(&vs_linecards[idx], 0, sizeof(vs_linecard_t));
+
+        pthread_rwlock_init(&vs_linecards[idx].lock, &attr);
+    }
+
+    pthread_rwlockattr_destroy(&attr);
+
+    vs_initialized = true;
+
+    pthread_mutex_unlock(&vs_global_lock);
+
+    vs_adapter_users = 1;
+
+    status = vs_notify_start();
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        vs_adapter_release();
+    }
+
+    return status;
+}
+
+void vs_adapter_release(void)
+{
+    size_t idx;
+
+    if (vs_adapter_users == 0 || --vs_adapter_users != 0)
+    {
+        return;
+    }
+
+    vs_notify_stop();
+
+    vs_async_clear();
+
+    vs_store_clear();
+
+    pthread_mutex_lock(&vs_global_lock);
+
+    vs_initialized = false;
+
+    for (idx = 0; idx < VS_MAX_LINECARDS; idx++)
+    {
+        pthread_rwlock_destroy(&vs_linecards[idx].lock);
+    }
+
+    pthread_mutex_unlock(&vs_global_lock);
+}
+
+lai_status_t lai_api_initialize(
+        _In_ uint64_t flags,
+        _In_ const lai_service_method_table_t *services)
+{
+    lai_status_t status = LAI_STATUS_FAILURE;
+
+    if (flags > LAI_API_CONCURRENCY_MODE_CONCURRENT_READS)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&vs_adapter_lock);
+
+    if (!vs_api_initialized)
+    {
+        status = vs_adapter_acquire();
+
+        vs_api_initialized = (status == LAI_STATUS_SUCCESS);
+
+        if (vs_api_initialized)
+        {
+            vs_domain_open(VS_API_DOMAIN, (lai_api_concurrency_mode_t)flags, services);
+        }
+    }
+
+    pthread_mutex_unlock(&vs_adapter_lock);
+
+    return status;
+}
+
+lai_status_t lai_api_query(
+        _In_ lai_api_t api,
+        _Out_ void **api_method_table)
+{
+    if (api_method_table == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    if (api <= LAI_API_UNSPECIFIED || api >= LAI_API_MAX)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    *api_method_table = vs_api_tables[api];
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_api_uninitialize(void)
+{
+    lai_status_t status = LAI_STATUS_UNINITIALIZED;
+
+    pthread_mutex_lock(&vs_adapter_lock);
+
+    if (vs_api_initialized)
+    {
+        vs_api_initialized = false;
+
+        vs_domain_close(VS_API_DOMAIN);
+
+        vs_adapter_release();
+
+        status = LAI_STATUS_SUCCESS;
+    }
+
+    pthread_mutex_unlock(&vs_adapter_lock);
+
+    return status;
+}
+
+lai_status_t lai_api_concurrency_mode_query(
+        _Out_ lai_api_concurrency_mode_t *mode)
+{
+    if (mode == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!vs_api_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    *mode = __atomic_load_n(&vs_domains[VS_API_DOMAIN].mode, __ATOMIC_RELAXED);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_log_set(
+        _In_ lai_api_t api,
+        _In_ lai_log_level_t log_level)
+{
+    if (api < LAI_API_UNSPECIFIED || api >= LAI_API_MAX ||
+            log_level < LAI_LOG_LEVEL_DEBUG || log_level >= LAI_LOG_LEVEL_MAX)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    /* metadata logger has single level for all APIs */
+
+    lai_metadata_log_level = log_level;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_object_type_t lai_object_type_query(
+        _In_ lai_object_id_t object_id)
+{
+    lai_object_type_t object_type = LAI_OBJECT_ID_TYPE(object_id);
+
+    if (object_id == LAI_NULL_OBJECT_ID || !lai_metadata_is_object_type_valid(object_type))
+    {
+        return LAI_OBJECT_TYPE_NULL;
+    }
+
+    return object_type;
+}
+
+lai_object_id_t lai_linecard_id_query(
+        _In_ lai_object_id_t object_id)
+{
+    if (lai_object_type_query(object_id) == LAI_OBJECT_TYPE_NULL)
+    {
+        return LAI_NULL_OBJECT_ID;
+    }
+
+    return LAI_OBJECT_ID_LINECARD(object_id);
+}
+
+lai_status_t lai_link_check(
+        _Out_ bool *up)
+{
+    if (up == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    *up = vs_initialized;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static void vs_dump_object(
+        _In_ FILE *file,
+        _In_ const lai_object_type_info_t *info,
+        _In_ const vs_object_t *object,
+        _Inout_ char *buffer)
+{
+    size_t pos;
+    lai_attribute_t attr;
+
+    fprintf(file, "  %s 0x%llx\n", info->objecttypename, (unsigned long long)object->oid);
+
+    for (pos = 0; pos < info->attrmetadatalength; pos++)
+    {
+        const lai_attr_metadata_t *md = info->attrmetadata[pos];
+
+        if (object->values[pos] == NULL)
+        {
+            continue;
+        }
+
+        if (!md->isprimitive && md->attrvaluetype != LAI_ATTR_VALUE_TYPE_CHARDATA)
+        {
+            fprintf(file, "    %s (list)\n", md->attridname);
+            continue;
+        }
+
+        attr.id = md->attrid;
+        attr.value = *object->values[pos];
+
+        if (lai_serialize_attribute(buffer, md, &attr) < 0)
+        {
+            fprintf(file, "    %s (not serializable)\n", md->attridname);
+            continue;
+        }
+
+        fprintf(file, "    %s\n", buffer);
+    }
+}
+
+lai_status_t lai_dbg_generate_dump(
+        _In_ const char *dump_file_name)
+{
+    FILE *file;
+    char *buffer;
+    size_t idx;
+    size_t ot;
+    size_t slot;
+
+    if (dump_file_name == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    /* chardata may be escaped, 4 characters per byte in worst case */
+
+    buffer = (char*)malloc(8192);
+
+    if (buffer == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    file = fopen(dump_file_name, "w");
+
+    if (file == NULL)
+    {
+        free(buffer);
+        return LAI_STATUS_FAILURE;
+    }
+
+    for (idx = 0; idx < VS_MAX_LINECARDS; idx++)
+    {
+        vs_linecard_t *lc = &vs_linecards[idx];
+
+        pthread_rwlock_wrlock(&lc->lock);
+
+        if (lc->used)
+        {
+            fprintf(file, "linecard %u\n", (unsigned int)idx);
+
+            for (ot = LAI_OBJECT_TYPE_NULL + 1; ot < LAI_OBJECT_TYPE_MAX; ot++)
+            {
+                const lai_object_type_info_t *info = lai_metadata_get_object_type_info((lai_object_type_t)ot);
+                const vs_table_t *table = &lc->tables[ot];
+
+                for (slot = 0; slot < table->size; slot++)
+                {
+                    if (table->objects[slot].oid != LAI_NULL_OBJECT_ID && !table->objects[slot].removed &&
+                            !table->objects[slot].staged)
+                    {
+                        vs_dump_object(file, info, &table->objects[slot], buffer);
+                    }
+                }
+            }
+        }
+
+        pthread_rwlock_unlock(&lc->lock);
+    }
+
+    fclose(file);
+    free(buffer);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_object_type_get_availability(
+        _In_ lai_object_id_t linecard_gid,
+        _In_ lai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list,
+        _Out_ uint64_t *count)
+{
+    pthread_mutex_t *lock;
+    vs_linecard_t *lc;
+
+    if (count == NULL || !lai_metadata_is_object_type_valid(object_type) ||
+            lai_object_type_query(linecard_gid) != LAI_OBJECT_TYPE_LINECARD)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    lock = vs_domain_enter(object_type, linecard_gid);
+
+    if (vs_object_lock(linecard_gid, false, &lc) == NULL)
+    {
+        vs_domain_leave(lock);
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    *count = VS_SLOT_MASK - lc->tables[object_type].count;
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    vs_domain_leave(lock);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_query_attribute_capability(
+        _In_ lai_object_id_t linecard_gid,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_attr_id_t attr_id,
+        _Out_ lai_attr_capability_t *attr_capability)
+{
+    const lai_attr_metadata_t *md = lai_metadata_get_attr_metadata(object_type, attr_id);
+
+    if (md == NULL || attr_capability == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    attr_capability->create_implemented = md->ismandatoryoncreate || md->iscreateonly || md->iscreateandset;
+    attr_capability->set_implemented = md->iscreateandset || md->issetonly;
+    attr_capability->get_implemented = !md->issetonly;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_get_object_generation(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _Out_ lai_generation_t *generation)
+{
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    VS_SERIALIZED(object_type, object_id, vs_store_get_generation(object_type, object_id, generation))
+}
+
+lai_status_t lai_get_changed_attributes(
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_generation_t since,
+        _Out_ lai_generation_t *generation,
+        _Inout_ uint32_t *attr_count,
+        _Out_ lai_object_id_t *object_list,
+        _Inout_ lai_attribute_t *attr_list)
+{
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    VS_SERIALIZED(LAI_OBJECT_TYPE_LINECARD, linecard_id,
+            vs_store_get_changed(linecard_id, since, generation, attr_count, object_list, attr_list))
+}
+
+lai_status_t lai_get_attribute_ext(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ lai_read_mode_t read_mode,
+        _In_ uint64_t max_age,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list,
+        _Out_ uint64_t *timestamp_list)
+{
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    VS_SERIALIZED(object_type, object_id,
+            vs_generic_get_ext(object_type, object_id, read_mode, max_age, attr_count, attr_list, timestamp_list))
+}
+
+lai_status_t lai_begin_transaction(
+        _In_ lai_object_id_t linecard_id)
+{
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    VS_SERIALIZED(LAI_OBJECT_TYPE_LINECARD, linecard_id, vs_store_begin_transaction(linecard_id))
+}
+
+lai_status_t lai_commit_transaction(
+        _In_ lai_object_id_t linecard_id)
+{
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    VS_SERIALIZED(LAI_OBJECT_TYPE_LINECARD, linecard_id, vs_store_end_transaction(linecard_id, true))
+}
+
+lai_status_t lai_abort_transaction(
+        _In_ lai_object_id_t linecard_id)
+{
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    VS_SERIALIZED(LAI_OBJECT_TYPE_LINECARD, linecard_id, vs_store_end_transaction(linecard_id, false))
+}
+
+lai_status_t lai_query_attribute_enum_values_capability(
+        _In_ lai_object_id_t linecard_gid,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_attr_id_t attr_id,
+        _Inout_ lai_s32_list_t *enum_values_capability)
+{
+    const lai_attr_metadata_t *md = lai_metadata_get_attr_metadata(object_type, attr_id);
+    const lai_enum_metadata_t *emd;
+    size_t idx;
+
+    if (md == NULL || md->enummetadata == NULL || enum_values_capability == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    emd = md->enummetadata;
+
+    if (enum_values_capability->count < emd->valuescount || enum_values_capability->list == NULL)
+    {
+        enum_values_capability->count = (uint32_t)emd->valuescount;
+        return LAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    for (idx = 0; idx < emd->valuescount; idx++)
+    {
+        enum_values_capability->list[idx] = emd->values[idx];
+    }
+
+    enum_values_capability->count = (uint32_t)emd->valuescount;
+
+    return LAI_STATUS_SUCCESS;
+}
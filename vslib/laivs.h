@@ -0,0 +1,807 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laivs.h
+ *
+ * @brief   This module defines LAI Virtual Adapter internals
+ */
+
+#ifndef __LAIVS_H_
+#define __LAIVS_H_
+
+#include <pthread.h>
+#include <lai.h>
+#include "laimetadata.h"
+
+/**
+ * @defgroup LAIVS LAI - Virtual Adapter Definitions
+ *
+ * Virtual adapter keeps all objects in memory. Every linecard has its own
+ * lock and its own table per object type, object id encodes object type,
+ * linecard index and slot in the table, so every lookup is direct index.
+ * Index bits above slot count reuses of slot, so id of removed object
+ * never finds object created later in the same slot.
+ *
+ * Attribute values are stored only when created or set, other attributes
+ * are returned from metadata default value or synthesized. Statistics are
+ * synthesized from time and object id.
+ *
+ * @{
+ */
+
+/**
+ * @brief Maximum number of linecards
+ */
+#define VS_MAX_LINECARDS            256
+
+/**
+ * @brief Maximum number of API contexts, context id is linecard index
+ */
+#define VS_MAX_CONTEXTS             16
+
+/**
+ * @brief Number of object id index bits holding table slot
+ */
+#define VS_SLOT_BITS                32
+
+/**
+ * @brief Mask of table slot in object id index
+ */
+#define VS_SLOT_MASK                ((lai_object_id_t)0xFFFFFFFFULL)
+
+/**
+ * @brief Mask of slot reuse count in object id index above slot bits
+ */
+#define VS_REUSE_MASK               ((lai_object_id_t)0xFFFFULL)
+
+/**
+ * @brief Gets table slot of object id
+ */
+#define VS_OBJECT_ID_SLOT(_O_)      ((size_t)(LAI_OBJECT_ID_INDEX(_O_) & VS_SLOT_MASK))
+
+/**
+ * @brief Profile key of notification timer interval in milliseconds
+ */
+#define VS_KEY_NOTIFY_INTERVAL      "LAI_VS_NOTIFY_INTERVAL_MS"
+
+/**
+ * @brief Default notification timer interval in milliseconds
+ */
+#define VS_DEFAULT_NOTIFY_INTERVAL  1000
+
+/**
+ * @brief Single object
+ */
+typedef struct _vs_object_t
+{
+    /**
+     * @brief Object id, #LAI_NULL_OBJECT_ID when slot is free.
+     */
+    lai_object_id_t oid;
+
+    /**
+     * @brief Creation time in milliseconds.
+     */
+    uint64_t created;
+
+    /**
+     * @brief Stored values, indexed as object type attribute metadata.
+     */
+    lai_attribute_value_t **values;
+
+    /**
+     * @brief Generations of last change, indexed as values.
+     */
+    lai_generation_t *generations;
+
+    /**
+     * @brief Times in nanoseconds since epoch of last write or hardware read, indexed as values.
+     */
+    uint64_t *timestamps;
+
+    /**
+     * @brief Generation of creation or of last changed attribute.
+     */
+    lai_generation_t generation;
+
+    /**
+     * @brief Counter values at last clear, indexed by statistics id.
+     */
+    uint64_t *cleared;
+
+    /**
+     * @brief Number of objects removed from slot, kept when slot is freed and encoded in object id.
+     */
+    uint64_t reuse;
+
+    /**
+     * @brief Time in milliseconds of the last drained sample or of sampling restart.
+     */
+    uint64_t sampled;
+
+    /**
+     * @brief Scan was requested and result is not yet notified.
+     */
+    bool scan;
+
+    /**
+     * @brief Removal is staged by open transaction, object is hidden until commit.
+     */
+    bool removed;
+
+    /**
+     * @brief Creation is staged by open transaction, object is hidden from reads until commit.
+     */
+    bool staged;
+
+} vs_object_t;
+
+/**
+ * @brief Objects of single object type on single linecard
+ */
+typedef struct _vs_table_t
+{
+    /**
+     * @brief Object slots.
+     */
+    vs_object_t *objects;
+
+    /**
+     * @brief Number of slots ever used.
+     */
+    size_t size;
+
+    /**
+     * @brief Number of allocated slots.
+     */
+    size_t capacity;
+
+    /**
+     * @brief Number of existing objects.
+     */
+    size_t count;
+
+    /**
+     * @brief Free slots, used as stack.
+     */
+    size_t *free_slots;
+
+    /**
+     * @brief Number of free slots.
+     */
+    size_t free_count;
+
+} vs_table_t;
+
+/**
+ * @brief Type of transaction journal entry
+ */
+typedef enum _vs_change_type_t
+{
+    /** Object was created */
+    VS_CHANGE_CREATE,
+
+    /** Attribute set is staged */
+    VS_CHANGE_SET,
+
+    /** Object removal is staged */
+    VS_CHANGE_REMOVE,
+
+    /** Scan request is staged */
+    VS_CHANGE_SCAN,
+
+} vs_change_type_t;
+
+/**
+ * @brief Transaction journal entry
+ */
+typedef struct _vs_change_t
+{
+    /**
+     * @brief Entry type.
+     */
+    vs_change_type_t type;
+
+    /**
+     * @brief Changed object id.
+     */
+    lai_object_id_t oid;
+
+    /**
+     * @brief Position of set attribute in attribute metadata.
+     */
+    size_t position;
+
+    /**
+     * @brief Staged value of set, NULL once applied.
+     */
+    lai_attribute_value_t *value;
+
+} vs_change_t;
+
+/**
+ * @brief Transaction of single linecard
+ *
+ * Calls are validated when called and journaled. Created objects are
+ * stored hidden from reads, so later calls of transaction can use them,
+ * values of sets, removals and scans wait in journal. Readers see committed
+ * state until commit applies journal in call order, abort discards it.
+ */
+typedef struct _vs_transaction_t
+{
+    /**
+     * @brief Transaction is open.
+     */
+    bool active;
+
+    /**
+     * @brief Status of the first failed call.
+     */
+    lai_status_t status;
+
+    /**
+     * @brief Journal entries in call order.
+     */
+    vs_change_t *changes;
+
+    /**
+     * @brief Number of journal entries.
+     */
+    size_t count;
+
+    /**
+     * @brief Number of allocated journal entries.
+     */
+    size_t capacity;
+
+} vs_transaction_t;
+
+/**
+ * @brief Single linecard
+ */
+typedef struct _vs_linecard_t
+{
+    /**
+     * @brief Linecard exists.
+     */
+    bool used;
+
+    /**
+     * @brief Linecard slot is bound to API context.
+     */
+    bool reserved;
+
+    /**
+     * @brief Lock protecting all tables of linecard, shared by readers.
+     */
+    pthread_rwlock_t lock;
+
+    /**
+     * @brief Tables per object type, linecard itself is in linecard table.
+     */
+    vs_table_t tables[LAI_OBJECT_TYPE_MAX];
+
+    /**
+     * @brief Number of notification timer ticks.
+     */
+    uint64_t ticks;
+
+    /**
+     * @brief Time in milliseconds of next notification timer tick, zero when not scheduled.
+     */
+    uint64_t due;
+
+    /**
+     * @brief Generation counter, kept when linecard is removed.
+     */
+    lai_generation_t generation;
+
+    /**
+     * @brief Open transaction.
+     */
+    vs_transaction_t transaction;
+
+} vs_linecard_t;
+
+/**
+ * @brief All linecards
+ */
+extern vs_linecard_t vs_linecards[VS_MAX_LINECARDS];
+
+/**
+ * @brief Domain of lai_api_initialize() method tables, contexts use their id
+ */
+#define VS_API_DOMAIN               VS_MAX_CONTEXTS
+
+/**
+ * @brief Calls sharing concurrency mode, services and profile
+ *
+ * Every API context is domain of its own, method tables of
+ * lai_api_initialize() are the last domain.
+ */
+typedef struct _vs_domain_t
+{
+    /**
+     * @brief Domain is in use.
+     */
+    bool active;
+
+    /**
+     * @brief Concurrency mode of calls.
+     */
+    lai_api_concurrency_mode_t mode;
+
+    /**
+     * @brief Services passed by adapter host.
+     */
+    lai_service_method_table_t services;
+
+    /**
+     * @brief Profile read through services.
+     */
+    lai_metadata_profile_t profile;
+
+    /**
+     * @brief Notification timer interval of domain linecards in milliseconds, zero disables timer.
+     */
+    uint64_t notify_interval;
+
+    /**
+     * @brief Recursive locks, the first one serializes all calls in single
+     * threaded mode, the others calls of their object type.
+     */
+    pthread_mutex_t locks[LAI_OBJECT_TYPE_MAX];
+
+} vs_domain_t;
+
+/**
+ * @brief Lock protecting linecard creation and removal
+ */
+extern pthread_mutex_t vs_global_lock;
+
+/**
+ * @brief Whether adapter is initialized
+ */
+extern bool vs_initialized;
+
+/**
+ * @brief API method tables indexed by API id
+ */
+extern void* const vs_api_tables[LAI_API_MAX];
+
+/**
+ * @brief Lock serializing adapter and API context initialization
+ */
+extern pthread_mutex_t vs_adapter_lock;
+
+/**
+ * @brief Starts adapter on first user, adapter lock must be held
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_adapter_acquire(void);
+
+/**
+ * @brief Stops adapter after last user, adapter lock must be held
+ */
+extern void vs_adapter_release(void);
+
+/**
+ * @brief Opens domain, adapter lock must be held
+ *
+ * Profile is loaded through services with context id as profile id, zero
+ * for #VS_API_DOMAIN, calls are serialized by concurrency mode from now on.
+ *
+ * @param[in] domain Context id or #VS_API_DOMAIN
+ * @param[in] mode Concurrency mode
+ * @param[in] services Services passed by adapter host
+ */
+extern void vs_domain_open(
+        _In_ size_t domain,
+        _In_ lai_api_concurrency_mode_t mode,
+        _In_ const lai_service_method_table_t *services);
+
+/**
+ * @brief Closes domain, adapter lock must be held
+ *
+ * @param[in] domain Context id or #VS_API_DOMAIN
+ */
+extern void vs_domain_close(
+        _In_ size_t domain);
+
+/**
+ * @brief Gets domain of linecard slot
+ *
+ * @param[in] linecard_index Linecard index
+ *
+ * @return Context domain when slot is bound to open context, otherwise domain of lai_api_initialize()
+ */
+extern vs_domain_t* vs_domain_get(
+        _In_ size_t linecard_index);
+
+/**
+ * @brief Enters call on object as concurrency mode of its domain requires
+ *
+ * Domain is found from linecard index of object id, linecard slot bound to
+ * context belongs to context domain.
+ *
+ * @param[in] object_type Object type
+ * @param[in] object_id Object or linecard id, #LAI_NULL_OBJECT_ID for linecard create
+ *
+ * @return Lock held by call, NULL when call runs concurrently
+ */
+extern pthread_mutex_t* vs_domain_enter(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id);
+
+/**
+ * @brief Leaves call entered by vs_domain_enter()
+ *
+ * @param[in] lock Lock returned by vs_domain_enter()
+ */
+extern void vs_domain_leave(
+        _In_ pthread_mutex_t *lock);
+
+/**
+ * @brief Function body returning status of call made within domain of object
+ */
+#define VS_SERIALIZED(ot, object_id, call) \
+    { \
+        pthread_mutex_t *lock = vs_domain_enter(ot, object_id); \
+        lai_status_t status = call; \
+        vs_domain_leave(lock); \
+        return status; \
+    }
+
+/**
+ * @brief Gets current time in milliseconds
+ *
+ * @return Monotonic time in milliseconds
+ */
+extern uint64_t vs_now(void);
+
+/**
+ * @brief Gets object from locked linecard
+ *
+ * Readers share linecard lock, so statistics polling does not wait for
+ * other readers.
+ *
+ * @param[in] object_id Object id
+ * @param[in] write Lock linecard exclusively
+ * @param[out] linecard Linecard of object, locked on success
+ *
+ * @return Object or NULL if object does not exist
+ */
+extern vs_object_t* vs_object_lock(
+        _In_ lai_object_id_t object_id,
+        _In_ bool write,
+        _Out_ vs_linecard_t **linecard);
+
+/**
+ * @brief Creates object of any object type
+ *
+ * @param[in] object_type Object type
+ * @param[out] object_id Created object id
+ * @param[in] linecard_id Linecard id, for linecard id bound to API context
+ * or #LAI_NULL_OBJECT_ID for any free linecard
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attributes
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_generic_create(
+        _In_ lai_object_type_t object_type,
+        _Out_ lai_object_id_t *object_id,
+        _In_ lai_object_id_t linecard_id,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list);
+
+/**
+ * @brief Removes object of any object type
+ *
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_generic_remove(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id);
+
+/**
+ * @brief Sets attribute of any object type
+ *
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[in] attr Attribute
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_generic_set(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ const lai_attribute_t *attr);
+
+/**
+ * @brief Gets attributes of any object type
+ *
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[in] attr_count Number of attributes
+ * @param[inout] attr_list Attributes
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_generic_get(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list);
+
+/**
+ * @brief Gets attributes of any object type with read mode
+ *
+ * Refreshing read takes linecard lock exclusively, cached read shares it.
+ *
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[in] read_mode Read mode
+ * @param[in] max_age Maximum value age in nanoseconds
+ * @param[in] attr_count Number of attributes
+ * @param[inout] attr_list Attributes
+ * @param[out] timestamp_list Value timestamps in nanoseconds since epoch
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_generic_get_ext(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ lai_read_mode_t read_mode,
+        _In_ uint64_t max_age,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list,
+        _Out_ uint64_t *timestamp_list);
+
+/**
+ * @brief Gets statistics of any object type
+ *
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[in] number_of_counters Number of statistics
+ * @param[in] counter_ids Statistics ids
+ * @param[in] mode Statistics mode
+ * @param[out] counters Statistics values
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_generic_get_stats_ext(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids,
+        _In_ lai_stats_mode_t mode,
+        _Out_ lai_stat_value_t *counters);
+
+/**
+ * @brief Clears statistics of any object type
+ *
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[in] number_of_counters Number of statistics
+ * @param[in] counter_ids Statistics ids
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_generic_clear_stats(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids);
+
+/**
+ * @brief Synthesizes raw counter of object, ignoring clears
+ *
+ * @param[in] object Object
+ * @param[in] metadata Statistics metadata
+ * @param[in] now Current time in milliseconds
+ *
+ * @return Counter value since object creation
+ */
+extern uint64_t vs_stats_counter(
+        _In_ const vs_object_t *object,
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ uint64_t now);
+
+/**
+ * @brief Synthesizes statistics value of object
+ *
+ * Counters are reported relative to their last clear.
+ * @param[in] object Object
+ * @param[in] metadata Statistics metadata
+ * @param[in] now Current time in milliseconds
+ * @param[out] value Statistics value
+ */
+extern void vs_stats_synthesize(
+        _In_ const vs_object_t *object,
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ uint64_t now,
+        _Out_ lai_stat_value_t *value);
+
+/**
+ * @brief Drains OA sampling ring
+ *
+ * Statistics are function of time, so ring is not filled by timer, samples
+ * at period boundaries since previous drain are synthesized on drain.
+ *
+ * @param[in] oa_id OA id
+ * @param[inout] count Number of samples fitting the arrays, number of returned samples on return
+ * @param[out] timestamps Sample times in nanoseconds since epoch
+ * @param[out] counters Sample values
+ * @param[out] dropped Number of samples overwritten since previous drain
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_stats_drain_oa_samples(
+        _In_ lai_object_id_t oa_id,
+        _Inout_ uint32_t *count,
+        _Out_ uint64_t *timestamps,
+        _Out_ lai_stat_value_t *counters,
+        _Out_ uint64_t *dropped);
+
+/**
+ * @brief Gets stored attribute value of locked object
+ *
+ * @param[in] object Object
+ * @param[in] object_type Object type
+ * @param[in] attr_id Attribute id
+ *
+ * @return Stored value or NULL if attribute was not created or set
+ */
+extern const lai_attribute_value_t* vs_object_get_value(
+        _In_ const vs_object_t *object,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_attr_id_t attr_id);
+
+/**
+ * @brief Gets generation of object
+ *
+ * @param[in] object_type Object type
+ * @param[in] object_id Object id
+ * @param[out] generation Linecard generation of last object change
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_INVALID_OBJECT_ID if
+ * object does not exist, failure status code on error
+ */
+extern lai_status_t vs_store_get_generation(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _Out_ lai_generation_t *generation);
+
+/**
+ * @brief Gets attributes of linecard objects changed since generation
+ *
+ * @param[in] linecard_id Linecard id
+ * @param[in] since Generation already known to caller
+ * @param[out] generation Current linecard generation
+ * @param[inout] attr_count Number of entries, required number on overflow
+ * @param[out] object_list Object ids of changed attributes
+ * @param[inout] attr_list Changed attributes, lists with count only
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_BUFFER_OVERFLOW if
+ * list size insufficient, failure status code on error
+ */
+extern lai_status_t vs_store_get_changed(
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_generation_t since,
+        _Out_ lai_generation_t *generation,
+        _Inout_ uint32_t *attr_count,
+        _Out_ lai_object_id_t *object_list,
+        _Inout_ lai_attribute_t *attr_list);
+
+/**
+ * @brief Opens transaction on linecard
+ *
+ * @param[in] linecard_id Linecard id
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_OBJECT_IN_USE if
+ * transaction is already open, failure status code on error
+ */
+extern lai_status_t vs_store_begin_transaction(
+        _In_ lai_object_id_t linecard_id);
+
+/**
+ * @brief Closes transaction on linecard, applying or undoing its journal
+ *
+ * @param[in] linecard_id Linecard id
+ * @param[in] commit Apply staged changes unless some call failed
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_ITEM_NOT_FOUND if no
+ * transaction is open, status of the first failed call on commit
+ */
+extern lai_status_t vs_store_end_transaction(
+        _In_ lai_object_id_t linecard_id,
+        _In_ bool commit);
+
+/**
+ * @brief Removes all objects of all linecards
+ */
+extern void vs_store_clear(void);
+
+/**
+ * @brief Binds free linecard slot to API context
+ *
+ * @param[in] linecard_index Linecard index
+ *
+ * @return #LAI_STATUS_SUCCESS on success, #LAI_STATUS_OBJECT_IN_USE if slot is used
+ */
+extern lai_status_t vs_store_bind_linecard(
+        _In_ size_t linecard_index);
+
+/**
+ * @brief Removes all objects of linecard slot and unbinds it from API context
+ *
+ * @param[in] linecard_index Linecard index
+ */
+extern void vs_store_unbind_linecard(
+        _In_ size_t linecard_index);
+
+/**
+ * @brief Starts notification timer
+ *
+ * Every linecard ticks with notification interval of its domain.
+ *
+ * @return #LAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern lai_status_t vs_notify_start(void);
+
+/**
+ * @brief Wakes notification timer to schedule new linecard
+ */
+extern void vs_notify_wake(void);
+
+/**
+ * @brief Stops notification timer
+ */
+extern void vs_notify_stop(void);
+
+/**
+ * @brief Checks whether notification timer ticks linecard
+ *
+ * @param[in] linecard_id Linecard id
+ *
+ * @return True if timer is running and interval of linecard domain is not zero
+ */
+extern bool vs_notify_active(
+        _In_ lai_object_id_t linecard_id);
+
+/**
+ * @brief Advances pending asynchronous operations and notifies them
+ *
+ * @param[in] linecard_id Linecard id, #LAI_NULL_OBJECT_ID advances operations of all linecards
+ *
+ * @return Number of operations of linecard still pending
+ */
+extern size_t vs_async_tick(
+        _In_ lai_object_id_t linecard_id);
+
+/**
+ * @brief Drops all pending asynchronous operations
+ */
+extern void vs_async_clear(void);
+
+/**
+ * @}
+ */
+#endif /** __LAIVS_H_ */
@@ -0,0 +1,345 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laivsasync.c
+ *
+ * @brief   This module implements LAI Virtual Adapter asynchronous operations
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <stdlib.h>
+#include "laivs.h"
+
+/*
+ * Set is applied immediately, so validation errors are returned to the
+ * caller. Long running operations then advance on every notification timer
+ * tick of their linecard, other sets complete on next tick. Get is executed on completion,
+ * since caller keeps attribute list until then. Callbacks are called
+ * without locks held, always from timer thread. Request id is stored before
+ * request is queued, so it is known to caller before any callback of it.
+ * Linecards without timer wake timer thread, which completes their
+ * requests at once.
+ */
+
+#define VS_ASYNC_LONG_STEP      25
+#define VS_ASYNC_SHORT_STEP     100
+
+typedef struct _vs_async_request_t
+{
+    lai_request_id_t request_id;
+    lai_linecard_async_operation_notification_fn callback;
+    lai_object_id_t linecard_id;
+    lai_object_type_t object_type;
+    lai_object_id_t object_id;
+
+    /* get only, owned by caller */
+    uint32_t attr_count;
+    lai_attribute_t *attr_list;
+
+    uint8_t progress;
+    uint8_t step;
+
+} vs_async_request_t;
+
+static pthread_mutex_t vs_async_lock = PTHREAD_MUTEX_INITIALIZER;
+static vs_async_request_t *vs_async_requests = NULL;
+static size_t vs_async_count = 0;
+static size_t vs_async_capacity = 0;
+static lai_request_id_t vs_async_next_id = 1;
+
+static bool vs_async_is_long(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_attr_id_t attr_id)
+{
+    switch (object_type)
+    {
+        case LAI_OBJECT_TYPE_LINECARD:
+            return attr_id == LAI_LINECARD_ATTR_UPGRADE_DOWNLOAD || attr_id == LAI_LINECARD_ATTR_RESET;
+
+        case LAI_OBJECT_TYPE_TRANSCEIVER:
+            return attr_id == LAI_TRANSCEIVER_ATTR_UPGRADE_DOWNLOAD;
+
+        case LAI_OBJECT_TYPE_OCM:
+            return attr_id == LAI_OCM_ATTR_SCAN;
+
+        case LAI_OBJECT_TYPE_OTDR:
+            return attr_id == LAI_OTDR_ATTR_SCAN;
+
+        default:
+            return false;
+    }
+}
+
+static lai_status_t vs_async_callback(
+        _In_ lai_object_id_t object_id,
+        _Out_ lai_linecard_async_operation_notification_fn *callback)
+{
+    lai_object_id_t linecard_id = lai_linecard_id_query(object_id);
+    const lai_attribute_value_t *value;
+    const vs_object_t *linecard;
+    vs_linecard_t *lc;
+
+    *callback = NULL;
+
+    linecard = vs_object_lock(linecard_id, false, &lc);
+
+    if (linecard == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    value = vs_object_get_value(linecard, LAI_OBJECT_TYPE_LINECARD, LAI_LINECARD_ATTR_LINECARD_ASYNC_OPERATION_NOTIFY);
+
+    if (value != NULL)
+    {
+        *callback = (lai_linecard_async_operation_notification_fn)value->ptr;
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return *callback == NULL ? LAI_STATUS_UNINITIALIZED : LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t vs_async_enqueue(
+        _Inout_ vs_async_request_t *request,
+        _Out_ lai_request_id_t *request_id)
+{
+    vs_async_request_t *requests;
+    size_t capacity;
+
+    pthread_mutex_lock(&vs_async_lock);
+
+    if (vs_async_count == vs_async_capacity)
+    {
+        capacity = vs_async_capacity == 0 ? 16 : vs_async_capacity * 2;
+
+        requests = (vs_async_request_t*)realloc(vs_async_requests, capacity * sizeof(vs_async_request_t));
+
+        if (requests == NULL)
+        {
+            pthread_mutex_unlock(&vs_async_lock);
+            return LAI_STATUS_NO_MEMORY;
+        }
+
+        vs_async_requests = requests;
+        vs_async_capacity = capacity;
+    }
+
+    request->request_id = vs_async_next_id++;
+
+    vs_async_requests[vs_async_count++] = *request;
+
+    *request_id = request->request_id;
+
+    pthread_mutex_unlock(&vs_async_lock);
+
+    if (!vs_notify_active(request->linecard_id))
+    {
+        vs_notify_wake();
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+size_t vs_async_tick(
+        _In_ lai_object_id_t linecard_id)
+{
+    vs_async_request_t *due;
+    size_t count = 0;
+    size_t kept = 0;
+    size_t pending = 0;
+    size_t idx;
+    lai_status_t status;
+    bool completed;
+
+    pthread_mutex_lock(&vs_async_lock);
+
+    if (vs_async_count == 0)
+    {
+        pthread_mutex_unlock(&vs_async_lock);
+        return 0;
+    }
+
+    due = (vs_async_request_t*)malloc(vs_async_count * sizeof(vs_async_request_t));
+
+    if (due == NULL)
+    {
+        pthread_mutex_unlock(&vs_async_lock);
+        return vs_async_count;
+    }
+
+    for (idx = 0; idx < vs_async_count; idx++)
+    {
+        vs_async_request_t *request = &vs_async_requests[idx];
+
+        if (linecard_id == LAI_NULL_OBJECT_ID || request->linecard_id == linecard_id)
+        {
+            request->progress = (uint8_t)(request->progress + request->step > 100 ? 100 : request->progress + request->step);
+
+            due[count++] = *request;
+
+            if (request->progress >= 100)
+            {
+                continue;
+            }
+
+            pending++;
+        }
+
+        vs_async_requests[kept++] = *request;
+    }
+
+    vs_async_count = kept;
+
+    pthread_mutex_unlock(&vs_async_lock);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        completed = due[idx].progress >= 100;
+        status = LAI_STATUS_SUCCESS;
+
+        if (completed && due[idx].attr_list != NULL)
+        {
+            status = vs_generic_get(due[idx].object_type, due[idx].object_id, due[idx].attr_count, due[idx].attr_list);
+        }
+
+        due[idx].callback(due[idx].linecard_id, due[idx].request_id, due[idx].object_id, completed, status, due[idx].progress);
+    }
+
+    free(due);
+
+    return pending;
+}
+
+void vs_async_clear(void)
+{
+    pthread_mutex_lock(&vs_async_lock);
+
+    free(vs_async_requests);
+
+    vs_async_requests = NULL;
+    vs_async_count = 0;
+    vs_async_capacity = 0;
+
+    pthread_mutex_unlock(&vs_async_lock);
+}
+
+static lai_status_t vs_async_set(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ const lai_attribute_t *attr,
+        _Out_ lai_request_id_t *request_id)
+{
+    vs_async_request_t request;
+    lai_status_t status;
+
+    memset(&request, 0, sizeof(request));
+
+    status = vs_async_callback(object_id, &request.callback);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    status = vs_generic_set(object_type, object_id, attr);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    request.linecard_id = lai_linecard_id_query(object_id);
+    request.object_type = object_type;
+    request.object_id = object_id;
+    request.step = vs_async_is_long(object_type, attr->id) ? VS_ASYNC_LONG_STEP : VS_ASYNC_SHORT_STEP;
+
+    return vs_async_enqueue(&request, request_id);
+}
+
+static lai_status_t vs_async_get(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list,
+        _Out_ lai_request_id_t *request_id)
+{
+    vs_async_request_t request;
+    lai_status_t status;
+
+    memset(&request, 0, sizeof(request));
+
+    status = vs_async_callback(object_id, &request.callback);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    request.linecard_id = lai_linecard_id_query(object_id);
+    request.object_type = object_type;
+    request.object_id = object_id;
+    request.attr_count = attr_count;
+    request.attr_list = attr_list;
+    request.step = VS_ASYNC_SHORT_STEP;
+
+    return vs_async_enqueue(&request, request_id);
+}
+
+lai_status_t lai_set_attribute_async(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ const lai_attribute_t *attr,
+        _Out_ lai_request_id_t *request_id)
+{
+    if (attr == NULL || request_id == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    VS_SERIALIZED(object_type, object_id, vs_async_set(object_type, object_id, attr, request_id))
+}
+
+lai_status_t lai_get_attribute_async(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list,
+        _Out_ lai_request_id_t *request_id)
+{
+    if (attr_count == 0 || attr_list == NULL || request_id == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    if (lai_object_type_query(object_id) != object_type)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    VS_SERIALIZED(object_type, object_id, vs_async_get(object_type, object_id, attr_count, attr_list, request_id))
+}
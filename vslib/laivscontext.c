@@ -0,0 +1,220 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laivscontext.c
+ *
+ * @brief   This module implements LAI Virtual Adapter API contexts
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include "laivs.h"
+
+/*
+ * Context id is linecard index, so every context has its own linecard lock
+ * and contexts do not contend. Only linecard create has no object id to
+ * find linecard from, so every context gets its own linecard method table
+ * with create bound to context, other tables are shared. Every context
+ * reads profile through its own services with context id as profile id.
+ */
+
+typedef struct _vs_context_t
+{
+    bool initialized;
+
+    lai_linecard_api_t linecard_api;
+
+} vs_context_t;
+
+static vs_context_t vs_contexts[VS_MAX_CONTEXTS];
+
+static lai_status_t vs_context_create_linecard(
+        _In_ lai_api_context_id_t context_id,
+        _Out_ lai_object_id_t *linecard_id,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    lai_object_id_t bound = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_LINECARD, context_id, 0);
+
+    VS_SERIALIZED(LAI_OBJECT_TYPE_LINECARD, bound,
+            vs_generic_create(LAI_OBJECT_TYPE_LINECARD, linecard_id, bound, attr_count, attr_list))
+}
+
+#define VS_CONTEXT_CREATE_LINECARD(id) \
+    static lai_status_t vs_context_create_linecard_##id( \
+            _Out_ lai_object_id_t *linecard_id, \
+            _In_ uint32_t attr_count, \
+            _In_ const lai_attribute_t *attr_list) \
+    { \
+        return vs_context_create_linecard(id, linecard_id, attr_count, attr_list); \
+    }
+
+VS_CONTEXT_CREATE_LINECARD(0)
+VS_CONTEXT_CREATE_LINECARD(1)
+VS_CONTEXT_CREATE_LINECARD(2)
+VS_CONTEXT_CREATE_LINECARD(3)
+VS_CONTEXT_CREATE_LINECARD(4)
+VS_CONTEXT_CREATE_LINECARD(5)
+VS_CONTEXT_CREATE_LINECARD(6)
+VS_CONTEXT_CREATE_LINECARD(7)
+VS_CONTEXT_CREATE_LINECARD(8)
+VS_CONTEXT_CREATE_LINECARD(9)
+VS_CONTEXT_CREATE_LINECARD(10)
+VS_CONTEXT_CREATE_LINECARD(11)
+VS_CONTEXT_CREATE_LINECARD(12)
+VS_CONTEXT_CREATE_LINECARD(13)
+VS_CONTEXT_CREATE_LINECARD(14)
+VS_CONTEXT_CREATE_LINECARD(15)
+
+static const lai_create_linecard_fn vs_context_create_linecard_fns[VS_MAX_CONTEXTS] = {
+    vs_context_create_linecard_0,
+    vs_context_create_linecard_1,
+    vs_context_create_linecard_2,
+    vs_context_create_linecard_3,
+    vs_context_create_linecard_4,
+    vs_context_create_linecard_5,
+    vs_context_create_linecard_6,
+    vs_context_create_linecard_7,
+    vs_context_create_linecard_8,
+    vs_context_create_linecard_9,
+    vs_context_create_linecard_10,
+    vs_context_create_linecard_11,
+    vs_context_create_linecard_12,
+    vs_context_create_linecard_13,
+    vs_context_create_linecard_14,
+    vs_context_create_linecard_15,
+};
+
+lai_status_t lai_api_context_initialize(
+        _In_ lai_api_context_id_t context_id,
+        _In_ uint64_t flags,
+        _In_ const lai_service_method_table_t *services)
+{
+    vs_context_t *context;
+    lai_status_t status;
+
+    if (context_id >= VS_MAX_CONTEXTS || flags > LAI_API_CONCURRENCY_MODE_CONCURRENT_READS)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    context = &vs_contexts[context_id];
+
+    pthread_mutex_lock(&vs_adapter_lock);
+
+    if (context->initialized)
+    {
+        pthread_mutex_unlock(&vs_adapter_lock);
+        return LAI_STATUS_FAILURE;
+    }
+
+    status = vs_adapter_acquire();
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        status = vs_store_bind_linecard(context_id);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            vs_adapter_release();
+        }
+    }
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        context->linecard_api = *(const lai_linecard_api_t*)vs_api_tables[LAI_API_LINECARD];
+        context->linecard_api.create_linecard = vs_context_create_linecard_fns[context_id];
+
+        vs_domain_open(context_id, (lai_api_concurrency_mode_t)flags, services);
+
+        context->initialized = true;
+    }
+
+    pthread_mutex_unlock(&vs_adapter_lock);
+
+    return status;
+}
+
+lai_status_t lai_api_context_query(
+        _In_ lai_api_context_id_t context_id,
+        _In_ lai_api_t api,
+        _Out_ void **api_method_table)
+{
+    if (context_id >= VS_MAX_CONTEXTS || api_method_table == NULL ||
+            api <= LAI_API_UNSPECIFIED || api >= LAI_API_MAX)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!vs_contexts[context_id].initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    *api_method_table = (api == LAI_API_LINECARD) ? &vs_contexts[context_id].linecard_api : vs_api_tables[api];
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t lai_api_context_uninitialize(
+        _In_ lai_api_context_id_t context_id)
+{
+    lai_status_t status = LAI_STATUS_UNINITIALIZED;
+
+    if (context_id >= VS_MAX_CONTEXTS)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&vs_adapter_lock);
+
+    if (vs_contexts[context_id].initialized)
+    {
+        vs_contexts[context_id].initialized = false;
+
+        vs_domain_close(context_id);
+
+        vs_store_unbind_linecard(context_id);
+
+        vs_adapter_release();
+
+        status = LAI_STATUS_SUCCESS;
+    }
+
+    pthread_mutex_unlock(&vs_adapter_lock);
+
+    return status;
+}
+
+lai_status_t lai_api_context_log_set(
+        _In_ lai_api_context_id_t context_id,
+        _In_ lai_api_t api,
+        _In_ lai_log_level_t log_level)
+{
+    if (context_id >= VS_MAX_CONTEXTS)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (!vs_contexts[context_id].initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    /* metadata logger is shared, so level applies to all contexts */
+
+    return lai_log_set(api, log_level);
+}
@@ -0,0 +1,483 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laivsnotify.c
+ *
+ * @brief   This module implements LAI Virtual Adapter notifications
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "laivs.h"
+
+/*
+ * Every tick each linecard may raise or clear alarm, report OCM spectrum
+ * and OTDR result. Scan attribute makes report on next tick, otherwise
+ * reports are periodic, then pending asynchronous operations advance.
+ * Callbacks are called without linecard lock, so they can call LAI APIs.
+ * Linecards tick with interval of their domain, timer sleeps until the
+ * nearest one is due and is woken when linecard is created. Linecards with
+ * zero interval never tick, their asynchronous operations are completed
+ * whenever timer is woken.
+ */
+
+#define VS_ALARM_PERIOD         10
+#define VS_OCM_PERIOD           10
+#define VS_OTDR_PERIOD          60
+#define VS_OCM_CHANNELS         96
+#define VS_OCM_START_FREQUENCY  191350000
+#define VS_OCM_CHANNEL_WIDTH    50000
+#define VS_OTDR_TRACE_POINTS    1000
+
+static pthread_t vs_notify_thread;
+static pthread_mutex_t vs_notify_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t vs_notify_cond = PTHREAD_COND_INITIALIZER;
+static bool vs_notify_running = false;
+static bool vs_notify_woken = false;
+
+typedef struct _vs_notify_work_t
+{
+    lai_object_id_t linecard_id;
+    uint64_t ticks;
+
+    lai_linecard_alarm_notification_fn on_alarm;
+    lai_linecard_ocm_spectrum_power_notification_fn on_ocm;
+    lai_linecard_otdr_result_notification_fn on_otdr;
+
+    lai_object_id_t *ocm_ids;
+    size_t ocm_count;
+
+    lai_object_id_t *otdr_ids;
+    size_t otdr_count;
+
+} vs_notify_work_t;
+
+static lai_pointer_t vs_notify_callback(
+        _In_ const vs_object_t *linecard,
+        _In_ lai_attr_id_t attr_id)
+{
+    const lai_attribute_value_t *value = vs_object_get_value(linecard, LAI_OBJECT_TYPE_LINECARD, attr_id);
+
+    return value == NULL ? NULL : value->ptr;
+}
+
+/*
+ * Collects objects due for report and clears their scan flag.
+ */
+
+static lai_object_id_t* vs_notify_collect(
+        _Inout_ vs_table_t *table,
+        _In_ bool periodic,
+        _Out_ size_t *count)
+{
+    lai_object_id_t *ids;
+    size_t slot;
+
+    *count = 0;
+
+    if (table->count == 0)
+    {
+        return NULL;
+    }
+
+    ids = (lai_object_id_t*)malloc(table->count * sizeof(lai_object_id_t));
+
+    if (ids == NULL)
+    {
+        return NULL;
+    }
+
+    for (slot = 0; slot < table->size; slot++)
+    {
+        vs_object_t *object = &table->objects[slot];
+
+        if (object->oid != LAI_NULL_OBJECT_ID && !object->removed && !object->staged && (periodic || object->scan))
+        {
+            ids[(*count)++] = object->oid;
+        }
+
+        object->scan = false;
+    }
+
+    return ids;
+}
+
+/*
+ * Schedules linecard and prepares its work when tick is due, next is
+ * lowered to time of next tick. Linecard without timer only sets linecard
+ * id of work.
+ */
+
+static bool vs_notify_prepare(
+        _In_ size_t linecard_index,
+        _In_ uint64_t now,
+        _Inout_ uint64_t *next,
+        _Out_ vs_notify_work_t *work)
+{
+    vs_linecard_t *lc = &vs_linecards[linecard_index];
+    uint64_t interval = __atomic_load_n(&vs_domain_get(linecard_index)->notify_interval, __ATOMIC_RELAXED);
+    const vs_object_t *linecard;
+    uint64_t ticks;
+
+    memset(work, 0, sizeof(vs_notify_work_t));
+
+    pthread_rwlock_wrlock(&lc->lock);
+
+    if (!lc->used || lc->tables[LAI_OBJECT_TYPE_LINECARD].count == 0 || interval == 0)
+    {
+        if (lc->used && lc->tables[LAI_OBJECT_TYPE_LINECARD].count != 0)
+        {
+            work->linecard_id = lc->tables[LAI_OBJECT_TYPE_LINECARD].objects[0].oid;
+        }
+
+        lc->due = 0;
+
+        pthread_rwlock_unlock(&lc->lock);
+        return false;
+    }
+
+    if (lc->due == 0)
+    {
+        lc->due = now + interval;
+    }
+
+    if (now < lc->due)
+    {
+        *next = (*next == 0 || lc->due < *next) ? lc->due : *next;
+
+        pthread_rwlock_unlock(&lc->lock);
+        return false;
+    }
+
+    /* late ticks are dropped, not made up */
+
+    lc->due = (lc->due + interval > now) ? lc->due + interval : now + interval;
+
+    *next = (*next == 0 || lc->due < *next) ? lc->due : *next;
+
+    linecard = &lc->tables[LAI_OBJECT_TYPE_LINECARD].objects[0];
+
+    ticks = ++lc->ticks;
+
+    work->linecard_id = linecard->oid;
+    work->ticks = ticks;
+
+    work->on_alarm = (lai_linecard_alarm_notification_fn)vs_notify_callback(linecard, LAI_LINECARD_ATTR_LINECARD_ALARM_NOTIFY);
+    work->on_ocm = (lai_linecard_ocm_spectrum_power_notification_fn)vs_notify_callback(linecard, LAI_LINECARD_ATTR_LINECARD_OCM_SPECTRUM_POWER_NOTIFY);
+    work->on_otdr = (lai_linecard_otdr_result_notification_fn)vs_notify_callback(linecard, LAI_LINECARD_ATTR_LINECARD_OTDR_RESULT_NOTIFY);
+
+    if (work->on_ocm != NULL)
+    {
+        work->ocm_ids = vs_notify_collect(&lc->tables[LAI_OBJECT_TYPE_OCM], ticks % VS_OCM_PERIOD == 0, &work->ocm_count);
+    }
+
+    if (work->on_otdr != NULL)
+    {
+        work->otdr_ids = vs_notify_collect(&lc->tables[LAI_OBJECT_TYPE_OTDR], ticks % VS_OTDR_PERIOD == 0, &work->otdr_count);
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return true;
+}
+
+static void vs_notify_alarm(
+        _In_ const vs_notify_work_t *work)
+{
+    static const char text[] = "virtual linecard temperature warning";
+    int8_t buffer[sizeof(text)];
+    lai_alarm_info_t info;
+
+    if (work->on_alarm == NULL || work->ticks % VS_ALARM_PERIOD != 0)
+    {
+        return;
+    }
+
+    memcpy(buffer, text, sizeof(text));
+
+    memset(&info, 0, sizeof(info));
+
+    info.status = (work->ticks / VS_ALARM_PERIOD) % 2 ? LAI_ALARM_STATUS_ACTIVE : LAI_ALARM_STATUS_INACTIVE;
+    info.time_created = (uint64_t)time(NULL) * 1000000000ULL;
+    info.text.count = (uint32_t)(sizeof(text) - 1);
+    info.text.list = buffer;
+    info.resource_oid = work->linecard_id;
+    info.severity = LAI_ALARM_SEVERITY_WARNING;
+
+    work->on_alarm(work->linecard_id, LAI_ALARM_TYPE_HIGH_TEMPERATURE_WARN, info);
+}
+
+static void vs_notify_ocm(
+        _In_ const vs_notify_work_t *work)
+{
+    lai_spectrum_power_t channels[VS_OCM_CHANNELS];
+    lai_spectrum_power_list_t list;
+    size_t idx;
+    size_t ch;
+
+    for (idx = 0; idx < work->ocm_count; idx++)
+    {
+        for (ch = 0; ch < VS_OCM_CHANNELS; ch++)
+        {
+            uint64_t phase = (work->ticks + ch + LAI_OBJECT_ID_INDEX(work->ocm_ids[idx])) % 20;
+
+            channels[ch].lower_frequency = VS_OCM_START_FREQUENCY + ch * VS_OCM_CHANNEL_WIDTH;
+            channels[ch].upper_frequency = channels[ch].lower_frequency + VS_OCM_CHANNEL_WIDTH;
+            channels[ch].power = -20.0 + (lai_double_t)(phase < 10 ? phase : 20 - phase);
+        }
+
+        list.count = VS_OCM_CHANNELS;
+        list.list = channels;
+
+        work->on_ocm(work->linecard_id, work->ocm_ids[idx], list);
+    }
+}
+
+static void vs_notify_otdr(
+        _In_ const vs_notify_work_t *work)
+{
+    lai_otdr_event_t events[3];
+    uint8_t *trace;
+    lai_otdr_result_t result;
+    size_t idx;
+
+    if (work->otdr_count == 0)
+    {
+        return;
+    }
+
+    trace = (uint8_t*)malloc(VS_OTDR_TRACE_POINTS);
+
+    if (trace == NULL)
+    {
+        return;
+    }
+
+    /*
+     * Trace is linear fiber attenuation with single reflection in the middle.
+     */
+
+    for (idx = 0; idx < VS_OTDR_TRACE_POINTS; idx++)
+    {
+        trace[idx] = (uint8_t)(255 - idx * 200 / VS_OTDR_TRACE_POINTS);
+    }
+
+    trace[VS_OTDR_TRACE_POINTS / 2] = 255;
+
+    memset(events, 0, sizeof(events));
+
+    events[0].type = LAI_OTDR_EVENT_TYPE_START;
+    events[1].type = LAI_OTDR_EVENT_TYPE_REFLECTION;
+    events[1].length = 40.0;
+    events[1].loss = 0.5;
+    events[1].reflection = -45.0;
+    events[1].accumulate_loss = 8.5;
+    events[2].type = LAI_OTDR_EVENT_TYPE_END;
+    events[2].length = 80.0;
+    events[2].accumulate_loss = 16.5;
+
+    memset(&result, 0, sizeof(result));
+
+    result.scanning_profile.scan_time = (uint64_t)time(NULL) * 1000000000ULL;
+    result.scanning_profile.distance_range = 80;
+    result.scanning_profile.pulse_width = 1000;
+    result.scanning_profile.average_time = 10;
+    result.scanning_profile.output_frequency = 193100000;
+    result.events.span_distance = 80.0;
+    result.events.span_loss = 16.5;
+    result.events.events.count = 3;
+    result.events.events.list = events;
+    result.trace.update_time = result.scanning_profile.scan_time;
+    result.trace.data.count = VS_OTDR_TRACE_POINTS;
+    result.trace.data.list = trace;
+
+    for (idx = 0; idx < work->otdr_count; idx++)
+    {
+        work->on_otdr(work->linecard_id, work->otdr_ids[idx], result);
+    }
+
+    free(trace);
+}
+
+/*
+ * Ticks due linecards, returns time of next tick, zero when no linecard is
+ * scheduled.
+ */
+
+static uint64_t vs_notify_tick(void)
+{
+    vs_notify_work_t work;
+    uint64_t now = vs_now();
+    uint64_t next = 0;
+    size_t idx;
+
+    for (idx = 0; idx < VS_MAX_LINECARDS; idx++)
+    {
+        if (!vs_notify_prepare(idx, now, &next, &work))
+        {
+            while (work.linecard_id != LAI_NULL_OBJECT_ID && vs_async_tick(work.linecard_id) != 0)
+            {
+            }
+
+            continue;
+        }
+
+        vs_notify_alarm(&work);
+        vs_notify_ocm(&work);
+        vs_notify_otdr(&work);
+
+        free(work.ocm_ids);
+        free(work.otdr_ids);
+
+        vs_async_tick(work.linecard_id);
+    }
+
+    return next;
+}
+
+static void* vs_notify_run(
+        _In_ void *arg)
+{
+    struct timespec deadline;
+    uint64_t next = 0;
+    uint64_t now;
+    bool running;
+
+    pthread_mutex_lock(&vs_notify_lock);
+
+    while (vs_notify_running)
+    {
+        now = vs_now();
+
+        if (next == 0)
+        {
+            while (vs_notify_running && !vs_notify_woken)
+            {
+                pthread_cond_wait(&vs_notify_cond, &vs_notify_lock);
+            }
+        }
+        else if (next > now)
+        {
+            /* monotonic delay, condition waits on realtime clock */
+
+            clock_gettime(CLOCK_REALTIME, &deadline);
+
+            deadline.tv_sec += (time_t)((next - now) / 1000);
+            deadline.tv_nsec += (long)((next - now) % 1000) * 1000000L;
+
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+
+            while (vs_notify_running && !vs_notify_woken &&
+                    pthread_cond_timedwait(&vs_notify_cond, &vs_notify_lock, &deadline) == 0)
+            {
+                /* woken up spuriously, wait until deadline */
+            }
+        }
+
+        vs_notify_woken = false;
+
+        running = vs_notify_running;
+
+        pthread_mutex_unlock(&vs_notify_lock);
+
+        if (running)
+        {
+            next = vs_notify_tick();
+        }
+
+        pthread_mutex_lock(&vs_notify_lock);
+    }
+
+    pthread_mutex_unlock(&vs_notify_lock);
+
+    return NULL;
+}
+
+lai_status_t vs_notify_start(void)
+{
+    pthread_mutex_lock(&vs_notify_lock);
+
+    vs_notify_woken = false;
+    vs_notify_running = true;
+
+    if (pthread_create(&vs_notify_thread, NULL, vs_notify_run, NULL) != 0)
+    {
+        vs_notify_running = false;
+
+        pthread_mutex_unlock(&vs_notify_lock);
+
+        LAI_META_LOG_ERROR("failed to start notification thread");
+
+        return LAI_STATUS_FAILURE;
+    }
+
+    pthread_mutex_unlock(&vs_notify_lock);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+void vs_notify_stop(void)
+{
+    bool running;
+
+    pthread_mutex_lock(&vs_notify_lock);
+
+    running = vs_notify_running;
+
+    vs_notify_running = false;
+
+    pthread_cond_broadcast(&vs_notify_cond);
+
+    pthread_mutex_unlock(&vs_notify_lock);
+
+    if (running)
+    {
+        pthread_join(vs_notify_thread, NULL);
+    }
+}
+
+void vs_notify_wake(void)
+{
+    pthread_mutex_lock(&vs_notify_lock);
+
+    vs_notify_woken = true;
+
+    pthread_cond_broadcast(&vs_notify_cond);
+
+    pthread_mutex_unlock(&vs_notify_lock);
+}
+
+bool vs_notify_active(
+        _In_ lai_object_id_t linecard_id)
+{
+    bool running;
+
+    pthread_mutex_lock(&vs_notify_lock);
+
+    running = vs_notify_running;
+
+    pthread_mutex_unlock(&vs_notify_lock);
+
+    return running &&
+        __atomic_load_n(&vs_domain_get(LAI_OBJECT_ID_LINECARD_INDEX(linecard_id))->notify_interval, __ATOMIC_RELAXED) != 0;
+}
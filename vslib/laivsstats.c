@@ -0,0 +1,277 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laivsstats.c
+ *
+ * @brief   This module implements LAI Virtual Adapter statistics
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <time.h>
+#include "laivs.h"
+#include "laimetadatafixedpoint.h"
+
+/*
+ * Counters grow linearly since object creation, every object and counter
+ * has different rate. Gauges follow triangle wave around value typical for
+ * their unit, so min, max and average of monitoring bins differ.
+ *
+ * OA sampling ring holds samples at multiples of sampling period, between
+ * the last drained sample and now, limited to ring depth.
+ */
+
+static uint64_t vs_stats_seed(
+        _In_ const vs_object_t *object,
+        _In_ const lai_stat_metadata_t *metadata)
+{
+    return LAI_OBJECT_ID_INDEX(object->oid) * 31 + (uint64_t)metadata->statid * 7;
+}
+
+uint64_t vs_stats_counter(
+        _In_ const vs_object_t *object,
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ uint64_t now)
+{
+    uint64_t rate = 1 + vs_stats_seed(object, metadata) % 1000;
+
+    return (now - object->created) * rate / 1000;
+}
+
+static lai_double_t vs_stats_gauge(
+        _In_ const vs_object_t *object,
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ uint64_t now)
+{
+    uint64_t phase = (now / 100 + vs_stats_seed(object, metadata)) % 200;
+    lai_double_t wave = (lai_double_t)(phase < 100 ? phase : 200 - phase) / 100.0;
+
+    switch (metadata->statvalueunit)
+    {
+        case LAI_STAT_VALUE_UNIT_DBM:
+            return -10.0 + 8.0 * wave;
+
+        case LAI_STAT_VALUE_UNIT_DB:
+            return 10.0 + 10.0 * wave;
+
+        default:
+            return 20.0 + 30.0 * wave;
+    }
+}
+
+void vs_stats_synthesize(
+        _In_ const vs_object_t *object,
+        _In_ const lai_stat_metadata_t *metadata,
+        _In_ uint64_t now,
+        _Out_ lai_stat_value_t *value)
+{
+    uint64_t counter;
+    lai_double_t gauge;
+    int64_t scale;
+    int64_t fixed;
+
+    memset(value, 0, sizeof(lai_stat_value_t));
+
+    if (metadata->statvalueiscounter)
+    {
+        counter = vs_stats_counter(object, metadata, now);
+
+        if (object->cleared != NULL)
+        {
+            counter -= object->cleared[metadata->statid];
+        }
+
+        switch (metadata->statvaluetype)
+        {
+            case LAI_STAT_VALUE_TYPE_INT32:
+                value->s32 = (int32_t)(counter & 0x7FFFFFFF);
+                break;
+            case LAI_STAT_VALUE_TYPE_UINT32:
+                value->u32 = (uint32_t)counter;
+                break;
+            case LAI_STAT_VALUE_TYPE_INT64:
+                value->s64 = (int64_t)(counter & 0x7FFFFFFFFFFFFFFFULL);
+                break;
+            case LAI_STAT_VALUE_TYPE_DOUBLE:
+                value->d64 = (lai_double_t)counter;
+                break;
+            default:
+                value->u64 = counter;
+                break;
+        }
+
+        return;
+    }
+
+    gauge = vs_stats_gauge(object, metadata, now);
+
+    switch (metadata->statvaluetype)
+    {
+        case LAI_STAT_VALUE_TYPE_INT32:
+            value->s32 = (int32_t)gauge;
+            break;
+        case LAI_STAT_VALUE_TYPE_UINT32:
+            value->u32 = (uint32_t)gauge;
+            break;
+        case LAI_STAT_VALUE_TYPE_INT64:
+            value->s64 = (int64_t)gauge;
+            break;
+        case LAI_STAT_VALUE_TYPE_UINT64:
+            value->u64 = (uint64_t)gauge;
+            break;
+        default:
+
+            /*
+             * Round to precision from metadata, as real adapter would report.
+             */
+
+            scale = lai_metadata_get_stat_fixed_point_scale(metadata);
+
+            if (scale > 100)
+            {
+                value->d64 = gauge;
+                break;
+            }
+
+            fixed = (int64_t)(gauge * (lai_double_t)scale + (gauge < 0 ? -0.5 : 0.5));
+
+            lai_metadata_fixed_s64_to_stat_values(metadata, 1, &fixed, value);
+            break;
+    }
+}
+
+static uint32_t vs_stats_sampling_u32(
+        _In_ const vs_object_t *object,
+        _In_ lai_attr_id_t attr_id)
+{
+    const lai_attribute_value_t *value = vs_object_get_value(object, LAI_OBJECT_TYPE_OA, attr_id);
+    const lai_attr_metadata_t *md;
+
+    if (value != NULL)
+    {
+        return value->u32;
+    }
+
+    md = lai_metadata_get_attr_metadata(LAI_OBJECT_TYPE_OA, attr_id);
+
+    return (md != NULL && md->defaultvalue != NULL) ? md->defaultvalue->u32 : 0;
+}
+
+lai_status_t vs_stats_drain_oa_samples(
+        _In_ lai_object_id_t oa_id,
+        _Inout_ uint32_t *count,
+        _Out_ uint64_t *timestamps,
+        _Out_ lai_stat_value_t *counters,
+        _Out_ uint64_t *dropped)
+{
+    const lai_attribute_value_t *stats;
+    const lai_stat_metadata_t *md;
+    struct timespec ts;
+    vs_linecard_t *lc;
+    vs_object_t *object;
+    uint64_t now = vs_now();
+    uint64_t epoch;
+    uint64_t period;
+    uint64_t depth;
+    uint64_t first;
+    uint64_t available;
+    uint64_t t;
+    uint32_t n;
+    uint32_t k;
+    uint32_t s;
+
+    if (count == NULL || dropped == NULL || (*count != 0 && (timestamps == NULL || counters == NULL)))
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (lai_object_type_query(oa_id) != LAI_OBJECT_TYPE_OA)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    object = vs_object_lock(oa_id, true, &lc);
+
+    if (object == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    *dropped = 0;
+
+    period = vs_stats_sampling_u32(object, LAI_OA_ATTR_SAMPLING_PERIOD);
+    depth = vs_stats_sampling_u32(object, LAI_OA_ATTR_SAMPLING_DEPTH);
+    stats = vs_object_get_value(object, LAI_OBJECT_TYPE_OA, LAI_OA_ATTR_SAMPLING_STATS);
+
+    if (period == 0 || depth == 0 || stats == NULL || stats->s32list.count == 0)
+    {
+        pthread_rwlock_unlock(&lc->lock);
+
+        *count = 0;
+
+        return LAI_STATUS_SUCCESS;
+    }
+
+    first = (object->sampled / period + 1) * period;
+    available = now < first ? 0 : (now - first) / period + 1;
+
+    if (available > depth)
+    {
+        *dropped = available - depth;
+
+        first += *dropped * period;
+        available = depth;
+    }
+
+    n = available < *count ? (uint32_t)available : *count;
+
+    /* monotonic milliseconds to realtime nanoseconds */
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    epoch = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec - now * 1000000ULL;
+
+    for (k = 0; k < n; k++)
+    {
+        t = first + k * period;
+
+        timestamps[k] = epoch + t * 1000000ULL;
+
+        for (s = 0; s < stats->s32list.count; s++)
+        {
+            md = lai_metadata_get_stat_metadata(LAI_OBJECT_TYPE_OA, (lai_stat_id_t)stats->s32list.list[s]);
+
+            if (md == NULL)
+            {
+                memset(&counters[(size_t)k * stats->s32list.count + s], 0, sizeof(lai_stat_value_t));
+                continue;
+            }
+
+            vs_stats_synthesize(object, md, t, &counters[(size_t)k * stats->s32list.count + s]);
+        }
+    }
+
+    if (n != 0 || *dropped != 0)
+    {
+        object->sampled = first + n * period - period;
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    *count = n;
+
+    return LAI_STATUS_SUCCESS;
+}
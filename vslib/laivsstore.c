@@ -0,0 +1,1927 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laivsstore.c
+ *
+ * @brief   This module implements LAI Virtual Adapter object store
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "laivs.h"
+
+#define VS_STATUS_ATTR(base, idx)   ((lai_status_t)((base) + (lai_status_t)(idx)))
+
+vs_linecard_t vs_linecards[VS_MAX_LINECARDS];
+
+/*
+ * Standard attributes have position in attribute metadata equal to their id,
+ * only custom attributes need search.
+ */
+
+static bool vs_attr_position(
+        _In_ const lai_object_type_info_t *info,
+        _In_ lai_attr_id_t attr_id,
+        _Out_ size_t *position)
+{
+    size_t idx;
+
+    if (attr_id < info->attrmetadatalength && info->attrmetadata[attr_id]->attrid == attr_id)
+    {
+        *position = attr_id;
+        return true;
+    }
+
+    for (idx = 0; idx < info->attrmetadatalength; idx++)
+    {
+        if (info->attrmetadata[idx]->attrid == attr_id)
+        {
+            *position = idx;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static size_t vs_list_element_size(
+        _In_ lai_attr_value_type_t type)
+{
+    switch (type)
+    {
+        case LAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            return sizeof(lai_object_id_t);
+        case LAI_ATTR_VALUE_TYPE_UINT8_LIST:
+            return sizeof(uint8_t);
+        case LAI_ATTR_VALUE_TYPE_INT8_LIST:
+            return sizeof(int8_t);
+        case LAI_ATTR_VALUE_TYPE_UINT16_LIST:
+            return sizeof(uint16_t);
+        case LAI_ATTR_VALUE_TYPE_INT16_LIST:
+            return sizeof(int16_t);
+        case LAI_ATTR_VALUE_TYPE_UINT32_LIST:
+            return sizeof(uint32_t);
+        case LAI_ATTR_VALUE_TYPE_INT32_LIST:
+            return sizeof(int32_t);
+        case LAI_ATTR_VALUE_TYPE_SPECTRUM_POWER_LIST:
+            return sizeof(lai_spectrum_power_t);
+        default:
+            return 0;
+    }
+}
+
+static void* vs_list_get(
+        _In_ lai_attr_value_type_t type,
+        _In_ const lai_attribute_value_t *value,
+        _Out_ uint32_t *count)
+{
+    switch (type)
+    {
+        case LAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            *count = value->objlist.count;
+            return value->objlist.list;
+        case LAI_ATTR_VALUE_TYPE_UINT8_LIST:
+            *count = value->u8list.count;
+            return value->u8list.list;
+        case LAI_ATTR_VALUE_TYPE_INT8_LIST:
+            *count = value->s8list.count;
+            return value->s8list.list;
+        case LAI_ATTR_VALUE_TYPE_UINT16_LIST:
+            *count = value->u16list.count;
+            return value->u16list.list;
+        case LAI_ATTR_VALUE_TYPE_INT16_LIST:
+            *count = value->s16list.count;
+            return value->s16list.list;
+        case LAI_ATTR_VALUE_TYPE_UINT32_LIST:
+            *count = value->u32list.count;
+            return value->u32list.list;
+        case LAI_ATTR_VALUE_TYPE_INT32_LIST:
+            *count = value->s32list.count;
+            return value->s32list.list;
+        case LAI_ATTR_VALUE_TYPE_SPECTRUM_POWER_LIST:
+            *count = value->spectrumpowerlist.count;
+            return value->spectrumpowerlist.list;
+        default:
+            *count = 0;
+            return NULL;
+    }
+}
+
+static void vs_list_set(
+        _In_ lai_attr_value_type_t type,
+        _Inout_ lai_attribute_value_t *value,
+        _In_ uint32_t count,
+        _In_ void *list)
+{
+    switch (type)
+    {
+        case LAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            value->objlist.count = count;
+            value->objlist.list = list;
+            break;
+        case LAI_ATTR_VALUE_TYPE_UINT8_LIST:
+            value->u8list.count = count;
+            value->u8list.list = list;
+            break;
+        case LAI_ATTR_VALUE_TYPE_INT8_LIST:
+            value->s8list.count = count;
+            value->s8list.list = list;
+            break;
+        case LAI_ATTR_VALUE_TYPE_UINT16_LIST:
+            value->u16list.count = count;
+            value->u16list.list = list;
+            break;
+        case LAI_ATTR_VALUE_TYPE_INT16_LIST:
+            value->s16list.count = count;
+            value->s16list.list = list;
+            break;
+        case LAI_ATTR_VALUE_TYPE_UINT32_LIST:
+            value->u32list.count = count;
+            value->u32list.list = list;
+            break;
+        case LAI_ATTR_VALUE_TYPE_INT32_LIST:
+            value->s32list.count = count;
+            value->s32list.list = list;
+            break;
+        case LAI_ATTR_VALUE_TYPE_SPECTRUM_POWER_LIST:
+            value->spectrumpowerlist.count = count;
+            value->spectrumpowerlist.list = list;
+            break;
+        default:
+            break;
+    }
+}
+
+static void vs_value_free(
+        _In_ const lai_attr_metadata_t *md,
+        _In_ lai_attribute_value_t *value)
+{
+    uint32_t count;
+
+    if (value == NULL)
+    {
+        return;
+    }
+
+    free(vs_list_get(md->attrvaluetype, value, &count));
+    free(value);
+}
+
+static lai_status_t vs_value_store(
+        _In_ const lai_attr_metadata_t *md,
+        _In_ const lai_attribute_value_t *src,
+        _Out_ lai_attribute_value_t **dst)
+{
+    lai_attribute_value_t *value;
+    size_t size = vs_list_element_size(md->attrvaluetype);
+    uint32_t count;
+    void *list;
+
+    value = (lai_attribute_value_t*)malloc(sizeof(lai_attribute_value_t));
+
+    if (value == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    *value = *src;
+
+    if (size != 0)
+    {
+        const void *src_list = vs_list_get(md->attrvaluetype, src, &count);
+
+        list = NULL;
+
+        if (count != 0)
+        {
+            list = malloc(size * count);
+
+            if (list == NULL)
+            {
+                free(value);
+                return LAI_STATUS_NO_MEMORY;
+            }
+
+            memcpy(list, src_list, size * count);
+        }
+
+        vs_list_set(md->attrvaluetype, value, count, list);
+    }
+
+    *dst = value;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+/*
+ * Copies value to user buffer, lists are copied to user provided memory.
+ */
+
+static lai_status_t vs_value_copy_out(
+        _In_ const lai_attr_metadata_t *md,
+        _In_ const lai_attribute_value_t *src,
+        _Inout_ lai_attribute_value_t *dst)
+{
+    size_t size = vs_list_element_size(md->attrvaluetype);
+    uint32_t count;
+    uint32_t capacity;
+    const void *src_list;
+    void *dst_list;
+
+    if (size == 0)
+    {
+        *dst = *src;
+        return LAI_STATUS_SUCCESS;
+    }
+
+    src_list = vs_list_get(md->attrvaluetype, src, &count);
+    dst_list = vs_list_get(md->attrvaluetype, dst, &capacity);
+
+    if (count > capacity || (count != 0 && dst_list == NULL))
+    {
+        vs_list_set(md->attrvaluetype, dst, count, dst_list);
+        return LAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    if (count != 0)
+    {
+        memcpy(dst_list, src_list, size * count);
+    }
+
+    vs_list_set(md->attrvaluetype, dst, count, dst_list);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+/*
+ * Value timestamps are returned to caller, so they are kept in wall clock
+ * time instead of monotonic milliseconds.
+ */
+
+static uint64_t vs_realtime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Value of attribute which was never created nor set.
+ */
+
+static void vs_value_synthesize(
+        _In_ const lai_attr_metadata_t *md,
+        _Out_ lai_attribute_value_t *value)
+{
+    memset(value, 0, sizeof(lai_attribute_value_t));
+
+    if (md->defaultvaluetype == LAI_DEFAULT_VALUE_TYPE_CONST && md->defaultvalue != NULL)
+    {
+        *value = *md->defaultvalue;
+        return;
+    }
+
+    if (md->isenum && md->enummetadata != NULL && md->enummetadata->valuescount != 0)
+    {
+        value->s32 = md->enummetadata->values[0];
+    }
+    else if (md->attrvaluetype == LAI_ATTR_VALUE_TYPE_CHARDATA)
+    {
+        snprintf(value->chardata, sizeof(value->chardata), "%s", md->attridshortname);
+    }
+}
+
+static bool vs_oid_allowed(
+        _In_ const lai_attr_metadata_t *md,
+        _In_ lai_object_id_t oid)
+{
+    if (oid == LAI_NULL_OBJECT_ID)
+    {
+        return md->allownullobjectid;
+    }
+
+    return lai_metadata_is_allowed_object_type(md, lai_object_type_query(oid));
+}
+
+static bool vs_value_valid(
+        _In_ const lai_attr_metadata_t *md,
+        _In_ const lai_attribute_value_t *value)
+{
+    uint32_t idx;
+
+    if (md->isenum)
+    {
+        return lai_metadata_is_allowed_enum_value(md, value->s32);
+    }
+
+    switch (md->attrvaluetype)
+    {
+        case LAI_ATTR_VALUE_TYPE_OBJECT_ID:
+            return vs_oid_allowed(md, value->oid);
+
+        case LAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+
+            if (value->objlist.count != 0 && value->objlist.list == NULL)
+            {
+                return false;
+            }
+
+            for (idx = 0; idx < value->objlist.count; idx++)
+            {
+                if (!vs_oid_allowed(md, value->objlist.list[idx]))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+
+        case LAI_ATTR_VALUE_TYPE_INT32_LIST:
+
+            if (md->isenumlist)
+            {
+                if (value->s32list.count != 0 && value->s32list.list == NULL)
+                {
+                    return false;
+                }
+
+                for (idx = 0; idx < value->s32list.count; idx++)
+                {
+                    if (!lai_metadata_is_allowed_enum_value(md, value->s32list.list[idx]))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+
+        default:
+            return true;
+    }
+}
+
+uint64_t vs_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static vs_object_t* vs_object_find(
+        _In_ vs_linecard_t *lc,
+        _In_ lai_object_id_t object_id,
+        _In_ bool staged)
+{
+    lai_object_type_t object_type = LAI_OBJECT_ID_TYPE(object_id);
+    size_t slot = VS_OBJECT_ID_SLOT(object_id);
+    vs_table_t *table;
+
+    if (!lc->used || !lai_metadata_is_object_type_valid(object_type))
+    {
+        return NULL;
+    }
+
+    table = &lc->tables[object_type];
+
+    if (slot < table->size && table->objects[slot].oid == object_id && !table->objects[slot].removed &&
+            (staged || !table->objects[slot].staged))
+    {
+        return &table->objects[slot];
+    }
+
+    return NULL;
+}
+
+vs_object_t* vs_object_lock(
+        _In_ lai_object_id_t object_id,
+        _In_ bool write,
+        _Out_ vs_linecard_t **linecard)
+{
+    vs_linecard_t *lc;
+    vs_object_t *object;
+
+    *linecard = NULL;
+
+    if (!vs_initialized || !lai_metadata_is_object_type_valid(LAI_OBJECT_ID_TYPE(object_id)))
+    {
+        return NULL;
+    }
+
+    lc = &vs_linecards[LAI_OBJECT_ID_LINECARD_INDEX(object_id)];
+
+    if (write)
+    {
+        pthread_rwlock_wrlock(&lc->lock);
+    }
+    else
+    {
+        pthread_rwlock_rdlock(&lc->lock);
+    }
+
+    object = vs_object_find(lc, object_id, false);
+
+    if (object != NULL)
+    {
+        *linecard = lc;
+        return object;
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return NULL;
+}
+
+/*
+ * Finds object for call which may be staged by open transaction, objects
+ * created by transaction are found too. Linecard stays locked for writing
+ * even when object is not found, so failure is recorded in transaction
+ * under the same lock. Linecard is NULL only when adapter is not
+ * initialized.
+ */
+
+static vs_object_t* vs_object_lock_staged(
+        _In_ lai_object_id_t object_id,
+        _Out_ vs_linecard_t **linecard)
+{
+    *linecard = NULL;
+
+    if (!vs_initialized)
+    {
+        return NULL;
+    }
+
+    *linecard = &vs_linecards[LAI_OBJECT_ID_LINECARD_INDEX(object_id)];
+
+    pthread_rwlock_wrlock(&(*linecard)->lock);
+
+    return vs_object_find(*linecard, object_id, true);
+}
+
+/*
+ * Records failed call in open transaction of locked linecard, then unlocks
+ * linecard.
+ */
+
+static lai_status_t vs_linecard_unlock(
+        _Inout_ vs_linecard_t *lc,
+        _In_ lai_status_t status)
+{
+    if (status != LAI_STATUS_SUCCESS && lc->used && lc->transaction.active &&
+            lc->transaction.status == LAI_STATUS_SUCCESS)
+    {
+        lc->transaction.status = status;
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return status;
+}
+
+/*
+ * Records call which failed before linecard was locked. Call saw no state
+ * of linecard, so it is ordered at this point.
+ */
+
+static lai_status_t vs_transaction_fail(
+        _In_ lai_object_id_t object_id,
+        _In_ lai_status_t status)
+{
+    vs_linecard_t *lc;
+
+    if (status == LAI_STATUS_SUCCESS || !vs_initialized || lai_object_type_query(object_id) == LAI_OBJECT_TYPE_NULL)
+    {
+        return status;
+    }
+
+    lc = &vs_linecards[LAI_OBJECT_ID_LINECARD_INDEX(object_id)];
+
+    pthread_rwlock_wrlock(&lc->lock);
+
+    return vs_linecard_unlock(lc, status);
+}
+
+const lai_attribute_value_t* vs_object_get_value(
+        _In_ const vs_object_t *object,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_attr_id_t attr_id)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(object_type);
+    size_t position;
+
+    if (info == NULL || object->values == NULL || !vs_attr_position(info, attr_id, &position))
+    {
+        return NULL;
+    }
+
+    return object->values[position];
+}
+
+static void vs_object_release(
+        _In_ const lai_object_type_info_t *info,
+        _Inout_ vs_object_t *object)
+{
+    size_t idx;
+
+    if (object->values != NULL)
+    {
+        for (idx = 0; idx < info->attrmetadatalength; idx++)
+        {
+            vs_value_free(info->attrmetadata[idx], object->values[idx]);
+        }
+    }
+
+    free(object->values);
+    free(object->generations);
+    free(object->timestamps);
+    free(object->cleared);
+
+    memset(object, 0, sizeof(vs_object_t));
+}
+
+/*
+ * Set of the same value doesn't change generation, attribute which was
+ * never set is compared with its synthesized value.
+ */
+
+static bool vs_value_changed(
+        _In_ const lai_attr_metadata_t *md,
+        _In_ const lai_attribute_value_t *old_value,
+        _In_ const lai_attribute_value_t *new_value)
+{
+    lai_attribute_t lhs;
+    lai_attribute_t rhs;
+    bool equal;
+
+    lhs.id = md->attrid;
+    rhs.id = md->attrid;
+    rhs.value = *new_value;
+
+    if (old_value == NULL)
+    {
+        vs_value_synthesize(md, &lhs.value);
+    }
+    else
+    {
+        lhs.value = *old_value;
+    }
+
+    if (lai_metadata_deepequal_attr_value(md, &lhs, &rhs, &equal) != LAI_STATUS_SUCCESS)
+    {
+        return true;
+    }
+
+    return !equal;
+}
+
+static lai_status_t vs_table_alloc(
+        _Inout_ vs_table_t *table,
+        _Out_ size_t *slot)
+{
+    size_t capacity;
+    vs_object_t *objects;
+    size_t *free_slots;
+
+    if (table->free_count != 0)
+    {
+        *slot = table->free_slots[--table->free_count];
+        return LAI_STATUS_SUCCESS;
+    }
+
+    if (table->size == VS_SLOT_MASK)
+    {
+        return LAI_STATUS_TABLE_FULL;
+    }
+
+    if (table->size == table->capacity)
+    {
+        capacity = table->capacity == 0 ? 16 : table->capacity * 2;
+
+        objects = (vs_object_t*)realloc(table->objects, capacity * sizeof(vs_object_t));
+
+        if (objects == NULL)
+        {
+            return LAI_STATUS_NO_MEMORY;
+        }
+
+        table->objects = objects;
+
+        free_slots = (size_t*)realloc(table->free_slots, capacity * sizeof(size_t));
+
+        if (free_slots == NULL)
+        {
+            return LAI_STATUS_NO_MEMORY;
+        }
+
+        table->free_slots = free_slots;
+
+        memset(&table->objects[table->capacity], 0, (capacity - table->capacity) * sizeof(vs_object_t));
+
+        table->capacity = capacity;
+    }
+
+    *slot = table->size++;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static void vs_table_release(
+        _In_ const lai_object_type_info_t *info,
+        _Inout_ vs_table_t *table,
+        _In_ size_t slot)
+{
+    uint64_t reuse = (table->objects[slot].reuse + 1) & VS_REUSE_MASK;
+
+    vs_object_release(info, &table->objects[slot]);
+
+    table->objects[slot].reuse = reuse;
+
+    table->free_slots[table->free_count++] = slot;
+    table->count--;
+}
+
+static lai_status_t vs_transaction_record(
+        _Inout_ vs_linecard_t *lc,
+        _In_ vs_change_type_t type,
+        _In_ lai_object_id_t oid,
+        _In_ size_t position,
+        _In_ lai_attribute_value_t *value)
+{
+    vs_transaction_t *tx = &lc->transaction;
+    vs_change_t *change;
+
+    if (tx->count == tx->capacity)
+    {
+        size_t capacity = tx->capacity == 0 ? 16 : tx->capacity * 2;
+        vs_change_t *changes = (vs_change_t*)realloc(tx->changes, capacity * sizeof(vs_change_t));
+
+        if (changes == NULL)
+        {
+            return LAI_STATUS_NO_MEMORY;
+        }
+
+        tx->changes = changes;
+        tx->capacity = capacity;
+    }
+
+    change = &tx->changes[tx->count++];
+
+    change->type = type;
+    change->oid = oid;
+    change->position = position;
+    change->value = value;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static vs_object_t* vs_transaction_object(
+        _In_ vs_linecard_t *lc,
+        _In_ const vs_change_t *change,
+        _Out_ const lai_object_type_info_t **info,
+        _Out_ vs_table_t **table)
+{
+    lai_object_type_t object_type = LAI_OBJECT_ID_TYPE(change->oid);
+    size_t slot = VS_OBJECT_ID_SLOT(change->oid);
+
+    *info = lai_metadata_get_object_type_info(object_type);
+    *table = &lc->tables[object_type];
+
+    if (slot < (*table)->size && (*table)->objects[slot].oid == change->oid)
+    {
+        return &(*table)->objects[slot];
+    }
+
+    return NULL;
+}
+
+/*
+ * Staged values left in journal belong to journal, applied entries leave
+ * NULL there.
+ */
+
+static void vs_transaction_reset(
+        _Inout_ vs_linecard_t *lc)
+{
+    vs_transaction_t *tx = &lc->transaction;
+    size_t idx;
+
+    for (idx = 0; idx < tx->count; idx++)
+    {
+        if (tx->changes[idx].value != NULL)
+        {
+            const lai_object_type_info_t *info = lai_metadata_get_object_type_info(LAI_OBJECT_ID_TYPE(tx->changes[idx].oid));
+
+            vs_value_free(info->attrmetadata[tx->changes[idx].position], tx->changes[idx].value);
+        }
+    }
+
+    free(tx->changes);
+
+    memset(tx, 0, sizeof(vs_transaction_t));
+}
+
+/*
+ * Replaces stored value of attribute, new value is owned by object.
+ */
+
+static void vs_object_apply(
+        _Inout_ vs_linecard_t *lc,
+        _In_ const lai_object_type_info_t *info,
+        _Inout_ vs_object_t *object,
+        _In_ size_t position,
+        _In_ lai_attribute_value_t *value)
+{
+    const lai_attr_metadata_t *md = info->attrmetadata[position];
+
+    if (vs_value_changed(md, object->values[position], value))
+    {
+        object->generation = ++lc->generation;
+        object->generations[position] = object->generation;
+    }
+
+    if (info->objecttype == LAI_OBJECT_TYPE_OA &&
+            (md->attrid == LAI_OA_ATTR_SAMPLING_STATS || md->attrid == LAI_OA_ATTR_SAMPLING_PERIOD ||
+             md->attrid == LAI_OA_ATTR_SAMPLING_DEPTH))
+    {
+        object->sampled = vs_now();
+    }
+
+    vs_value_free(md, object->values[position]);
+
+    object->values[position] = value;
+    object->timestamps[position] = vs_realtime();
+}
+
+/*
+ * Commit makes created objects visible and stores staged values, both with
+ * new generation, so observers which read generation during transaction
+ * see them changed.
+ */
+
+static void vs_transaction_apply(
+        _Inout_ vs_linecard_t *lc)
+{
+    vs_transaction_t *tx = &lc->transaction;
+    const lai_object_type_info_t *info;
+    vs_table_t *table;
+    vs_object_t *object;
+    size_t idx;
+    size_t pos;
+
+    for (idx = 0; idx < tx->count; idx++)
+    {
+        vs_change_t *change = &tx->changes[idx];
+
+        object = vs_transaction_object(lc, change, &info, &table);
+
+        switch (change->type)
+        {
+            case VS_CHANGE_CREATE:
+                if (object != NULL)
+                {
+                    object->staged = false;
+                    object->generation = ++lc->generation;
+
+                    for (pos = 0; pos < info->attrmetadatalength; pos++)
+                    {
+                        object->generations[pos] = object->generation;
+                    }
+                }
+                break;
+
+            case VS_CHANGE_SET:
+                if (object != NULL)
+                {
+                    vs_object_apply(lc, info, object, change->position, change->value);
+                }
+                else
+                {
+                    vs_value_free(info->attrmetadata[change->position], change->value);
+                }
+
+                change->value = NULL;
+                break;
+
+            case VS_CHANGE_REMOVE:
+                if (object != NULL)
+                {
+                    vs_table_release(info, table, (size_t)(object - table->objects));
+                }
+                break;
+
+            case VS_CHANGE_SCAN:
+                if (object != NULL && !object->removed)
+                {
+                    object->scan = true;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/*
+ * Undo runs backwards, so every entry finds object in state right after its
+ * call. Staged values were never stored in objects, journal frees them.
+ */
+
+static void vs_transaction_undo(
+        _Inout_ vs_linecard_t *lc)
+{
+    vs_transaction_t *tx = &lc->transaction;
+    const lai_object_type_info_t *info;
+    vs_table_t *table;
+    vs_object_t *object;
+    size_t idx;
+
+    for (idx = tx->count; idx > 0; idx--)
+    {
+        vs_change_t *change = &tx->changes[idx - 1];
+
+        object = vs_transaction_object(lc, change, &info, &table);
+
+        if (object == NULL)
+        {
+            continue;
+        }
+
+        switch (change->type)
+        {
+            case VS_CHANGE_CREATE:
+                vs_table_release(info, table, (size_t)(object - table->objects));
+                break;
+
+            case VS_CHANGE_REMOVE:
+                object->removed = false;
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+static void vs_linecard_clear(
+        _Inout_ vs_linecard_t *lc)
+{
+    size_t ot;
+    size_t slot;
+
+    vs_transaction_reset(lc);
+
+    for (ot = LAI_OBJECT_TYPE_NULL + 1; ot < LAI_OBJECT_TYPE_MAX; ot++)
+    {
+        const lai_object_type_info_t *info = lai_metadata_get_object_type_info((lai_object_type_t)ot);
+        vs_table_t *table = &lc->tables[ot];
+
+        for (slot = 0; slot < table->size; slot++)
+        {
+            if (table->objects[slot].oid != LAI_NULL_OBJECT_ID)
+            {
+                vs_object_release(info, &table->objects[slot]);
+            }
+        }
+
+        free(table->objects);
+        free(table->free_slots);
+
+        memset(table, 0, sizeof(vs_table_t));
+    }
+
+    lc->used = false;
+    lc->ticks = 0;
+    lc->due = 0;
+}
+
+void vs_store_clear(void)
+{
+    size_t idx;
+
+    pthread_mutex_lock(&vs_global_lock);
+
+    for (idx = 0; idx < VS_MAX_LINECARDS; idx++)
+    {
+        pthread_rwlock_wrlock(&vs_linecards[idx].lock);
+
+        vs_linecard_clear(&vs_linecards[idx]);
+
+        pthread_rwlock_unlock(&vs_linecards[idx].lock);
+    }
+
+    pthread_mutex_unlock(&vs_global_lock);
+}
+
+static lai_status_t vs_create_validate(
+        _In_ const lai_object_type_info_t *info,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    uint32_t idx;
+    uint32_t prev;
+    size_t pos;
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const lai_attr_metadata_t *md = lai_metadata_get_attr_metadata(info->objecttype, attr_list[idx].id);
+
+        if (md == NULL)
+        {
+            LAI_META_LOG_ERROR("unknown attribute %u on %s", attr_list[idx].id, info->objecttypename);
+            return VS_STATUS_ATTR(LAI_STATUS_UNKNOWN_ATTRIBUTE_0, idx);
+        }
+
+        if (md->isreadonly || md->issetonly)
+        {
+            LAI_META_LOG_ERROR("attribute %s can't be created", md->attridname);
+            return VS_STATUS_ATTR(LAI_STATUS_INVALID_ATTRIBUTE_0, idx);
+        }
+
+        for (prev = 0; prev < idx; prev++)
+        {
+            if (attr_list[prev].id == attr_list[idx].id)
+            {
+                LAI_META_LOG_ERROR("attribute %s passed twice", md->attridname);
+                return VS_STATUS_ATTR(LAI_STATUS_INVALID_ATTRIBUTE_0, idx);
+            }
+        }
+
+        if (!vs_value_valid(md, &attr_list[idx].value))
+        {
+            LAI_META_LOG_ERROR("invalid value of attribute %s", md->attridname);
+            return VS_STATUS_ATTR(LAI_STATUS_INVALID_ATTR_VALUE_0, idx);
+        }
+    }
+
+    for (pos = 0; pos < info->attrmetadatalength; pos++)
+    {
+        const lai_attr_metadata_t *md = info->attrmetadata[pos];
+
+        bool mandatory = md->isconditional ?
+            lai_metadata_is_condition_met(md, attr_count, attr_list) : md->ismandatoryoncreate;
+
+        if (mandatory && lai_metadata_get_attr_by_id(md->attrid, attr_count, attr_list) == NULL)
+        {
+            LAI_META_LOG_ERROR("mandatory attribute %s is missing", md->attridname);
+            return LAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t vs_object_store_attrs(
+        _In_ const lai_object_type_info_t *info,
+        _Inout_ vs_object_t *object,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    uint32_t idx;
+    size_t pos;
+    uint64_t now = vs_realtime();
+    lai_status_t status;
+
+    object->values = (lai_attribute_value_t**)calloc(info->attrmetadatalength, sizeof(lai_attribute_value_t*));
+    object->generations = (lai_generation_t*)calloc(info->attrmetadatalength, sizeof(lai_generation_t));
+    object->timestamps = (uint64_t*)calloc(info->attrmetadatalength, sizeof(uint64_t));
+
+    if (object->values == NULL || object->generations == NULL || object->timestamps == NULL)
+    {
+        return LAI_STATUS_NO_MEMORY;
+    }
+
+    /* creation changes all attributes, including synthesized ones */
+
+    for (pos = 0; pos < info->attrmetadatalength; pos++)
+    {
+        object->generations[pos] = object->generation;
+        object->timestamps[pos] = now;
+    }
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        if (!vs_attr_position(info, attr_list[idx].id, &pos))
+        {
+            return VS_STATUS_ATTR(LAI_STATUS_UNKNOWN_ATTRIBUTE_0, idx);
+        }
+
+        status = vs_value_store(info->attrmetadata[pos], &attr_list[idx].value, &object->values[pos]);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+static lai_status_t vs_linecard_reserve(
+        _In_ lai_object_id_t linecard_id,
+        _Out_ size_t *linecard_index)
+{
+    size_t idx;
+    size_t first = 0;
+    size_t last = VS_MAX_LINECARDS;
+
+    if (linecard_id != LAI_NULL_OBJECT_ID)
+    {
+        /* linecard slot bound to API context */
+
+        first = LAI_OBJECT_ID_LINECARD_INDEX(linecard_id);
+        last = first + 1;
+    }
+
+    pthread_mutex_lock(&vs_global_lock);
+
+    for (idx = first; idx < last; idx++)
+    {
+        vs_linecard_t *lc = &vs_linecards[idx];
+
+        pthread_rwlock_wrlock(&lc->lock);
+
+        if (!lc->used && lc->reserved == (linecard_id != LAI_NULL_OBJECT_ID))
+        {
+            lc->used = true;
+
+            pthread_rwlock_unlock(&lc->lock);
+            pthread_mutex_unlock(&vs_global_lock);
+
+            *linecard_index = idx;
+
+            return LAI_STATUS_SUCCESS;
+        }
+
+        pthread_rwlock_unlock(&lc->lock);
+    }
+
+    pthread_mutex_unlock(&vs_global_lock);
+
+    return linecard_id != LAI_NULL_OBJECT_ID ? LAI_STATUS_ITEM_ALREADY_EXISTS : LAI_STATUS_INSUFFICIENT_RESOURCES;
+}
+
+lai_status_t vs_store_bind_linecard(
+        _In_ size_t linecard_index)
+{
+    vs_linecard_t *lc = &vs_linecards[linecard_index];
+    lai_status_t status = LAI_STATUS_SUCCESS;
+
+    pthread_mutex_lock(&vs_global_lock);
+    pthread_rwlock_wrlock(&lc->lock);
+
+    if (lc->used || lc->reserved)
+    {
+        status = LAI_STATUS_OBJECT_IN_USE;
+    }
+    else
+    {
+        lc->reserved = true;
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+    pthread_mutex_unlock(&vs_global_lock);
+
+    return status;
+}
+
+void vs_store_unbind_linecard(
+        _In_ size_t linecard_index)
+{
+    vs_linecard_t *lc = &vs_linecards[linecard_index];
+
+    pthread_mutex_lock(&vs_global_lock);
+    pthread_rwlock_wrlock(&lc->lock);
+
+    vs_linecard_clear(lc);
+
+    lc->reserved = false;
+
+    pthread_rwlock_unlock(&lc->lock);
+    pthread_mutex_unlock(&vs_global_lock);
+}
+
+lai_status_t vs_generic_create(
+        _In_ lai_object_type_t object_type,
+        _Out_ lai_object_id_t *object_id,
+        _In_ lai_object_id_t linecard_id,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(object_type);
+    vs_linecard_t *lc;
+    vs_table_t *table;
+    vs_object_t *object;
+    size_t linecard_index;
+    size_t slot;
+    lai_status_t status;
+
+    if (!vs_initialized)
+    {
+        return LAI_STATUS_UNINITIALIZED;
+    }
+
+    if (info == NULL || object_id == NULL || (attr_count != 0 && attr_list == NULL))
+    {
+        return vs_transaction_fail(linecard_id, LAI_STATUS_INVALID_PARAMETER);
+    }
+
+    status = vs_create_validate(info, attr_count, attr_list);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return vs_transaction_fail(linecard_id, status);
+    }
+
+    if (object_type == LAI_OBJECT_TYPE_LINECARD)
+    {
+        status = vs_linecard_reserve(linecard_id, &linecard_index);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+
+        lc = &vs_linecards[linecard_index];
+
+        pthread_rwlock_wrlock(&lc->lock);
+    }
+    else
+    {
+        if (lai_object_type_query(linecard_id) != LAI_OBJECT_TYPE_LINECARD)
+        {
+            return vs_transaction_fail(linecard_id, LAI_STATUS_INVALID_OBJECT_ID);
+        }
+
+        if (vs_object_lock_staged(linecard_id, &lc) == NULL)
+        {
+            return lc == NULL ? LAI_STATUS_INVALID_OBJECT_ID : vs_linecard_unlock(lc, LAI_STATUS_INVALID_OBJECT_ID);
+        }
+
+        linecard_index = (size_t)(lc - vs_linecards);
+    }
+
+    table = &lc->tables[object_type];
+
+    status = vs_table_alloc(table, &slot);
+
+    if (status == LAI_STATUS_SUCCESS)
+    {
+        object = &table->objects[slot];
+
+        object->oid = LAI_OBJECT_ID_ENCODE(object_type, linecard_index, (object->reuse << VS_SLOT_BITS) | slot);
+        object->created = vs_now();
+        object->sampled = object->created;
+        object->generation = ++lc->generation;
+        object->staged = lc->transaction.active;
+
+        table->count++;
+
+        status = vs_object_store_attrs(info, object, attr_count, attr_list);
+
+        if (status == LAI_STATUS_SUCCESS && lc->transaction.active)
+        {
+            status = vs_transaction_record(lc, VS_CHANGE_CREATE, object->oid, 0, NULL);
+        }
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            *object_id = object->oid;
+        }
+        else
+        {
+            vs_table_release(info, table, slot);
+        }
+    }
+
+    if (status != LAI_STATUS_SUCCESS && object_type == LAI_OBJECT_TYPE_LINECARD)
+    {
+        vs_linecard_clear(lc);
+    }
+
+    status = vs_linecard_unlock(lc, status);
+
+    if (status == LAI_STATUS_SUCCESS && object_type == LAI_OBJECT_TYPE_LINECARD)
+    {
+        vs_notify_wake();
+    }
+
+    return status;
+}
+
+lai_status_t vs_generic_remove(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(object_type);
+    vs_linecard_t *lc;
+    vs_object_t *object;
+    lai_status_t status;
+
+    if (info == NULL || lai_object_type_query(object_id) != object_type)
+    {
+        return vs_transaction_fail(object_id, LAI_STATUS_INVALID_OBJECT_ID);
+    }
+
+    if (object_type == LAI_OBJECT_TYPE_LINECARD)
+    {
+        pthread_mutex_lock(&vs_global_lock);
+    }
+
+    object = vs_object_lock_staged(object_id, &lc);
+
+    if (lc == NULL)
+    {
+        if (object_type == LAI_OBJECT_TYPE_LINECARD)
+        {
+            pthread_mutex_unlock(&vs_global_lock);
+        }
+
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if (object_type == LAI_OBJECT_TYPE_LINECARD)
+    {
+        status = object == NULL ? LAI_STATUS_INVALID_OBJECT_ID :
+            lc->transaction.active ? LAI_STATUS_OBJECT_IN_USE : LAI_STATUS_SUCCESS;
+
+        if (status == LAI_STATUS_SUCCESS)
+        {
+            vs_linecard_clear(lc);
+        }
+
+        status = vs_linecard_unlock(lc, status);
+
+        pthread_mutex_unlock(&vs_global_lock);
+
+        return status;
+    }
+
+    if (object == NULL)
+    {
+        return vs_linecard_unlock(lc, LAI_STATUS_INVALID_OBJECT_ID);
+    }
+
+    if (lc->transaction.active)
+    {
+        status = vs_transaction_record(lc, VS_CHANGE_REMOVE, object_id, 0, NULL);
+
+        object->removed = status == LAI_STATUS_SUCCESS;
+
+        return vs_linecard_unlock(lc, status);
+    }
+
+    vs_table_release(info, &lc->tables[object_type], (size_t)(object - lc->tables[object_type].objects));
+
+    return vs_linecard_unlock(lc, LAI_STATUS_SUCCESS);
+}
+
+lai_status_t vs_generic_set(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ const lai_attribute_t *attr)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(object_type);
+    const lai_attr_metadata_t *md;
+    lai_attribute_value_t *value;
+    vs_linecard_t *lc;
+    vs_object_t *object;
+    size_t pos;
+    lai_status_t status;
+
+    if (info == NULL || attr == NULL)
+    {
+        return vs_transaction_fail(object_id, LAI_STATUS_INVALID_PARAMETER);
+    }
+
+    if (!vs_attr_position(info, attr->id, &pos))
+    {
+        return vs_transaction_fail(object_id, LAI_STATUS_UNKNOWN_ATTRIBUTE_0);
+    }
+
+    md = info->attrmetadata[pos];
+
+    if (md->isreadonly || md->iscreateonly)
+    {
+        LAI_META_LOG_ERROR("attribute %s can't be set", md->attridname);
+        return vs_transaction_fail(object_id, LAI_STATUS_INVALID_ATTRIBUTE_0);
+    }
+
+    if (!vs_value_valid(md, &attr->value))
+    {
+        LAI_META_LOG_ERROR("invalid value of attribute %s", md->attridname);
+        return vs_transaction_fail(object_id, LAI_STATUS_INVALID_ATTR_VALUE_0);
+    }
+
+    if (lai_object_type_query(object_id) != object_type)
+    {
+        return vs_transaction_fail(object_id, LAI_STATUS_INVALID_OBJECT_ID);
+    }
+
+    /*
+     * Set only attributes are actions, scan results are notified by timer.
+     */
+
+    if (md->issetonly)
+    {
+        object = vs_object_lock_staged(object_id, &lc);
+
+        if (object == NULL)
+        {
+            return lc == NULL ? LAI_STATUS_INVALID_OBJECT_ID : vs_linecard_unlock(lc, LAI_STATUS_INVALID_OBJECT_ID);
+        }
+
+        status = LAI_STATUS_SUCCESS;
+
+        if (((object_type == LAI_OBJECT_TYPE_OCM && attr->id == LAI_OCM_ATTR_SCAN) ||
+                (object_type == LAI_OBJECT_TYPE_OTDR && attr->id == LAI_OTDR_ATTR_SCAN)) && attr->value.booldata)
+        {
+            if (lc->transaction.active)
+            {
+                status = vs_transaction_record(lc, VS_CHANGE_SCAN, object_id, 0, NULL);
+            }
+            else
+            {
+                object->scan = true;
+            }
+        }
+
+        return vs_linecard_unlock(lc, status);
+    }
+
+    status = vs_value_store(md, &attr->value, &value);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return vs_transaction_fail(object_id, status);
+    }
+
+    object = vs_object_lock_staged(object_id, &lc);
+
+    if (object == NULL)
+    {
+        vs_value_free(md, value);
+        return lc == NULL ? LAI_STATUS_INVALID_OBJECT_ID : vs_linecard_unlock(lc, LAI_STATUS_INVALID_OBJECT_ID);
+    }
+
+    /*
+     * Staged value waits in journal, readers see stored value until commit.
+     */
+
+    if (lc->transaction.active)
+    {
+        status = vs_transaction_record(lc, VS_CHANGE_SET, object_id, pos, value);
+
+        if (status != LAI_STATUS_SUCCESS)
+        {
+            vs_value_free(md, value);
+        }
+
+        return vs_linecard_unlock(lc, status);
+    }
+
+    vs_object_apply(lc, info, object, pos, value);
+
+    return vs_linecard_unlock(lc, LAI_STATUS_SUCCESS);
+}
+
+/*
+ * Validates get before linecard is locked.
+ */
+
+static lai_status_t vs_get_validate(
+        _In_ const lai_object_type_info_t *info,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    uint32_t idx;
+    size_t pos;
+
+    if (info == NULL || attr_count == 0 || attr_list == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        if (!vs_attr_position(info, attr_list[idx].id, &pos))
+        {
+            return VS_STATUS_ATTR(LAI_STATUS_UNKNOWN_ATTRIBUTE_0, idx);
+        }
+
+        if (info->attrmetadata[pos]->issetonly)
+        {
+            return VS_STATUS_ATTR(LAI_STATUS_INVALID_ATTRIBUTE_0, idx);
+        }
+    }
+
+    if (lai_object_type_query(object_id) != object_type)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t vs_generic_get(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(object_type);
+    lai_attribute_value_t synthesized;
+    vs_linecard_t *lc;
+    vs_object_t *object;
+    uint32_t idx;
+    size_t pos;
+    lai_status_t status;
+
+    status = vs_get_validate(info, object_type, object_id, attr_count, attr_list);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    object = vs_object_lock(object_id, false, &lc);
+
+    if (object == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    /*
+     * All attributes are filled even when some list is too small, so caller
+     * can resize all lists at once.
+     */
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const lai_attribute_value_t *value;
+
+        vs_attr_position(info, attr_list[idx].id, &pos);
+
+        value = object->values[pos];
+
+        if (value == NULL)
+        {
+            vs_value_synthesize(info->attrmetadata[pos], &synthesized);
+
+            value = &synthesized;
+        }
+
+        if (vs_value_copy_out(info->attrmetadata[pos], value, &attr_list[idx].value) != LAI_STATUS_SUCCESS)
+        {
+            status = LAI_STATUS_BUFFER_OVERFLOW;
+        }
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return status;
+}
+
+/*
+ * Virtual hardware holds stored or synthesized value, so hardware read
+ * only refreshes value timestamp.
+ */
+
+lai_status_t vs_generic_get_ext(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ lai_read_mode_t read_mode,
+        _In_ uint64_t max_age,
+        _In_ uint32_t attr_count,
+        _Inout_ lai_attribute_t *attr_list,
+        _Out_ uint64_t *timestamp_list)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(object_type);
+    lai_attribute_value_t synthesized;
+    vs_linecard_t *lc;
+    vs_object_t *object;
+    uint32_t idx;
+    size_t pos;
+    uint64_t now;
+    lai_status_t status;
+
+    if (timestamp_list == NULL ||
+            (read_mode != LAI_READ_MODE_CACHED && read_mode != LAI_READ_MODE_FORCE && read_mode != LAI_READ_MODE_MAX_AGE))
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    status = vs_get_validate(info, object_type, object_id, attr_count, attr_list);
+
+    if (status != LAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    object = vs_object_lock(object_id, read_mode != LAI_READ_MODE_CACHED, &lc);
+
+    if (object == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    now = vs_realtime();
+
+    for (idx = 0; idx < attr_count; idx++)
+    {
+        const lai_attribute_value_t *value;
+
+        vs_attr_position(info, attr_list[idx].id, &pos);
+
+        if (read_mode == LAI_READ_MODE_FORCE ||
+                (read_mode == LAI_READ_MODE_MAX_AGE && now > object->timestamps[pos] && now - object->timestamps[pos] > max_age))
+        {
+            object->timestamps[pos] = now;
+        }
+
+        value = object->values[pos];
+
+        if (value == NULL)
+        {
+            vs_value_synthesize(info->attrmetadata[pos], &synthesized);
+
+            value = &synthesized;
+        }
+
+        if (vs_value_copy_out(info->attrmetadata[pos], value, &attr_list[idx].value) != LAI_STATUS_SUCCESS)
+        {
+            status = LAI_STATUS_BUFFER_OVERFLOW;
+        }
+
+        timestamp_list[idx] = object->timestamps[pos];
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return status;
+}
+
+lai_status_t vs_store_get_generation(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _Out_ lai_generation_t *generation)
+{
+    const vs_object_t *object;
+    vs_linecard_t *lc;
+
+    if (generation == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (lai_object_type_query(object_id) != object_type)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    object = vs_object_lock(object_id, false, &lc);
+
+    if (object == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    *generation = object->generation;
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t vs_store_get_changed(
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_generation_t since,
+        _Out_ lai_generation_t *generation,
+        _Inout_ uint32_t *attr_count,
+        _Out_ lai_object_id_t *object_list,
+        _Inout_ lai_attribute_t *attr_list)
+{
+    lai_attribute_value_t synthesized;
+    vs_linecard_t *lc;
+    size_t ot;
+    size_t slot;
+    size_t pos;
+    uint32_t count = 0;
+
+    if (generation == NULL || attr_count == NULL ||
+            (*attr_count != 0 && (object_list == NULL || attr_list == NULL)))
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (lai_object_type_query(linecard_id) != LAI_OBJECT_TYPE_LINECARD ||
+            vs_object_lock(linecard_id, false, &lc) == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    /*
+     * Object generation is checked first, so quiet linecard costs single pass
+     * over its objects.
+     */
+
+    for (ot = LAI_OBJECT_TYPE_NULL + 1; ot < LAI_OBJECT_TYPE_MAX; ot++)
+    {
+        const lai_object_type_info_t *info = lai_metadata_get_object_type_info((lai_object_type_t)ot);
+        const vs_table_t *table = &lc->tables[ot];
+
+        for (slot = 0; slot < table->size; slot++)
+        {
+            const vs_object_t *object = &table->objects[slot];
+
+            if (object->oid == LAI_NULL_OBJECT_ID || object->staged || object->generation <= since)
+            {
+                continue;
+            }
+
+            for (pos = 0; pos < info->attrmetadatalength; pos++)
+            {
+                const lai_attr_metadata_t *md = info->attrmetadata[pos];
+                const lai_attribute_value_t *value = object->values[pos];
+
+                if (md->issetonly || object->generations[pos] <= since)
+                {
+                    continue;
+                }
+
+                if (count < *attr_count)
+                {
+                    if (value == NULL)
+                    {
+                        vs_value_synthesize(md, &synthesized);
+
+                        value = &synthesized;
+                    }
+
+                    object_list[count] = object->oid;
+                    attr_list[count].id = md->attrid;
+
+                    memset(&attr_list[count].value, 0, sizeof(lai_attribute_value_t));
+
+                    /* without user list only element count is copied */
+
+                    vs_value_copy_out(md, value, &attr_list[count].value);
+                }
+
+                count++;
+            }
+        }
+    }
+
+    *generation = lc->generation;
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    if (count > *attr_count)
+    {
+        *attr_count = count;
+        return LAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    *attr_count = count;
+
+    return LAI_STATUS_SUCCESS;
+}
+
+lai_status_t vs_store_begin_transaction(
+        _In_ lai_object_id_t linecard_id)
+{
+    vs_linecard_t *lc;
+    lai_status_t status = LAI_STATUS_SUCCESS;
+
+    if (lai_object_type_query(linecard_id) != LAI_OBJECT_TYPE_LINECARD ||
+            vs_object_lock(linecard_id, true, &lc) == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if (lc->transaction.active)
+    {
+        status = LAI_STATUS_OBJECT_IN_USE;
+    }
+    else
+    {
+        lc->transaction.active = true;
+        lc->transaction.status = LAI_STATUS_SUCCESS;
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return status;
+}
+
+lai_status_t vs_store_end_transaction(
+        _In_ lai_object_id_t linecard_id,
+        _In_ bool commit)
+{
+    vs_linecard_t *lc;
+    lai_status_t status;
+
+    if (lai_object_type_query(linecard_id) != LAI_OBJECT_TYPE_LINECARD ||
+            vs_object_lock(linecard_id, true, &lc) == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if (!lc->transaction.active)
+    {
+        pthread_rwlock_unlock(&lc->lock);
+
+        return LAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    status = commit ? lc->transaction.status : LAI_STATUS_SUCCESS;
+
+    if (commit && status == LAI_STATUS_SUCCESS)
+    {
+        vs_transaction_apply(lc);
+    }
+    else
+    {
+        vs_transaction_undo(lc);
+    }
+
+    vs_transaction_reset(lc);
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return status;
+}
+
+static const lai_stat_metadata_t* vs_stat_metadata(
+        _In_ lai_object_type_t object_type,
+        _In_ uint32_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids)
+{
+    const lai_stat_metadata_t *md = NULL;
+    uint32_t idx;
+
+    for (idx = 0; idx < number_of_counters; idx++)
+    {
+        md = lai_metadata_get_stat_metadata(object_type, counter_ids[idx]);
+
+        if (md == NULL)
+        {
+            LAI_META_LOG_ERROR("unknown statistics %u", counter_ids[idx]);
+            return NULL;
+        }
+    }
+
+    return md;
+}
+
+static lai_status_t vs_object_cleared(
+        _In_ const lai_object_type_info_t *info,
+        _Inout_ vs_object_t *object)
+{
+    if (object->cleared == NULL)
+    {
+        object->cleared = (uint64_t*)calloc(info->statenum->valuescount, sizeof(uint64_t));
+    }
+
+    return object->cleared == NULL ? LAI_STATUS_NO_MEMORY : LAI_STATUS_SUCCESS;
+}
+
+lai_status_t vs_generic_get_stats_ext(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids,
+        _In_ lai_stats_mode_t mode,
+        _Out_ lai_stat_value_t *counters)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(object_type);
+    vs_linecard_t *lc;
+    vs_object_t *object;
+    uint64_t now = vs_now();
+    uint32_t idx;
+    lai_status_t status = LAI_STATUS_SUCCESS;
+
+    if (info == NULL || info->statenum == NULL || number_of_counters == 0 ||
+            counter_ids == NULL || counters == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (mode != LAI_STATS_MODE_READ && mode != LAI_STATS_MODE_READ_AND_CLEAR)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (vs_stat_metadata(object_type, number_of_counters, counter_ids) == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (lai_object_type_query(object_id) != object_type)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    object = vs_object_lock(object_id, mode == LAI_STATS_MODE_READ_AND_CLEAR, &lc);
+
+    if (object == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    for (idx = 0; idx < number_of_counters && status == LAI_STATUS_SUCCESS; idx++)
+    {
+        const lai_stat_metadata_t *md = lai_metadata_get_stat_metadata(object_type, counter_ids[idx]);
+
+        vs_stats_synthesize(object, md, now, &counters[idx]);
+
+        if (md->statvalueiscounter && mode == LAI_STATS_MODE_READ_AND_CLEAR)
+        {
+            status = vs_object_cleared(info, object);
+
+            if (status == LAI_STATUS_SUCCESS)
+            {
+                object->cleared[counter_ids[idx]] = vs_stats_counter(object, md, now);
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return status;
+}
+
+lai_status_t vs_generic_clear_stats(
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ uint32_t number_of_counters,
+        _In_ const lai_stat_id_t *counter_ids)
+{
+    const lai_object_type_info_t *info = lai_metadata_get_object_type_info(object_type);
+    vs_linecard_t *lc;
+    vs_object_t *object;
+    uint64_t now = vs_now();
+    uint32_t idx;
+    lai_status_t status;
+
+    if (info == NULL || info->statenum == NULL || number_of_counters == 0 || counter_ids == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (vs_stat_metadata(object_type, number_of_counters, counter_ids) == NULL)
+    {
+        return LAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (lai_object_type_query(object_id) != object_type)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    object = vs_object_lock(object_id, true, &lc);
+
+    if (object == NULL)
+    {
+        return LAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    status = vs_object_cleared(info, object);
+
+    for (idx = 0; idx < number_of_counters && status == LAI_STATUS_SUCCESS; idx++)
+    {
+        const lai_stat_metadata_t *md = lai_metadata_get_stat_metadata(object_type, counter_ids[idx]);
+
+        if (md->statvalueiscounter)
+        {
+            object->cleared[counter_ids[idx]] = vs_stats_counter(object, md, now);
+        }
+    }
+
+    pthread_rwlock_unlock(&lc->lock);
+
+    return status;
+}
@@ -0,0 +1,1528 @@
+/**
+ * Copyright (c) 2021 Alibaba Group.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ * @file    laivstest.c
+ *
+ * @brief   This module implements LAI Virtual Adapter tests
+ *
+ * Usage: laivstest [name]...
+ *
+ * Runs virtual adapter through LAI API, alone and under metadata helpers
+ * which drive adapter. Runs all tests or tests given by name, prints
+ * result of every test and exits with failure when any test fails.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <lai.h>
+#include "laivs.h"
+
+#define TEST_THREADS        4
+#define TEST_ITERATIONS     2000
+
+#define TEST_ASSERT(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            return false; \
+        } \
+    } while (0)
+
+typedef bool (*lai_test_fn)(void);
+
+typedef struct _lai_test_t
+{
+    const char *name;
+    lai_test_fn fn;
+
+} lai_test_t;
+
+static const char* lai_test_profile_get_value(
+        _In_ lai_linecard_profile_id_t profile_id,
+        _In_ const char *variable)
+{
+    /* short timer period, so notification timer runs during tests */
+
+    if (strcmp(variable, "LAI_VS_NOTIFY_INTERVAL_MS") == 0)
+    {
+        return "5";
+    }
+
+    return NULL;
+}
+
+static const lai_service_method_table_t lai_test_services = {
+    lai_test_profile_get_value,
+    NULL,
+};
+
+/*
+ * Concurrency stress: writers set OA target gain while readers get it and
+ * poll OA statistics on the same linecard. Every call must succeed and
+ * every read must return one of written values.
+ */
+
+typedef struct _lai_test_stress_t
+{
+    const lai_oa_api_t *oa_api;
+    lai_object_id_t oa_id;
+    uint32_t thread;
+    uint32_t failures;
+
+} lai_test_stress_t;
+
+static void* lai_test_stress_writer(
+        _In_ void *arg)
+{
+    lai_test_stress_t *stress = (lai_test_stress_t*)arg;
+    lai_attribute_t attr;
+    int idx;
+
+    attr.id = LAI_OA_ATTR_TARGET_GAIN;
+    attr.value.d64 = 10.0 + (double)stress->thread;
+
+    for (idx = 0; idx < TEST_ITERATIONS; idx++)
+    {
+        if (stress->oa_api->set_oa_attribute(stress->oa_id, &attr) != LAI_STATUS_SUCCESS)
+        {
+            stress->failures++;
+        }
+    }
+
+    return NULL;
+}
+
+static void* lai_test_stress_reader(
+        _In_ void *arg)
+{
+    lai_test_stress_t *stress = (lai_test_stress_t*)arg;
+    lai_stat_id_t counter_ids[2] = { LAI_OA_STAT_TEMPERATURE, LAI_OA_STAT_ACTUAL_GAIN };
+    lai_stat_value_t counters[2];
+    lai_attribute_t attr;
+    int idx;
+
+    for (idx = 0; idx < TEST_ITERATIONS; idx++)
+    {
+        attr.id = LAI_OA_ATTR_TARGET_GAIN;
+
+        if (stress->oa_api->get_oa_attribute(stress->oa_id, 1, &attr) != LAI_STATUS_SUCCESS ||
+                !(attr.value.d64 >= 10.0 && attr.value.d64 <= 10.0 + TEST_THREADS - 1))
+        {
+            stress->failures++;
+        }
+
+        if (stress->oa_api->get_oa_stats(stress->oa_id, 2, counter_ids, counters) != LAI_STATUS_SUCCESS)
+        {
+            stress->failures++;
+        }
+    }
+
+    return NULL;
+}
+
+static bool lai_test_stress(
+        _In_ const lai_linecard_api_t *linecard_api,
+        _In_ const lai_oa_api_t *oa_api)
+{
+    lai_test_stress_t stress[2 * TEST_THREADS];
+    pthread_t threads[2 * TEST_THREADS];
+    lai_object_id_t linecard_id;
+    lai_attribute_t attrs[2];
+    uint32_t idx;
+    uint32_t failures = 0;
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+
+    TEST_ASSERT(linecard_api->create_linecard(&linecard_id, 1, attrs) == LAI_STATUS_SUCCESS);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[0].value.u32 = 1;
+    attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+    attrs[1].value.d64 = 10.0;
+
+    memset(stress, 0, sizeof(stress));
+
+    TEST_ASSERT(oa_api->create_oa(&stress[0].oa_id, linecard_id, 2, attrs) == LAI_STATUS_SUCCESS);
+
+    for (idx = 0; idx < 2 * TEST_THREADS; idx++)
+    {
+        stress[idx].oa_api = oa_api;
+        stress[idx].oa_id = stress[0].oa_id;
+        stress[idx].thread = idx % TEST_THREADS;
+
+        TEST_ASSERT(pthread_create(&threads[idx], NULL,
+                    idx < TEST_THREADS ? lai_test_stress_writer : lai_test_stress_reader, &stress[idx]) == 0);
+    }
+
+    for (idx = 0; idx < 2 * TEST_THREADS; idx++)
+    {
+        pthread_join(threads[idx], NULL);
+
+        failures += stress[idx].failures;
+    }
+
+    TEST_ASSERT(failures == 0);
+
+    TEST_ASSERT(oa_api->remove_oa(stress[0].oa_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(linecard_api->remove_linecard(linecard_id) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_concurrency_modes(void)
+{
+    lai_api_concurrency_mode_t mode;
+    lai_api_concurrency_mode_t queried;
+    void *linecard_api;
+    void *oa_api;
+    bool passed;
+
+    TEST_ASSERT(lai_api_initialize(LAI_API_CONCURRENCY_MODE_CONCURRENT_READS + 1, &lai_test_services) == LAI_STATUS_INVALID_PARAMETER);
+
+    for (mode = LAI_API_CONCURRENCY_MODE_SINGLE_THREADED; mode <= LAI_API_CONCURRENCY_MODE_CONCURRENT_READS;
+            mode = (lai_api_concurrency_mode_t)(mode + 1))
+    {
+        TEST_ASSERT(lai_api_initialize((uint64_t)mode, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+        passed = lai_api_concurrency_mode_query(&queried) == LAI_STATUS_SUCCESS && queried == mode &&
+            lai_api_query(LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS &&
+            lai_api_query(LAI_API_OA, &oa_api) == LAI_STATUS_SUCCESS &&
+            lai_test_stress((const lai_linecard_api_t*)linecard_api, (const lai_oa_api_t*)oa_api);
+
+        TEST_ASSERT(lai_api_uninitialize() == LAI_STATUS_SUCCESS);
+        TEST_ASSERT(passed);
+    }
+
+    return true;
+}
+
+typedef struct _lai_test_context_t
+{
+    lai_api_context_id_t context_id;
+    bool passed;
+
+} lai_test_context_t;
+
+static void* lai_test_context_stress(
+        _In_ void *arg)
+{
+    lai_test_context_t *context = (lai_test_context_t*)arg;
+    void *linecard_api;
+    void *oa_api;
+
+    context->passed = lai_api_context_query(context->context_id, LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS &&
+        lai_api_context_query(context->context_id, LAI_API_OA, &oa_api) == LAI_STATUS_SUCCESS &&
+        lai_test_stress((const lai_linecard_api_t*)linecard_api, (const lai_oa_api_t*)oa_api);
+
+    return NULL;
+}
+
+static bool lai_test_context_modes(void)
+{
+    lai_test_context_t contexts[LAI_API_CONCURRENCY_MODE_CONCURRENT_READS + 1];
+    pthread_t threads[LAI_API_CONCURRENCY_MODE_CONCURRENT_READS + 1];
+    uint32_t idx;
+    bool passed = true;
+
+    /* every context in other mode, all stressed at once */
+
+    for (idx = 0; idx <= LAI_API_CONCURRENCY_MODE_CONCURRENT_READS; idx++)
+    {
+        contexts[idx].context_id = idx;
+        contexts[idx].passed = false;
+
+        TEST_ASSERT(lai_api_context_initialize(idx, idx, &lai_test_services) == LAI_STATUS_SUCCESS);
+    }
+
+    for (idx = 0; idx <= LAI_API_CONCURRENCY_MODE_CONCURRENT_READS; idx++)
+    {
+        TEST_ASSERT(pthread_create(&threads[idx], NULL, lai_test_context_stress, &contexts[idx]) == 0);
+    }
+
+    for (idx = 0; idx <= LAI_API_CONCURRENCY_MODE_CONCURRENT_READS; idx++)
+    {
+        pthread_join(threads[idx], NULL);
+
+        passed = passed && contexts[idx].passed;
+
+        TEST_ASSERT(lai_api_context_uninitialize(idx) == LAI_STATUS_SUCCESS);
+    }
+
+    TEST_ASSERT(passed);
+
+    return true;
+}
+
+/*
+ * Context profiles: context 0 profile disables notification timer, so
+ * asynchronous set completes as soon as timer thread is woken, context 1
+ * profile enables it, so set completes on timer tick. Both are notified
+ * from timer thread with request id already returned.
+ */
+
+#define TEST_NOTIFY_INTERVAL_MS     200
+
+static const char* lai_test_context_profile_get_value(
+        _In_ lai_linecard_profile_id_t profile_id,
+        _In_ const char *variable)
+{
+    if (strcmp(variable, "LAI_VS_NOTIFY_INTERVAL_MS") == 0)
+    {
+        return profile_id == 0 ? "0" : "200";
+    }
+
+    return NULL;
+}
+
+static const lai_service_method_table_t lai_test_context_services = {
+    lai_test_context_profile_get_value,
+    NULL,
+};
+
+static uint32_t lai_test_async_completed[2];
+static lai_request_id_t lai_test_async_request[2];
+static pthread_t lai_test_async_caller;
+
+static void lai_test_async_notify(
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_request_id_t request_id,
+        _In_ lai_object_id_t object_id,
+        _In_ bool completed,
+        _In_ lai_status_t status,
+        _In_ lai_uint8_t progress)
+{
+    uint32_t idx = LAI_OBJECT_ID_LINECARD_INDEX(linecard_id);
+
+    if (completed && status == LAI_STATUS_SUCCESS && idx < 2 &&
+            request_id == lai_test_async_request[idx] && !pthread_equal(pthread_self(), lai_test_async_caller))
+    {
+        __atomic_add_fetch(&lai_test_async_completed[idx], 1, __ATOMIC_RELEASE);
+    }
+}
+
+static bool lai_test_context_async_set(
+        _In_ lai_api_context_id_t context_id,
+        _Out_ bool *timer_completed)
+{
+    struct timespec delay = { 0, 10000000L };
+    struct timespec start;
+    struct timespec end;
+    lai_object_id_t linecard_id;
+    lai_object_id_t oa_id;
+    lai_attribute_t attrs[2];
+    void *linecard_api;
+    void *oa_api;
+    int idx;
+
+    TEST_ASSERT(lai_api_context_query(context_id, LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_api_context_query(context_id, LAI_API_OA, &oa_api) == LAI_STATUS_SUCCESS);
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+    attrs[1].id = LAI_LINECARD_ATTR_LINECARD_ASYNC_OPERATION_NOTIFY;
+    attrs[1].value.ptr = (lai_pointer_t)lai_test_async_notify;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    TEST_ASSERT(((const lai_linecard_api_t*)linecard_api)->create_linecard(&linecard_id, 2, attrs) == LAI_STATUS_SUCCESS);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[0].value.u32 = 1;
+    attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+    attrs[1].value.d64 = 12.0;
+
+    TEST_ASSERT(((const lai_oa_api_t*)oa_api)->create_oa(&oa_id, linecard_id, 1, attrs) == LAI_STATUS_SUCCESS);
+
+    TEST_ASSERT(lai_set_attribute_async(LAI_OBJECT_TYPE_OA, oa_id, &attrs[1], &lai_test_async_request[context_id]) == LAI_STATUS_SUCCESS);
+
+    for (idx = 0; idx < 200 && __atomic_load_n(&lai_test_async_completed[context_id], __ATOMIC_ACQUIRE) == 0; idx++)
+    {
+        nanosleep(&delay, NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    TEST_ASSERT(__atomic_load_n(&lai_test_async_completed[context_id], __ATOMIC_ACQUIRE) == 1);
+
+    /* linecard is scheduled when created, tick can't come sooner */
+
+    *timer_completed = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000 >= TEST_NOTIFY_INTERVAL_MS;
+
+    TEST_ASSERT(((const lai_oa_api_t*)oa_api)->remove_oa(oa_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(((const lai_linecard_api_t*)linecard_api)->remove_linecard(linecard_id) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_context_profiles(void)
+{
+    bool timer_completed[2] = { false, false };
+    bool passed;
+
+    memset(lai_test_async_completed, 0, sizeof(lai_test_async_completed));
+
+    lai_test_async_caller = pthread_self();
+
+    TEST_ASSERT(lai_api_context_initialize(0, LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_context_services) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_api_context_initialize(1, LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_context_services) == LAI_STATUS_SUCCESS);
+
+    passed = lai_test_context_async_set(0, &timer_completed[0]) &&
+        lai_test_context_async_set(1, &timer_completed[1]);
+
+    TEST_ASSERT(lai_api_context_uninitialize(1) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_api_context_uninitialize(0) == LAI_STATUS_SUCCESS);
+
+    TEST_ASSERT(passed);
+    TEST_ASSERT(!timer_completed[0] && timer_completed[1]);
+
+    return true;
+}
+
+/*
+ * Transaction isolation: staged sets and creates are not visible to reads
+ * until commit, abort and failed commit leave committed values. Reader
+ * thread polls gain while transactions stage value which is never
+ * committed.
+ */
+
+#define TEST_STAGED_GAIN    99.0
+
+typedef struct _lai_test_transaction_t
+{
+    const lai_oa_api_t *oa_api;
+    lai_object_id_t oa_id;
+    bool stop;
+    uint32_t failures;
+
+} lai_test_transaction_t;
+
+static bool lai_test_get_gain(
+        _In_ const lai_oa_api_t *oa_api,
+        _In_ lai_object_id_t oa_id,
+        _In_ double expected)
+{
+    lai_attribute_t attr;
+
+    attr.id = LAI_OA_ATTR_TARGET_GAIN;
+
+    /* test gains are whole numbers */
+
+    return oa_api->get_oa_attribute(oa_id, 1, &attr) == LAI_STATUS_SUCCESS &&
+        attr.value.d64 > expected - 0.5 && attr.value.d64 < expected + 0.5;
+}
+
+static void* lai_test_transaction_reader(
+        _In_ void *arg)
+{
+    lai_test_transaction_t *tx = (lai_test_transaction_t*)arg;
+    lai_attribute_t attr;
+
+    while (!__atomic_load_n(&tx->stop, __ATOMIC_ACQUIRE))
+    {
+        attr.id = LAI_OA_ATTR_TARGET_GAIN;
+
+        if (tx->oa_api->get_oa_attribute(tx->oa_id, 1, &attr) != LAI_STATUS_SUCCESS ||
+                attr.value.d64 > TEST_STAGED_GAIN - 0.5)
+        {
+            tx->failures++;
+        }
+    }
+
+    return NULL;
+}
+
+static bool lai_test_transaction_run(
+        _In_ const lai_linecard_api_t *linecard_api,
+        _In_ const lai_oa_api_t *oa_api)
+{
+    lai_test_transaction_t tx;
+    lai_object_id_t linecard_id;
+    lai_object_id_t staged_id;
+    lai_attribute_t attrs[2];
+    pthread_t reader;
+    int idx;
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+
+    TEST_ASSERT(linecard_api->create_linecard(&linecard_id, 1, attrs) == LAI_STATUS_SUCCESS);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[0].value.u32 = 1;
+    attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+    attrs[1].value.d64 = 10.0;
+
+    memset(&tx, 0, sizeof(tx));
+
+    tx.oa_api = oa_api;
+
+    TEST_ASSERT(oa_api->create_oa(&tx.oa_id, linecard_id, 2, attrs) == LAI_STATUS_SUCCESS);
+
+    /* abort discards staged set and create */
+
+    TEST_ASSERT(lai_begin_transaction(linecard_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_begin_transaction(linecard_id) == LAI_STATUS_OBJECT_IN_USE);
+
+    attrs[1].value.d64 = 15.0;
+
+    TEST_ASSERT(oa_api->set_oa_attribute(tx.oa_id, &attrs[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_test_get_gain(oa_api, tx.oa_id, 10.0));
+
+    attrs[0].value.u32 = 2;
+
+    TEST_ASSERT(oa_api->create_oa(&staged_id, linecard_id, 1, attrs) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(oa_api->set_oa_attribute(staged_id, &attrs[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(!lai_test_get_gain(oa_api, staged_id, 15.0));
+
+    TEST_ASSERT(lai_abort_transaction(linecard_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_test_get_gain(oa_api, tx.oa_id, 10.0));
+    TEST_ASSERT(!lai_test_get_gain(oa_api, staged_id, 15.0));
+
+    /* failed call fails commit, nothing is applied */
+
+    TEST_ASSERT(lai_begin_transaction(linecard_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(oa_api->set_oa_attribute(tx.oa_id, &attrs[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(oa_api->set_oa_attribute(tx.oa_id, &attrs[0]) != LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_commit_transaction(linecard_id) != LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_test_get_gain(oa_api, tx.oa_id, 10.0));
+
+    /* commit applies staged set and create */
+
+    TEST_ASSERT(lai_begin_transaction(linecard_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(oa_api->set_oa_attribute(tx.oa_id, &attrs[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(oa_api->create_oa(&staged_id, linecard_id, 2, attrs) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_commit_transaction(linecard_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_commit_transaction(linecard_id) == LAI_STATUS_ITEM_NOT_FOUND);
+    TEST_ASSERT(lai_test_get_gain(oa_api, tx.oa_id, 15.0));
+    TEST_ASSERT(lai_test_get_gain(oa_api, staged_id, 15.0));
+
+    /* reader never sees value staged by aborted transactions */
+
+    TEST_ASSERT(pthread_create(&reader, NULL, lai_test_transaction_reader, &tx) == 0);
+
+    for (idx = 0; idx < TEST_ITERATIONS; idx++)
+    {
+        attrs[1].value.d64 = (idx % 2) ? TEST_STAGED_GAIN : 10.0 + (double)(idx % 5);
+
+        if (lai_begin_transaction(linecard_id) != LAI_STATUS_SUCCESS ||
+                oa_api->set_oa_attribute(tx.oa_id, &attrs[1]) != LAI_STATUS_SUCCESS ||
+                ((idx % 2) ? lai_abort_transaction(linecard_id) : lai_commit_transaction(linecard_id)) != LAI_STATUS_SUCCESS)
+        {
+            tx.failures++;
+        }
+    }
+
+    __atomic_store_n(&tx.stop, true, __ATOMIC_RELEASE);
+
+    pthread_join(reader, NULL);
+
+    TEST_ASSERT(tx.failures == 0);
+
+    TEST_ASSERT(oa_api->remove_oa(staged_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(oa_api->remove_oa(tx.oa_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(linecard_api->remove_linecard(linecard_id) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_transaction(void)
+{
+    void *linecard_api;
+    void *oa_api;
+    bool passed;
+
+    TEST_ASSERT(lai_api_initialize(LAI_API_CONCURRENCY_MODE_CONCURRENT_READS, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+    passed = lai_api_query(LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS &&
+        lai_api_query(LAI_API_OA, &oa_api) == LAI_STATUS_SUCCESS &&
+        lai_test_transaction_run((const lai_linecard_api_t*)linecard_api, (const lai_oa_api_t*)oa_api);
+
+    TEST_ASSERT(lai_api_uninitialize() == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(passed);
+
+    return true;
+}
+
+/*
+ * Owner replacing memory of previous owner closes old memory, so readers
+ * attached to it get not ready until they attach again, previous owner
+ * released later leaves name of new owner, readers of released owner get
+ * not ready and reader gives up on sequence left odd by owner which died
+ * in the middle of update.
+ */
+
+#define TEST_ACCUMULATOR_NAME   "/laimetadatatest_accumulator"
+#define TEST_ACCUMULATOR_SEQ    10
+
+static bool lai_test_accumulator_run(
+        _In_ const lai_linecard_api_t *linecard_api,
+        _In_ const lai_ethernet_api_t *ethernet_api)
+{
+    const lai_stat_id_t counter_id = LAI_ETHERNET_STAT_IN_MAC_CONTROL_FRAMES;
+    const struct timespec delay = { 0, 10000000 };
+    lai_metadata_accumulator_t previous;
+    lai_metadata_accumulator_t owner;
+    lai_metadata_accumulator_t stale;
+    lai_metadata_accumulator_t reader;
+    lai_object_id_t linecard_id;
+    lai_object_id_t ethernet_id;
+    lai_attribute_t attr;
+    uint64_t total;
+    uint64_t stale_total;
+    uint64_t *words;
+    uint32_t idx;
+    int fd;
+
+    attr.id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attr.value.chardata, "P230C");
+
+    TEST_ASSERT(linecard_api->create_linecard(&linecard_id, 1, &attr) == LAI_STATUS_SUCCESS);
+
+    attr.id = LAI_ETHERNET_ATTR_CHANNEL_ID;
+    attr.value.u32 = 1;
+
+    TEST_ASSERT(ethernet_api->create_ethernet(&ethernet_id, linecard_id, 1, &attr) == LAI_STATUS_SUCCESS);
+
+    TEST_ASSERT(lai_metadata_accumulator_create(&previous, TEST_ACCUMULATOR_NAME, LAI_OBJECT_TYPE_ETHERNET,
+                1, &ethernet_id, 1, &counter_id) == LAI_STATUS_SUCCESS);
+
+    TEST_ASSERT(lai_metadata_accumulator_attach(&stale, TEST_ACCUMULATOR_NAME) == LAI_STATUS_SUCCESS);
+
+    for (idx = 0, stale_total = 0; idx < 200 && stale_total == 0; idx++)
+    {
+        nanosleep(&delay, NULL);
+
+        TEST_ASSERT(lai_metadata_accumulator_poll(&previous) == LAI_STATUS_SUCCESS);
+        TEST_ASSERT(lai_metadata_accumulator_get(&stale, ethernet_id, 1, &counter_id, &stale_total) == LAI_STATUS_SUCCESS);
+    }
+
+    TEST_ASSERT(stale_total != 0);
+
+    /* previous owner is gone without removing its memory */
+
+    TEST_ASSERT(lai_metadata_accumulator_create(&owner, TEST_ACCUMULATOR_NAME, LAI_OBJECT_TYPE_ETHERNET,
+                1, &ethernet_id, 1, &counter_id) == LAI_STATUS_SUCCESS);
+
+    TEST_ASSERT(lai_metadata_accumulator_get(&stale, ethernet_id, 1, &counter_id, &total) == LAI_STATUS_OBJECT_NOT_READY);
+
+    lai_metadata_accumulator_free(&stale);
+    lai_metadata_accumulator_free(&previous);
+
+    TEST_ASSERT(lai_metadata_accumulator_attach(&reader, TEST_ACCUMULATOR_NAME) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_metadata_accumulator_get(&reader, ethernet_id, 1, &counter_id, &total) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(total == 0);
+
+    TEST_ASSERT(lai_metadata_accumulator_attach(&stale, TEST_ACCUMULATOR_NAME) == LAI_STATUS_SUCCESS);
+
+    /* odd sequence of the only object, as left by owner killed during update */
+
+    fd = shm_open(TEST_ACCUMULATOR_NAME, O_RDWR, 0);
+
+    TEST_ASSERT(fd >= 0);
+
+    words = (uint64_t*)mmap(NULL, (TEST_ACCUMULATOR_SEQ + 2) * sizeof(uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    TEST_ASSERT(words != MAP_FAILED);
+
+    __atomic_store_n(&words[TEST_ACCUMULATOR_SEQ], words[TEST_ACCUMULATOR_SEQ] | 1, __ATOMIC_RELEASE);
+
+    TEST_ASSERT(lai_metadata_accumulator_get(&reader, ethernet_id, 1, &counter_id, &total) == LAI_STATUS_OBJECT_NOT_READY);
+
+    munmap(words, (TEST_ACCUMULATOR_SEQ + 2) * sizeof(uint64_t));
+
+    lai_metadata_accumulator_free(&owner);
+
+    TEST_ASSERT(lai_metadata_accumulator_get(&stale, ethernet_id, 1, &counter_id, &total) == LAI_STATUS_OBJECT_NOT_READY);
+    TEST_ASSERT(lai_metadata_accumulator_attach(&previous, TEST_ACCUMULATOR_NAME) == LAI_STATUS_ITEM_NOT_FOUND);
+
+    lai_metadata_accumulator_free(&reader);
+    lai_metadata_accumulator_free(&stale);
+
+    TEST_ASSERT(ethernet_api->remove_ethernet(ethernet_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(linecard_api->remove_linecard(linecard_id) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_accumulator(void)
+{
+    void *linecard_api;
+    void *ethernet_api;
+    bool passed;
+
+    TEST_ASSERT(lai_api_initialize(LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+    lai_metadata_apis_query(lai_api_query, &lai_metadata_apis);
+
+    passed = lai_api_query(LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS &&
+        lai_api_query(LAI_API_ETHERNET, &ethernet_api) == LAI_STATUS_SUCCESS &&
+        lai_test_accumulator_run((const lai_linecard_api_t*)linecard_api, (const lai_ethernet_api_t*)ethernet_api);
+
+    TEST_ASSERT(lai_api_uninitialize() == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(passed);
+
+    return true;
+}
+
+/*
+ * Record and replay: calls recorded with ids of another adapter replay on
+ * virtual adapter with created ids mapped, so only set of create only
+ * attribute, which adapter rejects, differs from recorded status.
+ */
+
+#define TEST_RECORD_FILE        "/tmp/laimetadatatest.record"
+#define TEST_RECORD_CALLS       7
+
+static void lai_test_record(
+        _In_ lai_metadata_record_kind_t kind,
+        _In_ lai_object_type_t object_type,
+        _In_ lai_object_id_t object_id,
+        _In_ lai_object_id_t linecard_id,
+        _In_ uint32_t attr_count,
+        _In_ const lai_attribute_t *attr_list)
+{
+    uint64_t begin = lai_metadata_record_begin();
+
+    lai_metadata_record_call(kind, object_type, object_id, linecard_id, LAI_STATUS_SUCCESS, begin, attr_count, attr_list);
+}
+
+static bool lai_test_record_replay(void)
+{
+    lai_object_id_t linecard_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_LINECARD, 5, 0);
+    lai_object_id_t oa_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_OA, 5, 77);
+    lai_metadata_record_replay_report_t report;
+    lai_metadata_record_stats_t stats;
+    lai_attribute_t attrs[2];
+    uint64_t mismatches = 0;
+    uint64_t calls = 0;
+    lai_apis_t apis;
+    lai_status_t status;
+    size_t idx;
+
+    TEST_ASSERT(lai_metadata_record_start(TEST_RECORD_FILE) == LAI_STATUS_SUCCESS);
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+
+    lai_test_record(LAI_METADATA_RECORD_KIND_CREATE, LAI_OBJECT_TYPE_LINECARD, linecard_id, LAI_NULL_OBJECT_ID, 1, attrs);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[0].value.u32 = 1;
+    attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+    attrs[1].value.d64 = 14.5;
+
+    lai_test_record(LAI_METADATA_RECORD_KIND_CREATE, LAI_OBJECT_TYPE_OA, oa_id, linecard_id, 2, attrs);
+
+    attrs[1].value.d64 = 16.0;
+
+    lai_test_record(LAI_METADATA_RECORD_KIND_SET, LAI_OBJECT_TYPE_OA, oa_id, linecard_id, 1, &attrs[1]);
+    lai_test_record(LAI_METADATA_RECORD_KIND_GET, LAI_OBJECT_TYPE_OA, oa_id, linecard_id, 1, &attrs[1]);
+    lai_test_record(LAI_METADATA_RECORD_KIND_SET, LAI_OBJECT_TYPE_OA, oa_id, linecard_id, 1, &attrs[0]);
+    lai_test_record(LAI_METADATA_RECORD_KIND_REMOVE, LAI_OBJECT_TYPE_OA, oa_id, linecard_id, 0, NULL);
+    lai_test_record(LAI_METADATA_RECORD_KIND_REMOVE, LAI_OBJECT_TYPE_LINECARD, linecard_id, linecard_id, 0, NULL);
+
+    lai_metadata_record_stop();
+    lai_metadata_record_get_stats(&stats);
+
+    TEST_ASSERT(stats.recorded == TEST_RECORD_CALLS && stats.dropped == 0);
+
+    TEST_ASSERT(lai_api_initialize(LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+    lai_metadata_apis_query(lai_api_query, &apis);
+
+    status = lai_metadata_record_replay(TEST_RECORD_FILE, 0, &report);
+
+    lai_metadata_apis_query(NULL, &apis);
+
+    TEST_ASSERT(lai_api_uninitialize() == LAI_STATUS_SUCCESS);
+
+    unlink(TEST_RECORD_FILE);
+
+    TEST_ASSERT(status == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(report.records == TEST_RECORD_CALLS && report.skipped == 0);
+
+    for (idx = 0; idx < report.count; idx++)
+    {
+        calls += report.entries[idx].calls;
+        mismatches += report.entries[idx].mismatches;
+
+        if (report.entries[idx].kind == LAI_METADATA_RECORD_KIND_SET)
+        {
+            TEST_ASSERT(report.entries[idx].calls == 2 && report.entries[idx].mismatches == 1);
+        }
+    }
+
+    lai_metadata_record_replay_report_free(&report);
+
+    TEST_ASSERT(calls == TEST_RECORD_CALLS && mismatches == 1);
+
+    return true;
+}
+
+/*
+ * Instrumented contexts: tables of two contexts are instrumented, every
+ * context creates linecard in its own slot and objects are created on
+ * linecard given, whichever instrumented table is called.
+ */
+
+static uint64_t lai_test_instrumented_creates(void)
+{
+    lai_metadata_instrument_snapshot_t snapshot;
+    uint64_t calls = 0;
+    size_t idx;
+
+    if (lai_metadata_instrument_snapshot(&snapshot) != LAI_STATUS_SUCCESS)
+    {
+        return 0;
+    }
+
+    for (idx = 0; idx < snapshot.count; idx++)
+    {
+        if (snapshot.entries[idx].object_type == LAI_OBJECT_TYPE_LINECARD &&
+                snapshot.entries[idx].op == LAI_METADATA_INSTRUMENT_OP_CREATE)
+        {
+            calls += snapshot.entries[idx].calls;
+        }
+    }
+
+    lai_metadata_instrument_snapshot_free(&snapshot);
+
+    return calls;
+}
+
+static bool lai_test_instrument_contexts_run(
+        _Inout_ lai_apis_t *apis)
+{
+    lai_object_id_t linecard_ids[2];
+    lai_object_id_t oa_id;
+    lai_attribute_t attrs[2];
+    uint64_t creates = lai_test_instrumented_creates();
+    uint32_t idx;
+
+    TEST_ASSERT(lai_metadata_instrument_apis(&apis[0]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_metadata_instrument_apis(&apis[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(apis[0].linecard_api != apis[1].linecard_api);
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+
+    /* second context first, so slot can't be guessed from order */
+
+    TEST_ASSERT(apis[1].linecard_api->create_linecard(&linecard_ids[1], 1, attrs) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(apis[0].linecard_api->create_linecard(&linecard_ids[0], 1, attrs) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(LAI_OBJECT_ID_LINECARD_INDEX(linecard_ids[0]) == 0 && LAI_OBJECT_ID_LINECARD_INDEX(linecard_ids[1]) == 1);
+    TEST_ASSERT(lai_test_instrumented_creates() == creates + 2);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[0].value.u32 = 1;
+    attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+    attrs[1].value.d64 = 11.0;
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        TEST_ASSERT(apis[0].oa_api->create_oa(&oa_id, linecard_ids[idx], 2, attrs) == LAI_STATUS_SUCCESS);
+        TEST_ASSERT(LAI_OBJECT_ID_LINECARD(oa_id) == linecard_ids[idx]);
+
+        attrs[1].value.d64 = 0.0;
+
+        TEST_ASSERT(apis[1 - idx].oa_api->get_oa_attribute(oa_id, 1, &attrs[1]) == LAI_STATUS_SUCCESS);
+        TEST_ASSERT(attrs[1].value.d64 > 10.5 && attrs[1].value.d64 < 11.5);
+        TEST_ASSERT(apis[idx].oa_api->remove_oa(oa_id) == LAI_STATUS_SUCCESS);
+    }
+
+    TEST_ASSERT(apis[0].linecard_api->remove_linecard(linecard_ids[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(apis[1].linecard_api->remove_linecard(linecard_ids[0]) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_instrument_contexts(void)
+{
+    lai_apis_t apis[2];
+    lai_apis_t empty;
+    lai_status_t status = LAI_STATUS_SUCCESS;
+    void *linecard_api;
+    void *oa_api;
+    bool passed = true;
+    uint32_t idx;
+
+    memset(apis, 0, sizeof(apis));
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        TEST_ASSERT(lai_api_context_initialize(idx, LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+        passed = passed &&
+            lai_api_context_query(idx, LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS &&
+            lai_api_context_query(idx, LAI_API_OA, &oa_api) == LAI_STATUS_SUCCESS;
+
+        apis[idx].linecard_api = (lai_linecard_api_t*)linecard_api;
+        apis[idx].oa_api = (lai_oa_api_t*)oa_api;
+    }
+
+    passed = passed && lai_test_instrument_contexts_run(apis);
+
+    TEST_ASSERT(lai_api_context_uninitialize(1) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_api_context_uninitialize(0) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(passed);
+
+    /* slots are never released, the last one fails */
+
+    for (idx = 0; idx <= LAI_METADATA_API_SLOTS && status == LAI_STATUS_SUCCESS; idx++)
+    {
+        memset(&empty, 0, sizeof(empty));
+
+        status = lai_metadata_instrument_apis(&empty);
+    }
+
+    TEST_ASSERT(status == LAI_STATUS_INSUFFICIENT_RESOURCES);
+
+    return true;
+}
+
+/*
+ * Recorded contexts: tables of two contexts are recorded, every context
+ * creates linecard in its own slot and alarms of every linecard reach
+ * callback passed by its creator.
+ */
+
+#define TEST_RECORD_ALARM_WAIT      400
+
+static uint32_t lai_test_record_alarms[2][2];
+
+static void lai_test_record_alarm(
+        _In_ uint32_t callback,
+        _In_ lai_object_id_t linecard_id)
+{
+    uint32_t idx = LAI_OBJECT_ID_LINECARD_INDEX(linecard_id);
+
+    if (idx < 2)
+    {
+        __atomic_add_fetch(&lai_test_record_alarms[callback][idx], 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void lai_test_record_alarm_0(
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_alarm_type_t alarm_type,
+        _In_ lai_alarm_info_t alarm_info)
+{
+    lai_test_record_alarm(0, linecard_id);
+}
+
+static void lai_test_record_alarm_1(
+        _In_ lai_object_id_t linecard_id,
+        _In_ lai_alarm_type_t alarm_type,
+        _In_ lai_alarm_info_t alarm_info)
+{
+    lai_test_record_alarm(1, linecard_id);
+}
+
+static bool lai_test_record_contexts_run(
+        _Inout_ lai_apis_t *apis)
+{
+    struct timespec delay = { 0, 10000000L };
+    lai_object_id_t linecard_ids[2];
+    lai_attribute_t attrs[2];
+    int wait;
+
+    TEST_ASSERT(lai_metadata_record_apis(&apis[0]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_metadata_record_apis(&apis[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(apis[0].linecard_api != apis[1].linecard_api);
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+    attrs[1].id = LAI_LINECARD_ATTR_LINECARD_ALARM_NOTIFY;
+    attrs[1].value.ptr = (lai_pointer_t)lai_test_record_alarm_1;
+
+    TEST_ASSERT(apis[1].linecard_api->create_linecard(&linecard_ids[1], 2, attrs) == LAI_STATUS_SUCCESS);
+
+    attrs[1].value.ptr = (lai_pointer_t)lai_test_record_alarm_0;
+
+    TEST_ASSERT(apis[0].linecard_api->create_linecard(&linecard_ids[0], 2, attrs) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(LAI_OBJECT_ID_LINECARD_INDEX(linecard_ids[0]) == 0 && LAI_OBJECT_ID_LINECARD_INDEX(linecard_ids[1]) == 1);
+
+    for (wait = 0; wait < TEST_RECORD_ALARM_WAIT &&
+            (__atomic_load_n(&lai_test_record_alarms[0][0], __ATOMIC_RELAXED) == 0 ||
+             __atomic_load_n(&lai_test_record_alarms[1][1], __ATOMIC_RELAXED) == 0); wait++)
+    {
+        nanosleep(&delay, NULL);
+    }
+
+    TEST_ASSERT(apis[0].linecard_api->remove_linecard(linecard_ids[0]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(apis[1].linecard_api->remove_linecard(linecard_ids[1]) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_record_contexts(void)
+{
+    lai_metadata_record_stats_t stats;
+    lai_apis_t apis[2];
+    void *linecard_api;
+    bool passed = true;
+    uint32_t idx;
+
+    memset(apis, 0, sizeof(apis));
+    memset(lai_test_record_alarms, 0, sizeof(lai_test_record_alarms));
+
+    TEST_ASSERT(lai_metadata_record_start(TEST_RECORD_FILE) == LAI_STATUS_SUCCESS);
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        TEST_ASSERT(lai_api_context_initialize(idx, LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+        passed = passed && lai_api_context_query(idx, LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS;
+
+        apis[idx].linecard_api = (lai_linecard_api_t*)linecard_api;
+    }
+
+    passed = passed && lai_test_record_contexts_run(apis);
+
+    TEST_ASSERT(lai_api_context_uninitialize(1) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_api_context_uninitialize(0) == LAI_STATUS_SUCCESS);
+
+    lai_metadata_record_stop();
+    lai_metadata_record_get_stats(&stats);
+
+    unlink(TEST_RECORD_FILE);
+
+    TEST_ASSERT(passed);
+
+    /* alarms of every linecard were recorded and reached only its creator */
+
+    TEST_ASSERT(lai_test_record_alarms[0][0] > 0 && lai_test_record_alarms[1][1] > 0);
+    TEST_ASSERT(lai_test_record_alarms[0][1] == 0 && lai_test_record_alarms[1][0] == 0);
+    TEST_ASSERT(stats.recorded >= 4 + lai_test_record_alarms[0][0] + lai_test_record_alarms[1][1] && stats.dropped == 0);
+
+    return true;
+}
+
+/*
+ * Generations: every create and changing set takes next linecard
+ * generation, set of unchanged value keeps it, changed attributes are
+ * filtered by generation known to caller and short list reports required
+ * count, and generation is not available before initialization.
+ */
+
+#define TEST_GENERATION_CHANGED     128
+
+static bool lai_test_generation_run(
+        _In_ const lai_linecard_api_t *linecard_api,
+        _In_ const lai_oa_api_t *oa_api)
+{
+    lai_object_id_t objects[TEST_GENERATION_CHANGED];
+    lai_attribute_t changed[TEST_GENERATION_CHANGED];
+    lai_generation_t generations[3];
+    lai_generation_t generation;
+    lai_object_id_t linecard_id;
+    lai_object_id_t oa_ids[2];
+    lai_attribute_t attrs[2];
+    uint32_t count;
+    uint32_t idx;
+    uint32_t kept = 0;
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+
+    TEST_ASSERT(linecard_api->create_linecard(&linecard_id, 1, attrs) == LAI_STATUS_SUCCESS);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+    attrs[1].value.d64 = 12.0;
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        attrs[0].value.u32 = idx + 1;
+
+        TEST_ASSERT(oa_api->create_oa(&oa_ids[idx], linecard_id, 2, attrs) == LAI_STATUS_SUCCESS);
+        TEST_ASSERT(lai_get_object_generation(LAI_OBJECT_TYPE_OA, oa_ids[idx], &generations[idx]) == LAI_STATUS_SUCCESS);
+    }
+
+    TEST_ASSERT(generations[0] < generations[1]);
+    TEST_ASSERT(lai_get_object_generation(LAI_OBJECT_TYPE_LINECARD, oa_ids[0], &generation) == LAI_STATUS_INVALID_OBJECT_ID);
+
+    /* changing set takes new generation, the same value again doesn't */
+
+    attrs[1].value.d64 = 15.0;
+
+    TEST_ASSERT(oa_api->set_oa_attribute(oa_ids[0], &attrs[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_get_object_generation(LAI_OBJECT_TYPE_OA, oa_ids[0], &generations[2]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(generations[2] > generations[1]);
+
+    TEST_ASSERT(oa_api->set_oa_attribute(oa_ids[0], &attrs[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_get_object_generation(LAI_OBJECT_TYPE_OA, oa_ids[0], &generation) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(generation == generations[2]);
+
+    count = 0;
+
+    TEST_ASSERT(lai_get_changed_attributes(linecard_id, generations[2], &generation, &count, NULL, NULL) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(count == 0 && generation == generations[2]);
+
+    /* since second create only the gain of the first OA changed */
+
+    TEST_ASSERT(lai_get_changed_attributes(linecard_id, generations[1], &generation, &count, NULL, NULL) ==
+            LAI_STATUS_BUFFER_OVERFLOW);
+    TEST_ASSERT(count == 1);
+    TEST_ASSERT(lai_get_changed_attributes(linecard_id, generations[1], &generation, &count, objects, changed) ==
+            LAI_STATUS_SUCCESS);
+    TEST_ASSERT(count == 1 && objects[0] == oa_ids[0] && changed[0].id == LAI_OA_ATTR_TARGET_GAIN);
+    TEST_ASSERT(changed[0].value.d64 > 14.99 && changed[0].value.d64 < 15.01);
+
+    /* since first create all attributes of the second OA changed too */
+
+    count = TEST_GENERATION_CHANGED;
+
+    TEST_ASSERT(lai_get_changed_attributes(linecard_id, generations[0], &generation, &count, objects, changed) ==
+            LAI_STATUS_SUCCESS);
+    TEST_ASSERT(count > 2 && generation == generations[2]);
+
+    for (idx = 0; idx < count; idx++)
+    {
+        TEST_ASSERT(objects[idx] == oa_ids[0] || objects[idx] == oa_ids[1]);
+
+        kept += objects[idx] == oa_ids[0];
+    }
+
+    TEST_ASSERT(kept == 1);
+
+    count = 1;
+
+    TEST_ASSERT(lai_get_changed_attributes(linecard_id, generations[0], &generation, &count, objects, changed) ==
+            LAI_STATUS_BUFFER_OVERFLOW);
+    TEST_ASSERT(count > 2);
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        TEST_ASSERT(oa_api->remove_oa(oa_ids[idx]) == LAI_STATUS_SUCCESS);
+    }
+
+    TEST_ASSERT(lai_get_object_generation(LAI_OBJECT_TYPE_OA, oa_ids[0], &generation) == LAI_STATUS_INVALID_OBJECT_ID);
+    TEST_ASSERT(linecard_api->remove_linecard(linecard_id) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_generation(void)
+{
+    const lai_object_id_t oa_id = LAI_OBJECT_ID_ENCODE(LAI_OBJECT_TYPE_OA, 0, 0);
+    lai_generation_t generation;
+    uint32_t count = 0;
+    void *linecard_api;
+    void *oa_api;
+    bool passed;
+
+    TEST_ASSERT(lai_get_object_generation(LAI_OBJECT_TYPE_OA, oa_id, &generation) == LAI_STATUS_UNINITIALIZED);
+    TEST_ASSERT(lai_get_changed_attributes(LAI_NULL_OBJECT_ID, 0, &generation, &count, NULL, NULL) == LAI_STATUS_UNINITIALIZED);
+
+    TEST_ASSERT(lai_api_initialize(LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+    passed = lai_api_query(LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS &&
+        lai_api_query(LAI_API_OA, &oa_api) == LAI_STATUS_SUCCESS &&
+        lai_test_generation_run((const lai_linecard_api_t*)linecard_api, (const lai_oa_api_t*)oa_api);
+
+    TEST_ASSERT(lai_api_uninitialize() == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(passed);
+
+    return true;
+}
+
+/*
+ * Read modes: cached read keeps timestamp of create, forced read and read
+ * of value older than max age refresh it, set stamps written value.
+ */
+
+static bool lai_test_read_modes_get(
+        _In_ lai_object_id_t oa_id,
+        _In_ lai_read_mode_t read_mode,
+        _In_ uint64_t max_age,
+        _Out_ uint64_t *timestamps)
+{
+    struct timespec delay = { 0, 2000000 };
+    lai_attribute_t attrs[2];
+
+    /* previous timestamps are at least delay old */
+
+    nanosleep(&delay, NULL);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+
+    TEST_ASSERT(lai_get_attribute_ext(LAI_OBJECT_TYPE_OA, oa_id, read_mode, max_age, 2, attrs, timestamps) ==
+            LAI_STATUS_SUCCESS);
+    TEST_ASSERT(attrs[0].value.u32 == 1);
+    TEST_ASSERT(attrs[1].value.d64 > 11.99 && attrs[1].value.d64 < 12.01);
+
+    return true;
+}
+
+static bool lai_test_read_modes_run(
+        _In_ const lai_linecard_api_t *linecard_api,
+        _In_ const lai_oa_api_t *oa_api)
+{
+    uint64_t created[2];
+    uint64_t forced[2];
+    uint64_t timestamps[2];
+    lai_object_id_t linecard_id;
+    lai_object_id_t oa_id;
+    lai_attribute_t attrs[2];
+    int idx;
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+
+    TEST_ASSERT(linecard_api->create_linecard(&linecard_id, 1, attrs) == LAI_STATUS_SUCCESS);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[0].value.u32 = 1;
+    attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+    attrs[1].value.d64 = 12.0;
+
+    TEST_ASSERT(oa_api->create_oa(&oa_id, linecard_id, 2, attrs) == LAI_STATUS_SUCCESS);
+
+    TEST_ASSERT(lai_test_read_modes_get(oa_id, LAI_READ_MODE_CACHED, 0, created));
+    TEST_ASSERT(lai_test_read_modes_get(oa_id, LAI_READ_MODE_CACHED, 0, timestamps));
+    TEST_ASSERT(created[0] != 0 && timestamps[0] == created[0] && timestamps[1] == created[1]);
+
+    TEST_ASSERT(lai_test_read_modes_get(oa_id, LAI_READ_MODE_FORCE, 0, forced));
+    TEST_ASSERT(forced[0] > created[0] && forced[1] > created[1]);
+
+    TEST_ASSERT(lai_test_read_modes_get(oa_id, LAI_READ_MODE_CACHED, 0, timestamps));
+    TEST_ASSERT(timestamps[0] == forced[0] && timestamps[1] == forced[1]);
+
+    /* value younger than max age is kept, older one is read again */
+
+    TEST_ASSERT(lai_test_read_modes_get(oa_id, LAI_READ_MODE_MAX_AGE, 1000000000ULL, timestamps));
+    TEST_ASSERT(timestamps[0] == forced[0] && timestamps[1] == forced[1]);
+
+    TEST_ASSERT(lai_test_read_modes_get(oa_id, LAI_READ_MODE_MAX_AGE, 1000000ULL, timestamps));
+    TEST_ASSERT(timestamps[0] > forced[0] && timestamps[1] > forced[1]);
+
+    /* set stamps only written attribute */
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        forced[idx] = timestamps[idx];
+    }
+
+    TEST_ASSERT(oa_api->set_oa_attribute(oa_id, &attrs[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(lai_test_read_modes_get(oa_id, LAI_READ_MODE_CACHED, 0, timestamps));
+    TEST_ASSERT(timestamps[0] == forced[0] && timestamps[1] > forced[1]);
+
+    TEST_ASSERT(lai_get_attribute_ext(LAI_OBJECT_TYPE_OA, oa_id, (lai_read_mode_t)(LAI_READ_MODE_MAX_AGE + 1), 0, 1,
+                attrs, timestamps) == LAI_STATUS_INVALID_PARAMETER);
+    TEST_ASSERT(lai_get_attribute_ext(LAI_OBJECT_TYPE_OA, oa_id, LAI_READ_MODE_CACHED, 0, 1, attrs, NULL) ==
+            LAI_STATUS_INVALID_PARAMETER);
+
+    TEST_ASSERT(oa_api->remove_oa(oa_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(linecard_api->remove_linecard(linecard_id) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_read_modes(void)
+{
+    void *linecard_api;
+    void *oa_api;
+    bool passed;
+
+    TEST_ASSERT(lai_api_initialize(LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+    passed = lai_api_query(LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS &&
+        lai_api_query(LAI_API_OA, &oa_api) == LAI_STATUS_SUCCESS &&
+        lai_test_read_modes_run((const lai_linecard_api_t*)linecard_api, (const lai_oa_api_t*)oa_api);
+
+    TEST_ASSERT(lai_api_uninitialize() == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(passed);
+
+    return true;
+}
+
+/*
+ * Sampling ring: drains of few samples continue where previous drain
+ * stopped, and samples overwritten in full ring are reported as dropped
+ * exactly where the gap is.
+ */
+
+#define TEST_SAMPLES_PERIOD     10
+#define TEST_SAMPLES_DEPTH      4
+#define TEST_SAMPLES_MAX        16
+#define TEST_SAMPLES_STATS      2
+
+/*
+ * Timestamps of drains are converted from monotonic milliseconds, so
+ * samples of different drains are compared with millisecond tolerance.
+ */
+
+static bool lai_test_samples_step(
+        _In_ uint64_t previous,
+        _In_ uint64_t next,
+        _In_ uint64_t periods)
+{
+    const uint64_t step = periods * TEST_SAMPLES_PERIOD * 1000000ULL;
+
+    return next > previous && next - previous > step - 2000000ULL && next - previous < step + 2000000ULL;
+}
+
+static bool lai_test_samples_drain(
+        _In_ const lai_oa_api_t *oa_api,
+        _In_ lai_object_id_t oa_id,
+        _In_ uint32_t count,
+        _Inout_ uint64_t *last,
+        _Out_ uint32_t *drained,
+        _Out_ uint64_t *dropped)
+{
+    lai_stat_value_t counters[TEST_SAMPLES_MAX * TEST_SAMPLES_STATS];
+    uint64_t timestamps[TEST_SAMPLES_MAX];
+    uint32_t idx;
+
+    *drained = count;
+
+    TEST_ASSERT(oa_api->drain_oa_samples(oa_id, drained, timestamps, counters, dropped) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(*drained <= count && *drained <= TEST_SAMPLES_DEPTH);
+
+    /* the first sample follows the last drained one and samples dropped in between */
+
+    TEST_ASSERT(*drained == 0 || *last == 0 || lai_test_samples_step(*last, timestamps[0], *dropped + 1));
+
+    for (idx = 1; idx < *drained; idx++)
+    {
+        TEST_ASSERT(timestamps[idx] - timestamps[idx - 1] == TEST_SAMPLES_PERIOD * 1000000ULL);
+    }
+
+    *last = *drained != 0 ? timestamps[*drained - 1] : *last;
+
+    return true;
+}
+
+static bool lai_test_samples_run(
+        _In_ const lai_linecard_api_t *linecard_api,
+        _In_ const lai_oa_api_t *oa_api)
+{
+    struct timespec delay = { 0, 100000000 };
+    int32_t stats[TEST_SAMPLES_STATS] = { LAI_OA_STAT_TEMPERATURE, LAI_OA_STAT_ACTUAL_GAIN };
+    lai_object_id_t linecard_id;
+    lai_object_id_t oa_id;
+    lai_attribute_t attrs[4];
+    uint64_t last = 0;
+    uint64_t dropped;
+    uint32_t drained;
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+
+    TEST_ASSERT(linecard_api->create_linecard(&linecard_id, 1, attrs) == LAI_STATUS_SUCCESS);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[0].value.u32 = 1;
+    attrs[1].id = LAI_OA_ATTR_SAMPLING_PERIOD;
+    attrs[1].value.u32 = TEST_SAMPLES_PERIOD;
+    attrs[2].id = LAI_OA_ATTR_SAMPLING_DEPTH;
+    attrs[2].value.u32 = TEST_SAMPLES_DEPTH;
+    attrs[3].id = LAI_OA_ATTR_SAMPLING_STATS;
+    attrs[3].value.s32list.count = TEST_SAMPLES_STATS;
+    attrs[3].value.s32list.list = stats;
+
+    TEST_ASSERT(oa_api->create_oa(&oa_id, linecard_id, 4, attrs) == LAI_STATUS_SUCCESS);
+
+    /* drain everything to get last sample before the ring overflows */
+
+    nanosleep(&delay, NULL);
+
+    TEST_ASSERT(lai_test_samples_drain(oa_api, oa_id, TEST_SAMPLES_MAX, &last, &drained, &dropped));
+    TEST_ASSERT(drained == TEST_SAMPLES_DEPTH && dropped != 0);
+
+    nanosleep(&delay, NULL);
+
+    /* partial drains report the gap once and continue without gaps or repeats */
+
+    TEST_ASSERT(lai_test_samples_drain(oa_api, oa_id, 1, &last, &drained, &dropped));
+    TEST_ASSERT(drained == 1 && dropped != 0);
+
+    TEST_ASSERT(lai_test_samples_drain(oa_api, oa_id, 2, &last, &drained, &dropped));
+    TEST_ASSERT(drained == 2 && dropped == 0);
+
+    TEST_ASSERT(lai_test_samples_drain(oa_api, oa_id, TEST_SAMPLES_MAX, &last, &drained, &dropped));
+    TEST_ASSERT(drained != 0 && dropped == 0);
+
+    TEST_ASSERT(oa_api->remove_oa(oa_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(linecard_api->remove_linecard(linecard_id) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_samples(void)
+{
+    void *linecard_api;
+    void *oa_api;
+    bool passed;
+
+    TEST_ASSERT(lai_api_initialize(LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+    passed = lai_api_query(LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS &&
+        lai_api_query(LAI_API_OA, &oa_api) == LAI_STATUS_SUCCESS &&
+        lai_test_samples_run((const lai_linecard_api_t*)linecard_api, (const lai_oa_api_t*)oa_api);
+
+    TEST_ASSERT(lai_api_uninitialize() == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(passed);
+
+    return true;
+}
+
+/*
+ * Object ids: object created in slot of removed object gets another id, id
+ * of removed object doesn't reach it.
+ */
+
+#define TEST_OBJECT_ID_REUSES       4
+
+static bool lai_test_object_ids_run(
+        _In_ const lai_linecard_api_t *linecard_api,
+        _In_ const lai_oa_api_t *oa_api)
+{
+    lai_object_id_t removed[TEST_OBJECT_ID_REUSES];
+    lai_object_id_t linecard_id;
+    lai_object_id_t kept_id;
+    lai_object_id_t oa_id;
+    lai_attribute_t attrs[2];
+    int idx;
+    int prev;
+
+    attrs[0].id = LAI_LINECARD_ATTR_LINECARD_TYPE;
+    strcpy(attrs[0].value.chardata, "P230C");
+
+    TEST_ASSERT(linecard_api->create_linecard(&linecard_id, 1, attrs) == LAI_STATUS_SUCCESS);
+
+    attrs[0].id = LAI_OA_ATTR_ID;
+    attrs[0].value.u32 = 1;
+    attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+    attrs[1].value.d64 = 12.0;
+
+    TEST_ASSERT(oa_api->create_oa(&kept_id, linecard_id, 2, attrs) == LAI_STATUS_SUCCESS);
+
+    for (idx = 0; idx < TEST_OBJECT_ID_REUSES; idx++)
+    {
+        attrs[0].value.u32 = 2;
+
+        TEST_ASSERT(oa_api->create_oa(&oa_id, linecard_id, 2, attrs) == LAI_STATUS_SUCCESS);
+        TEST_ASSERT(oa_id != kept_id);
+
+        for (prev = 0; prev < idx; prev++)
+        {
+            /* the same slot, but not the same id */
+
+            TEST_ASSERT(VS_OBJECT_ID_SLOT(oa_id) == VS_OBJECT_ID_SLOT(removed[prev]));
+            TEST_ASSERT(oa_id != removed[prev]);
+
+            attrs[1].id = LAI_OA_ATTR_TARGET_GAIN;
+
+            TEST_ASSERT(oa_api->get_oa_attribute(removed[prev], 1, &attrs[1]) != LAI_STATUS_SUCCESS);
+            TEST_ASSERT(oa_api->remove_oa(removed[prev]) != LAI_STATUS_SUCCESS);
+        }
+
+        TEST_ASSERT(oa_api->remove_oa(oa_id) == LAI_STATUS_SUCCESS);
+
+        removed[idx] = oa_id;
+    }
+
+    TEST_ASSERT(oa_api->get_oa_attribute(kept_id, 1, &attrs[1]) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(oa_api->remove_oa(kept_id) == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(linecard_api->remove_linecard(linecard_id) == LAI_STATUS_SUCCESS);
+
+    return true;
+}
+
+static bool lai_test_object_ids(void)
+{
+    void *linecard_api;
+    void *oa_api;
+    bool passed;
+
+    TEST_ASSERT(lai_api_initialize(LAI_API_CONCURRENCY_MODE_SINGLE_THREADED, &lai_test_services) == LAI_STATUS_SUCCESS);
+
+    passed = lai_api_query(LAI_API_LINECARD, &linecard_api) == LAI_STATUS_SUCCESS &&
+        lai_api_query(LAI_API_OA, &oa_api) == LAI_STATUS_SUCCESS &&
+        lai_test_object_ids_run((const lai_linecard_api_t*)linecard_api, (const lai_oa_api_t*)oa_api);
+
+    TEST_ASSERT(lai_api_uninitialize() == LAI_STATUS_SUCCESS);
+    TEST_ASSERT(passed);
+
+    return true;
+}
+
+static const lai_test_t lai_tests[] = {
+    { "accumulator", lai_test_accumulator },
+    { "concurrency_modes", lai_test_concurrency_modes },
+    { "context_modes", lai_test_context_modes },
+    { "context_profiles", lai_test_context_profiles },
+    { "generation", lai_test_generation },
+    { "instrument_contexts", lai_test_instrument_contexts },
+    { "object_ids", lai_test_object_ids },
+    { "read_modes", lai_test_read_modes },
+    { "record_contexts", lai_test_record_contexts },
+    { "record_replay", lai_test_record_replay },
+    { "samples", lai_test_samples },
+    { "transaction", lai_test_transaction },
+};
+
+int main(
+        int argc,
+        char **argv)
+{
+    size_t idx;
+    int arg;
+    int failed = 0;
+    bool selected;
+
+    for (idx = 0; idx < sizeof(lai_tests) / sizeof(lai_tests[0]); idx++)
+    {
+        selected = (argc < 2);
+
+        for (arg = 1; arg < argc; arg++)
+        {
+            selected = selected || strcmp(argv[arg], lai_tests[idx].name) == 0;
+        }
+
+        if (!selected)
+        {
+            continue;
+        }
+
+        if (lai_tests[idx].fn())
+        {
+            printf("PASS %s\n", lai_tests[idx].name);
+        }
+        else
+        {
+            printf("FAIL %s\n", lai_tests[idx].name);
+            failed++;
+        }
+    }
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}